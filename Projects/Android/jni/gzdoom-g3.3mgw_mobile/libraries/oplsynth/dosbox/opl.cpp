@@ -25,6 +25,7 @@
  */
 
 #include "../oplsynth/opl.h"
+#include "../oplsynth/opl_simd.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
@@ -1400,21 +1401,16 @@ void DBOPL::Update(float* sndptr, int numsamples) {
 #if defined(OPLTYPE_IS_OPL3)
 		if (adlibreg[0x105]&1) {
 			// convert to float samples (stereo->stereo)
-			for (i=0;i<endsamples;i++) {
-				clipit16(outbufl[i],sndptr++);
-				clipit16(outbufr[i],sndptr++);
-			}
+			OPL_MixStereo(sndptr, outbufl, outbufr, (int)endsamples, 10240.f);
 		} else {
 			// convert to float samples (mono->stereo)
-			for (i=0;i<endsamples;i++) {
-				clipit16(outbufl[i],sndptr++);
-				clipit16(outbufl[i],sndptr++);
-			}
+			OPL_MixStereo(sndptr, outbufl, outbufl, (int)endsamples, 10240.f);
 		}
+		sndptr += endsamples * 2;
 #else
 		// convert to float samples
-		for (i=0;i<endsamples;i++)
-			clipit16(outbufl[i],sndptr++);
+		OPL_Mix(sndptr, outbufl, (int)endsamples, 10240.f);
+		sndptr += endsamples;
 #endif
 
 	}
@@ -57,6 +57,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "nukedopl3.h"
+#include "opl_simd.h"
 
 //
 // Envelope generator
@@ -1000,11 +1001,16 @@ void NukedOPL3::WriteReg(int reg, int v) {
 }
 
 void NukedOPL3::Update(float* sndptr, int numsamples) {
-	Bit16s buffer[2];
-	for (Bit32u i = 0; i < (Bit32u)numsamples; i++) {
-		chip_generate(&opl3, buffer);
-		*sndptr++ += (float)(buffer[0] / 10240.0);
-		*sndptr++ += (float)(buffer[1] / 10240.0);
+	// Generate a block of samples first, so that the conversion can be done in one go.
+	Bit16s buffer[2 * 256];
+	while (numsamples > 0) {
+		int count = numsamples < 256 ? numsamples : 256;
+		for (int i = 0; i < count; i++) {
+			chip_generate(&opl3, &buffer[i * 2]);
+		}
+		OPL_MixS16(sndptr, buffer, count * 2, 10240.0);
+		sndptr += count * 2;
+		numsamples -= count;
 	}
 }
 
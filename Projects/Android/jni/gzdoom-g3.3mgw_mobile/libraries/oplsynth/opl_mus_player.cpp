@@ -42,6 +42,7 @@
 #include "opl_mus_player.h"
 #include "opl.h"
 #include "o_swap.h"
+#include "opl_simd.h"
 
 
 #define IMF_RATE				700.0
@@ -322,18 +323,22 @@ void OPLmusicBlock::OffsetSamples(float *buff, int count)
 	double max = -1e10, min = 1e10, offset, step;
 	int i, ramp, largest_at = 0;
 
-	// Find max and min values for this segment of the waveform.
-	for (i = 0; i < count; ++i)
+	// Find max and min values for this segment of the waveform. The
+	// position of the extreme is only needed for short segments.
+	if (count < 512 || !OPL_MinMax(buff, count, min, max))
 	{
-		if (buff[i] > max)
+		for (i = 0; i < count; ++i)
 		{
-			max = buff[i];
-			largest_at = i;
-		}
-		if (buff[i] < min)
-		{
-			min = buff[i];
-			largest_at = i;
+			if (buff[i] > max)
+			{
+				max = buff[i];
+				largest_at = i;
+			}
+			if (buff[i] < min)
+			{
+				min = buff[i];
+				largest_at = i;
+			}
 		}
 	}
 	// Prefer to keep the offset at 0, even if it means a little clipping.
@@ -376,10 +381,7 @@ void OPLmusicBlock::OffsetSamples(float *buff, int count)
 	}
 	if (offset != 0)
 	{
-		for (; i < count; ++i)
-		{
-			buff[i] = float(buff[i] - offset);
-		}
+		OPL_Offset(buff + i, count - i, offset);
 	}
 	LastOffset = float(offset);
 }
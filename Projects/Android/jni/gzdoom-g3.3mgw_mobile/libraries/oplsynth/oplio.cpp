@@ -34,6 +34,8 @@
 
 const double HALF_PI = (3.14159265358979323846 * 0.5);
 
+bool opl_simd_mixing = true;
+
 OPLio::~OPLio()
 {
 }
@@ -15,6 +15,9 @@ public:
 	virtual void SetPanning(int c, float left, float right) = 0;
 };
 
+// Use the SSE2/NEON output mixing loops where available.
+extern bool opl_simd_mixing;
+
 OPLEmul *YM3812Create(bool stereo);
 OPLEmul *DBOPLCreate(bool stereo);
 OPLEmul *JavaOPLCreate(bool stereo);
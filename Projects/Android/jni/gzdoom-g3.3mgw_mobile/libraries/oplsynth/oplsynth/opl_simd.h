@@ -0,0 +1,205 @@
+#ifndef OPL_SIMD_H
+#define OPL_SIMD_H
+
+// SSE2/NEON versions of the loops that move the emulators' output into
+// the stream buffer and recenter it. Each function handles four samples
+// at a time and falls back to the original scalar code for the rest, or
+// for everything if opl_simd_mixing is off.
+
+#include <stdint.h>
+#include "opl.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define OPL_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define OPL_NEON
+#endif
+
+#ifdef OPL_NEON
+static inline float32x4_t OPL_Div(float32x4_t v, float divisor)
+{
+#ifdef __aarch64__
+	return vdivq_f32(v, vdupq_n_f32(divisor));
+#else
+	return vmulq_n_f32(v, 1.f / divisor);
+#endif
+}
+#endif
+
+// dst[i] += src[i] / divisor, for interleaved 16 bit chip output.
+static inline void OPL_MixS16(float *dst, const int16_t *src, int count, double divisor)
+{
+#ifdef OPL_SSE2
+	if (opl_simd_mixing)
+	{
+		const __m128 div = _mm_set1_ps(float(divisor));
+		for (; count >= 8; count -= 8, src += 8, dst += 8)
+		{
+			__m128i s = _mm_loadu_si128((const __m128i *)src);
+			__m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+			__m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+			_mm_storeu_ps(dst, _mm_add_ps(_mm_loadu_ps(dst), _mm_div_ps(_mm_cvtepi32_ps(lo), div)));
+			_mm_storeu_ps(dst + 4, _mm_add_ps(_mm_loadu_ps(dst + 4), _mm_div_ps(_mm_cvtepi32_ps(hi), div)));
+		}
+	}
+#elif defined(OPL_NEON)
+	if (opl_simd_mixing)
+	{
+		for (; count >= 8; count -= 8, src += 8, dst += 8)
+		{
+			int16x8_t s = vld1q_s16(src);
+			float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(s)));
+			float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(s)));
+			vst1q_f32(dst, vaddq_f32(vld1q_f32(dst), OPL_Div(lo, float(divisor))));
+			vst1q_f32(dst + 4, vaddq_f32(vld1q_f32(dst + 4), OPL_Div(hi, float(divisor))));
+		}
+	}
+#endif
+	while (count--)
+	{
+		*dst++ += (float)(*src++ / divisor);
+	}
+}
+
+// dst[i*2] += left[i] / divisor, dst[i*2+1] += right[i] / divisor.
+static inline void OPL_MixStereo(float *dst, const float *left, const float *right, int count, float divisor)
+{
+#ifdef OPL_SSE2
+	if (opl_simd_mixing)
+	{
+		const __m128 div = _mm_set1_ps(divisor);
+		for (; count >= 4; count -= 4, left += 4, right += 4, dst += 8)
+		{
+			__m128 l = _mm_div_ps(_mm_loadu_ps(left), div);
+			__m128 r = _mm_div_ps(_mm_loadu_ps(right), div);
+			_mm_storeu_ps(dst, _mm_add_ps(_mm_loadu_ps(dst), _mm_unpacklo_ps(l, r)));
+			_mm_storeu_ps(dst + 4, _mm_add_ps(_mm_loadu_ps(dst + 4), _mm_unpackhi_ps(l, r)));
+		}
+	}
+#elif defined(OPL_NEON)
+	if (opl_simd_mixing)
+	{
+		for (; count >= 4; count -= 4, left += 4, right += 4, dst += 8)
+		{
+			float32x4x2_t z = vzipq_f32(OPL_Div(vld1q_f32(left), divisor), OPL_Div(vld1q_f32(right), divisor));
+			vst1q_f32(dst, vaddq_f32(vld1q_f32(dst), z.val[0]));
+			vst1q_f32(dst + 4, vaddq_f32(vld1q_f32(dst + 4), z.val[1]));
+		}
+	}
+#endif
+	while (count--)
+	{
+		*dst++ += *left++ / divisor;
+		*dst++ += *right++ / divisor;
+	}
+}
+
+// dst[i] += src[i] / divisor.
+static inline void OPL_Mix(float *dst, const float *src, int count, float divisor)
+{
+#ifdef OPL_SSE2
+	if (opl_simd_mixing)
+	{
+		const __m128 div = _mm_set1_ps(divisor);
+		for (; count >= 4; count -= 4, src += 4, dst += 4)
+		{
+			_mm_storeu_ps(dst, _mm_add_ps(_mm_loadu_ps(dst), _mm_div_ps(_mm_loadu_ps(src), div)));
+		}
+	}
+#elif defined(OPL_NEON)
+	if (opl_simd_mixing)
+	{
+		for (; count >= 4; count -= 4, src += 4, dst += 4)
+		{
+			vst1q_f32(dst, vaddq_f32(vld1q_f32(dst), OPL_Div(vld1q_f32(src), divisor)));
+		}
+	}
+#endif
+	while (count--)
+	{
+		*dst++ += *src++ / divisor;
+	}
+}
+
+// Finds the smallest and largest value in a buffer. Returns false if
+// the caller has to do it itself.
+static inline bool OPL_MinMax(const float *buff, int count, double &min, double &max)
+{
+#if defined(OPL_SSE2) || defined(OPL_NEON)
+	if (opl_simd_mixing && count >= 4)
+	{
+		int i = 4;
+#ifdef OPL_SSE2
+		__m128 vmin = _mm_loadu_ps(buff), vmax = vmin;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 v = _mm_loadu_ps(buff + i);
+			vmin = _mm_min_ps(vmin, v);
+			vmax = _mm_max_ps(vmax, v);
+		}
+		float mins[4], maxs[4];
+		_mm_storeu_ps(mins, vmin);
+		_mm_storeu_ps(maxs, vmax);
+#else
+		float32x4_t vmin = vld1q_f32(buff), vmax = vmin;
+		for (; i + 4 <= count; i += 4)
+		{
+			float32x4_t v = vld1q_f32(buff + i);
+			vmin = vminq_f32(vmin, v);
+			vmax = vmaxq_f32(vmax, v);
+		}
+		float mins[4], maxs[4];
+		vst1q_f32(mins, vmin);
+		vst1q_f32(maxs, vmax);
+#endif
+		float lo = mins[0], hi = maxs[0];
+		for (int j = 1; j < 4; j++)
+		{
+			if (mins[j] < lo) lo = mins[j];
+			if (maxs[j] > hi) hi = maxs[j];
+		}
+		for (; i < count; i++)
+		{
+			if (buff[i] < lo) lo = buff[i];
+			if (buff[i] > hi) hi = buff[i];
+		}
+		min = lo;
+		max = hi;
+		return true;
+	}
+#endif
+	return false;
+}
+
+// buff[i] -= offset
+static inline void OPL_Offset(float *buff, int count, double offset)
+{
+#ifdef OPL_SSE2
+	if (opl_simd_mixing)
+	{
+		const __m128 ofs = _mm_set1_ps(float(offset));
+		for (; count >= 4; count -= 4, buff += 4)
+		{
+			_mm_storeu_ps(buff, _mm_sub_ps(_mm_loadu_ps(buff), ofs));
+		}
+	}
+#elif defined(OPL_NEON)
+	if (opl_simd_mixing)
+	{
+		const float32x4_t ofs = vdupq_n_f32(float(offset));
+		for (; count >= 4; count -= 4, buff += 4)
+		{
+			vst1q_f32(buff, vsubq_f32(vld1q_f32(buff), ofs));
+		}
+	}
+#endif
+	while (count--)
+	{
+		*buff = float(*buff - offset);
+		buff++;
+	}
+}
+
+#endif
@@ -29,11 +29,14 @@
 #include "common.h"
 #include "instrum.h"
 #include "playmidi.h"
+#include "mix_simd.h"
 
 
 namespace Timidity
 {
 
+bool simd_mixing = true;
+
 static int convert_envelope_rate(Renderer *song, uint8_t rate)
 {
 	int r;
@@ -434,7 +437,6 @@ static void mix_mystery_signal(int32_t control_ratio, const sample_t *sp, float
 		left = v->left_mix, 
 		right = v->right_mix;
 	int cc;
-	sample_t s;
 
 	if (!(cc = v->control_counter))
 	{
@@ -451,13 +453,9 @@ static void mix_mystery_signal(int32_t control_ratio, const sample_t *sp, float
 		if (cc < count)
 		{
 			count -= cc;
-			while (cc--)
-			{
-				s = *sp++;
-				lp[0] += left * s;
-				lp[1] += right * s;
-				lp += 2;
-			}
+			mix_run_stereo(sp, lp, left, right, cc);
+			sp += cc;
+			lp += cc * 2;
 			cc = control_ratio;
 			if (update_signal(v))
 				return;	/* Envelope ran out */
@@ -467,13 +465,7 @@ static void mix_mystery_signal(int32_t control_ratio, const sample_t *sp, float
 		else
 		{
 			v->control_counter = cc - count;
-			while (count--)
-			{
-				s = *sp++;
-				lp[0] += left * s;
-				lp[1] += right * s;
-				lp += 2;
-			}
+			mix_run_stereo(sp, lp, left, right, count);
 			return;
 		}
 	}
@@ -497,11 +489,9 @@ static void mix_single_signal(int32_t control_ratio, const sample_t *sp, float *
 		if (cc < count)
 		{
 			count -= cc;
-			while (cc--)
-			{
-				lp[0] += *sp++ * amp;
-				lp += 2;
-			}
+			mix_run_single(sp, lp, amp, cc);
+			sp += cc;
+			lp += cc * 2;
 			cc = control_ratio;
 			if (update_signal(v))
 				return;	/* Envelope ran out */
@@ -510,11 +500,7 @@ static void mix_single_signal(int32_t control_ratio, const sample_t *sp, float *
 		else
 		{
 			v->control_counter = cc - count;
-			while (count--)
-			{
-				lp[0] += *sp++ * amp;
-				lp += 2;
-			}
+			mix_run_single(sp, lp, amp, count);
 			return;
 		}
 	}
@@ -549,10 +535,9 @@ static void mix_mono_signal(int32_t control_ratio, const sample_t *sp, float *lp
 		if (cc < count)
 		{
 			count -= cc;
-			while (cc--)
-			{
-				*lp++ += *sp++ * left;
-			}
+			mix_run_mono(sp, lp, left, cc);
+			sp += cc;
+			lp += cc;
 			cc = control_ratio;
 			if (update_signal(v))
 				return;	/* Envelope ran out */
@@ -561,10 +546,7 @@ static void mix_mono_signal(int32_t control_ratio, const sample_t *sp, float *lp
 		else
 		{
 			v->control_counter = cc - count;
-			while (count--)
-			{
-				*lp++ += *sp++ * left;
-			}
+			mix_run_mono(sp, lp, left, count);
 			return;
 		}
 	}
@@ -572,27 +554,12 @@ static void mix_mono_signal(int32_t control_ratio, const sample_t *sp, float *lp
 
 static void mix_mystery(int32_t control_ratio, const sample_t *sp, float *lp, Voice *v, int count)
 {
-	final_volume_t 
-		left = v->left_mix, 
-		right = v->right_mix;
-	sample_t s;
-
-	while (count--)
-	{
-		s = *sp++;
-		lp[0] += s * left;
-		lp[1] += s * right;
-		lp += 2;
-	}
+	mix_run_stereo(sp, lp, v->left_mix, v->right_mix, count);
 }
 
 static void mix_single(const sample_t *sp, float *lp, final_volume_t amp, int count)
 {
-	while (count--)
-	{
-		lp[0] += *sp++ * amp;
-		lp += 2;
-	}
+	mix_run_single(sp, lp, amp, count);
 }
 
 static void mix_single_left(const sample_t *sp, float *lp, Voice *v, int count)
@@ -606,13 +573,7 @@ static void mix_single_right(const sample_t *sp, float *lp, Voice *v, int count)
 
 static void mix_mono(const sample_t *sp, float *lp, Voice *v, int count)
 {
-	final_volume_t 
-		left = v->left_mix;
-
-	while (count--)
-	{
-		*lp++ += *sp++ * left;
-	}
+	mix_run_mono(sp, lp, v->left_mix, count);
 }
 
 /* Ramp a note out in c samples */
@@ -29,6 +29,7 @@
 #include "common.h"
 #include "instrum.h"
 #include "playmidi.h"
+#include "mix_simd.h"
 
 
 namespace Timidity
@@ -76,11 +77,8 @@ static sample_t *rs_plain(sample_t *resample_buffer, Voice *v, int *countptr)
 		count -= i;
 	}
 
-	while (i--) 
-	{
-		RESAMPLATION;
-		ofs += incr;
-	}
+	ofs = resample_linear(src, dest, ofs, incr, i);
+	dest += i;
 
 	if (ofs >= le) 
 	{
@@ -125,11 +123,8 @@ static sample_t *rs_loop(sample_t *resample_buffer, Voice *vp, int count)
 		{
 			count -= i;
 		}
-		while (i--) 
-		{
-			RESAMPLATION;
-			ofs += incr;
-		}
+		ofs = resample_linear(src, dest, ofs, incr, i);
+		dest += i;
 	}
 
 	vp->sample_offset=ofs; /* Update offset */
@@ -169,11 +164,8 @@ static sample_t *rs_bidir(sample_t *resample_buffer, Voice *vp, int count)
 		{
 			count -= i;
 		}
-		while (i--) 
-		{
-			RESAMPLATION;
-			ofs += incr;
-		}
+		ofs = resample_linear(src, dest, ofs, incr, i);
+		dest += i;
 	}
 
 	/* Then do the bidirectional looping */
@@ -191,11 +183,8 @@ static sample_t *rs_bidir(sample_t *resample_buffer, Voice *vp, int count)
 		{
 			count -= i;
 		}
-		while (i--) 
-		{
-			RESAMPLATION;
-			ofs += incr;
-		}
+		ofs = resample_linear(src, dest, ofs, incr, i);
+		dest += i;
 		if (ofs >= le) 
 		{
 			/* fold the overshoot back in */
@@ -364,11 +353,8 @@ static sample_t *rs_vib_loop(sample_t *resample_buffer, float rate, Voice *vp, i
 			cc -= i;
 		}
 		count -= i;
-		while (i--) 
-		{
-			RESAMPLATION;
-			ofs += incr;
-		}
+		ofs = resample_linear(src, dest, ofs, incr, i);
+		dest += i;
 		if (vibflag) 
 		{
 			cc = vp->vibrato_control_ratio;
@@ -422,11 +408,8 @@ static sample_t *rs_vib_bidir(sample_t *resample_buffer, float rate, Voice *vp,
 			cc -= i;
 		}
 		count -= i;
-		while (i--) 
-		{
-			RESAMPLATION;
-			ofs += incr;
-		}
+		ofs = resample_linear(src, dest, ofs, incr, i);
+		dest += i;
 		if (vibflag) 
 		{
 			cc = vp->vibrato_control_ratio;
@@ -455,11 +438,8 @@ static sample_t *rs_vib_bidir(sample_t *resample_buffer, float rate, Voice *vp,
 			cc -= i;
 		}
 		count -= i;
-		while (i--) 
-		{
-			RESAMPLATION;
-			ofs += incr;
-		}
+		ofs = resample_linear(src, dest, ofs, incr, i);
+		dest += i;
 		if (vibflag) 
 		{
 			cc = vp->vibrato_control_ratio;
@@ -0,0 +1,194 @@
+/*
+
+	TiMidity -- Experimental MIDI to WAVE converter
+	Copyright (C) 1995 Tuukka Toivonen <toivonen@clinet.fi>
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+	mix_simd.h
+
+	Vectorized inner loops for the resampler and the voice mixer.
+	Every kernel processes four samples at a time with SSE2 or NEON and
+	finishes the remainder with the original scalar code. The operations
+	are performed in the same order as the scalar code, so both paths
+	produce the same output as long as the compiler does not contract
+	the scalar multiply-adds. simd_mixing selects the path at runtime so
+	that the two can be compared against each other.
+
+*/
+
+#ifndef TIMIDITY_MIX_SIMD_H
+#define TIMIDITY_MIX_SIMD_H
+
+#include <stdint.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TIMIDITY_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define TIMIDITY_NEON
+#endif
+
+namespace Timidity
+{
+
+/* Linear interpolation of count samples, starting at the fixed point
+   position ofs. Returns the position after the last sample. */
+static inline int resample_linear(const sample_t *src, sample_t *dest, int ofs, int incr, int count)
+{
+#if defined(TIMIDITY_SSE2) || defined(TIMIDITY_NEON)
+	if (simd_mixing && count >= 4)
+	{
+		int32_t o[4], m[4];
+		for (; count >= 4; count -= 4)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				o[j] = ofs >> FRACTION_BITS;
+				m[j] = ofs & FRACTION_MASK;
+				ofs += incr;
+			}
+#ifdef TIMIDITY_SSE2
+			__m128 a = _mm_setr_ps(src[o[0]], src[o[1]], src[o[2]], src[o[3]]);
+			__m128 b = _mm_setr_ps(src[o[0] + 1], src[o[1] + 1], src[o[2] + 1], src[o[3] + 1]);
+			__m128 f = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)m));
+			__m128 d = _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(b, a), f), _mm_set1_ps(1.f / (1 << FRACTION_BITS)));
+			_mm_storeu_ps(dest, _mm_add_ps(a, d));
+#else
+			const float av[4] = { src[o[0]], src[o[1]], src[o[2]], src[o[3]] };
+			const float bv[4] = { src[o[0] + 1], src[o[1] + 1], src[o[2] + 1], src[o[3] + 1] };
+			float32x4_t a = vld1q_f32(av);
+			float32x4_t b = vld1q_f32(bv);
+			float32x4_t f = vcvtq_f32_s32(vld1q_s32(m));
+			float32x4_t d = vmulq_n_f32(vmulq_f32(vsubq_f32(b, a), f), 1.f / (1 << FRACTION_BITS));
+			vst1q_f32(dest, vaddq_f32(a, d));
+#endif
+			dest += 4;
+		}
+	}
+#endif
+	while (count--)
+	{
+		int o = ofs >> FRACTION_BITS, m = ofs & FRACTION_MASK;
+		*dest++ = src[o] + (src[o + 1] - src[o]) * m / (1 << FRACTION_BITS);
+		ofs += incr;
+	}
+	return ofs;
+}
+
+/* Adds a mono voice to an interleaved stereo buffer. */
+static inline void mix_run_stereo(const sample_t *sp, float *lp, final_volume_t left, final_volume_t right, int count)
+{
+#ifdef TIMIDITY_SSE2
+	if (simd_mixing)
+	{
+		const __m128 vol = _mm_setr_ps(left, right, left, right);
+		for (; count >= 4; count -= 4, sp += 4, lp += 8)
+		{
+			__m128 s = _mm_loadu_ps(sp);
+			__m128 lo = _mm_mul_ps(_mm_unpacklo_ps(s, s), vol);
+			__m128 hi = _mm_mul_ps(_mm_unpackhi_ps(s, s), vol);
+			_mm_storeu_ps(lp, _mm_add_ps(_mm_loadu_ps(lp), lo));
+			_mm_storeu_ps(lp + 4, _mm_add_ps(_mm_loadu_ps(lp + 4), hi));
+		}
+	}
+#elif defined(TIMIDITY_NEON)
+	if (simd_mixing)
+	{
+		const float volv[4] = { left, right, left, right };
+		const float32x4_t vol = vld1q_f32(volv);
+		for (; count >= 4; count -= 4, sp += 4, lp += 8)
+		{
+			float32x4_t s = vld1q_f32(sp);
+			float32x4x2_t z = vzipq_f32(s, s);
+			vst1q_f32(lp, vaddq_f32(vld1q_f32(lp), vmulq_f32(z.val[0], vol)));
+			vst1q_f32(lp + 4, vaddq_f32(vld1q_f32(lp + 4), vmulq_f32(z.val[1], vol)));
+		}
+	}
+#endif
+	while (count--)
+	{
+		sample_t s = *sp++;
+		lp[0] += s * left;
+		lp[1] += s * right;
+		lp += 2;
+	}
+}
+
+/* Adds a mono voice to one channel of an interleaved stereo buffer. */
+static inline void mix_run_single(const sample_t *sp, float *lp, final_volume_t amp, int count)
+{
+#ifdef TIMIDITY_SSE2
+	if (simd_mixing)
+	{
+		const __m128 vol = _mm_set1_ps(amp);
+		const __m128 zero = _mm_setzero_ps();
+		for (; count >= 4; count -= 4, sp += 4, lp += 8)
+		{
+			__m128 s = _mm_mul_ps(_mm_loadu_ps(sp), vol);
+			_mm_storeu_ps(lp, _mm_add_ps(_mm_loadu_ps(lp), _mm_unpacklo_ps(s, zero)));
+			_mm_storeu_ps(lp + 4, _mm_add_ps(_mm_loadu_ps(lp + 4), _mm_unpackhi_ps(s, zero)));
+		}
+	}
+#elif defined(TIMIDITY_NEON)
+	if (simd_mixing)
+	{
+		for (; count >= 4; count -= 4, sp += 4, lp += 8)
+		{
+			float32x4_t s = vmulq_n_f32(vld1q_f32(sp), amp);
+			float32x4x2_t z = vzipq_f32(s, vdupq_n_f32(0));
+			vst1q_f32(lp, vaddq_f32(vld1q_f32(lp), z.val[0]));
+			vst1q_f32(lp + 4, vaddq_f32(vld1q_f32(lp + 4), z.val[1]));
+		}
+	}
+#endif
+	while (count--)
+	{
+		lp[0] += *sp++ * amp;
+		lp += 2;
+	}
+}
+
+/* Adds a mono voice to a mono buffer. */
+static inline void mix_run_mono(const sample_t *sp, float *lp, final_volume_t amp, int count)
+{
+#ifdef TIMIDITY_SSE2
+	if (simd_mixing)
+	{
+		const __m128 vol = _mm_set1_ps(amp);
+		for (; count >= 4; count -= 4, sp += 4, lp += 4)
+		{
+			_mm_storeu_ps(lp, _mm_add_ps(_mm_loadu_ps(lp), _mm_mul_ps(_mm_loadu_ps(sp), vol)));
+		}
+	}
+#elif defined(TIMIDITY_NEON)
+	if (simd_mixing)
+	{
+		for (; count >= 4; count -= 4, sp += 4, lp += 4)
+		{
+			vst1q_f32(lp, vaddq_f32(vld1q_f32(lp), vmulq_n_f32(vld1q_f32(sp), amp)));
+		}
+	}
+#endif
+	while (count--)
+	{
+		*lp++ += *sp++ * amp;
+	}
+}
+
+}
+
+#endif
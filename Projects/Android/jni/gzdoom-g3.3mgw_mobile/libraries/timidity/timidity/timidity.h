@@ -50,6 +50,9 @@ enum
 
 extern void (*printMessage)(int type, int verbosity_level, const char *fmt, ...);
 
+/* Use the SSE2/NEON resampling and mixing loops where available. */
+extern bool simd_mixing;
+
 
 /*
 timidity.h
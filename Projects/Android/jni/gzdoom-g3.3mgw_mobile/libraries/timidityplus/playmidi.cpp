@@ -37,6 +37,7 @@
 #include "quantity.h"
 #include "tables.h"
 #include "effect.h"
+#include "threadpool.h"
 
 
 namespace TimidityPlus
@@ -58,6 +59,7 @@ namespace TimidityPlus
 	int timidity_key_adjust = 0;
 	float timidity_tempo_adjust = 1.f;
 	float min_sustain_time = 5000;
+	int timidity_render_threads = 0;	// 0 picks a number based on the CPU count.
 
 	// The following options have no generic use and are only meaningful for some SYSEX events not normally found in common MIDIs.
 	// For now they are kept as unchanging global variables
@@ -172,6 +174,7 @@ Player::~Player()
 	reuse_mblock(&playmidi_pool);
 	if (reverb_buffer != nullptr) free(reverb_buffer);
 	for (int i = 0; i < MAX_CHANNELS; i++) free_drum_effect(i);
+	free_voice_jobs();
 	delete mixer;
 	delete recache;
 	delete effect;
@@ -4742,10 +4745,174 @@ int Player::is_insertion_effect_xg(int ch)
 	return 0;
 }
 
+/* returns the buffer a voice gets mixed into */
+int32_t *Player::get_voice_buffer(int v, int channel_effect, int32_t **vpblist)
+{
+	int j, ch = voice[v].channel, note = voice[v].note;
+	int32_t *vpb = NULL;
+
+	if (!channel_effect) {
+		return buffer_pointer;
+	}
+	if (timidity_drum_effect && ISDRUMCHANNEL(ch)) {
+		make_drum_effect(ch);
+		for (j = 0; j < channel[ch].drum_effect_num; j++) {
+			if (channel[ch].drum_effect[j].note == note) {
+				vpb = channel[ch].drum_effect[j].buf;
+			}
+		}
+	}
+	return vpb != NULL ? vpb : vpblist[ch];
+}
+
+/*
+ * Mixing voices on multiple threads.
+ *
+ * Everything a voice modifies while being mixed belongs either to the
+ * voice itself or to its channel (pitch and modulation state, the
+ * channel's effect and drum part buffers), and chorus voices always share
+ * their partner's channel. So the voices are split up by channel, and
+ * each job gets its own Mixer and its own copies of the dry and insertion
+ * effect buffers that the channels share. These are added up in job
+ * order afterwards. The mixing is done in integer arithmetic, so the
+ * result is exactly the same as when mixing on a single thread.
+ */
+
+#define PARALLEL_MIN_VOICES 16
+#define MAX_RENDER_THREADS 8
+
+struct VoiceJob
+{
+	Mixer *mixer;
+	int voices[max_voices];
+	int num_voices;
+	int load;
+	bool use_dry, use_insertion;
+	int32_t dry[AUDIO_BUFFER_SIZE * 2];
+	int32_t insertion[AUDIO_BUFFER_SIZE * 2];
+};
+
+void Player::free_voice_jobs(void)
+{
+	delete render_pool;
+	render_pool = NULL;
+	for (int i = 0; i < num_voice_jobs; i++) {
+		delete voice_jobs[i].mixer;
+	}
+	delete[] voice_jobs;
+	voice_jobs = NULL;
+	num_voice_jobs = 0;
+}
+
+void Player::mix_voice_job(VoiceJob *job, int32_t count)
+{
+	int i, v;
+
+	if (job->use_dry) {memset(job->dry, 0, count * 8);}
+	if (job->use_insertion) {memset(job->insertion, 0, count * 8);}
+	for (i = 0; i < job->num_voices; i++) {
+		int32_t *vpb;
+
+		v = job->voices[i];
+		vpb = voice_target[v];
+		if (vpb == buffer_pointer) {vpb = job->dry;}
+		else if (vpb == insertion_effect_buffer) {vpb = job->insertion;}
+		job->mixer->mix_voice(vpb, v, count);
+
+		if(voice[v].timeout == 1 && voice[v].timeout < current_sample) {
+			free_voice(v);
+		}
+	}
+}
+
+/* returns 0 if the voices should be mixed on the calling thread */
+int Player::mix_voices_parallel(int32_t count, int uv, int channel_effect, int32_t **vpblist)
+{
+	int i, j, ch, active = 0, njobs = 0, nchannels = 0;
+	int threads = timidity_render_threads;
+	int chvoices[MAX_CHANNELS], chlist[MAX_CHANNELS], chjob[MAX_CHANNELS];
+
+	if (threads <= 0) {
+		/* leave a core for the game */
+		static const int cores = (int)std::thread::hardware_concurrency();
+		threads = cores - 1;
+	}
+	threads = std::min(threads, MAX_RENDER_THREADS);
+	if (threads < 2) {
+		if (render_pool != NULL) {free_voice_jobs();}
+		return 0;
+	}
+
+	memset(chvoices, 0, sizeof(chvoices));
+	for (i = 0; i < uv; i++) {
+		if (voice[i].status != VOICE_FREE) {
+			chvoices[voice[i].channel]++;
+			active++;
+		}
+	}
+	if (active < PARALLEL_MIN_VOICES) {return 0;}
+	for (ch = 0; ch < MAX_CHANNELS; ch++) {
+		if (chvoices[ch] > 0 && !IS_SET_CHANNELMASK(channel_mute, ch)) {chlist[nchannels++] = ch;}
+	}
+	/* a single channel cannot be split up */
+	if (nchannels < 2) {return 0;}
+
+	if (render_pool == NULL || render_pool->size() != threads) {
+		free_voice_jobs();
+		render_pool = new ThreadPool(threads);
+		voice_jobs = new VoiceJob[threads];
+		num_voice_jobs = threads;
+		for (i = 0; i < threads; i++) {
+			voice_jobs[i].mixer = new Mixer(this);
+		}
+	}
+	njobs = std::min(threads, nchannels);
+	for (i = 0; i < njobs; i++) {
+		voice_jobs[i].num_voices = voice_jobs[i].load = 0;
+		voice_jobs[i].use_dry = voice_jobs[i].use_insertion = false;
+	}
+
+	/* Busiest channels first, each to the job with the least voices so far */
+	std::stable_sort(chlist, chlist + nchannels, [&](int a, int b) { return chvoices[a] > chvoices[b]; });
+	for (i = 0; i < nchannels; i++) {
+		int best = 0;
+		for (j = 1; j < njobs; j++) {
+			if (voice_jobs[j].load < voice_jobs[best].load) {best = j;}
+		}
+		chjob[chlist[i]] = best;
+		voice_jobs[best].load += chvoices[chlist[i]];
+	}
+
+	for (i = 0; i < uv; i++) {
+		if (voice[i].status != VOICE_FREE) {
+			int32_t *vpb = get_voice_buffer(i, channel_effect, vpblist);
+			VoiceJob *job;
+
+			if (IS_SET_CHANNELMASK(channel_mute, voice[i].channel)) {
+				free_voice(i);
+				continue;
+			}
+			job = &voice_jobs[chjob[voice[i].channel]];
+			job->voices[job->num_voices++] = i;
+			voice_target[i] = vpb;
+			if (vpb == buffer_pointer) {job->use_dry = true;}
+			else if (vpb == insertion_effect_buffer) {job->use_insertion = true;}
+		}
+	}
+
+	render_pool->run(njobs, [=](int j) { mix_voice_job(&voice_jobs[j], count); });
+
+	for (j = 0; j < njobs; j++) {
+		if (voice_jobs[j].use_dry) {mix_signal(buffer_pointer, voice_jobs[j].dry, count * 2);}
+		if (voice_jobs[j].use_insertion) {mix_signal(insertion_effect_buffer, voice_jobs[j].insertion, count * 2);}
+	}
+	return 1;
+}
+
 /* do_compute_data_midi() with DSP Effect */
 void Player::do_compute_data(int32_t count)
 {
-	int i, j, uv, stereo, n, ch, note;
+	int i, j, uv, stereo, n, ch;
 	int32_t *vpblist[MAX_CHANNELS];
 	int channel_effect, channel_reverb, channel_chorus, channel_delay, channel_eq;
 	int32_t cnt = count * 2, rev_max_delay_out;
@@ -4819,39 +4986,20 @@ void Player::do_compute_data(int32_t count)
 		if(buf_index) {memset(reverb_buffer, 0, buf_index);}
 	}
 
-	for (i = 0; i < uv; i++) {
-		if (voice[i].status != VOICE_FREE) {
-			int32_t *vpb = NULL;
-			int8_t flag;
-			
-			if (channel_effect) {
-				flag = 0;
-				ch = voice[i].channel;
-				if (timidity_drum_effect && ISDRUMCHANNEL(ch)) {
-					make_drum_effect(ch);
-					note = voice[i].note;
-					for (j = 0; j < channel[ch].drum_effect_num; j++) {
-						if (channel[ch].drum_effect[j].note == note) {
-							vpb = channel[ch].drum_effect[j].buf;
-							flag = 1;
-						}
-					}
-					if (flag == 0) {vpb = vpblist[ch];}
+	if (!mix_voices_parallel(count, uv, channel_effect, vpblist)) {
+		for (i = 0; i < uv; i++) {
+			if (voice[i].status != VOICE_FREE) {
+				int32_t *vpb = get_voice_buffer(i, channel_effect, vpblist);
+
+				if(!IS_SET_CHANNELMASK(channel_mute, voice[i].channel)) {
+					mixer->mix_voice(vpb, i, count);
 				} else {
-					vpb = vpblist[ch];
+					free_voice(i);
 				}
-			} else {
-				vpb = buffer_pointer;
-			}
 
-			if(!IS_SET_CHANNELMASK(channel_mute, voice[i].channel)) {
-				mixer->mix_voice(vpb, i, count);
-			} else {
-				free_voice(i);
-			}
-
-			if(voice[i].timeout == 1 && voice[i].timeout < current_sample) {
-				free_voice(i);
+				if(voice[i].timeout == 1 && voice[i].timeout < current_sample) {
+					free_voice(i);
+				}
 			}
 		}
 	}
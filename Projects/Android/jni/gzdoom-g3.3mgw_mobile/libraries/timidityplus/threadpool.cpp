@@ -0,0 +1,106 @@
+/*
+    TiMidity++ -- MIDI to WAVE converter and player
+    Copyright (C) 2020 QuestZDoom contributors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    threadpool.cpp
+*/
+
+#include "threadpool.h"
+
+namespace TimidityPlus
+{
+
+/* numthreads includes the calling thread. */
+ThreadPool::ThreadPool(int numthreads)
+{
+	next_job = 0;
+	for (int i = 1; i < numthreads; i++)
+	{
+		threads.push_back(std::thread([this]() { worker_proc(); }));
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lk(lock);
+		quit = true;
+	}
+	wake.notify_all();
+	for (auto &thread : threads)
+	{
+		thread.join();
+	}
+}
+
+/* Processes jobs until there are none left. Returns the number of jobs done. */
+int ThreadPool::run_jobs()
+{
+	int count = 0;
+	for (int j; (j = next_job++) < num_jobs; count++)
+	{
+		job(j);
+	}
+	return count;
+}
+
+void ThreadPool::worker_proc()
+{
+	unsigned seen = 0;
+	std::unique_lock<std::mutex> lk(lock);
+	for (;;)
+	{
+		wake.wait(lk, [&]() { return quit || generation != seen; });
+		if (quit) return;
+		seen = generation;
+		busy++;
+		lk.unlock();
+		int count = run_jobs();
+		lk.lock();
+		jobs_done += count;
+		if (--busy == 0) done.notify_all();
+	}
+}
+
+void ThreadPool::run(int numjobs, const std::function<void(int)> &func)
+{
+	if (threads.empty() || numjobs < 2)
+	{
+		for (int j = 0; j < numjobs; j++) func(j);
+		return;
+	}
+	{
+		/* A worker that woke up too late for the previous batch may still
+		   be checking for work. Let it finish before the job state changes. */
+		std::unique_lock<std::mutex> lk(lock);
+		done.wait(lk, [&]() { return busy == 0; });
+		job = func;
+		num_jobs = numjobs;
+		jobs_done = 0;
+		next_job = 0;
+		generation++;
+	}
+	wake.notify_all();
+	int count = run_jobs();
+
+	std::unique_lock<std::mutex> lk(lock);
+	jobs_done += count;
+	done.wait(lk, [&]() { return jobs_done == num_jobs && busy == 0; });
+	job = nullptr;
+}
+
+}
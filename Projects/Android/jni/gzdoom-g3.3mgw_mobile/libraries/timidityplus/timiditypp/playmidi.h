@@ -508,6 +508,8 @@ class Recache;
 class Mixer;
 class Reverb;
 class Effect;
+class ThreadPool;
+struct VoiceJob;
 
 class Player
 {
@@ -572,6 +574,12 @@ private:
 
 	int32_t insertion_effect_buffer[AUDIO_BUFFER_SIZE * 2];
 
+	/* For mixing voices on multiple threads */
+	ThreadPool *render_pool;
+	VoiceJob *voice_jobs;
+	int num_voice_jobs;
+	int32_t *voice_target[max_voices];
+
 
 	/* Ring voice id for each notes.  This ID enables duplicated note. */
 	uint8_t vidq_head[128 * MAX_CHANNELS], vidq_tail[128 * MAX_CHANNELS];
@@ -647,6 +655,10 @@ private:
 	void mix_signal(int32_t *dest, int32_t *src, int32_t count);
 	int is_insertion_effect_xg(int ch);
 	void do_compute_data(int32_t count);
+	int32_t *get_voice_buffer(int v, int channel_effect, int32_t **vpblist);
+	int mix_voices_parallel(int32_t count, int uv, int channel_effect, int32_t **vpblist);
+	void mix_voice_job(VoiceJob *job, int32_t count);
+	void free_voice_jobs(void);
 	int check_midi_play_end(MidiEvent *e, int len);
 	int midi_play_end(void);
 	void update_modulation_wheel(int ch);
@@ -0,0 +1,63 @@
+/*
+    TiMidity++ -- MIDI to WAVE converter and player
+    Copyright (C) 2020 QuestZDoom contributors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    threadpool.h
+*/
+
+#ifndef ___THREADPOOL_H_
+#define ___THREADPOOL_H_
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <vector>
+#include <atomic>
+
+namespace TimidityPlus
+{
+
+/* A small set of worker threads for mixing voices in parallel.
+   run() hands the jobs out to the workers and the calling thread and
+   only returns once all of them are finished. */
+class ThreadPool
+{
+	std::vector<std::thread> threads;
+	std::mutex lock;
+	std::condition_variable wake, done;
+	std::function<void(int)> job;
+	std::atomic<int> next_job;
+	int num_jobs = 0;
+	int jobs_done = 0;
+	int busy = 0;
+	unsigned generation = 0;
+	bool quit = false;
+
+	int run_jobs();
+	void worker_proc();
+
+public:
+	ThreadPool(int numthreads);
+	~ThreadPool();
+
+	int size() const { return (int)threads.size() + 1; }
+	void run(int numjobs, const std::function<void(int)> &func);
+};
+
+}
+#endif /* ___THREADPOOL_H_ */
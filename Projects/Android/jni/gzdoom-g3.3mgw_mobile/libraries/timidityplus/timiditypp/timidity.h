@@ -143,6 +143,7 @@ extern int timidity_key_adjust;
 extern float timidity_tempo_adjust;
 extern float min_sustain_time;
 extern int timidity_lpf_def;
+extern int timidity_render_threads;
 
 extern int32_t playback_rate;
 extern int32_t control_ratio;	// derived from playback_rate
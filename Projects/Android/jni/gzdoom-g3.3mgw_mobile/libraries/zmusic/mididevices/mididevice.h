@@ -1,6 +1,8 @@
 #pragma once
 
 #include <mutex>
+#include <thread>
+#include <atomic>
 #include "zmusic/midiconfig.h"
 #include "zmusic/mididefs.h"
 
@@ -63,6 +65,7 @@ protected:
 class SoftSynthMIDIDevice : public MIDIDevice
 {
 	friend class MIDIWaveWriter;
+	friend class MIDIRenderCache;
 public:
 	SoftSynthMIDIDevice(int samplerate, int minrate = 1, int maxrate = 1000000 /* something higher than any valid value */);
 	~SoftSynthMIDIDevice();
@@ -95,6 +98,9 @@ protected:
 	uint32_t Position;
 	int SampleRate;
 	int StreamBlockSize = 2;
+	int64_t FramesRendered = 0;		// output position, for the markers below.
+	int64_t LoopStartFrame = -1;	// position of the first loop markers, if any.
+	int64_t LoopEndFrame = -1;
 
 	virtual void CalcTickRate();
 	int PlayTick();
@@ -140,6 +146,83 @@ protected:
 };
 
 
+// Render cache for software synths ----------------------------------------
+//
+// Renders the song once as fast as the synth allows on a background thread
+// and stores the output as compressed PCM in a cache file. Playback reads
+// from that file, so later plays of the same song with the same synth and
+// settings don't need the synth at all.
+
+class MIDIRenderCache : public SoftSynthMIDIDevice
+{
+public:
+	static bool CanRender(int devtype);
+	static uint64_t MakeKey(uint64_t songhash, int subsong, int devtype, const char *args, int samplerate);
+	static MIDIRenderCache *OpenCache(uint64_t key, int devtype, bool looping);
+	static MIDIRenderCache *CreateWriter(uint64_t key, SoftSynthMIDIDevice *devtouse, std::mutex &songlock, bool looping);
+	~MIDIRenderCache();
+
+	int Open() override;
+	void Close() override;
+	bool IsOpen() const override;
+	int Resume() override;
+	void Stop() override;
+	bool Pause(bool paused) override;
+	int OpenRenderer() override { return 0; }
+	void HandleEvent(int status, int parm1, int parm2) override {}
+	void HandleLongEvent(const uint8_t *data, int len) override {}
+	void ComputeOutput(float *buffer, int len) override {}
+	int StreamOutSync(MidiHeader *data) override;
+	int StreamOut(MidiHeader *data) override;
+	int SetTempo(int tempo) override;
+	int SetTimeDiv(int timediv) override;
+	void CalcTickRate() override;
+	void InitPlayback() override;
+	void PrecacheInstruments(const uint16_t *instruments, int count) override;
+	void ChangeSettingInt(const char *setting, int value) override;
+	void ChangeSettingNum(const char *setting, double value) override;
+	void ChangeSettingString(const char *setting, const char *value) override;
+	bool CanHandleSysex() const override;
+	int GetDeviceType() const override { return DeviceType; }
+	bool ServiceStream(void *buff, int numbytes) override;
+	std::string GetStats() override;
+
+protected:
+	MIDIRenderCache(int samplerate, int devtype, bool looping);
+
+	bool ReadBlock(int block);
+	void RenderBlock();
+	void FinishRender();
+	void RenderProc();
+	int64_t FramesAvailable() const;
+	void GetLoop(int64_t &start, int64_t &end) const;
+
+	std::unique_ptr<SoftSynthMIDIDevice> playDevice;	// only while rendering
+	std::mutex *SongLock = nullptr;
+	std::thread Renderer;
+	std::atomic<bool> QuitRenderer{ false };
+	std::string FileName, ReadName;
+	std::string Signature;
+	uint64_t Key = 0;
+	FILE *Writer = nullptr;
+	FILE *Reader = nullptr;
+	std::vector<uint64_t> BlockOffsets;		// start of each block, followed by the end of the last one.
+	std::vector<uint8_t> Encoded;
+	std::vector<float> Samples;
+	int DecodedBlock = -1;
+	int64_t PlayFrame = 0;
+	int64_t TotalFrames = 0;
+	int64_t LoopStart = 0, LoopEnd = 0;
+	int DeviceType;
+	bool Looping;
+	bool Rendering = false;
+	bool Passthrough = false;		// the cache file could not be written, play the synth directly.
+	bool Discard = false;			// settings changed while rendering, don't keep the result.
+	bool Paused = false;
+	bool Finished = false;
+};
+
+
 // MIDI devices
 
 MIDIDevice *CreateFluidSynthMIDIDevice(int samplerate, const char *Args);
@@ -0,0 +1,938 @@
+/*
+** music_rendercache_mididevice.cpp
+** Renders a MIDI with one of the software synths to a compressed PCM
+** cache file and plays it back from there.
+**
+**---------------------------------------------------------------------------
+** Copyright 2020 QuestZDoom contributors
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** The cache file contains 16 bit stereo PCM in blocks of BLOCK_FRAMES
+** frames. Each channel of a block is coded with a fixed second order
+** predictor and Rice coded residuals, which roughly halves the size and
+** is cheap enough to decode on the streaming thread.
+**
+** The files are machine local, so everything is stored in native byte order.
+**
+*/
+
+// HEADER FILES ------------------------------------------------------------
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include "mididevice.h"
+#include "timiditypp/timidity.h"
+#include "../music_common/fileio.h"
+
+// MACROS ------------------------------------------------------------------
+
+enum
+{
+	CACHE_MAGIC = MAKE_ID('Z', 'M', 'R', 'C'),
+	CACHE_VERSION = 1,
+	BLOCK_FRAMES = 4096,
+	RICE_ESCAPE = 24,		// quotients this large store the residual verbatim.
+};
+
+// TYPES -------------------------------------------------------------------
+
+struct RenderCacheHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint64_t Key;
+	uint32_t SampleRate;
+	uint32_t NumBlocks;
+	int64_t TotalFrames;
+	int64_t LoopStart;
+	int64_t LoopEnd;
+	uint64_t TableOffset;	// NumBlocks + 1 block offsets
+};
+
+class BitWriter
+{
+	std::vector<uint8_t> &Out;
+	uint64_t Acc = 0;
+	int Bits = 0;
+
+public:
+	BitWriter(std::vector<uint8_t> &out) : Out(out) {}
+
+	void Put(uint32_t value, int count)
+	{
+		Acc |= uint64_t(value) << Bits;
+		Bits += count;
+		while (Bits >= 8)
+		{
+			Out.push_back(uint8_t(Acc));
+			Acc >>= 8;
+			Bits -= 8;
+		}
+	}
+
+	void Flush()
+	{
+		if (Bits > 0) Out.push_back(uint8_t(Acc));
+		Acc = 0;
+		Bits = 0;
+	}
+};
+
+class BitReader
+{
+	const uint8_t *Data, *End;
+	uint64_t Acc = 0;
+	int Bits = 0;
+
+public:
+	BitReader(const uint8_t *data, const uint8_t *end) : Data(data), End(end) {}
+
+	uint32_t Get(int count)
+	{
+		while (Bits <= 56)
+		{
+			// Reading past the end yields zeros, the block size check catches corrupt data.
+			Acc |= uint64_t(Data < End ? *Data++ : 0) << Bits;
+			Bits += 8;
+		}
+		uint32_t value = uint32_t(Acc & ((uint64_t(1) << count) - 1));
+		Acc >>= count;
+		Bits -= count;
+		return value;
+	}
+};
+
+// PRIVATE DATA DEFINITIONS ------------------------------------------------
+
+static int64_t RenderedFrames, CachedFrames;
+
+// CODE --------------------------------------------------------------------
+
+//==========================================================================
+//
+// EncodeBlock
+//
+// Block layout: uint32 frame count, then for each channel a byte with the
+// Rice parameter, a uint32 with the size of the coded data and the data.
+//
+//==========================================================================
+
+static void EncodeBlock(const float *samples, int frames, std::vector<uint8_t> &out)
+{
+	int16_t pcm[BLOCK_FRAMES];
+	uint32_t residual[BLOCK_FRAMES];
+
+	out.resize(4);
+	memcpy(out.data(), &frames, 4);
+
+	for (int ch = 0; ch < 2; ch++)
+	{
+		uint64_t sum = 0;
+		for (int i = 0; i < frames; i++)
+		{
+			float s = samples[i * 2 + ch] * 32767.f;
+			pcm[i] = int16_t(std::max(-32768.f, std::min(32767.f, roundf(s))));
+
+			int predicted = i >= 2 ? 2 * pcm[i - 1] - pcm[i - 2] : i == 1 ? pcm[0] : 0;
+			int r = pcm[i] - predicted;
+			residual[i] = (uint32_t(r) << 1) ^ uint32_t(r >> 31);
+			sum += residual[i];
+		}
+
+		int k = 0;
+		while (k < 20 && (uint64_t(frames) << (k + 1)) < sum) k++;
+
+		out.push_back(uint8_t(k));
+		size_t sizepos = out.size();
+		out.resize(sizepos + 4);
+
+		BitWriter bits(out);
+		for (int i = 0; i < frames; i++)
+		{
+			uint32_t q = residual[i] >> k;
+			if (q < RICE_ESCAPE)
+			{
+				bits.Put((1u << q) - 1, q + 1);	// unary, terminated by a 0 bit.
+				bits.Put(residual[i] & ((1u << k) - 1), k);
+			}
+			else
+			{
+				bits.Put((1u << RICE_ESCAPE) - 1, RICE_ESCAPE);
+				bits.Put(residual[i], 32);
+			}
+		}
+		bits.Flush();
+
+		uint32_t size = uint32_t(out.size() - sizepos - 4);
+		memcpy(&out[sizepos], &size, 4);
+	}
+}
+
+//==========================================================================
+//
+// DecodeBlock
+//
+//==========================================================================
+
+static int DecodeBlock(const uint8_t *data, size_t size, float *out)
+{
+	const uint8_t *end = data + size;
+	int frames;
+
+	if (size < 4) return 0;
+	memcpy(&frames, data, 4);
+	data += 4;
+	if (frames <= 0 || frames > BLOCK_FRAMES) return 0;
+
+	for (int ch = 0; ch < 2; ch++)
+	{
+		uint32_t chansize;
+		if (end - data < 5) return 0;
+		int k = *data++;
+		memcpy(&chansize, data, 4);
+		data += 4;
+		if (k > 20 || chansize > size_t(end - data)) return 0;
+
+		BitReader bits(data, data + chansize);
+		int p1 = 0, p2 = 0;
+		for (int i = 0; i < frames; i++)
+		{
+			uint32_t q = 0, u;
+			while (q < RICE_ESCAPE && bits.Get(1)) q++;
+			if (q == RICE_ESCAPE) u = bits.Get(32);
+			else u = (q << k) | bits.Get(k);
+
+			int r = int(u >> 1) ^ -int(u & 1);
+			int predicted = i >= 2 ? 2 * p1 - p2 : i == 1 ? p1 : 0;
+			int s = int16_t(predicted + r);
+			p2 = p1;
+			p1 = s;
+			out[i * 2 + ch] = s * (1.f / 32768.f);
+		}
+		data += chansize;
+	}
+	return frames;
+}
+
+//==========================================================================
+//
+// DeviceSignature
+//
+// Collects all settings that affect a synth's output so that changing any
+// of them creates a new cache entry.
+//
+//==========================================================================
+
+template<class T> static std::string str(T value)
+{
+	return std::to_string(value) + '|';
+}
+
+static std::string DeviceSignature(int devtype)
+{
+	switch (devtype)
+	{
+	case MDEV_GUS:
+		return gusConfig.gus_config + '|' + gusConfig.gus_patchdir + '|' + str(gusConfig.midi_voices) + str(gusConfig.gus_memsize) +
+			str(gusConfig.gus_dmxgus) + str(gusConfig.dmxgus.size());
+
+	case MDEV_TIMIDITY:
+	{
+		using namespace TimidityPlus;
+		std::lock_guard<std::mutex> lock(ConfigMutex);
+		return timidityConfig.timidity_config + '|' + str(timidity_modulation_wheel) + str(timidity_portamento) + str(timidity_reverb) +
+			str(timidity_chorus) + str(timidity_surround_chorus) + str(timidity_channel_pressure) + str(timidity_lpf_def) +
+			str(timidity_temper_control) + str(timidity_modulation_envelope) + str(timidity_overlap_voice_allow) +
+			str(timidity_drum_effect) + str(timidity_pan_delay) + str(timidity_drum_power) + str(timidity_key_adjust) +
+			str(timidity_tempo_adjust) + str(min_sustain_time);
+	}
+
+	case MDEV_FLUIDSYNTH:
+		return fluidConfig.fluid_patchset + '|' + str(fluidConfig.fluid_reverb) + str(fluidConfig.fluid_chorus) + str(fluidConfig.fluid_voices) +
+			str(fluidConfig.fluid_interp) + str(fluidConfig.fluid_samplerate) + str(fluidConfig.fluid_chorus_voices) +
+			str(fluidConfig.fluid_chorus_type) + str(fluidConfig.fluid_gain) + str(fluidConfig.fluid_reverb_roomsize) +
+			str(fluidConfig.fluid_reverb_damping) + str(fluidConfig.fluid_reverb_width) + str(fluidConfig.fluid_reverb_level) +
+			str(fluidConfig.fluid_chorus_level) + str(fluidConfig.fluid_chorus_speed) + str(fluidConfig.fluid_chorus_depth);
+
+	case MDEV_ADL:
+		return str(adlConfig.adl_chips_count) + str(adlConfig.adl_emulator_id) + str(adlConfig.adl_bank) + str(adlConfig.adl_volume_model) +
+			str(adlConfig.adl_run_at_pcm_rate) + str(adlConfig.adl_fullpan) + str(adlConfig.adl_use_custom_bank) + adlConfig.adl_custom_bank;
+
+	case MDEV_OPN:
+		return str(opnConfig.opn_chips_count) + str(opnConfig.opn_emulator_id) + str(opnConfig.opn_run_at_pcm_rate) + str(opnConfig.opn_fullpan) +
+			str(opnConfig.opn_use_custom_bank) + opnConfig.opn_custom_bank + '|' + str(opnConfig.default_bank.size());
+
+	case MDEV_WILDMIDI:
+		return wildMidiConfig.config + '|' + str(wildMidiConfig.reverb) + str(wildMidiConfig.enhanced_resampling);
+
+	default:
+		return "";
+	}
+}
+
+//==========================================================================
+//
+// CacheFileName
+//
+//==========================================================================
+
+static std::string CacheFileName(uint64_t key)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "/%016llx.zmc", (unsigned long long)key);
+	return miscConfig.snd_midirendercache_path + name;
+}
+
+//==========================================================================
+//
+// MIDIRenderCache :: CanRender										static
+//
+// Only synths that stream through SoftSynthMIDIDevice::ServiceStream can
+// be rendered. OPL has its own streaming and is cheap enough anyway.
+//
+//==========================================================================
+
+bool MIDIRenderCache::CanRender(int devtype)
+{
+	switch (devtype)
+	{
+	case MDEV_GUS:
+	case MDEV_TIMIDITY:
+	case MDEV_FLUIDSYNTH:
+	case MDEV_ADL:
+	case MDEV_OPN:
+	case MDEV_WILDMIDI:
+		return !miscConfig.snd_midirendercache_path.empty();
+
+	default:
+		return false;
+	}
+}
+
+//==========================================================================
+//
+// MIDIRenderCache :: MakeKey										static
+//
+//==========================================================================
+
+uint64_t MIDIRenderCache::MakeKey(uint64_t songhash, int subsong, int devtype, const char *args, int samplerate)
+{
+	std::string id = std::to_string(CACHE_VERSION) + '|' + std::to_string(songhash) + '|' + std::to_string(subsong) + '|' +
+		std::to_string(devtype) + '|' + std::to_string(samplerate) + '|' + (args ? args : "") + '|' + DeviceSignature(devtype);
+
+	uint64_t hash = 14695981039346656037ull;
+	for (auto c : id)
+	{
+		hash = (hash ^ uint8_t(c)) * 1099511628211ull;
+	}
+	return hash;
+}
+
+//==========================================================================
+//
+// MIDIRenderCache Constructor
+//
+//==========================================================================
+
+MIDIRenderCache::MIDIRenderCache(int samplerate, int devtype, bool looping)
+	: SoftSynthMIDIDevice(samplerate)
+{
+	DeviceType = devtype;
+	Looping = looping;
+	Samples.resize(BLOCK_FRAMES * 2);
+}
+
+//==========================================================================
+//
+// MIDIRenderCache :: OpenCache										static
+//
+// Returns a device that plays the cached file for this key, or nullptr
+// if there is no valid one.
+//
+//==========================================================================
+
+MIDIRenderCache *MIDIRenderCache::OpenCache(uint64_t key, int devtype, bool looping)
+{
+	if (!CanRender(devtype)) return nullptr;
+
+	auto filename = CacheFileName(key);
+	FILE *f = MusicIO::utf8_fopen(filename.c_str(), "rb");
+	if (f == nullptr) return nullptr;
+
+	RenderCacheHeader header;
+	std::vector<uint64_t> offsets;
+	bool valid = fread(&header, 1, sizeof(header), f) == sizeof(header) &&
+		header.Magic == CACHE_MAGIC && header.Version == CACHE_VERSION && header.Key == key &&
+		header.NumBlocks > 0 && header.TotalFrames <= int64_t(header.NumBlocks) * BLOCK_FRAMES &&
+		header.LoopStart >= 0 && header.LoopStart < header.LoopEnd && header.LoopEnd <= header.TotalFrames;
+
+	if (valid)
+	{
+		offsets.resize(header.NumBlocks + 1);
+		valid = fseek(f, long(header.TableOffset), SEEK_SET) == 0 &&
+			fread(offsets.data(), sizeof(uint64_t), offsets.size(), f) == offsets.size() &&
+			offsets[0] == sizeof(header) && offsets.back() == header.TableOffset &&
+			std::is_sorted(offsets.begin(), offsets.end());
+	}
+	if (!valid)
+	{
+		fclose(f);
+		remove(filename.c_str());
+		return nullptr;
+	}
+
+	auto cache = new MIDIRenderCache(header.SampleRate, devtype, looping);
+	cache->FileName = cache->ReadName = filename;
+	cache->Reader = f;
+	cache->BlockOffsets = std::move(offsets);
+	cache->TotalFrames = header.TotalFrames;
+	cache->LoopStart = header.LoopStart;
+	cache->LoopEnd = header.LoopEnd;
+	return cache;
+}
+
+//==========================================================================
+//
+// MIDIRenderCache :: CreateWriter									static
+//
+// Takes ownership of the device if successful. Playback reads back from
+// the file while it is being written. songlock is the lock the streaming
+// thread holds while servicing the stream, the render thread needs it too
+// because rendering advances the MIDIStreamer.
+//
+//==========================================================================
+
+MIDIRenderCache *MIDIRenderCache::CreateWriter(uint64_t key, SoftSynthMIDIDevice *devtouse, std::mutex &songlock, bool looping)
+{
+	int devtype = devtouse->GetDeviceType();
+	if (!CanRender(devtype)) return nullptr;
+
+	auto filename = CacheFileName(key);
+	auto tempname = filename + ".tmp";
+	FILE *writer = MusicIO::utf8_fopen(tempname.c_str(), "wb");
+	if (writer == nullptr) return nullptr;
+
+	RenderCacheHeader header = {};
+	FILE *reader = nullptr;
+	if (fwrite(&header, 1, sizeof(header), writer) != sizeof(header) || fflush(writer) != 0 ||
+		(reader = MusicIO::utf8_fopen(tempname.c_str(), "rb")) == nullptr)
+	{
+		fclose(writer);
+		remove(tempname.c_str());
+		return nullptr;
+	}
+
+	auto cache = new MIDIRenderCache(devtouse->GetSampleRate(), devtype, looping);
+	cache->playDevice.reset(devtouse);
+	cache->SongLock = &songlock;
+	cache->Key = key;
+	cache->FileName = filename;
+	cache->ReadName = tempname;
+	cache->Writer = writer;
+	cache->Reader = reader;
+	cache->BlockOffsets.push_back(sizeof(header));
+	cache->Signature = DeviceSignature(devtype);
+	cache->Rendering = true;
+	return cache;
+}
+
+//==========================================================================
+//
+// MIDIRenderCache Destructor
+//
+//==========================================================================
+
+MIDIRenderCache::~MIDIRenderCache()
+{
+	Stop();
+	Close();
+}
+
+//==========================================================================
+//
+// MIDIRenderCache :: Open
+//
+//==========================================================================
+
+int MIDIRenderCache::Open()
+{
+	isOpen = true;
+	if (playDevice != nullptr)
+	{
+		playDevice->SetCallback(Callback, CallbackData);
+		return playDevice->Open();
+	}
+	return 0;
+}
+
+//==========================================================================
+//
+// MIDIRenderCache :: Close
+//
+// An unfinished render is thrown away.
+//
+//==========================================================================
+
+void MIDIRenderCache::Close()
+{
+	if (Writer != nullptr)
+	{
+		fclose(Writer);
+		Writer = nullptr;
+	}
+	if (Reader != nullptr)
+	{
+		fclose(Reader);
+		Reader = nullptr;
+	}
+	if (Rendering || Discard)
+	{
+		remove(ReadName.c_str());
+		Rendering = Discard = false;
+	}
+	if (playDevice != nullptr)
+	{
+		playDevice->Close();
+	}
+	isOpen = false;
+	Started = false;
+}
+
+//==========================================================================
+//
+// MIDIRenderCache :: IsOpen
+//
+//==========================================================================
+
+bool MIDIRenderCache::IsOpen() const
+{
+	return isOpen && !Finished;
+}
+
+//==========================================================================
+//
+// MIDIRenderCache :: Resume
+//
+// The initial buffers have been queued, so the renderer can start.
+//
+//==========================================================================
+
+int MIDIRenderCache::Resume()
+{
+	Started = true;
+	if (Rendering && !Renderer.joinable())
+	{
+		QuitRenderer = false;
+		Renderer = std::thread([this]() { RenderProc(); });
+	}
+	return 0;
+}
+
+//==========================================================================
+//
+// MIDIRenderCache :: Stop
+//
+//==========================================================================
+
+void MIDIRenderCache::Stop()
+{
+	if (Renderer.joinable())
+	{
+		QuitRenderer = true;
+		Renderer.join();
+	}
+}
+
+//==========================================================================
+//
+// MIDIRenderCache :: Pause
+//
+// The render must not continue while paused because the MIDIStreamer
+// only outputs NOPs in that state.
+//
+//==========================================================================
+
+bool MIDIRenderCache::Pause(bool paused)
+{
+	Paused = paused;
+	return true;
+}
+
+//==========================================================================
+//
+// MIDIRenderCache :: forwarders to the rendering device
+//
+// When playing a finished cache file all MIDI data is ignored.
+//
+//==========================================================================
+
+int MIDIRenderCache::StreamOutSync(MidiHeader *data)
+{
+	return playDevice != nullptr ? playDevice->StreamOutSync(data) : 0;
+}
+
+int MIDIRenderCache::StreamOut(MidiHeader *data)
+{
+	return playDevice != nullptr ? playDevice->StreamOut(data) : 0;
+}
+
+int MIDIRenderCache::SetTempo(int tempo)
+{
+	return playDevice != nullptr ? playDevice->SetTempo(tempo) : 0;
+}
+
+int MIDIRenderCache::SetTimeDiv(int timediv)
+{
+	return playDevice != nullptr ? playDevice->SetTimeDiv(timediv) : 0;
+}
+
+void MIDIRenderCache::CalcTickRate()
+{
+	if (playDevice != nullptr) playDevice->CalcTickRate();
+}
+
+void MIDIRenderCache::InitPlayback()
+{
+	if (playDevice != nullptr) playDevice->InitPlayback();
+}
+
+void MIDIRenderCache::PrecacheInstruments(const uint16_t *instruments, int count)
+{
+	if (playDevice != nullptr) playDevice->PrecacheInstruments(instruments, count);
+}
+
+bool MIDIRenderCache::CanHandleSysex() const
+{
+	return playDevice != nullptr ? playDevice->CanHandleSysex() : true;
+}
+
+void MIDIRenderCache::ChangeSettingInt(const char *setting, int value)
+{
+	if (playDevice != nullptr)
+	{
+		playDevice->ChangeSettingInt(setting, value);
+		Discard = true;
+	}
+}
+
+void MIDIRenderCache::ChangeSettingNum(const char *setting, double value)
+{
+	if (playDevice != nullptr)
+	{
+		playDevice->ChangeSettingNum(setting, value);
+		Discard = true;
+	}
+}
+
+void MIDIRenderCache::ChangeSettingString(const char *setting, const char *value)
+{
+	if (playDevice != nullptr)
+	{
+		playDevice->ChangeSettingString(setting, value);
+		Discard = true;
+	}
+}
+
+//==========================================================================
+//
+// MIDIRenderCache :: RenderProc
+//
+// Background thread that renders ahead of playback as fast as possible.
+// Stop() is called with the song lock held, so this must never block on it.
+//
+//==========================================================================
+
+void MIDIRenderCache::RenderProc()
+{
+	while (!QuitRenderer)
+	{
+		if (Paused || !SongLock->try_lock())
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			continue;
+		}
+		if (Rendering && !Passthrough && !Paused)
+		{
+			RenderBlock();
+		}
+		bool done = !Rendering || Passthrough;
+		SongLock->unlock();
+		if (done) break;
+		std::this_thread::yield();
+	}
+}
+
+//==========================================================================
+//
+// MIDIRenderCache :: RenderBlock
+//
+// Must be called with the song lock held.
+//
+//==========================================================================
+
+void MIDIRenderCache::RenderBlock()
+{
+	bool more = playDevice->ServiceStream(Samples.data(), BLOCK_FRAMES * 2 * sizeof(float));
+	EncodeBlock(Samples.data(), BLOCK_FRAMES, Encoded);
+	DecodedBlock = -1;
+
+	if (fwrite(Encoded.data(), 1, Encoded.size(), Writer) != Encoded.size() || fflush(Writer) != 0)
+	{
+		// Continue with what has been written so far, then hand over to the synth.
+		Passthrough = true;
+		Discard = true;
+		return;
+	}
+	BlockOffsets.push_back(BlockOffsets.back() + Encoded.size());
+	TotalFrames += BLOCK_FRAMES;
+	RenderedFrames += BLOCK_FRAMES;
+
+	if (!more)
+	{
+		FinishRender();
+	}
+}
+
+//==========================================================================
+//
+// MIDIRenderCache :: FinishRender
+//
+// Writes the block table and the final header and moves the file to its
+// real name. The synth's loop markers become the loop points.
+//
+//==========================================================================
+
+void MIDIRenderCache::FinishRender()
+{
+	Rendering = false;
+	LoopStart = std::max<int64_t>(playDevice->LoopStartFrame, 0);
+	LoopEnd = playDevice->LoopEndFrame > 0 ? std::min(playDevice->LoopEndFrame, TotalFrames) : TotalFrames;
+	if (LoopStart >= LoopEnd) LoopStart = 0;
+
+	if (Discard || DeviceSignature(DeviceType) != Signature)
+	{
+		Discard = true;
+		return;
+	}
+
+	RenderCacheHeader header;
+	header.Magic = CACHE_MAGIC;
+	header.Version = CACHE_VERSION;
+	header.Key = Key;
+	header.SampleRate = SampleRate;
+	header.NumBlocks = uint32_t(BlockOffsets.size() - 1);
+	header.TotalFrames = TotalFrames;
+	header.LoopStart = LoopStart;
+	header.LoopEnd = LoopEnd;
+	header.TableOffset = BlockOffsets.back();
+
+	bool ok = fwrite(BlockOffsets.data(), sizeof(uint64_t), BlockOffsets.size(), Writer) == BlockOffsets.size() &&
+		fseek(Writer, 0, SEEK_SET) == 0 &&
+		fwrite(&header, 1, sizeof(header), Writer) == sizeof(header);
+	ok = fclose(Writer) == 0 && ok;
+	Writer = nullptr;
+
+	if (!ok)
+	{
+		Discard = true;
+		return;
+	}
+
+	// Some platforms cannot rename open files.
+	fclose(Reader);
+	Reader = nullptr;
+	remove(FileName.c_str());
+	if (rename(ReadName.c_str(), FileName.c_str()) == 0)
+	{
+		ReadName = FileName;
+	}
+	else
+	{
+		Discard = true;
+	}
+	Reader = MusicIO::utf8_fopen(ReadName.c_str(), "rb");
+	if (Reader == nullptr)
+	{
+		Finished = true;
+	}
+}
+
+//==========================================================================
+//
+// MIDIRenderCache :: FramesAvailable
+//
+//==========================================================================
+
+int64_t MIDIRenderCache::FramesAvailable() const
+{
+	return int64_t(BlockOffsets.size() - 1) * BLOCK_FRAMES;
+}
+
+//==========================================================================
+//
+// MIDIRenderCache :: GetLoop
+//
+// While rendering, the loop end is not known until the synth has played
+// the corresponding marker.
+//
+//==========================================================================
+
+void MIDIRenderCache::GetLoop(int64_t &start, int64_t &end) const
+{
+	if (!Rendering)
+	{
+		start = LoopStart;
+		end = LoopEnd;
+	}
+	else
+	{
+		start = std::max<int64_t>(playDevice->LoopStartFrame, 0);
+		end = playDevice->LoopEndFrame;
+		if (end >= 0 && start >= end) start = 0;
+	}
+}
+
+//==========================================================================
+//
+// MIDIRenderCache :: ReadBlock
+//
+//==========================================================================
+
+bool MIDIRenderCache::ReadBlock(int block)
+{
+	uint64_t size = BlockOffsets[block + 1] - BlockOffsets[block];
+	std::vector<uint8_t> data(size);
+
+	if (Reader == nullptr || fseek(Reader, long(BlockOffsets[block]), SEEK_SET) != 0 ||
+		fread(data.data(), 1, size, Reader) != size ||
+		DecodeBlock(data.data(), size, Samples.data()) != BLOCK_FRAMES)
+	{
+		return false;
+	}
+	DecodedBlock = block;
+	return true;
+}
+
+//==========================================================================
+//
+// MIDIRenderCache :: ServiceStream
+//
+// If playback catches up with the renderer, the next block is rendered
+// right here. Otherwise the synth isn't touched at all.
+//
+//==========================================================================
+
+bool MIDIRenderCache::ServiceStream(void *buff, int numbytes)
+{
+	float *out = (float *)buff;
+	int frames = numbytes / (2 * sizeof(float));
+
+	while (frames > 0)
+	{
+		int64_t loopstart, loopend;
+		GetLoop(loopstart, loopend);
+		int64_t end = Rendering || Passthrough ? FramesAvailable() : TotalFrames;
+
+		if (Looping && loopend > 0 && PlayFrame >= loopend)
+		{
+			PlayFrame = loopstart;
+			continue;
+		}
+		if (PlayFrame >= end)
+		{
+			if (Passthrough)
+			{
+				return playDevice->ServiceStream(out, frames * 2 * sizeof(float));
+			}
+			if (Rendering)
+			{
+				if (Paused)
+				{
+					break;
+				}
+				RenderBlock();
+				continue;
+			}
+			if (!Looping || end == 0)
+			{
+				Finished = true;
+				break;
+			}
+			PlayFrame = loopstart;
+			continue;
+		}
+
+		int block = int(PlayFrame / BLOCK_FRAMES);
+		if (block != DecodedBlock && !ReadBlock(block))
+		{
+			Finished = true;
+			break;
+		}
+
+		int offset = int(PlayFrame % BLOCK_FRAMES);
+		if (Looping && loopend > 0) end = std::min(end, loopend);
+		int count = int(std::min<int64_t>({ int64_t(frames), BLOCK_FRAMES - offset, end - PlayFrame }));
+
+		memcpy(out, &Samples[offset * 2], count * 2 * sizeof(float));
+		out += count * 2;
+		frames -= count;
+		PlayFrame += count;
+		CachedFrames += count;
+	}
+
+	if (frames > 0)
+	{
+		memset(out, 0, frames * 2 * sizeof(float));
+	}
+	return !Finished;
+}
+
+//==========================================================================
+//
+// MIDIRenderCache :: GetStats
+//
+//==========================================================================
+
+std::string MIDIRenderCache::GetStats()
+{
+	char buffer[200];
+	double rate = SampleRate;
+
+	if (Rendering)
+	{
+		snprintf(buffer, sizeof(buffer), "Rendering to cache: %.1fs rendered, %.1fs played%s\n",
+			TotalFrames / rate, PlayFrame / rate, Passthrough ? " (cache write failed)" : "");
+		return buffer + playDevice->GetStats();
+	}
+	snprintf(buffer, sizeof(buffer), "Playing from render cache: %.1f/%.1fs, loop %.1f-%.1fs%s\nTotal: %.1fs rendered, %.1fs played from cache",
+		PlayFrame / rate, TotalFrames / rate, LoopStart / rate, LoopEnd / rate, Discard ? " (not kept)" : "",
+		RenderedFrames / rate, CachedFrames / rate);
+	return buffer;
+}
@@ -113,6 +113,8 @@ int SoftSynthMIDIDevice::Open()
 	Tempo = 500000;
 	Division = 100;
 	CalcTickRate();
+	FramesRendered = 0;
+	LoopStartFrame = LoopEndFrame = -1;
 	isOpen = true;
 	return OpenRenderer();
 }
@@ -292,6 +294,17 @@ int SoftSynthMIDIDevice::PlayTick()
 		{
 			HandleLongEvent((uint8_t *)&event[3], MEVENT_EVENTPARM(event[2]));
 		}
+		else if (MEVENT_EVENTTYPE(event[2]) == MEVENT_NOP)
+		{ // Position markers are only present when rendering to the cache.
+			if (MEVENT_EVENTPARM(event[2]) == MMARK_LOOPSTART && LoopStartFrame < 0)
+			{
+				LoopStartFrame = FramesRendered;
+			}
+			else if (MEVENT_EVENTPARM(event[2]) == MMARK_LOOPEND && LoopEndFrame < 0)
+			{
+				LoopEndFrame = FramesRendered;
+			}
+		}
 		else if (MEVENT_EVENTTYPE(event[2]) == 0)
 		{ // Short MIDI event
 			int status = event[2] & 0xff;
@@ -383,6 +396,7 @@ bool SoftSynthMIDIDevice::ServiceStream (void *buff, int numbytes)
 		{
 			ComputeOutput(samples1, samplesleft);
 			assert(NextTickIn == ticky);
+			FramesRendered += samplesleft;
 			NextTickIn -= samplesleft;
 			assert(NextTickIn >= 0);
 			numsamples -= samplesleft;
@@ -398,6 +412,7 @@ bool SoftSynthMIDIDevice::ServiceStream (void *buff, int numbytes)
 				if (numsamples > 0)
 				{
 					ComputeOutput(samples1, numsamples);
+					FramesRendered += numsamples;
 				}
 				res = false;
 				break;
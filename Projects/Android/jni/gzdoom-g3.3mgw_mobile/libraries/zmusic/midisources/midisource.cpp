@@ -95,6 +95,25 @@ int MIDISource::ClampLoopCount(int loopcount)
 	return loopcount;
 }
 
+//==========================================================================
+//
+// MIDISource :: MarkLoop
+//
+// When rendering to the cache, an infinite loop is not repeated. Instead
+// the song plays through once and the loop's start and end are marked in
+// the event stream so that the PCM data can be looped at the same place.
+// The passed event must be a NOP that is going to be output.
+//
+//==========================================================================
+
+void MIDISource::MarkLoop(uint32_t *event, int marker)
+{
+	if (MarkLoops)
+	{
+		event[2] = (MEVENT_NOP << 24) | marker;
+	}
+}
+
 //==========================================================================
 //
 // MIDISource :: VolumeControllerChange
@@ -495,6 +514,16 @@ DLL_EXPORT ZMusic_MidiSource ZMusic_CreateMIDISource(const uint8_t *data, size_t
 			source = nullptr;
 			break;
 		}
+		if (source != nullptr)
+		{
+			// FNV-1a, used to identify the song in the render cache.
+			uint64_t hash = 14695981039346656037ull;
+			for (size_t i = 0; i < length; i++)
+			{
+				hash = (hash ^ data[i]) * 1099511628211ull;
+			}
+			source->DataHash = hash ^ miditype;
+		}
 		return source;
 	}
 	catch (const std::exception & ex)
@@ -40,10 +40,13 @@ protected:
 	int VolumeControllerChange(int channel, int volume);
 	void SetTempo(int new_tempo);
 	int ClampLoopCount(int loopcount);
+	void MarkLoop(uint32_t *event, int marker);
 
 	
 public:
 	bool Exporting = false;
+	bool MarkLoops = false;		// emit position markers for infinite loops (render cache)
+	uint64_t DataHash = 0;		// identifies the song data (render cache)
 
 	// Virtuals for subclasses to override
 	virtual ~MIDISource() {}
@@ -484,6 +484,7 @@ uint32_t *MIDISong2::SendCommand (uint32_t *events, TrackInfo *track, uint32_t d
 						track->LoopDelay = 0;
 						track->LoopCount = loopcount == 0 ? 0 : loopcount - 1;
 						track->LoopFinished = track->Finished;
+						if (loopcount == 0) MarkLoop(events, MMARK_LOOPSTART);
 					}
 				}
 				event = MIDI_META;
@@ -495,6 +496,7 @@ uint32_t *MIDISong2::SendCommand (uint32_t *events, TrackInfo *track, uint32_t d
 					if (track->LoopCount == 0 && !isLooping)
 					{
 						track->Finished = true;
+						MarkLoop(events, MMARK_LOOPEND);
 					}
 					else
 					{
@@ -522,6 +524,7 @@ uint32_t *MIDISong2::SendCommand (uint32_t *events, TrackInfo *track, uint32_t d
 							Tracks[i].LoopCount = loopcount == 0 ? 0 : loopcount - 1;
 							Tracks[i].LoopFinished = Tracks[i].Finished;
 						}
+						if (loopcount == 0) MarkLoop(events, MMARK_LOOPSTART);
 					}
 				}
 				event = MIDI_META;
@@ -537,6 +540,7 @@ uint32_t *MIDISong2::SendCommand (uint32_t *events, TrackInfo *track, uint32_t d
 							if (Tracks[i].LoopCount == 0 && !isLooping)
 							{
 								Tracks[i].Finished = true;
+								MarkLoop(events, MMARK_LOOPEND);
 							}
 							else
 							{
@@ -641,7 +645,7 @@ uint32_t *MIDISong2::SendCommand (uint32_t *events, TrackInfo *track, uint32_t d
 		track->Delay = track->ReadVarLen();
 	}
 	// Advance events pointer unless this is a non-delaying NOP.
-	if (events[0] != 0 || MEVENT_EVENTTYPE(events[2]) != MEVENT_NOP)
+	if (events[0] != 0 || events[2] != (MEVENT_NOP << 24))
 	{
 		if (MEVENT_EVENTTYPE(events[2]) == MEVENT_LONGMSG)
 		{
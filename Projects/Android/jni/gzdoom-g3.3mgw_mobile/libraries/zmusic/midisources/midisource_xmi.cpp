@@ -442,6 +442,7 @@ uint32_t *XMISong::SendCommand (uint32_t *events, EventSource due, uint32_t dela
 					track->ForLoops[track->ForDepth].LoopBegin = track->EventP;
 					track->ForLoops[track->ForDepth].LoopCount = ClampLoopCount(data2);
 					track->ForLoops[track->ForDepth].LoopFinished = track->Finished;
+					if (track->ForLoops[track->ForDepth].LoopCount == 0) MarkLoop(events, MMARK_LOOPSTART);
 				}
 				track->ForDepth++;
 				event = MIDI_META;
@@ -453,6 +454,10 @@ uint32_t *XMISong::SendCommand (uint32_t *events, EventSource due, uint32_t dela
 					int depth = track->ForDepth - 1;
 					if (depth < MAX_FOR_DEPTH)
 					{
+						if (data2 >= 64 && track->ForLoops[depth].LoopCount == 0 && !isLooping)
+						{
+							MarkLoop(events, MMARK_LOOPEND);
+						}
 						if (data2 < 64 || (track->ForLoops[depth].LoopCount == 0 && !isLooping))
 						{ // throw away this loop.
 							track->ForLoops[depth].LoopCount = 1;
@@ -560,7 +565,7 @@ uint32_t *XMISong::SendCommand (uint32_t *events, EventSource due, uint32_t dela
 		track->Delay = track->ReadDelay();
 	}
 	// Advance events pointer unless this is a non-delaying NOP.
-	if (events[0] != 0 || MEVENT_EVENTTYPE(events[2]) != MEVENT_NOP)
+	if (events[0] != 0 || events[2] != (MEVENT_NOP << 24))
 	{
 		if (MEVENT_EVENTTYPE(events[2]) == MEVENT_LONGMSG)
 		{
@@ -111,6 +111,7 @@ protected:
 
 	static EMidiDevice SelectMIDIDevice(EMidiDevice devtype);
 	MIDIDevice* CreateMIDIDevice(EMidiDevice devtype, int samplerate);
+	MIDIDevice* CreateRenderCacheDevice(EMidiDevice devtype, int subsong);
 
 	static void Callback(void* userdata);
 
@@ -133,6 +134,7 @@ protected:
 	uint32_t Volume;
 	EMidiDevice DeviceType;
 	bool CallbackIsThreaded;
+	bool RenderingCache = false;	// the song is played once without looping, the render cache does the looping.
 	int LoopLimit;
 	std::string Args;
 	std::unique_ptr<MIDISource> source;
@@ -369,10 +371,60 @@ void MIDIStreamer::Play(bool looping, int subsong)
 	m_Looping = looping;
 	source->SetMIDISubsong(subsong);
 	devtype = SelectMIDIDevice(DeviceType);
-	MIDI.reset(CreateMIDIDevice(devtype, miscConfig.snd_outputrate));
+	RenderingCache = false;
+	if (miscConfig.snd_midirendercache)
+	{
+		MIDI.reset(CreateRenderCacheDevice(devtype, subsong));
+	}
+	if (MIDI == nullptr)
+	{
+		MIDI.reset(CreateMIDIDevice(devtype, miscConfig.snd_outputrate));
+	}
+	source->MarkLoops = RenderingCache;
 	InitPlayback();
 }
 
+//==========================================================================
+//
+// MIDIStreamer :: CreateRenderCacheDevice
+//
+// Returns a device that plays the song from the render cache, rendering
+// it first if necessary, or nullptr if the song should be played directly.
+//
+//==========================================================================
+
+MIDIDevice *MIDIStreamer::CreateRenderCacheDevice(EMidiDevice devtype, int subsong)
+{
+	int samplerate = miscConfig.snd_outputrate;
+
+	if (devtype == MDEV_SNDSYS) devtype = MDEV_FLUIDSYNTH;
+	if (!MIDIRenderCache::CanRender(devtype)) return nullptr;
+
+	uint64_t key = MIDIRenderCache::MakeKey(source->DataHash, subsong, devtype, Args.c_str(), samplerate);
+	MIDIDevice *dev = MIDIRenderCache::OpenCache(key, devtype, m_Looping);
+	if (dev != nullptr) return dev;
+
+	// If device creation falls back to another synth, cache that one instead.
+	dev = CreateMIDIDevice(devtype, samplerate);
+	int realtype = dev->GetDeviceType();
+	if (realtype != devtype)
+	{
+		if (!MIDIRenderCache::CanRender(realtype)) return dev;
+		key = MIDIRenderCache::MakeKey(source->DataHash, subsong, realtype, Args.c_str(), samplerate);
+		auto cached = MIDIRenderCache::OpenCache(key, realtype, m_Looping);
+		if (cached != nullptr)
+		{
+			delete dev;
+			return cached;
+		}
+	}
+
+	auto writer = MIDIRenderCache::CreateWriter(key, static_cast<SoftSynthMIDIDevice*>(dev), CritSec, m_Looping);
+	if (writer == nullptr) return dev;
+	RenderingCache = true;
+	return writer;
+}
+
 //==========================================================================
 //
 // MIDIStreamer :: DumpWave
@@ -382,8 +434,10 @@ void MIDIStreamer::Play(bool looping, int subsong)
 bool MIDIStreamer::DumpWave(const char *filename, int subsong, int samplerate)
 {
 	m_Looping = false;
+	RenderingCache = false;
 	if (source == nullptr) return false;	// We have nothing to play so abort.
 	source->SetMIDISubsong(subsong);
+	source->MarkLoops = false;
 
 	assert(MIDI == NULL);
 	auto devtype = SelectMIDIDevice(DeviceType);
@@ -462,7 +516,7 @@ void MIDIStreamer::StartPlayback()
 {
 	auto data = source->PrecacheData();
 	MIDI->PrecacheInstruments(data.data(), (int)data.size());
-	source->StartPlayback(m_Looping);
+	source->StartPlayback(m_Looping && !RenderingCache);
 	
 	// Set time division and tempo.
 	if (0 != MIDI->SetTimeDiv(source->getDivision()) ||
@@ -581,7 +635,8 @@ void MIDIStreamer::Stop()
 
 bool MIDIStreamer::IsPlaying()
 {
-	if (m_Status != STATE_Stopped && (MIDI == NULL || (EndQueued != 0 && EndQueued < 4)))
+	// When rendering to the cache the song end is reached long before playback ends.
+	if (m_Status != STATE_Stopped && (MIDI == NULL || (!RenderingCache && EndQueued != 0 && EndQueued < 4)))
 	{
 		std::lock_guard<std::mutex> lock(CritSec);
 		Stop();
@@ -767,7 +822,7 @@ fill:
 		break;
 
 	case SONG_DONE:
-		if (m_Looping)
+		if (m_Looping && !RenderingCache)
 		{
 			Restarting = true;
 			goto fill;
@@ -896,6 +951,13 @@ int MIDIStreamer::FillStopBuffer(int buffer_num)
 	uint32_t *events = Events[buffer_num];
 	int i;
 
+	if (RenderingCache)
+	{ // This is where a looping song would restart.
+		events[0] = 0;
+		events[1] = 0;
+		events[2] = (MEVENT_NOP << 24) | MMARK_LOOPEND;
+		events += 3;
+	}
 	events = WriteStopNotes(events);
 
 	// wait some tics, just so that this buffer takes some time
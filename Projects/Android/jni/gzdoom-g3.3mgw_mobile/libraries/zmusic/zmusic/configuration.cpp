@@ -40,6 +40,7 @@
 #include "timidity/timidity.h"
 #include "timiditypp/timidity.h"
 #include "oplsynth/oplio.h"
+#include "oplsynth/opl.h"
 #include "../../libraries/dumb/include/dumb.h"
 
 #include "zmusic_internal.h"
@@ -542,6 +543,13 @@ DLL_EXPORT bool ChangeMusicSettingInt(EIntConfigKey key, MusInfo *currSong, int
 			ChangeVarSync(TimidityPlus::timidity_key_adjust, value);
 			if (pRealValue) *pRealValue = value;
 			return false;
+
+		case zmusic_timidity_render_threads:
+			if (value < 0) value = 0;
+			else if (value > 8) value = 8;
+			ChangeVarSync(TimidityPlus::timidity_render_threads, value);
+			if (pRealValue) *pRealValue = value;
+			return false;
 			
 		case zmusic_wildmidi_reverb:
 			if (currSong != NULL)
@@ -612,6 +620,15 @@ DLL_EXPORT bool ChangeMusicSettingInt(EIntConfigKey key, MusInfo *currSong, int
 			miscConfig.snd_outputrate = value;
 			return false;
 
+		case zmusic_snd_midirendercache:
+			ChangeAndReturn(miscConfig.snd_midirendercache, value, pRealValue);
+			return false;	// only takes effect for next song.
+
+		case zmusic_snd_synthsimd:
+			ChangeAndReturn(miscConfig.snd_synthsimd, value, pRealValue);
+			Timidity::simd_mixing = opl_simd_mixing = !!value;
+			return false;
+
 	}
 	return false;
 }
@@ -806,6 +823,10 @@ DLL_EXPORT bool ChangeMusicSettingString(EStringConfigKey key, MusInfo* currSong
 		case zmusic_wildmidi_config:
 			wildMidiConfig.config = value;
 			return devType() == MDEV_TIMIDITY;
+
+		case zmusic_snd_midirendercache_path:
+			miscConfig.snd_midirendercache_path = value;
+			return false;
 			
 	}
 	return false;
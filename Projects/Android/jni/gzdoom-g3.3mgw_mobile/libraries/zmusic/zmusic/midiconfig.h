@@ -144,6 +144,9 @@ struct MiscConfig
 	float snd_musicvolume = 1.f;
 	float relative_volume = 1.f;
 	float snd_mastervolume = 1.f;
+	int snd_midirendercache = false;
+	std::string snd_midirendercache_path;
+	int snd_synthsimd = true;
 };
 
 extern ADLConfig adlConfig;
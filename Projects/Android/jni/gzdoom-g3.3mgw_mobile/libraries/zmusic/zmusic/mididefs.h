@@ -17,6 +17,14 @@ enum EMidiEvent : uint8_t
 	MEVENT_LONGMSG = 128,
 };
 
+// Parameters for MEVENT_NOP. Nonzero values mark song positions for the render cache.
+enum EMidiMarker
+{
+	MMARK_NONE = 0,
+	MMARK_LOOPSTART = 1,
+	MMARK_LOOPEND = 2,
+};
+
 #ifndef MAKE_ID
 #ifndef __BIG_ENDIAN__
 #define MAKE_ID(a,b,c,d)	((uint32_t)((a)|((b)<<8)|((c)<<16)|((d)<<24)))
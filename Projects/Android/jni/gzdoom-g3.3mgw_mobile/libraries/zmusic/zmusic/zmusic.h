@@ -117,6 +117,7 @@ enum EIntConfigKey
 	zmusic_timidity_drum_effect,
 	zmusic_timidity_pan_delay,
 	zmusic_timidity_key_adjust,
+	zmusic_timidity_render_threads,
 
 	zmusic_wildmidi_reverb,
 	zmusic_wildmidi_enhanced_resampling,
@@ -135,6 +136,8 @@ enum EIntConfigKey
 	
 	zmusic_snd_mididevice,
 	zmusic_snd_outputrate,
+	zmusic_snd_midirendercache,
+	zmusic_snd_synthsimd,
 
 	NUM_ZMUSIC_INT_CONFIGS
 };
@@ -174,6 +177,7 @@ enum EStringConfigKey
 	zmusic_gus_patchdir,
 	zmusic_timidity_config,
 	zmusic_wildmidi_config,
+	zmusic_snd_midirendercache_path,
 
 	NUM_STRING_CONFIGS
 };
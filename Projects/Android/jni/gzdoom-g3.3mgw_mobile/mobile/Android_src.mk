@@ -99,6 +99,7 @@ FASTMATH_SOURCES = \
 	gl/scene/gl_bsp.cpp \
 	gl/scene/gl_fakeflat.cpp \
 	gl/scene/gl_clipper.cpp \
+	gl/scene/gl_occlusion.cpp \
 	gl/scene/gl_decal.cpp \
 	gl/scene/gl_drawinfo.cpp \
 	gl/scene/gl_flats.cpp \
@@ -149,6 +150,8 @@ PCH_SOURCES = \
 	d_main.cpp \
 	d_stats.cpp \
 	d_net.cpp \
+	d_playsim.cpp \
+	d_startupprofile.cpp \
 	d_netinfo.cpp \
 	d_protocol.cpp \
 	decallib.cpp \
@@ -250,6 +253,7 @@ PCH_SOURCES = \
 	sound/s_sndseq.cpp \
 	sound/s_doomsound.cpp \
 	sound/s_sound.cpp \
+	sound/s_soundcache.cpp \
 	sound/s_music.cpp \
 	s_playlist.cpp \
 	serializer.cpp \
@@ -260,6 +264,7 @@ PCH_SOURCES = \
 	stats.cpp \
 	stringtable.cpp \
 	teaminfo.cpp \
+	threadpool.cpp \
 	umapinfo.cpp \
 	v_blend.cpp \
 	v_collection.cpp \
@@ -432,6 +437,7 @@ PCH_SOURCES = \
 	scripting/zscript/ast.cpp \
 	scripting/zscript/zcc_compile.cpp \
 	scripting/zscript/zcc_parser.cpp \
+	scripting/zscript/zcc_tokencache.cpp \
 	sfmt/SFMT.cpp \
 	sound/music/i_music.cpp \
 	sound/music/i_soundfont.cpp \
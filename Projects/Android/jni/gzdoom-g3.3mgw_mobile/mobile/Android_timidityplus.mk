@@ -36,6 +36,7 @@ LOCAL_SRC_FILES =  	\
         	smplfile.cpp \
         	sndfont.cpp \
         	tables.cpp \
+        	threadpool.cpp \
 
 
 
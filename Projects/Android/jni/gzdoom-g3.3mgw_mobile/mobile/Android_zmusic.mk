@@ -36,6 +36,7 @@ i_module.cpp \
 	mididevices/music_timidity_mididevice.cpp \
 	mididevices/music_wildmidi_mididevice.cpp \
 	mididevices/music_wavewriter_mididevice.cpp \
+	mididevices/music_rendercache_mididevice.cpp \
 	midisources/midisource.cpp \
 	midisources/midisource_mus.cpp \
 	midisources/midisource_smf.cpp \
@@ -907,6 +907,14 @@ void AddToConsole (int printlevel, const char *text)
 #define LOGI(...) ((void)__android_log_print(ANDROID_LOG_INFO,"Gzdoom", __VA_ARGS__))
 #endif
 
+// Output of the current thread is collected here instead of printed if set.
+static thread_local FString *CapturedOutput;
+
+void C_CaptureOutput(FString *buffer)
+{
+	CapturedOutput = buffer;
+}
+
 /* Adds a string to the console and also to the notify buffer */
 int PrintString (int printlevel, const char *outline)
 {
@@ -918,6 +926,12 @@ int PrintString (int printlevel, const char *outline)
 	{
 		return 0;
 	}
+	if (CapturedOutput != nullptr)
+	{
+		// The console can only be accessed by the main thread, which prints this later.
+		if (printlevel != PRINT_LOG) *CapturedOutput += outline;
+		return (int)strlen(outline);
+	}
 	if (printlevel != PRINT_LOG || Logfile != nullptr)
 	{
 		// Convert everything coming through here to UTF-8 so that all console text is in a consistent format
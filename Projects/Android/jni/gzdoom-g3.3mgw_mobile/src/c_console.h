@@ -38,6 +38,7 @@
 #include "basictypes.h"
 
 struct event_t;
+class FString;
 
 #define C_BLINKRATE			(TICRATE/2)
 
@@ -65,6 +66,7 @@ void C_Ticker (void);
 
 void AddToConsole (int printlevel, const char *string);
 int PrintString (int printlevel, const char *string);
+void C_CaptureOutput(FString *buffer);	// for worker threads, nullptr to stop capturing
 int VPrintf (int printlevel, const char *format, va_list parms) GCCFORMAT(2);
 
 void C_DrawConsole (bool hw2d);
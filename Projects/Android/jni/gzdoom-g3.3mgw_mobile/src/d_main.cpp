@@ -88,6 +88,7 @@
 #include "hardware.h"
 #include "sbarinfo.h"
 #include "d_net.h"
+#include "d_playsim.h"
 #include "d_event.h"
 #include "d_netinf.h"
 #include "m_cheat.h"
@@ -105,6 +106,8 @@
 #include "r_data/r_vanillatrans.h"
 #include "s_music.h"
 #include "swrenderer/r_swcolormaps.h"
+#include "gl/stereo3d/gl_stereo3d.h"
+#include "d_startupprofile.h"
 
 EXTERN_CVAR(Bool, hud_althud)
 EXTERN_CVAR(Bool, cl_customizeinvulmap)
@@ -1071,6 +1074,7 @@ void D_DoomLoop ()
 				//I_StartFrame (); // not used
 			}
 			I_SetFrameTime();
+			PlaysimThread.ResetFrameStats();
 
 			// process one or more tics
 			if (singletics)
@@ -1093,10 +1097,18 @@ void D_DoomLoop ()
 			else
 			{
 				TryRunTics (); // will run at least one tic
+
+				// Let the VR runtime wait for the next frame while the playsim thread is busy.
+				PlaysimThread.FrameWaitTime.Clock();
+				s3d::Stereo3DMode::getCurrentMode().BeginFrame();
+				PlaysimThread.FrameWaitTime.Unclock();
+				Net_FinishTics ();
 			}
 			// Update display, next frame, with current state.
 			//I_StartTic ();
+			PlaysimThread.DisplayTime.Clock();
 			D_Display ();
+			PlaysimThread.DisplayTime.Unclock();
 			S_UpdateMusic();
 			if (wantToRestart)
 			{
@@ -2352,6 +2364,9 @@ static int D_DoomMain_Internal (void)
 	
 	const char *batchout = Args->CheckValue("-errorlog");
 
+	StartupProfiler.Init();
+	StartupProfiler.Stage("Console");
+
 	C_InitConsole(80*8, 25*8, false);
 	Printf("%s version %s\n", GAMENAME, GetVersionString());
 	//I_DetectOS();
@@ -2396,11 +2411,14 @@ static int D_DoomMain_Internal (void)
 
 	if (!batchrun) Printf(PRINT_LOG, "%s version %s\n", GAMENAME, GetVersionString());
 
+	StartupProfiler.Stage("D_DoomInit");
 	D_DoomInit();
 
 	//extern void D_ConfirmSendStats();
 	//D_ConfirmSendStats();
 
+	StartupProfiler.Stage("IWAD detection");
+
 	// [RH] Make sure zdoom.pk3 is always loaded,
 	// as it contains magic stuff we need.
 	wad = BaseFileSearch (BASEWAD, NULL, true);
@@ -2492,12 +2510,14 @@ static int D_DoomMain_Internal (void)
 			Printf("Notice: File hashing is incredibly verbose. Expect loading files to take much longer than usual.\n");
 		}
 
+		StartupProfiler.Stage("W_Init");
 		if (!batchrun) Printf ("W_Init: Init WADfiles.\n");
 		Wads.InitMultipleFiles (allwads);
 		allwads.Clear();
 		allwads.ShrinkToFit();
 		SetMapxxFlag();
 
+		StartupProfiler.Stage("CVars");
 		C_GrabCVarDefaults(); //parse DEFCVARS
 
 		GameConfig->DoKeySetup(gameinfo.ConfigName);
@@ -2513,6 +2533,7 @@ static int D_DoomMain_Internal (void)
 			exec = NULL;
 		}
 
+		StartupProfiler.Stage("Strings");
 		// [RH] Initialize localizable strings.
 		GStrings.LoadStrings ();
 
@@ -2523,6 +2544,7 @@ static int D_DoomMain_Internal (void)
 
 		CT_Init ();
 
+		StartupProfiler.Stage("I_Init/V_Init");
 		if (!restart)
 		{
 			if (!batchrun) Printf ("I_Init: Setting up machine state.\n");
@@ -2536,9 +2558,11 @@ static int D_DoomMain_Internal (void)
 		// Base systems have been inited; enable cvar callbacks
 		FBaseCVar::EnableCallbacks ();
 
+		StartupProfiler.Stage("S_Init");
 		if (!batchrun) Printf ("S_Init: Setting up sound.\n");
 		S_Init ();
 
+		StartupProfiler.Stage("Startup screen");
 		if (!batchrun) Printf ("ST_Init: Init startup screen.\n");
 		if (!restart)
 		{
@@ -2553,6 +2577,7 @@ static int D_DoomMain_Internal (void)
 
 		CheckCmdLine();
 
+		StartupProfiler.Stage("S_InitData");
 		// [RH] Load sound environments
 		S_ParseReverbDef ();
 
@@ -2560,6 +2585,7 @@ static int D_DoomMain_Internal (void)
 		if (!batchrun) Printf ("S_InitData: Load sound definitions.\n");
 		S_InitData ();
 
+		StartupProfiler.Stage("MapInfo");
 		// [RH] Parse through all loaded mapinfo lumps
 		if (!batchrun) Printf ("G_ParseMapInfo: Load map definitions.\n");
 		G_ParseMapInfo (iwad_info->MapInfo);
@@ -2568,20 +2594,25 @@ static int D_DoomMain_Internal (void)
 		// MUSINFO must be parsed after MAPINFO
 		S_ParseMusInfo();
 
+		StartupProfiler.Stage("TexMan.Init");
 		if (!batchrun) Printf ("Texman.Init: Init texture manager.\n");
 		TexMan.Init();
 		C_InitConback();
 
+		StartupProfiler.Stage("Fonts");
 		StartScreen->Progress();
 		V_InitFonts();
 
+		StartupProfiler.Stage("TeamInfo");
 		// [CW] Parse any TEAMINFO lumps.
 		if (!batchrun) Printf ("ParseTeamInfo: Load team definitions.\n");
 		TeamLibrary.ParseTeamInfo ();
 
+		StartupProfiler.Stage("Actors");
 		R_ParseTrnslate();
 		PClassActor::StaticInit ();
 
+		StartupProfiler.Stage("Player classes");
 		// [GRB] Initialize player class list
 		SetupPlayerClasses ();
 
@@ -2596,15 +2627,19 @@ static int D_DoomMain_Internal (void)
 
 		StartScreen->Progress ();
 
+		StartupProfiler.Stage("GLDefs");
 		ParseGLDefs();
 
+		StartupProfiler.Stage("R_Init");
 		if (!batchrun) Printf ("R_Init: Init %s refresh subsystem.\n", gameinfo.ConfigName.GetChars());
 		StartScreen->LoadingStatus ("Loading graphics", 0x3f);
 		R_Init ();
 
+		StartupProfiler.Stage("Decals");
 		if (!batchrun) Printf ("DecalLibrary: Load decals.\n");
 		DecalLibrary.ReadAllDecals ();
 
+		StartupProfiler.Stage("Dehacked");
 		// Load embedded Dehacked patches
 		D_LoadDehLumps(FromIWAD);
 
@@ -2634,9 +2669,11 @@ static int D_DoomMain_Internal (void)
 		// Create replacements for dehacked pickups
 		FinishDehPatch();
 
+		StartupProfiler.Stage("M_Init");
 		if (!batchrun) Printf("M_Init: Init menus.\n");
 		M_Init();
 
+		StartupProfiler.Stage("Actor setup");
 		// clean up the compiler symbols which are not needed any longer.
 		RemoveUnusedSymbols();
 
@@ -2654,6 +2691,7 @@ static int D_DoomMain_Internal (void)
 		bglobal.spawn_tries = 0;
 		bglobal.wanted_botnum = bglobal.getspawned.Size();
 
+		StartupProfiler.Stage("P_Init");
 		if (!batchrun) Printf ("P_Init: Init Playloop state.\n");
 		StartScreen->LoadingStatus ("Init game engine", 0x3f);
 		AM_StaticInit();
@@ -2661,6 +2699,7 @@ static int D_DoomMain_Internal (void)
 
 		P_SetupWeapons_ntohton();
 
+		StartupProfiler.Stage("SBarInfo");
 		//SBarInfo support. Note that the first SBARINFO lump contains the mugshot definition so it even needs to be read when a regular status bar is being used.
 		SBarInfo::Load();
 
@@ -2680,6 +2719,7 @@ static int D_DoomMain_Internal (void)
 			}
 		}
 
+		StartupProfiler.Stage("D_CheckNetGame");
 		if (!restart)
 		{
 			if (!batchrun) Printf ("D_CheckNetGame: Checking network game status.\n");
@@ -2690,6 +2730,7 @@ static int D_DoomMain_Internal (void)
 			}
 		}
 
+		StartupProfiler.Stage("Finalize");
 		// [SP] Force vanilla transparency auto-detection to re-detect our game lumps now
 		UpdateVanillaTransparency();
 
@@ -2710,6 +2751,8 @@ static int D_DoomMain_Internal (void)
 		if (cl_customizeinvulmap)
 			R_UpdateInvulnerabilityColormap();
 
+		StartupProfiler.Finish();
+
 		if (!restart)
 		{
 			// start the apropriate game based on parms
@@ -58,6 +58,7 @@
 #include "p_trace.h"
 #include "a_sharedglobal.h"
 #include "st_start.h"
+#include "d_playsim.h"
 #include "teaminfo.h"
 #include "p_conversation.h"
 #include "g_level.h"
@@ -1862,6 +1863,14 @@ static void TicStabilityEnd()
 	stabilityticduration = std::min(stabilityendtime - stabilitystarttime, (uint64_t)1'000'000);
 }
 
+// Tics decided on by TryRunTics that haven't been run yet.
+static int pendingtics;
+static int pendinglowtic;
+static bool ticsstarted;
+static bool playsimstarted;
+
+static void RunPendingTics (bool playsimthread);
+
 //
 // TryRunTics
 //
@@ -1997,28 +2006,15 @@ void TryRunTics (void)
 	if (counts > 0)
 	{
 		P_UnPredictPlayer();
-		while (counts--)
+		pendingtics = counts;
+		pendinglowtic = lowtic;
+		ticsstarted = true;
+		if (FPlaysimThread::IsEnabled())
 		{
-			TicStabilityBegin();
-			if (gametic > lowtic)
-			{
-				I_Error ("gametic>lowtic");
-			}
-			if (advancedemo)
-			{
-				D_DoAdvanceDemo ();
-			}
-			if (debugfile) fprintf (debugfile, "run tic %d\n", gametic);
-			C_Ticker ();
-			M_Ticker ();
-			G_Ticker();
-			gametic++;
-
-			NetUpdate ();	// check for new console commands
-			TicStabilityEnd();
+			// The main thread continues with Net_FinishTics once the frame can be started.
+			playsimstarted = true;
+			PlaysimThread.Start([]() { RunPendingTics(true); });
 		}
-		P_PredictPlayer(&players[consoleplayer]);
-		S_UpdateSounds (players[consoleplayer].camera);	// move positional sounds
 	}
 	else
 	{
@@ -2026,6 +2022,71 @@ void TryRunTics (void)
 	}
 }
 
+//
+// RunPendingTics
+//
+// Runs the tics TryRunTics decided on. On the playsim thread this stops
+// at the first tic that has to be run by the main thread.
+//
+static void RunPendingTics (bool playsimthread)
+{
+	while (pendingtics > 0)
+	{
+		if (playsimthread && !FPlaysimThread::CanRunTic())
+			return;
+
+		PlaysimThread.TicTime.Clock();
+		TicStabilityBegin();
+		if (gametic > pendinglowtic)
+		{
+			I_Error ("gametic>lowtic");
+		}
+		if (advancedemo)
+		{
+			D_DoAdvanceDemo ();
+		}
+		if (debugfile) fprintf (debugfile, "run tic %d\n", gametic);
+		C_Ticker ();
+		M_Ticker ();
+		G_Ticker();
+		gametic++;
+		pendingtics--;
+
+		if (playsimthread) PlaysimThread.ThreadTics++;
+		else
+		{
+			PlaysimThread.MainTics++;
+			NetUpdate ();	// check for new console commands
+		}
+		TicStabilityEnd();
+		PlaysimThread.TicTime.Unclock();
+	}
+}
+
+//
+// Net_FinishTics
+//
+// Completes the tics started by TryRunTics. Must be called before
+// anything looks at the game state again.
+//
+void Net_FinishTics (void)
+{
+	if (!ticsstarted)
+		return;
+	ticsstarted = false;
+
+	if (playsimstarted)
+	{
+		playsimstarted = false;
+		PlaysimThread.Finish();
+		NetUpdate ();	// check for new console commands
+	}
+	RunPendingTics(false);
+
+	P_PredictPlayer(&players[consoleplayer]);
+	S_UpdateSounds (players[consoleplayer].camera);	// move positional sounds
+}
+
 void Net_CheckLastReceived (int counts)
 {
 	// [Ed850] Check to see the last time a packet was received.
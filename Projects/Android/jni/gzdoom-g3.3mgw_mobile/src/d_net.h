@@ -118,6 +118,7 @@ void D_QuitNetGame (void);
 
 //? how many ticks to run?
 void TryRunTics (void);
+void Net_FinishTics (void);
 
 //Use for checking to see if the netgame has stalled
 void Net_CheckLastReceived(int);
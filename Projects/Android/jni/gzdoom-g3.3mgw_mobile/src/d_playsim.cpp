@@ -0,0 +1,226 @@
+//-----------------------------------------------------------------------------
+//
+// Copyright 2018 Christoph Oelckers
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+//-----------------------------------------------------------------------------
+//
+// DESCRIPTION:
+//		Dedicated thread for running game tics while the main
+//		thread waits for the VR runtime.
+//
+//-----------------------------------------------------------------------------
+
+#include "d_playsim.h"
+#include "doomdef.h"
+#include "doomstat.h"
+#include "d_player.h"
+#include "d_main.h"
+#include "d_event.h"
+#include "g_game.h"
+#include "c_cvars.h"
+#include "c_dispatch.h"
+#include "templates.h"
+#include "vm.h"
+
+CVAR(Bool, vr_playsimthread, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+
+FPlaysimThread PlaysimThread;
+
+extern bool advancedemo;
+
+static double LastTicTime, LastFrameWaitTime, LastJoinTime, LastDisplayTime;
+static int LastThreadTics, LastMainTics;
+static double PeakTicTime[64];
+static unsigned PeakIndex;
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+FPlaysimThread::~FPlaysimThread()
+{
+	if (Worker.joinable())
+	{
+		{
+			std::unique_lock<std::mutex> lock(Lock);
+			QuitWorker = true;
+		}
+		JobAvailable.notify_one();
+		Worker.join();
+	}
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+bool FPlaysimThread::IsEnabled()
+{
+	return vr_playsimthread && !singletics;
+}
+
+//==========================================================================
+//
+// A tic may only leave the main thread if it doesn't change the game
+// state. Those tics load levels and textures, which needs the main
+// thread's GL context, or interact with the menus and the console.
+//
+//==========================================================================
+
+bool FPlaysimThread::CanRunTic()
+{
+	if (gamestate != GS_LEVEL || wipegamestate != gamestate) return false;
+	if (gameaction != ga_nothing || advancedemo || ToggleFullscreen) return false;
+	if (menuactive != MENU_Off) return false;
+	for (int i = 0; i < MAXPLAYERS; i++)
+	{
+		if (playeringame[i] && players[i].playerstate != PST_LIVE && players[i].playerstate != PST_DEAD) return false;
+	}
+	return true;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void FPlaysimThread::Start(std::function<void()> job)
+{
+	assert(!Busy);
+	if (!Worker.joinable())
+	{
+		Worker = std::thread([this]() { WorkerProc(); });
+	}
+	{
+		std::unique_lock<std::mutex> lock(Lock);
+		Job = std::move(job);
+		Error = nullptr;
+		Busy = true;
+	}
+	JobAvailable.notify_one();
+}
+
+//==========================================================================
+//
+// Waits until the playsim is done. Errors thrown by the tics are
+// passed on to the main thread.
+//
+//==========================================================================
+
+void FPlaysimThread::Finish()
+{
+	std::exception_ptr error;
+	JoinTime.Clock();
+	{
+		std::unique_lock<std::mutex> lock(Lock);
+		JobDone.wait(lock, [this]() { return !Busy; });
+		error = Error;
+		Error = nullptr;
+	}
+	JoinTime.Unclock();
+	if (error) std::rethrow_exception(error);
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void FPlaysimThread::WorkerProc()
+{
+	for (;;)
+	{
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(Lock);
+			JobAvailable.wait(lock, [this]() { return QuitWorker || Job; });
+			if (QuitWorker) return;
+			job = std::move(Job);
+			Job = nullptr;
+		}
+
+		std::exception_ptr error;
+		try
+		{
+			job();
+		}
+		catch (...)
+		{
+			// The VM stack is per thread so the main thread's error handling cannot clean up this one.
+			ClearGlobalVMStack();
+			error = std::current_exception();
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(Lock);
+			Error = error;
+			Busy = false;
+		}
+		JobDone.notify_one();
+	}
+}
+
+//==========================================================================
+//
+// Called once per frame by the main loop before any tics are run.
+//
+//==========================================================================
+
+void FPlaysimThread::ResetFrameStats()
+{
+	LastTicTime = TicTime.TimeMS();
+	LastFrameWaitTime = FrameWaitTime.TimeMS();
+	LastJoinTime = JoinTime.TimeMS();
+	LastDisplayTime = DisplayTime.TimeMS();
+	LastThreadTics = ThreadTics;
+	LastMainTics = MainTics;
+	PeakTicTime[PeakIndex++ % countof(PeakTicTime)] = LastTicTime;
+
+	TicTime.Reset();
+	FrameWaitTime.Reset();
+	JoinTime.Reset();
+	DisplayTime.Reset();
+	ThreadTics = MainTics = 0;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+FString FPlaysimThread::GetStats()
+{
+	double peak = 0;
+	for (double t : PeakTicTime) peak = MAX(peak, t);
+
+	FString out;
+	out.Format("Playsim: %04.2f ms (peak %04.2f ms), %d tics on playsim thread, %d on main thread\n"
+		"Main: frame wait %04.2f ms, playsim wait %04.2f ms, display %04.2f ms",
+		LastTicTime, peak, LastThreadTics, LastMainTics, LastFrameWaitTime, LastJoinTime, LastDisplayTime);
+	return out;
+}
+
+ADD_STAT(playsim)
+{
+	return PlaysimThread.GetStats();
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <functional>
+#include <exception>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include "stats.h"
+#include "zstring.h"
+
+//==========================================================================
+//
+// Runs the game tics of a frame on a dedicated thread.
+//
+// The main thread hands the tics over and then waits for the VR runtime
+// to release the next frame, so a long tic no longer adds to the time
+// between two frames. The playsim and the renderer never run at the same
+// time: the main thread collects the tics before it starts drawing, so
+// the world state seen by the renderer (including the interpolation
+// data) is exactly what a serial loop would produce.
+//
+// Tics that need to be on the main thread (level changes, savegames,
+// wipes, menus, ...) are left to the main thread to run.
+//
+//==========================================================================
+
+class FPlaysimThread
+{
+	std::mutex Lock;
+	std::condition_variable JobAvailable;
+	std::condition_variable JobDone;
+	std::thread Worker;
+	std::function<void()> Job;
+	std::exception_ptr Error;
+	bool Busy = false;
+	bool QuitWorker = false;
+
+	void WorkerProc();
+
+public:
+	~FPlaysimThread();
+
+	static bool IsEnabled();
+	static bool CanRunTic();
+
+	void Start(std::function<void()> job);
+	void Finish();
+
+	// Timing for the 'stat playsim' display.
+	cycle_t TicTime;		// time spent in tics during the current frame.
+	cycle_t FrameWaitTime;	// main thread waiting for the VR runtime.
+	cycle_t JoinTime;		// main thread waiting for the playsim after that.
+	cycle_t DisplayTime;	// main thread rendering.
+	int ThreadTics = 0, MainTics = 0;
+
+	void ResetFrameStats();
+	FString GetStats();
+};
+
+extern FPlaysimThread PlaysimThread;
@@ -0,0 +1,197 @@
+/*
+** d_startupprofile.cpp
+** Hierarchical timing of the engine startup
+**
+**---------------------------------------------------------------------------
+** Copyright 2018 Christoph Oelckers
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+*/
+
+#include <chrono>
+#include "rapidjson/rapidjson.h"
+#include "rapidjson/prettywriter.h"
+#include "rapidjson/stringbuffer.h"
+#include "d_startupprofile.h"
+#include "m_argv.h"
+#include "files.h"
+#include "c_console.h"
+#include "doomtype.h"
+
+FStartupProfiler StartupProfiler;
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+int64_t FStartupProfiler::Now()
+{
+	using namespace std::chrono;
+	return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+//==========================================================================
+//
+// Must be called once the command line is known.
+//
+//==========================================================================
+
+void FStartupProfiler::Init()
+{
+	if (Enabled || !Args->CheckParm("-profilestartup")) return;
+
+	const char *name = Args->CheckValue("-profilestartup");
+	FileName = name != nullptr ? name : "startupprofile.json";
+	Enabled = true;
+	Nodes.Clear();
+	Current = CurrentStage = -1;
+	Begin("Startup");
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+int FStartupProfiler::Begin(const char *name)
+{
+	if (!IsEnabled()) return -1;
+
+	Node node = { name, Current, Now(), -1 };
+	Current = Nodes.Push(node);
+	return Current;
+}
+
+//==========================================================================
+//
+// Also closes all nodes within the given one that have been left open,
+// so that an exception passing through a scope cannot corrupt the tree.
+//
+//==========================================================================
+
+void FStartupProfiler::End(int node)
+{
+	if (!IsEnabled() || node < 0) return;
+
+	auto now = Now();
+	while (Current >= node && Current >= 0)
+	{
+		if (Nodes[Current].End < 0) Nodes[Current].End = now;
+		Current = Nodes[Current].Parent;
+	}
+}
+
+//==========================================================================
+//
+// Ends the previous top level stage and starts the next one.
+//
+//==========================================================================
+
+void FStartupProfiler::Stage(const char *name)
+{
+	if (!IsEnabled()) return;
+
+	if (CurrentStage >= 0) End(CurrentStage);
+	CurrentStage = Begin(name);
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+template<class W> void FStartupProfiler::WriteNode(W &writer, unsigned index)
+{
+	auto &node = Nodes[index];
+	writer.StartObject();
+	writer.Key("name");
+	writer.String(node.Name.GetChars());
+	writer.Key("start_ms");
+	writer.Double((node.Start - Nodes[0].Start) / 1000.);
+	writer.Key("time_ms");
+	writer.Double((node.End - node.Start) / 1000.);
+
+	bool haschildren = false;
+	for (unsigned i = index + 1; i < Nodes.Size(); i++)
+	{
+		if (Nodes[i].Parent == (int)index)
+		{
+			if (!haschildren)
+			{
+				writer.Key("children");
+				writer.StartArray();
+				haschildren = true;
+			}
+			WriteNode(writer, i);
+		}
+	}
+	if (haschildren) writer.EndArray();
+	writer.EndObject();
+}
+
+//==========================================================================
+//
+// Closes all open nodes, writes the report and prints the top level
+// stages. Anything after this is not recorded.
+//
+//==========================================================================
+
+void FStartupProfiler::Finish()
+{
+	if (!IsEnabled()) return;
+
+	End(0);
+	Finished = true;
+
+	rapidjson::StringBuffer buffer;
+	rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+	WriteNode(writer, 0);
+
+	FileWriter *f = FileWriter::Open(FileName);
+	if (f != nullptr)
+	{
+		f->Write(buffer.GetString(), buffer.GetSize());
+		delete f;
+	}
+	else
+	{
+		Printf("Could not write startup profile to %s\n", FileName.GetChars());
+	}
+
+	Printf("Startup took %.1f ms:\n", (Nodes[0].End - Nodes[0].Start) / 1000.);
+	for (unsigned i = 1; i < Nodes.Size(); i++)
+	{
+		if (Nodes[i].Parent == 0)
+		{
+			Printf("  %-24s %8.1f ms\n", Nodes[i].Name.GetChars(), (Nodes[i].End - Nodes[i].Start) / 1000.);
+		}
+	}
+}
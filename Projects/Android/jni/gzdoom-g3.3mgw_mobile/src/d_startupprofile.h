@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+#include "tarray.h"
+#include "zstring.h"
+
+//==========================================================================
+//
+// Hierarchical timing of the engine startup, enabled with
+// -profilestartup [file]. Top level stages follow each other, nested
+// scopes may be opened within a stage. Once startup is complete the
+// collected times are written as JSON and summarized on the console.
+//
+// Only to be used on the main thread.
+//
+//==========================================================================
+
+class FStartupProfiler
+{
+	struct Node
+	{
+		FString Name;
+		int Parent;
+		int64_t Start;
+		int64_t End;
+	};
+
+	TArray<Node> Nodes;
+	int Current = -1;	// innermost open node
+	int CurrentStage = -1;
+	bool Enabled = false;
+	bool Finished = false;
+	FString FileName;
+
+	static int64_t Now();
+	template<class W> void WriteNode(W &writer, unsigned index);
+
+public:
+	void Init();
+	bool IsEnabled() const { return Enabled && !Finished; }
+
+	int Begin(const char *name);
+	void End(int node);
+	void Stage(const char *name);
+	void Finish();
+};
+
+extern FStartupProfiler StartupProfiler;
+
+class FStartupScope
+{
+	int Node;
+
+public:
+	FStartupScope(const char *name)
+	{
+		Node = StartupProfiler.Begin(name);
+	}
+	~FStartupScope()
+	{
+		StartupProfiler.End(Node);
+	}
+};
@@ -55,6 +55,11 @@ enum
 	METHOD_ZLIB = 1338,	// Zlib stream with header, used by compressed nodes.
 };
 
+// Decompresses a stream that is completely in memory in one go. This is a lot faster than
+// going through a decompressor stream but only supports METHOD_DEFLATE, METHOD_ZLIB and METHOD_BZIP2.
+// Returns false for other methods and calls I_Error for broken data.
+bool DecompressBuffer(void *dest, size_t destsize, const void *src, size_t srcsize, int method);
+
 class FileReaderInterface
 {
 public:
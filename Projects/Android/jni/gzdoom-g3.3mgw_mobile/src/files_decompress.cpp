@@ -42,6 +42,14 @@
 #include "i_system.h"
 #include "templates.h"
 #include "m_misc.h"
+#include "c_cvars.h"
+
+#ifdef HAVE_LIBDEFLATE
+#include <memory>
+#include <libdeflate.h>
+
+CVAR(Bool, zip_libdeflate, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
+#endif
 
 
 long DecompressorBase::Tell () const
@@ -602,3 +610,100 @@ bool FileReader::OpenDecompressor(FileReader &parent, Size length, int method, b
 		return false;
 	}
 }
+
+
+//==========================================================================
+//
+// DecompressBuffer
+//
+// If the entire stream is in memory there's no need to feed the
+// decompressor in small portions and it can write straight into the
+// destination. If available, libdeflate is used for Deflate streams,
+// which is considerably faster than zlib.
+//
+//==========================================================================
+
+bool DecompressBuffer(void *dest, size_t destsize, const void *src, size_t srcsize, int method)
+{
+	switch (method)
+	{
+	case METHOD_DEFLATE:
+	case METHOD_ZLIB:
+	{
+#ifdef HAVE_LIBDEFLATE
+		if (zip_libdeflate)
+		{
+			// Each thread keeps its own decompressor around because allocating one is not free.
+			static thread_local std::unique_ptr<libdeflate_decompressor, void(*)(libdeflate_decompressor *)>
+				decompressor(libdeflate_alloc_decompressor(), libdeflate_free_decompressor);
+
+			if (decompressor != nullptr)
+			{
+				size_t actual;
+				auto result = method == METHOD_DEFLATE ?
+					libdeflate_deflate_decompress(decompressor.get(), src, srcsize, dest, destsize, &actual) :
+					libdeflate_zlib_decompress(decompressor.get(), src, srcsize, dest, destsize, &actual);
+
+				// Like zlib, libdeflate refuses to write a partial stream so running out of space is no error.
+				if (result == LIBDEFLATE_BAD_DATA)
+				{
+					I_Error("Corrupt zlib stream");
+				}
+				if (result == LIBDEFLATE_SUCCESS && actual < destsize)
+				{
+					I_Error("Ran out of data in zlib stream");
+				}
+				if (result != LIBDEFLATE_INSUFFICIENT_SPACE)
+				{
+					return true;
+				}
+				// The stream is longer than the lump so let zlib decompress the part that fits.
+			}
+		}
+#endif
+		z_stream stream = {};
+		stream.next_in = (Bytef *)src;
+		stream.avail_in = (uInt)srcsize;
+		stream.next_out = (Bytef *)dest;
+		stream.avail_out = (uInt)destsize;
+
+		int err = inflateInit2(&stream, method == METHOD_DEFLATE ? -MAX_WBITS : MAX_WBITS);
+		if (err != Z_OK)
+		{
+			I_Error("DecompressBuffer: inflateInit failed: %s\n", M_ZLibError(err).GetChars());
+		}
+		err = inflate(&stream, Z_FINISH);
+		inflateEnd(&stream);
+
+		// Z_BUF_ERROR means that either the input or the output ran out. Only the latter is fine.
+		if (err != Z_STREAM_END && err != Z_BUF_ERROR)
+		{
+			I_Error("Corrupt zlib stream");
+		}
+		if (stream.avail_out != 0)
+		{
+			I_Error("Ran out of data in zlib stream");
+		}
+		return true;
+	}
+
+	case METHOD_BZIP2:
+	{
+		unsigned int destlen = (unsigned int)destsize;
+		int err = BZ2_bzBuffToBuffDecompress((char *)dest, &destlen, (char *)const_cast<void *>(src), (unsigned int)srcsize, 0, 0);
+
+		if (err != BZ_OK && err != BZ_OUTBUFF_FULL && err != BZ_UNEXPECTED_EOF)
+		{
+			I_Error("Corrupt bzip2 stream");
+		}
+		if (err == BZ_UNEXPECTED_EOF || destlen < destsize)
+		{
+			I_Error("Ran out of data in bzip2 stream");
+		}
+		return true;
+	}
+
+	default:
+		return false;
+	}
+}
@@ -76,6 +76,8 @@
 #include "gl/system//gl_interface.h"
 #include "vm.h"
 #include "memarena.h"
+#include "stats.h"
+#include "i_time.h"
 
 static FMemArena DynLightArena(sizeof(FDynamicLight) * 200);
 static TArray<FDynamicLight*> FreeList;
@@ -447,6 +449,101 @@ void FDynamicLight::UpdateLocation()
 	}
 }
 
+//=============================================================================
+//
+// Light nodes are allocated from an arena and recycled through a free list,
+// because moving lights constantly create and destroy them.
+//
+//=============================================================================
+
+static FMemArena LightNodeArena(sizeof(FLightNode) * 1024);
+static FLightNode *FreeLightNodes;
+
+static struct
+{
+	unsigned Relinks, Kept, Added, Removed;
+} LinkStats;
+
+static FLightNode *NewLightNode()
+{
+	FLightNode *node = FreeLightNodes;
+	if (node != nullptr) FreeLightNodes = node->nextTarget;
+	else node = (FLightNode*)LightNodeArena.Alloc(sizeof(FLightNode));
+	return node;
+}
+
+//=============================================================================
+//
+// Lookup table from link target to this light's node. It starts out with
+// the nodes of the previous link pass, so that nodes for targets that are
+// still in range are kept and everything else gets replaced. This replaces
+// the linear scan through the light's node lists, which made relinking
+// lights with large radii quadratic.
+//
+//=============================================================================
+
+static TArray<FLightNode *> LinkTable;
+static unsigned LinkTableCount;
+
+static inline unsigned HashLinkTarget(void *targ)
+{
+	uintptr_t v = (uintptr_t)targ;
+	return unsigned((v >> 3) ^ (v >> 15)) * 0x9E3779B1u;
+}
+
+static void ClearLinkTable(unsigned count)
+{
+	unsigned size = 64;
+	while (size < count * 2) size <<= 1;
+	LinkTable.Resize(size);
+	memset(LinkTable.Data(), 0, size * sizeof(FLightNode*));
+	LinkTableCount = 0;
+}
+
+static void InsertLink(FLightNode *node)
+{
+	if (LinkTableCount * 2 >= LinkTable.Size())
+	{
+		TArray<FLightNode *> old(std::move(LinkTable));
+		ClearLinkTable(old.Size());
+		for (auto n : old) if (n != nullptr) InsertLink(n);
+	}
+	unsigned mask = LinkTable.Size() - 1;
+	unsigned i = HashLinkTarget(node->targ) & mask;
+	while (LinkTable[i] != nullptr) i = (i + 1) & mask;
+	LinkTable[i] = node;
+	LinkTableCount++;
+}
+
+static FLightNode *FindLink(void *linkto)
+{
+	unsigned mask = LinkTable.Size() - 1;
+	for (unsigned i = HashLinkTarget(linkto) & mask; LinkTable[i] != nullptr; i = (i + 1) & mask)
+	{
+		if (LinkTable[i]->targ == linkto) return LinkTable[i];
+	}
+	return nullptr;
+}
+
+static void PrepareLinkTable(FDynamicLight *light)
+{
+	FLightNode *lists[] = { light->touching_sides, light->touching_subsectors, light->touching_sector };
+	unsigned count = 0;
+	for (auto node : lists)
+	{
+		for (; node != nullptr; node = node->nextTarget) count++;
+	}
+	ClearLinkTable(count);
+	for (auto node : lists)
+	{
+		for (; node != nullptr; node = node->nextTarget)
+		{
+			node->lightsource = nullptr;
+			InsertLink(node);
+		}
+	}
+}
+
 //=============================================================================
 //
 // These have been copied from the secnode code and modified for the light links
@@ -458,25 +555,23 @@ void FDynamicLight::UpdateLocation()
 //
 //=============================================================================
 
-FLightNode * AddLightNode(FLightNode ** thread, void * linkto, FDynamicLight * light, FLightNode *& nextnode)
+static FLightNode * AddLightNode(FLightNode ** thread, void * linkto, FDynamicLight * light, FLightNode *& nextnode)
 {
 	FLightNode * node;
 
-	node = nextnode;
-	while (node)
-    {
-		if (node->targ==linkto)   // Already have a node for this sector?
-		{
-			node->lightsource = light; // Yes. Setting m_thing says 'keep it'.
-			return(nextnode);
-		}
-		node = node->nextTarget;
-    }
+	node = FindLink(linkto);
+	if (node != nullptr)	// Already have a node for this sector?
+	{
+		node->lightsource = light; // Yes. Setting m_thing says 'keep it'.
+		LinkStats.Kept++;
+		return(nextnode);
+	}
 
 	// Couldn't find an existing node for this sector. Add one at the head
 	// of the list.
 	
-	node = new FLightNode;
+	node = NewLightNode();
+	LinkStats.Added++;
 	
 	node->targ = linkto;
 	node->lightsource = light; 
@@ -485,6 +580,7 @@ FLightNode * AddLightNode(FLightNode ** thread, void * linkto, FDynamicLight * l
 	node->nextTarget = nextnode;
 
 	if (nextnode) nextnode->prevTarget = &node->nextTarget;
+	InsertLink(node);
 	
 	// Add new node at head of sector thread starting at s->touching_thinglist
 	
@@ -519,7 +615,8 @@ static FLightNode * DeleteLightNode(FLightNode * node)
 		
 		// Return this node to the freelist
 		tn=node->nextTarget;
-		delete node;
+		node->nextTarget = FreeLightNodes;
+		FreeLightNodes = node;
 		return(tn);
     }
 	return(NULL);
@@ -682,25 +779,9 @@ void FDynamicLight::LinkLight()
 {
 	// mark the old light nodes
 	FLightNode * node;
-	
-	node = touching_sides;
-	while (node)
-    {
-		node->lightsource = NULL;
-		node = node->nextTarget;
-    }
-	node = touching_subsectors;
-	while (node)
-    {
-		node->lightsource = NULL;
-		node = node->nextTarget;
-    }
-	node = touching_sector;
-	while (node)
-	{
-		node->lightsource = NULL;
-		node = node->nextTarget;
-	}
+
+	LinkStats.Relinks++;
+	PrepareLinkTable(this);
 
 	if (radius>0)
 	{
@@ -720,6 +801,7 @@ void FDynamicLight::LinkLight()
 		if (node->lightsource == NULL)
 		{
 			node = DeleteLightNode(node);
+			LinkStats.Removed++;
 		}
 		else
 			node = node->nextTarget;
@@ -731,6 +813,7 @@ void FDynamicLight::LinkLight()
 		if (node->lightsource == NULL)
 		{
 			node = DeleteLightNode(node);
+			LinkStats.Removed++;
 		}
 		else
 			node = node->nextTarget;
@@ -742,6 +825,7 @@ void FDynamicLight::LinkLight()
 		if (node->lightsource == NULL)
 		{
 			node = DeleteLightNode(node);
+			LinkStats.Removed++;
 		}
 		else
 			node = node->nextTarget;
@@ -1114,3 +1198,85 @@ CCMD(listsublights)
 	}
 }
 
+
+//==========================================================================
+//
+// Light linking statistics
+//
+//==========================================================================
+
+ADD_STAT(lightlinks)
+{
+	FString out;
+	unsigned lights = 0, nodes = 0;
+	for (auto dl = level.lights; dl; dl = dl->next)
+	{
+		lights++;
+		for (auto list : { dl->touching_sides, dl->touching_subsectors, dl->touching_sector })
+		{
+			for (auto node = list; node; node = node->nextTarget) nodes++;
+		}
+	}
+	out.Format("%u lights, %u nodes, %u relinks, %u nodes kept, %u added, %u removed",
+		lights, nodes, LinkStats.Relinks, LinkStats.Kept, LinkStats.Added, LinkStats.Removed);
+	return out;
+}
+
+//==========================================================================
+//
+// CCMD lightlinkbench
+//
+// Moves every light in the level along a small circle and relinks it,
+// then puts it back. Spawn a lot of light emitting actors first to get
+// meaningful results.
+//
+//==========================================================================
+
+CCMD(lightlinkbench)
+{
+	int iterations = argv.argc() > 1 ? (int)strtol(argv[1], nullptr, 10) : 100;
+	double range = argv.argc() > 2 ? strtod(argv[2], nullptr) : 16.;
+	TArray<FDynamicLight *> lights;
+	TArray<DVector3> positions;
+
+	for (auto dl = level.lights; dl; dl = dl->next)
+	{
+		if (dl->IsActive() && dl->radius > 0)
+		{
+			lights.Push(dl);
+			positions.Push(dl->Pos);
+		}
+	}
+	if (lights.Size() == 0 || iterations <= 0)
+	{
+		Printf("No active dynamic lights\n");
+		return;
+	}
+
+	auto stats = LinkStats;
+	LinkStats = {};
+	uint64_t start = I_nsTime();
+	for (int i = 0; i < iterations; i++)
+	{
+		DAngle angle = 360. * i / iterations;
+		DVector3 offset(angle.Cos() * range, angle.Sin() * range, 0);
+		for (unsigned j = 0; j < lights.Size(); j++)
+		{
+			lights[j]->Pos = positions[j] + offset;
+			lights[j]->LinkLight();
+		}
+	}
+	uint64_t time = I_nsTime() - start;
+	auto bench = LinkStats;
+
+	for (unsigned j = 0; j < lights.Size(); j++)
+	{
+		lights[j]->Pos = positions[j];
+		lights[j]->LinkLight();
+	}
+	LinkStats = stats;
+
+	Printf("%u lights, %u relinks in %.2f ms, %.2f us per relink, %.1f nodes kept, %.2f added, %.2f removed per relink\n",
+		lights.Size(), bench.Relinks, time / 1e6, time / 1e3 / bench.Relinks,
+		double(bench.Kept) / bench.Relinks, double(bench.Added) / bench.Relinks, double(bench.Removed) / bench.Relinks);
+}
@@ -625,6 +625,7 @@ void gl_CleanLevelData()
 		delete glSectorPortals[i];
 	}
 	glSectorPortals.Clear();
+	gl_ClearWallCaches();
 }
 
 
@@ -39,6 +39,7 @@
 #include "gl/data/gl_vertexbuffer.h"
 
 CVAR(Int, gl_buffer_size, 2000000, CVAR_ARCHIVE);
+CVAR(Bool, gl_staticwalls, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
 
 //==========================================================================
 //
@@ -161,6 +162,8 @@ FFlatVertexBuffer::FFlatVertexBuffer(int width, int height)
 	}
 	mIndex = mCurIndex = 0;
 	mNumReserved = NUM_RESERVED;
+	mWallIndex = mNumWallSlots = 0;
+	mFrameStamp = 1;
 	vbo_shadowdata.Resize(mNumReserved);
 
 	// the first quad is reserved for handling coordinates through uniforms.
@@ -457,10 +460,83 @@ void FFlatVertexBuffer::UpdatePlaneVertices(sector_t *sec, int plane)
 //
 //==========================================================================
 
+//==========================================================================
+//
+// Reserves a fixed range of vertices for the upper, middle and lower part
+// of each sidedef. Walls are written into these only when their geometry
+// changes so that most of them do not need any per-frame vertex data.
+// If the level is too large for the buffer, all walls get streamed.
+//
+//==========================================================================
+
+void FFlatVertexBuffer::CreateWallVBO()
+{
+	unsigned int numslots = level.sides.Size() * WALLSLOTS_PER_SIDE;
+	unsigned int available = (unsigned int)gl_buffer_size - vbo_shadowdata.Size();
+
+	mWallIndex = vbo_shadowdata.Size();
+	mNumWallSlots = 0;
+	mWallSlotStamps.Clear();
+
+	if (!gl_staticwalls || numslots * 4 > available / 2)
+	{
+		return;
+	}
+	mNumWallSlots = numslots;
+	mWallSlotStamps.Resize(numslots);
+	memset(&mWallSlotStamps[0], 0, numslots * sizeof(unsigned int));
+
+	unsigned int idx = vbo_shadowdata.Reserve(numslots * 4);
+	memset(&vbo_shadowdata[idx], 0, numslots * 4 * sizeof(FFlatVertex));
+}
+
+//==========================================================================
+//
+// Returns the static vertex range for one wall part. It only gets written
+// if the vertices differ from what is already there. Each slot can only
+// hold one version of the wall per frame, if another piece of the same part
+// wants it afterward it has to go to the stream.
+//
+//==========================================================================
+
+bool FFlatVertexBuffer::GetStaticWall(unsigned int slot, const FFlatVertex *verts, unsigned int *poffset)
+{
+	if (slot >= mNumWallSlots || !gl_staticwalls || map == nullptr) return false;
+
+	unsigned int index = mWallIndex + slot * 4;
+	FFlatVertex *shadow = &vbo_shadowdata[index];
+	bool same = !memcmp(shadow, verts, 4 * sizeof(FFlatVertex));
+
+	if (mWallSlotStamps[slot] == mFrameStamp)
+	{
+		if (!same) return false;
+	}
+	else
+	{
+		mWallSlotStamps[slot] = mFrameStamp;
+		if (!same)
+		{
+			memcpy(shadow, verts, 4 * sizeof(FFlatVertex));
+			memcpy(&map[index], verts, 4 * sizeof(FFlatVertex));
+			staticwall_updates++;
+		}
+	}
+	staticwall_draws++;
+	*poffset = index;
+	return true;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
 void FFlatVertexBuffer::CreateVBO()
 {
 	vbo_shadowdata.Resize(mNumReserved);
 	CreateFlatVBO();
+	CreateWallVBO();
 	mCurIndex = mIndex = vbo_shadowdata.Size();
 	Map();
 	memcpy(map, &vbo_shadowdata[0], vbo_shadowdata.Size() * sizeof(FFlatVertex));
@@ -112,6 +112,10 @@ class FFlatVertexBuffer : public FVertexBuffer
 	unsigned int mIndex;
 	unsigned int mCurIndex;
 	unsigned int mNumReserved;
+	unsigned int mWallIndex;
+	unsigned int mNumWallSlots;
+	unsigned int mFrameStamp;
+	TArray<unsigned int> mWallSlotStamps;
 
 	void CheckPlanes(sector_t *sector);
 
@@ -127,6 +131,11 @@ public:
 		NUM_RESERVED = 20
 	};
 
+	enum
+	{
+		WALLSLOTS_PER_SIDE = 3	// upper, middle and lower part
+	};
+
 	TArray<FFlatVertex> vbo_shadowdata;	// this is kept around for updating the actual (non-readable) buffer and as stand-in for pre GL 4.x
 
 	FFlatVertexBuffer(int width, int height);
@@ -138,6 +147,7 @@ public:
 
 	void CreateVBO();
 	void CheckUpdate(sector_t *sector);
+	bool GetStaticWall(unsigned int slot, const FFlatVertex *verts, unsigned int *poffset);
 
 	FFlatVertex *GetBuffer()
 	{
@@ -212,6 +222,7 @@ public:
 	void Reset()
 	{
 		mCurIndex = mIndex;
+		mFrameStamp++;
 	}
 
 	void Map();
@@ -222,6 +233,7 @@ private:
 	int CreateSectorVertices(sector_t *sec, const secplane_t &plane, int floor);
 	int CreateVertices(int h, sector_t *sec, const secplane_t &plane, int floor);
 	void CreateFlatVBO();
+	void CreateWallVBO();
 	void UpdatePlaneVertices(sector_t *sec, int plane);
 
 };
@@ -26,6 +26,30 @@
 #include "gl/system/gl_interface.h"
 #include "r_state.h"
 #include "g_levellocals.h"
+#include "po_man.h"
+
+#if !defined(NO_SSE) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define AABB_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define AABB_NEON
+#endif
+
+// The ray packets are tested in single precision. Node boxes get grown by this much so that rounding
+// never rejects a node the double precision test in OverlapRayAABB would have accepted.
+static const float PacketAABBMargin = 1.0f;
+
+struct AABBRayPacket
+{
+	// Ray center, half delta and absolute half delta, one lane per ray
+	float cx[4], cy[4];
+	float wx[4], wy[4];
+	float awx[4], awy[4];
+
+	// Used by the scalar fallback
+	DVector2 start[4], end[4];
+};
 
 LevelAABBTree::LevelAABBTree()
 {
@@ -67,6 +91,118 @@ LevelAABBTree::LevelAABBTree()
 		treeline.dx = (float)line.v2->fX() - treeline.x;
 		treeline.dy = (float)line.v2->fY() - treeline.y;
 	}
+
+	// Link the nodes back to their parents and lines to their leaves so that moving lines can be refitted
+	parents.Resize(nodes.Size());
+	line_nodes.Resize(level.lines.Size());
+	for (unsigned int i = 0; i < nodes.Size(); i++)
+		parents[i] = -1;
+	for (unsigned int i = 0; i < level.lines.Size(); i++)
+		line_nodes[i] = -1;
+	for (unsigned int i = 0; i < nodes.Size(); i++)
+	{
+		if (nodes[i].line_index != -1)
+		{
+			line_nodes[nodes[i].line_index] = i;
+		}
+		else
+		{
+			if (nodes[i].left_node != -1) parents[nodes[i].left_node] = i;
+			if (nodes[i].right_node != -1) parents[nodes[i].right_node] = i;
+		}
+	}
+
+	for (int i = 0; i < po_NumPolyobjs; i++)
+	{
+		for (auto line : polyobjs[i].Linedefs)
+		{
+			dynamic_lines.Push(line->Index());
+		}
+	}
+
+	dirty_nodes_end = nodes.Size();
+	dirty_lines_end = lines.Size();
+}
+
+int LevelAABBTree::Update()
+{
+	int moved = 0;
+	for (int line_index : dynamic_lines)
+	{
+		const auto &line = level.lines[line_index];
+		auto &treeline = lines[line_index];
+
+		float x = (float)line.v1->fX();
+		float y = (float)line.v1->fY();
+		float dx = (float)line.v2->fX() - x;
+		float dy = (float)line.v2->fY() - y;
+		if (x == treeline.x && y == treeline.y && dx == treeline.dx && dy == treeline.dy)
+			continue;
+
+		treeline.x = x;
+		treeline.y = y;
+		treeline.dx = dx;
+		treeline.dy = dy;
+		dirty_lines_start = MIN(dirty_lines_start, line_index);
+		dirty_lines_end = MAX(dirty_lines_end, line_index + 1);
+		moved++;
+
+		if (line_nodes[line_index] != -1)
+			RefitNode(line_nodes[line_index]);
+	}
+	return moved;
+}
+
+void LevelAABBTree::RefitNode(int node_index)
+{
+	while (node_index != -1)
+	{
+		AABBTreeNode &node = nodes[node_index];
+		float left, top, right, bottom;
+		if (node.line_index != -1)
+		{
+			// Same as in GenerateTreeNode
+			const auto &line = level.lines[node.line_index];
+			float x1 = (float)line.v1->fX();
+			float y1 = (float)line.v1->fY();
+			float x2 = (float)line.v2->fX();
+			float y2 = (float)line.v2->fY();
+			left = MIN(x1, x2);
+			top = MIN(y1, y2);
+			right = MAX(x1, x2);
+			bottom = MAX(y1, y2);
+		}
+		else
+		{
+			const AABBTreeNode &l = nodes[node.left_node];
+			const AABBTreeNode &r = nodes[node.right_node];
+			left = MIN(l.aabb_left, r.aabb_left);
+			top = MIN(l.aabb_top, r.aabb_top);
+			right = MAX(l.aabb_right, r.aabb_right);
+			bottom = MAX(l.aabb_bottom, r.aabb_bottom);
+		}
+
+		// The parents only need to be refitted if this node's AABB changed
+		if (left == node.aabb_left && top == node.aabb_top && right == node.aabb_right && bottom == node.aabb_bottom)
+			break;
+
+		node.aabb_left = left;
+		node.aabb_top = top;
+		node.aabb_right = right;
+		node.aabb_bottom = bottom;
+		dirty_nodes_start = MIN(dirty_nodes_start, node_index);
+		dirty_nodes_end = MAX(dirty_nodes_end, node_index + 1);
+
+		node_index = parents[node_index];
+	}
+}
+
+void LevelAABBTree::ResetDirty()
+{
+	dirty_nodes_start = nodes.Size();
+	dirty_nodes_end = 0;
+	dirty_lines_start = lines.Size();
+	dirty_lines_end = 0;
 }
 
 double LevelAABBTree::RayTest(const DVector3 &ray_start, const DVector3 &ray_end)
@@ -116,6 +252,155 @@ double LevelAABBTree::RayTest(const DVector3 &ray_start, const DVector3 &ray_end
 	return hit_fraction;
 }
 
+void LevelAABBTree::RayTestBatch(const DVector3 *ray_starts, const DVector3 *ray_ends, double *hit_fractions, int count, bool any_hit)
+{
+#if !defined(AABB_SSE2) && !defined(AABB_NEON)
+	// Without SIMD a packet walk only visits more nodes than tracing the rays one by one
+	for (int i = 0; i < count; i++)
+	{
+		hit_fractions[i] = RayTest(ray_starts[i], ray_ends[i]);
+	}
+#else
+	for (int i = 0; i < count; i += 4)
+	{
+		RayTestPacket(ray_starts + i, ray_ends + i, hit_fractions + i, MIN(count - i, 4), any_hit);
+	}
+#endif
+}
+
+void LevelAABBTree::RayTestPacket(const DVector3 *ray_starts, const DVector3 *ray_ends, double *hit_fractions, int count, bool any_hit)
+{
+	AABBRayPacket packet;
+	DVector2 raydelta[4];
+	double rayd[4], raydist2[4];
+	int active = 0;
+
+	for (int i = 0; i < 4; i++)
+	{
+		// Unused lanes repeat the last ray so that the SIMD test doesn't work on garbage
+		int r = MIN(i, count - 1);
+		DVector2 start = ray_starts[r];
+		DVector2 end = ray_ends[r];
+		DVector2 center = (start + end) * 0.5;
+		DVector2 w = end - center;
+
+		packet.start[i] = start;
+		packet.end[i] = end;
+		packet.cx[i] = (float)center.X;
+		packet.cy[i] = (float)center.Y;
+		packet.wx[i] = (float)w.X;
+		packet.wy[i] = (float)w.Y;
+		packet.awx[i] = fabsf(packet.wx[i]);
+		packet.awy[i] = fabsf(packet.wy[i]);
+
+		// Same precalculation as in RayTest
+		raydelta[i] = end - start;
+		raydist2[i] = raydelta[i] | raydelta[i];
+		DVector2 raynormal = DVector2(raydelta[i].Y, -raydelta[i].X);
+		rayd[i] = raynormal | start;
+
+		if (i < count)
+		{
+			hit_fractions[i] = 1.0;
+			if (raydist2[i] >= 1.0)
+				active |= 1 << i;
+		}
+	}
+
+	// Walk the tree nodes. This is the same walk as in RayTest, except that a subtree is entered if any of the rays overlap it.
+	int stack[16];
+	int stack_pos = 1;
+	stack[0] = nodes.Size() - 1; // root node is the last node in the list
+	while (stack_pos > 0 && active != 0)
+	{
+		int node_index = stack[stack_pos - 1];
+		const AABBTreeNode &node = nodes[node_index];
+
+		int overlap = OverlapPacketAABB(packet, node) & active;
+		if (overlap == 0)
+		{
+			stack_pos--;
+		}
+		else if (node.line_index != -1) // isLeaf(node_index)
+		{
+			for (int i = 0; i < count; i++)
+			{
+				if (overlap & (1 << i))
+				{
+					double t = IntersectRayLine(packet.start[i], packet.end[i], node.line_index, raydelta[i], rayd[i], raydist2[i]);
+					if (t < hit_fractions[i])
+					{
+						hit_fractions[i] = t;
+						if (any_hit)
+							active &= ~(1 << i);
+					}
+				}
+			}
+			stack_pos--;
+		}
+		else if (stack_pos == 16)
+		{
+			stack_pos--; // stack overflow - tree is too deep!
+		}
+		else
+		{
+			stack[stack_pos - 1] = node.left_node;
+			stack[stack_pos] = node.right_node;
+			stack_pos++;
+		}
+	}
+}
+
+int LevelAABBTree::OverlapPacketAABB(const AABBRayPacket &packet, const AABBTreeNode &node)
+{
+	// 2D version of the separating axis test in OverlapRayAABB, for four rays at once.
+	// The Z axis tests of the 3D version can never separate a ray lying in the XY plane, so they are left out.
+	float bx = (node.aabb_left + node.aabb_right) * 0.5f;
+	float by = (node.aabb_top + node.aabb_bottom) * 0.5f;
+	float hx = (node.aabb_right - node.aabb_left) * 0.5f + PacketAABBMargin;
+	float hy = (node.aabb_bottom - node.aabb_top) * 0.5f + PacketAABBMargin;
+
+#if defined(AABB_SSE2)
+	const __m128 signmask = _mm_set1_ps(-0.0f);
+	__m128 cx = _mm_sub_ps(_mm_loadu_ps(packet.cx), _mm_set1_ps(bx));
+	__m128 cy = _mm_sub_ps(_mm_loadu_ps(packet.cy), _mm_set1_ps(by));
+	__m128 awx = _mm_loadu_ps(packet.awx);
+	__m128 awy = _mm_loadu_ps(packet.awy);
+	__m128 vhx = _mm_set1_ps(hx);
+	__m128 vhy = _mm_set1_ps(hy);
+	__m128 cross = _mm_sub_ps(_mm_mul_ps(cx, _mm_loadu_ps(packet.wy)), _mm_mul_ps(cy, _mm_loadu_ps(packet.wx)));
+
+	__m128 disjoint = _mm_cmpgt_ps(_mm_andnot_ps(signmask, cx), _mm_add_ps(awx, vhx));
+	disjoint = _mm_or_ps(disjoint, _mm_cmpgt_ps(_mm_andnot_ps(signmask, cy), _mm_add_ps(awy, vhy)));
+	disjoint = _mm_or_ps(disjoint, _mm_cmpgt_ps(_mm_andnot_ps(signmask, cross), _mm_add_ps(_mm_mul_ps(vhx, awy), _mm_mul_ps(vhy, awx))));
+	return ~_mm_movemask_ps(disjoint) & 15;
+#elif defined(AABB_NEON)
+	float32x4_t cx = vsubq_f32(vld1q_f32(packet.cx), vdupq_n_f32(bx));
+	float32x4_t cy = vsubq_f32(vld1q_f32(packet.cy), vdupq_n_f32(by));
+	float32x4_t awx = vld1q_f32(packet.awx);
+	float32x4_t awy = vld1q_f32(packet.awy);
+	float32x4_t cross = vsubq_f32(vmulq_f32(cx, vld1q_f32(packet.wy)), vmulq_f32(cy, vld1q_f32(packet.wx)));
+
+	uint32x4_t disjoint = vcgtq_f32(vabsq_f32(cx), vaddq_f32(awx, vdupq_n_f32(hx)));
+	disjoint = vorrq_u32(disjoint, vcgtq_f32(vabsq_f32(cy), vaddq_f32(awy, vdupq_n_f32(hy))));
+	disjoint = vorrq_u32(disjoint, vcgtq_f32(vabsq_f32(cross), vaddq_f32(vmulq_n_f32(awy, hx), vmulq_n_f32(awx, hy))));
+
+	static const uint32_t lanebits[4] = { 1, 2, 4, 8 };
+	uint32x4_t bits = vandq_u32(disjoint, vld1q_u32(lanebits));
+	uint32x2_t sum = vpadd_u32(vget_low_u32(bits), vget_high_u32(bits));
+	sum = vpadd_u32(sum, sum);
+	return ~vget_lane_u32(sum, 0) & 15;
+#else
+	int result = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		if (OverlapRayAABB(packet.start[i], packet.end[i], node))
+			result |= 1 << i;
+	}
+	return result;
+#endif
+}
+
 bool LevelAABBTree::OverlapRayAABB(const DVector2 &ray_start2d, const DVector2 &ray_end2d, const AABBTreeNode &node)
 {
 	// To do: simplify test to use a 2D test
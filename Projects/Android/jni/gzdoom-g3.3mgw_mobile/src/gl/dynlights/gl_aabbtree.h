@@ -31,6 +31,9 @@ struct AABBTreeLine
 	float dx, dy;
 };
 
+// Four rays prepared for the SIMD AABB test
+struct AABBRayPacket;
+
 // Axis aligned bounding box tree used for ray testing lines.
 class LevelAABBTree
 {
@@ -44,10 +47,43 @@ public:
 	// Line segments for the leaf nodes in the tree.
 	TArray<AABBTreeLine> lines;
 
+	// Range of nodes and lines changed by Update since the last ResetDirty call. End is exclusive and the range is empty if start >= end.
+	int dirty_nodes_start = 0, dirty_nodes_end = 0;
+	int dirty_lines_start = 0, dirty_lines_end = 0;
+
 	// Shoot a ray from ray_start to ray_end and return the closest hit as a fractional value between 0 and 1. Returns 1 if no line was hit.
 	double RayTest(const DVector3 &ray_start, const DVector3 &ray_end);
 
+	// Shoot count rays through the tree, four at a time, and store the hit fractions in hit_fractions.
+	// Rays next to each other should start from about the same place (e.g. the same light) so that a packet walks the same nodes.
+	// With any_hit set a ray stops at the first line it hits. This is enough for visibility tests, but the fraction is then not necessarily the closest hit.
+	void RayTestBatch(const DVector3 *ray_starts, const DVector3 *ray_ends, double *hit_fractions, int count, bool any_hit = false);
+
+	// Refits the tree to the polyobject lines that moved since the last call. Returns the number of lines that moved.
+	int Update();
+
+	// Marks the tree as uploaded
+	void ResetDirty();
+
 private:
+	// Parent of each node. -1 for the root node.
+	TArray<int> parents;
+
+	// Leaf node of each line. -1 for lines not in the tree.
+	TArray<int> line_nodes;
+
+	// Lines that can move (polyobject lines)
+	TArray<int> dynamic_lines;
+
+	// Recalculates the AABB of a leaf node and then its parents until a node's AABB stays the same
+	void RefitNode(int node_index);
+
+	// Trace up to four rays together, sharing the tree walk and the AABB tests
+	void RayTestPacket(const DVector3 *ray_starts, const DVector3 *ray_ends, double *hit_fractions, int count, bool any_hit);
+
+	// Test which rays in a packet overlap an AABB node. Returns one bit per ray.
+	int OverlapPacketAABB(const AABBRayPacket &packet, const AABBTreeNode &node);
+
 	// Test if a ray overlaps an AABB node or not
 	bool OverlapRayAABB(const DVector2 &ray_start2d, const DVector2 &ray_end2d, const AABBTreeNode &node);
 
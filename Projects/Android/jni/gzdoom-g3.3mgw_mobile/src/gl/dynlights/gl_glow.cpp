@@ -30,8 +30,24 @@
 #include "v_video.h"
 #include "r_defs.h"
 #include "textures/textures.h"
+#include "g_levellocals.h"
+#include "p_maputl.h"
 
+#include "gl/system/gl_cvars.h"
 #include "gl/dynlights/gl_glow.h"
+#include "gl/utility/gl_clock.h"
+
+CVAR(Bool, gl_wallcache, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+
+struct FGlowCacheEntry
+{
+	int validcount;
+	bool glowing;
+	float topglowcolor[4];
+	float bottomglowcolor[4];
+};
+
+static TArray<FGlowCacheEntry> GlowCache;
 
 //==========================================================================
 //
@@ -83,7 +99,7 @@ int gl_CheckSpriteGlow(sector_t *sector, int lightlevel, const DVector3 &pos)
 // Checks whether a wall should glow
 //
 //==========================================================================
-bool gl_GetWallGlow(sector_t *sector, float *topglowcolor, float *bottomglowcolor)
+static bool GetWallGlow(sector_t *sector, float *topglowcolor, float *bottomglowcolor)
 {
 	bool ret = false;
 	bottomglowcolor[3] = topglowcolor[3] = 0;
@@ -137,3 +153,52 @@ bool gl_GetWallGlow(sector_t *sector, float *topglowcolor, float *bottomglowcolo
 	return ret;
 }
 
+
+//==========================================================================
+//
+// Every wall of a sector needs the same glow values so they only get
+// looked up once per scene. Sectors that are not part of the level
+// (i.e. the copies created for deep water) are not cached.
+//
+//==========================================================================
+
+bool gl_GetWallGlow(sector_t *sector, float *topglowcolor, float *bottomglowcolor)
+{
+	unsigned index = unsigned(sector - &level.sectors[0]);
+	if (!gl_wallcache || index >= level.sectors.Size() || sector != &level.sectors[index])
+	{
+		return GetWallGlow(sector, topglowcolor, bottomglowcolor);
+	}
+
+	if (GlowCache.Size() != level.sectors.Size())
+	{
+		GlowCache.Resize(level.sectors.Size());
+		for (auto &entry : GlowCache) entry.validcount = validcount - 1;
+	}
+
+	FGlowCacheEntry &entry = GlowCache[index];
+	if (entry.validcount != validcount)
+	{
+		entry.validcount = validcount;
+		entry.glowing = GetWallGlow(sector, entry.topglowcolor, entry.bottomglowcolor);
+		glowcache_misses++;
+	}
+	else
+	{
+		glowcache_hits++;
+	}
+	memcpy(topglowcolor, entry.topglowcolor, sizeof(entry.topglowcolor));
+	memcpy(bottomglowcolor, entry.bottomglowcolor, sizeof(entry.bottomglowcolor));
+	return entry.glowing;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void gl_ClearGlowCache()
+{
+	GlowCache.Clear();
+}
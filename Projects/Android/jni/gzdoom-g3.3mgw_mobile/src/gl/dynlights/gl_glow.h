@@ -7,5 +7,6 @@ struct sector_t;
 void gl_InitGlow(const char * lumpnm);
 int gl_CheckSpriteGlow(sector_t *sec, int lightlevel, const DVector3 &pos);
 bool gl_GetWallGlow(sector_t *sector, float *topglowcolor, float *bottomglowcolor);
+void gl_ClearGlowCache();
 
 #endif
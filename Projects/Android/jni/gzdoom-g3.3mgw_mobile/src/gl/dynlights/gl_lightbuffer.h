@@ -28,6 +28,8 @@ public:
 	void Begin();
 	void Finish();
 	int BindUBO(unsigned int index);
+	// First index of the buffer range BindUBO binds for the given index.
+	unsigned int GetBlockStart(unsigned int index) const { return mBlockAlign == 0 ? 0 : (index / mBlockAlign) * mBlockAlign; }
 	unsigned int GetBlockSize() const { return mBlockSize; }
 	unsigned int GetBufferType() const { return mBufferType; }
 	unsigned int GetIndexPtr() const { return mIndices.Size();	}
@@ -31,8 +31,14 @@
 #include "gl/renderer/gl_postprocessstate.h"
 #include "gl/renderer/gl_renderbuffers.h"
 #include "gl/shaders/gl_shadowmapshader.h"
+#include "gl/scene/gl_drawinfo.h"
 #include "r_state.h"
 #include "g_levellocals.h"
+#include "p_effect.h"
+#include "actorinlines.h"
+#include "c_dispatch.h"
+#include "i_time.h"
+#include "v_text.h"
 #include "stats.h"
 
 /*
@@ -68,12 +74,23 @@ namespace
 	cycle_t UpdateCycles;
 	int LightsProcessed;
 	int LightsShadowmapped;
+	cycle_t SpriteRayCycles;
+	int SpriteRays;
+
+	// AABB tree build time and the cost of the last refit that moved something
+	cycle_t BuildCycles;
+	cycle_t RefitCycles;
+	int RefitLines;
+	int RefitUploadSize;
 }
 
 ADD_STAT(shadowmap)
 {
 	FString out;
-	out.Format("upload=%04.2f ms  lights=%d  shadowmapped=%d", UpdateCycles.TimeMS(), LightsProcessed, LightsShadowmapped);
+	out.Format("upload=%04.2f ms  lights=%d  shadowmapped=%d  sprite rays=%d (%04.2f ms)\n"
+		"tree build=%04.2f ms  last refit=%04.3f ms  lines=%d  upload=%d bytes",
+		UpdateCycles.TimeMS(), LightsProcessed, LightsShadowmapped, SpriteRays, SpriteRayCycles.TimeMS(),
+		BuildCycles.TimeMS(), RefitCycles.TimeMS(), RefitLines, RefitUploadSize);
 	return out;
 }
 
@@ -105,12 +122,22 @@ CUSTOM_CVAR (Bool, gl_light_shadowmap, false, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
     }
 }
 
+// Trace sprite lighting shadows on the CPU. This works without the shadowmap pass, which many GPUs can't afford.
+CVAR (Bool, gl_light_spriteshadows, false, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+
 
 void FShadowMap::Update()
 {
 	UpdateCycles.Reset();
+	SpriteRayCycles.Reset();
+	RefitUploadSize = 0;
 	LightsProcessed = 0;
 	LightsShadowmapped = 0;
+	SpriteRays = 0;
+
+	mSpriteLights.Clear();
+	mSpriteLightVisible.Clear();
+	mSpritePos.Clear();
 
 	if (!IsEnabled())
 		return;
@@ -150,12 +177,110 @@ void FShadowMap::Update()
 
 bool FShadowMap::ShadowTest(FDynamicLight *light, const DVector3 &pos)
 {
-	if (light->shadowmapped && light->GetRadius() > 0.0 && IsEnabled() && mAABBTree)
+	if (light->shadowmapped && light->GetRadius() > 0.0 && (IsEnabled() || gl_light_spriteshadows) && mAABBTree)
 		return mAABBTree->RayTest(light->Pos, pos) >= 1.0f;
 	else
 		return true;
 }
 
+//==========================================================================
+//
+// Collects the rays from every light to every sprite lit by it, the same
+// way gl_SetDynSpriteLight walks them, and traces them all in one batch.
+// The rays are sorted by light so that the ray packets stay coherent.
+//
+//==========================================================================
+
+void FShadowMap::PrepareSpriteShadows(FDrawInfo *di)
+{
+	if (!IsEnabled() && !gl_light_spriteshadows)
+	{
+		for (auto &list : di->drawlists)
+		{
+			for (auto &sprite : list.sprites) sprite.shadowrays = -1;
+		}
+		return;
+	}
+
+	SpriteRayCycles.Clock();
+	ValidateAABBTree();
+	mRayEntries.Clear();
+
+	for (auto &list : di->drawlists)
+	{
+		for (auto &sprite : list.sprites)
+		{
+			sprite.shadowrays = -1;
+			if (sprite.fullbright || sprite.RenderStyle.BlendOp == STYLEOP_Shadow || (sprite.modelframe && !sprite.particle))
+				continue;
+
+			AActor *actor = gl_light_sprites ? sprite.actor : nullptr;
+			particle_t *particle = gl_light_particles ? sprite.particle : nullptr;
+			DVector3 pos;
+			subsector_t *subsec;
+			if (actor != nullptr)
+			{
+				pos = DVector3((float)actor->X(), (float)actor->Y(), (float)actor->Center());
+				subsec = actor->subsector;
+			}
+			else if (particle != nullptr)
+			{
+				pos = DVector3((float)particle->Pos.X, (float)particle->Pos.Y, (float)particle->Pos.Z);
+				subsec = particle->subsector;
+			}
+			else continue;
+
+			sprite.shadowrays = mSpriteLights.Size();
+			for (FLightNode *node = subsec->lighthead; node; node = node->nextLight)
+			{
+				FDynamicLight *light = node->lightsource;
+				double radius = light->GetRadius();
+				if (light->shadowmapped && radius > 0 && light->ShouldLightActor(actor) && (pos - light->Pos).LengthSquared() < radius * radius)
+				{
+					mRayEntries.Push(mSpriteLights.Push(light));
+					mSpriteLightVisible.Push(true);
+					mSpritePos.Push(pos);
+				}
+			}
+			mSpriteLights.Push(nullptr);
+			mSpriteLightVisible.Push(true);
+			mSpritePos.Push(pos);
+		}
+	}
+
+	unsigned count = mRayEntries.Size();
+	if (count > 0)
+	{
+		std::sort(&mRayEntries[0], &mRayEntries[0] + count, [&](int a, int b) { return mSpriteLights[a] < mSpriteLights[b]; });
+
+		mRayStarts.Resize(count);
+		mRayEnds.Resize(count);
+		mRayResults.Resize(count);
+		for (unsigned i = 0; i < count; i++)
+		{
+			mRayStarts[i] = mSpriteLights[mRayEntries[i]]->Pos;
+			mRayEnds[i] = mSpritePos[mRayEntries[i]];
+		}
+		mAABBTree->RayTestBatch(&mRayStarts[0], &mRayEnds[0], &mRayResults[0], count, true);
+		for (unsigned i = 0; i < count; i++)
+		{
+			mSpriteLightVisible[mRayEntries[i]] = mRayResults[i] >= 1.0;
+		}
+	}
+	SpriteRays += count;
+	SpriteRayCycles.Unclock();
+}
+
+bool FShadowMap::SpriteShadowTest(int first, FDynamicLight *light, const DVector3 &pos)
+{
+	for (unsigned i = first; i < mSpriteLights.Size() && mSpriteLights[i] != nullptr; i++)
+	{
+		if (mSpriteLights[i] == light)
+			return !!mSpriteLightVisible[i];
+	}
+	return ShadowTest(light, pos);
+}
+
 bool FShadowMap::IsEnabled() const
 {
 	return gl_renderbuffers && gl_light_shadowmap && !!(gl.flags & RFL_SHADER_STORAGE_BUFFER);
@@ -204,17 +329,46 @@ void FShadowMap::UploadLights()
 	glBindBuffer(GL_SHADER_STORAGE_BUFFER, oldBinding);
 }
 
-void FShadowMap::UploadAABBTree()
+void FShadowMap::ValidateAABBTree()
 {
 	// Just comparing the level info is not enough. If two MAPINFO-less levels get played after each other, 
 	// they can both refer to the same default level info.
 	if (level.info != mLastLevel && (level.nodes.Size() != mLastNumNodes || level.segs.Size() != mLastNumSegs))
 		Clear();
 
-	if (mAABBTree)
-		return;
+	if (!mAABBTree)
+	{
+		BuildCycles.Reset();
+		BuildCycles.Clock();
+		mAABBTree.reset(new LevelAABBTree());
+		BuildCycles.Unclock();
+	}
+	else
+	{
+		// Moving polyobjects only refit the nodes above their lines instead of rebuilding the tree
+		cycle_t refit;
+		refit.Reset();
+		refit.Clock();
+		int moved = mAABBTree->Update();
+		refit.Unclock();
+		if (moved > 0)
+		{
+			RefitCycles = refit;
+			RefitLines = moved;
+		}
+	}
+}
+
+void FShadowMap::UploadAABBTree()
+{
+	ValidateAABBTree();
 
-	mAABBTree.reset(new LevelAABBTree());
+	// The tree may already exist for the CPU side sprite shadows
+	if (mNodesBuffer != 0)
+	{
+		UploadDirtyRanges();
+		return;
+	}
 
 	int oldBinding = 0;
 	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_BINDING, &oldBinding);
@@ -228,6 +382,35 @@ void FShadowMap::UploadAABBTree()
 	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(AABBTreeLine) * mAABBTree->lines.Size(), &mAABBTree->lines[0], GL_STATIC_DRAW);
 
 	glBindBuffer(GL_SHADER_STORAGE_BUFFER, oldBinding);
+	mAABBTree->ResetDirty();
+}
+
+void FShadowMap::UploadDirtyRanges()
+{
+	int nodesStart = mAABBTree->dirty_nodes_start, nodesEnd = mAABBTree->dirty_nodes_end;
+	int linesStart = mAABBTree->dirty_lines_start, linesEnd = mAABBTree->dirty_lines_end;
+	if (nodesStart >= nodesEnd && linesStart >= linesEnd)
+		return;
+
+	int oldBinding = 0;
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_BINDING, &oldBinding);
+
+	if (nodesStart < nodesEnd)
+	{
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, mNodesBuffer);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, sizeof(AABBTreeNode) * nodesStart, sizeof(AABBTreeNode) * (nodesEnd - nodesStart), &mAABBTree->nodes[nodesStart]);
+		RefitUploadSize = sizeof(AABBTreeNode) * (nodesEnd - nodesStart);
+	}
+
+	if (linesStart < linesEnd)
+	{
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, mLinesBuffer);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, sizeof(AABBTreeLine) * linesStart, sizeof(AABBTreeLine) * (linesEnd - linesStart), &mAABBTree->lines[linesStart]);
+		RefitUploadSize += sizeof(AABBTreeLine) * (linesEnd - linesStart);
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, oldBinding);
+	mAABBTree->ResetDirty();
 }
 
 void FShadowMap::Clear()
@@ -256,3 +439,91 @@ void FShadowMap::Clear()
 	mLastNumNodes = level.nodes.Size();
 	mLastNumSegs = level.segs.Size();
 }
+
+//==========================================================================
+//
+// CCMD spriteshadowbench
+//
+// Traces a ray from every light to every actor it touches in the current
+// level, one at a time and batched, and compares timing and results.
+//
+//==========================================================================
+
+CCMD(spriteshadowbench)
+{
+	int iterations = argv.argc() > 1 ? MAX((int)strtol(argv[1], nullptr, 10), 1) : 10;
+
+	if (level.lines.Size() == 0)
+	{
+		Printf("No level loaded\n");
+		return;
+	}
+
+	// Rays are collected per light, the same order PrepareSpriteShadows sorts them into
+	TArray<DVector3> starts, ends;
+	for (auto light = level.lights; light; light = light->next)
+	{
+		double radius = light->GetRadius();
+		if (radius <= 0 || !light->IsActive()) continue;
+
+		for (FLightNode *node = light->touching_subsectors; node; node = node->nextTarget)
+		{
+			for (AActor *actor = node->targSubsector->sector->thinglist; actor; actor = actor->snext)
+			{
+				DVector3 pos(actor->X(), actor->Y(), actor->Center());
+				if (actor->subsector == node->targSubsector && (pos - light->Pos).LengthSquared() < radius * radius)
+				{
+					starts.Push(light->Pos);
+					ends.Push(pos);
+				}
+			}
+		}
+	}
+	unsigned count = starts.Size();
+	if (count == 0)
+	{
+		Printf("No lit actors in this level\n");
+		return;
+	}
+
+	LevelAABBTree tree;
+	TArray<double> single, batched, anyhit;
+	single.Resize(count);
+	batched.Resize(count);
+	anyhit.Resize(count);
+
+	uint64_t start = I_nsTime();
+	for (int i = 0; i < iterations; i++)
+	{
+		for (unsigned j = 0; j < count; j++) single[j] = tree.RayTest(starts[j], ends[j]);
+	}
+	uint64_t singletime = I_nsTime() - start;
+
+	start = I_nsTime();
+	for (int i = 0; i < iterations; i++)
+	{
+		tree.RayTestBatch(&starts[0], &ends[0], &batched[0], count);
+	}
+	uint64_t batchtime = I_nsTime() - start;
+
+	start = I_nsTime();
+	for (int i = 0; i < iterations; i++)
+	{
+		tree.RayTestBatch(&starts[0], &ends[0], &anyhit[0], count, true);
+	}
+	uint64_t anyhittime = I_nsTime() - start;
+
+	unsigned shadowed = 0, mismatches = 0;
+	for (unsigned j = 0; j < count; j++)
+	{
+		if (single[j] < 1.0) shadowed++;
+		if (single[j] != batched[j] || (single[j] < 1.0) != (anyhit[j] < 1.0)) mismatches++;
+	}
+
+	double rays = double(count) * iterations;
+	Printf("%u rays, %u shadowed, %u lines in tree\n", count, shadowed, tree.lines.Size());
+	Printf("single: %.1f ns/ray, batched: %.1f ns/ray (%.2fx), any hit: %.1f ns/ray (%.2fx)\n",
+		singletime / rays, batchtime / rays, double(singletime) / MAX<uint64_t>(batchtime, 1),
+		anyhittime / rays, double(singletime) / MAX<uint64_t>(anyhittime, 1));
+	if (mismatches > 0) Printf(TEXTCOLOR_RED "%u rays differ between single and batched tests\n", mismatches);
+}
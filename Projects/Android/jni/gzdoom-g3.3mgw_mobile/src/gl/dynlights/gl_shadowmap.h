@@ -7,6 +7,7 @@
 
 struct FDynamicLight;
 struct level_info_t;
+struct FDrawInfo;
 
 class FShadowMap
 {
@@ -23,13 +24,25 @@ public:
 	// Test if a world position is in shadow relative to the specified light and returns false if it is
 	bool ShadowTest(FDynamicLight *light, const DVector3 &pos);
 
+	// Traces the light rays for all sprites in the draw lists in one batch and stores the first result index in each sprite
+	void PrepareSpriteShadows(FDrawInfo *di);
+
+	// Looks up the result of PrepareSpriteShadows for one light of a sprite. Falls back to ShadowTest if the light wasn't traced.
+	bool SpriteShadowTest(int first, FDynamicLight *light, const DVector3 &pos);
+
 	// Returns true if gl_light_shadowmap is enabled and supported by the hardware
 	bool IsEnabled() const;
 
 private:
+	// Create the AABB-tree for the current level if needed, or refit it to moved polyobjects
+	void ValidateAABBTree();
+
 	// Upload the AABB-tree to the GPU
 	void UploadAABBTree();
 
+	// Upload the parts of the AABB-tree changed by moving polyobjects
+	void UploadDirtyRanges();
+
 	// Upload light list to the GPU
 	void UploadLights();
 
@@ -39,6 +52,17 @@ private:
 	// Working buffer for creating the list of lights. Stored here to avoid allocating memory each frame
 	TArray<float> mLights;
 
+	// Lights tested for the sprites in PrepareSpriteShadows and their results. The lights of each sprite are terminated by a null entry.
+	TArray<FDynamicLight *> mSpriteLights;
+	TArray<uint8_t> mSpriteLightVisible;
+	TArray<DVector3> mSpritePos;
+
+	// Working buffers for the batched ray test
+	TArray<int> mRayEntries;
+	TArray<DVector3> mRayStarts;
+	TArray<DVector3> mRayEnds;
+	TArray<double> mRayResults;
+
 	// OpenGL storage buffers for the AABB tree
 	int mNodesBuffer = 0;
 	int mLinesBuffer = 0;
@@ -51,8 +51,11 @@
 #include "gl/textures/gl_material.h"
 #include "gl/renderer/gl_renderstate.h"
 #include "gl/shaders/gl_shader.h"
+#include "gl/utility/gl_clock.h"
+#include "gl/dynlights/gl_lightbuffer.h"
 
 CVAR(Bool, gl_light_models, true, CVAR_ARCHIVE)
+CVAR(Bool, gl_model_instancing, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
 
 extern int modellightindex;
 float gldepthmin, gldepthmax;
@@ -155,17 +158,251 @@ void FGLModelRenderer::SetMaterial(FTexture *skin, bool clampNoFilter, int trans
 
 void FGLModelRenderer::DrawArrays(int start, int count)
 {
-	glDrawArrays(GL_TRIANGLES, start, count);
+	if (mInstanceCount > 0)
+	{
+		glDrawArraysInstanced(GL_TRIANGLES, start, count, mInstanceCount);
+		model_instanced_draws++;
+	}
+	else glDrawArrays(GL_TRIANGLES, start, count);
+	model_drawcalls++;
 }
 
 void FGLModelRenderer::DrawElements(int numIndices, size_t offset)
 {
+	GLenum type = GL_UNSIGNED_INT;
 #ifdef __MOBILE__
     if (!(gl.flags & RFL_UINT_IDX))// Some old devices can not use integer index type
-        glDrawElements(GL_TRIANGLES, numIndices, GL_UNSIGNED_SHORT, ( void*)(intptr_t)offset);
-    else
+        type = GL_UNSIGNED_SHORT;
+#endif
+	if (mInstanceCount > 0)
+	{
+		glDrawElementsInstanced(GL_TRIANGLES, numIndices, type, (void*)(intptr_t)offset, mInstanceCount);
+		model_instanced_draws++;
+	}
+	else glDrawElements(GL_TRIANGLES, numIndices, type, (void*)(intptr_t)offset);
+	model_drawcalls++;
+}
+
+//===========================================================================
+//
+// Instance data buffer
+//
+//===========================================================================
+
+FModelInstanceBuffer::FModelInstanceBuffer()
+{
+	glGenBuffers(1, &mBufferId);
+}
+
+FModelInstanceBuffer::~FModelInstanceBuffer()
+{
+	glDeleteBuffers(1, &mBufferId);
+}
+
+void FModelInstanceBuffer::Upload(const FModelInstanceData *data, unsigned int count)
+{
+	// Respecifying the whole store lets the driver hand out fresh memory instead of waiting for earlier draws.
+	glBindBuffer(GL_ARRAY_BUFFER, mBufferId);
+	glBufferData(GL_ARRAY_BUFFER, count * sizeof(FModelInstanceData), data, GL_STREAM_DRAW);
+}
+
+void FModelInstanceBuffer::Bind()
+{
+	glBindBuffer(GL_ARRAY_BUFFER, mBufferId);
+	for (int i = 0; i < 4; i++)
+	{
+		glVertexAttribPointer(VATTR_INSTANCEMATRIX + i, 4, GL_FLOAT, false, sizeof(FModelInstanceData), (void*)(myoffsetof(FModelInstanceData, matrix) + i * 4 * sizeof(float)));
+	}
+	for (int i = 0; i < 3; i++)
+	{
+		glVertexAttribPointer(VATTR_INSTANCENORMAL + i, 3, GL_FLOAT, false, sizeof(FModelInstanceData), (void*)(myoffsetof(FModelInstanceData, normalMatrix) + i * 3 * sizeof(float)));
+	}
+	glVertexAttribPointer(VATTR_INSTANCEPARAMS, 2, GL_FLOAT, false, sizeof(FModelInstanceData), (void*)myoffsetof(FModelInstanceData, interpolation));
+	for (int i = VATTR_INSTANCEMATRIX; i <= VATTR_INSTANCEPARAMS; i++)
+	{
+		glEnableVertexAttribArray(i);
+		glVertexAttribDivisor(i, 1);
+	}
+}
+
+void FModelInstanceBuffer::Unbind()
+{
+	for (int i = VATTR_INSTANCEMATRIX; i <= VATTR_INSTANCEPARAMS; i++)
+	{
+		glVertexAttribDivisor(i, 0);
+		glDisableVertexAttribArray(i);
+	}
+}
+
+//===========================================================================
+//
+// Instancing needs the shader based vertex buffers, so it is only
+// available where models are not interpolated on the CPU.
+//
+//===========================================================================
+
+bool gl_ModelInstancingActive()
+{
+	if (!gl_model_instancing || gl.legacyMode || GLRenderer->mModelInstances == nullptr) return false;
+#ifdef __MOBILE__
+	if (gl.glesVer < 3) return false;
 #endif
-	glDrawElements(GL_TRIANGLES, numIndices, GL_UNSIGNED_INT, (void*)(intptr_t)offset);
+	return true;
+}
+
+//===========================================================================
+//
+// Draws a run of actors that share model frame, translation and lighting.
+// They are split into groups that interpolate towards the same frame, use
+// the same LOD and have their dynamic lights in the same block of the light
+// buffer, and each group is drawn with one instanced call per surface.
+//
+//===========================================================================
+
+void FGLModelRenderer::RenderModelBatch(GLSprite **sprites, const int *lightindices, int count)
+{
+	static TArray<FModelInstance> instances;
+	static TArray<FModelInstanceData> data;
+	static TArray<bool> done;
+
+	FSpriteModelFrame *smf = sprites[0]->modelframe;
+	AActor *actor = sprites[0]->actor;
+	int translation = (smf->flags & MDL_IGNORETRANSLATION) ? 0 : actor->Translation;
+
+	instances.Resize(count);
+	done.Resize(count);
+	for (int i = 0; i < count; i++)
+	{
+		GetModelInstance(sprites[i]->x, sprites[i]->y, sprites[i]->z, smf, sprites[i]->actor, instances[i]);
+		done[i] = false;
+		rendered_models++;
+		if (instances[i].lod > 0) rendered_models_lod++;
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		if (done[i]) continue;
+
+		const FModelInstance &first = instances[i];
+		int lightindex = -1;
+		unsigned int block = 0;
+
+		data.Clear();
+		for (int j = i; j < count; j++)
+		{
+			if (done[j] || instances[j].smfNext != first.smfNext || instances[j].lod != first.lod) continue;
+			if (lightindices[j] >= 0)
+			{
+				unsigned int jblock = GLRenderer->mLights->GetBlockStart(lightindices[j]);
+				if (lightindex < 0)
+				{
+					lightindex = lightindices[j];
+					block = jblock;
+				}
+				else if (jblock != block) continue;
+			}
+			done[j] = true;
+
+			FModelInstanceData &d = data[data.Reserve(1)];
+			VSMatrix norm;
+			norm.computeNormalMatrix(instances[j].objectToWorldMatrix);
+			const FLOATTYPE *m = instances[j].objectToWorldMatrix.get();
+			const FLOATTYPE *n = norm.get();
+			for (int k = 0; k < 16; k++) d.matrix[k] = (float)m[k];
+			for (int c = 0; c < 3; c++)
+			{
+				for (int r = 0; r < 3; r++) d.normalMatrix[c * 3 + r] = (float)n[c * 4 + r];
+			}
+			d.interpolation = (float)instances[j].inter;
+			d.lightIndex = lightindices[j] < 0 ? -1.f : float(lightindices[j] - block);
+		}
+
+		mLOD = first.lod;
+		// SetMaterial applies this index, which binds the light buffer block shared by the whole group.
+		modellightindex = lightindex;
+		if (data.Size() > 1)
+		{
+			GLRenderer->mModelInstances->Upload(&data[0], data.Size());
+			GLRenderer->mModelInstances->Bind();
+			mInstanceCount = data.Size();
+			gl_RenderState.EnableInstancing(true);
+		}
+		BeginDrawModel(actor, smf, first.objectToWorldMatrix, first.mirrored);
+		RenderFrameModels(smf, first.smfNext, first.inter, translation);
+		EndDrawModel(actor, smf);
+		if (mInstanceCount > 0)
+		{
+			gl_RenderState.EnableInstancing(false);
+			GLRenderer->mModelInstances->Unbind();
+			mInstanceCount = 0;
+		}
+	}
+	modellightindex = -1;
+}
+
+//===========================================================================
+//
+// Frames interpolated on the CPU are kept for reuse. All actors in the
+// same state and tic interpolate the same two frames with the same factor,
+// so only the first of them needs to do the work.
+//
+//===========================================================================
+
+struct FInterpolatedFrame
+{
+	const FModelVertexBuffer *buffer;
+	unsigned int frame1, frame2, size;
+	float frac;
+	unsigned int lastuse;
+	TArray<FModelVertex> vertices;
+};
+
+enum { NUM_INTERPOLATED_FRAMES = 64 };
+static FInterpolatedFrame InterpolatedFrames[NUM_INTERPOLATED_FRAMES];
+static unsigned int InterpolatedFrameUse;
+
+static FInterpolatedFrame *GetInterpolatedFrame(const FModelVertexBuffer *buffer, const FModelVertex *vbo_ptr, unsigned int frame1, unsigned int frame2, unsigned int size, float frac)
+{
+	FInterpolatedFrame *oldest = &InterpolatedFrames[0];
+	for (auto &frame : InterpolatedFrames)
+	{
+		if (frame.buffer == buffer && frame.frame1 == frame1 && frame.frame2 == frame2 && frame.size == size && frame.frac == frac)
+		{
+			frame.lastuse = ++InterpolatedFrameUse;
+			model_framecache_hits++;
+			return &frame;
+		}
+		if (frame.lastuse < oldest->lastuse) oldest = &frame;
+	}
+
+	FInterpolatedFrame &frame = *oldest;
+	frame.buffer = buffer;
+	frame.frame1 = frame1;
+	frame.frame2 = frame2;
+	frame.size = size;
+	frame.frac = frac;
+	frame.lastuse = ++InterpolatedFrameUse;
+	frame.vertices.Resize(size);
+	for (unsigned i = 0; i < size; i++)
+	{
+		frame.vertices[i].x = vbo_ptr[frame1 + i].x * (1.f - frac) + vbo_ptr[frame2 + i].x * frac;
+		frame.vertices[i].y = vbo_ptr[frame1 + i].y * (1.f - frac) + vbo_ptr[frame2 + i].y * frac;
+		frame.vertices[i].z = vbo_ptr[frame1 + i].z * (1.f - frac) + vbo_ptr[frame2 + i].z * frac;
+	}
+	model_framecache_misses++;
+	return &frame;
+}
+
+static void FlushInterpolatedFrames(const FModelVertexBuffer *buffer)
+{
+	for (auto &frame : InterpolatedFrames)
+	{
+		if (frame.buffer == buffer)
+		{
+			frame.buffer = nullptr;
+			frame.lastuse = 0;
+		}
+	}
 }
 
 //===========================================================================
@@ -237,6 +474,7 @@ FModelVertexBuffer::~FModelVertexBuffer()
 	if (vbo_ptr != nullptr)
 	{
 		delete[] vbo_ptr;
+		FlushInterpolatedFrames(this);
 	}
 #ifdef __MOBILE__
     if (ibo_mem == nullptr)
@@ -266,6 +504,7 @@ FModelVertex *FModelVertexBuffer::LockVertexBuffer(unsigned int size)
 	else
 	{
 		if (vbo_ptr != nullptr) delete[] vbo_ptr;
+		FlushInterpolatedFrames(this);
 		vbo_ptr = new FModelVertex[size];
 		memset(vbo_ptr, 0, size * sizeof(FModelVertex));
 		return vbo_ptr;
@@ -370,7 +609,6 @@ void FModelVertexBuffer::UnlockIndexBuffer()
 // This must be called after gl_RenderState.Apply!
 //
 //===========================================================================
-static TArray<FModelVertex> iBuffer;
 
 void FModelVertexBuffer::SetupFrame(FModelRenderer *renderer, unsigned int frame1, unsigned int frame2, unsigned int size)
 {
@@ -399,16 +637,9 @@ void FModelVertexBuffer::SetupFrame(FModelRenderer *renderer, unsigned int frame
 	else
 	{
 		// must interpolate
-		iBuffer.Resize(size);
-		glVertexPointer(3, GL_FLOAT, sizeof(FModelVertex), &iBuffer[0].x);
+		FInterpolatedFrame *frame = GetInterpolatedFrame(this, vbo_ptr, frame1, frame2, size, gl_RenderState.GetInterpolationFactor());
+		glVertexPointer(3, GL_FLOAT, sizeof(FModelVertex), &frame->vertices[0].x);
 		glTexCoordPointer(2, GL_FLOAT, sizeof(FModelVertex), &vbo_ptr[frame1].u);
-		float frac = gl_RenderState.GetInterpolationFactor();
-		for (unsigned i = 0; i < size; i++)
-		{
-			iBuffer[i].x = vbo_ptr[frame1 + i].x * (1.f - frac) + vbo_ptr[frame2 + i].x * frac;
-			iBuffer[i].y = vbo_ptr[frame1 + i].y * (1.f - frac) + vbo_ptr[frame2 + i].y * frac;
-			iBuffer[i].z = vbo_ptr[frame1 + i].z * (1.f - frac) + vbo_ptr[frame2 + i].z * frac;
-		}
 	}
 }
 
@@ -421,7 +652,25 @@ void FModelVertexBuffer::SetupFrame(FModelRenderer *renderer, unsigned int frame
 void gl_RenderModel(GLSprite * spr)
 {
 	FGLModelRenderer renderer;
+	RenderModels.Clock();
 	renderer.RenderModel(spr->x, spr->y, spr->z, spr->modelframe, spr->actor);
+	RenderModels.Unclock();
+	rendered_models++;
+	if (renderer.GetLOD() > 0) rendered_models_lod++;
+}
+
+//===========================================================================
+//
+// gl_RenderModelBatch
+//
+//===========================================================================
+
+void gl_RenderModelBatch(GLSprite **sprites, const int *lightindices, int count)
+{
+	FGLModelRenderer renderer;
+	RenderModels.Clock();
+	renderer.RenderModelBatch(sprites, lightindices, count);
+	RenderModels.Unclock();
 }
 
 //===========================================================================
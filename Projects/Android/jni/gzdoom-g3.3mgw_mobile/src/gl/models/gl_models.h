@@ -30,6 +30,27 @@
 
 class GLSprite;
 
+// Per-instance data for instanced model rendering. The layout matches the aInstance* attributes in main.vp.
+struct FModelInstanceData
+{
+	float matrix[16];
+	float normalMatrix[9];
+	float interpolation;
+	float lightIndex;
+};
+
+class FModelInstanceBuffer
+{
+	unsigned int mBufferId;
+
+public:
+	FModelInstanceBuffer();
+	~FModelInstanceBuffer();
+	void Upload(const FModelInstanceData *data, unsigned int count);
+	void Bind();
+	void Unbind();
+};
+
 class FGLModelRenderer : public FModelRenderer
 {
 public:
@@ -46,7 +67,14 @@ public:
 	void SetMaterial(FTexture *skin, bool clampNoFilter, int translation) override;
 	void DrawArrays(int start, int count) override;
 	void DrawElements(int numIndices, size_t offset) override;
+
+	void RenderModelBatch(GLSprite **sprites, const int *lightindices, int count);
+
+private:
+	int mInstanceCount = 0;
 };
 
+bool gl_ModelInstancingActive();
 void gl_RenderModel(GLSprite * spr);
+void gl_RenderModelBatch(GLSprite **sprites, const int *lightindices, int count);
 void gl_RenderHUDModel(DPSprite *psp, float ofsx, float ofsy);
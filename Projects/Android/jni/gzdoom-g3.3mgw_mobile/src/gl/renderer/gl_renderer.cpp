@@ -111,6 +111,7 @@ FGLRenderer::FGLRenderer(OpenGLFrameBuffer *fb)
 	mVBO = nullptr;
 	mSkyVBO = nullptr;
 	mLights = nullptr;
+	mModelInstances = nullptr;
 	gl_spriteindex = 0;
 	mShaderManager = nullptr;
 	m2DDrawer = nullptr;
@@ -212,6 +213,7 @@ void FGLRenderer::Initialize(int width, int height)
 	NextVtxBuffer();
 	NextSkyBuffer();
 	NextLightBuffer();
+	if (!gl.legacyMode) mModelInstances = new FModelInstanceBuffer;
 
 	gl_RenderState.SetVertexBuffer(mVBO);
 	mFBID = 0;
@@ -252,6 +254,7 @@ FGLRenderer::~FGLRenderer()
         delete mLightsBuff[n];
     }
 	if (mLightsBuff) delete []mLightsBuff;
+	if (mModelInstances) delete mModelInstances;
 
 
 	if (syncBuff) delete []syncBuff;
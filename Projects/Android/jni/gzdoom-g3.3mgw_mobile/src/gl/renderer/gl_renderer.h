@@ -20,6 +20,7 @@ struct FDrawInfo;
 class FShaderManager;
 class GLPortal;
 class FLightBuffer;
+class FModelInstanceBuffer;
 class FSamplerManager;
 class DPSprite;
 class FGLRenderBuffers;
@@ -202,6 +203,7 @@ public:
 	FSkyVertexBuffer *mSkyVBO;
 
 	FLightBuffer *mLights;
+	FModelInstanceBuffer *mModelInstances;
 	F2DDrawer *m2DDrawer;
 
 	GL_IRECT mScreenViewport;
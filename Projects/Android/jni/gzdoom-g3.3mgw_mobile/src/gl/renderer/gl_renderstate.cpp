@@ -80,6 +80,7 @@ void FRenderState::Reset()
 	mAlphaThreshold = 0.5f;
 	mBlendEquation = GL_FUNC_ADD;
 	mModelMatrixEnabled = false;
+	mInstancingEnabled = false;
 	mTextureMatrixEnabled = false;
 	mAddColor = 0;
 	mObjectColor = 0xffffffff;
@@ -180,6 +181,7 @@ bool FRenderState::ApplyShader()
 	activeShader->muObjectColor.Set(mObjectColor);
 	activeShader->muDynLightColor.Set(mDynColor.vec);
 	activeShader->muInterpolationFactor.Set(mInterpolationFactor);
+	activeShader->muInstanced.Set(mInstancingEnabled);
 	activeShader->muClipHeight.Set(mClipHeight);
 	activeShader->muClipHeightDirection.Set(mClipHeightDirection);
 	activeShader->muShadowmapFilter.Set(static_cast<int>(gl_shadowmap_filter));
@@ -91,6 +91,7 @@ class FRenderState
 	float mAlphaThreshold;
 	int mBlendEquation;
 	bool mModelMatrixEnabled;
+	bool mInstancingEnabled;
 	bool mTextureMatrixEnabled;
 	bool mLastDepthClamp;
 	float mInterpolationFactor;
@@ -347,6 +348,11 @@ public:
 		mModelMatrixEnabled = on;
 	}
 
+	void EnableInstancing(bool on)
+	{
+		mInstancingEnabled = on;
+	}
+
 	void EnableTextureMatrix(bool on)
 	{
 		mTextureMatrixEnabled = on;
@@ -41,6 +41,7 @@
 #include "gl/scene/gl_scenedrawer.h"
 #include "gl/scene/gl_portal.h"
 #include "gl/scene/gl_wall.h"
+#include "gl/scene/gl_occlusion.h"
 #include "gl/utility/gl_clock.h"
 
 EXTERN_CVAR(Bool, gl_render_segs)
@@ -48,6 +49,7 @@ EXTERN_CVAR(Bool, gl_render_segs)
 CVAR(Bool, gl_render_things, true, 0)
 CVAR(Bool, gl_render_walls, true, 0)
 CVAR(Bool, gl_render_flats, true, 0)
+CVAR(Bool, gl_occlusionbuffer, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 
 void GLSceneDrawer::UnclipSubsector(subsector_t *sub)
 {
@@ -150,6 +152,7 @@ void GLSceneDrawer::AddLine (seg_t *seg, bool portalclip)
 	if (!seg->backsector)
 	{
 		clipper.SafeAddClipRange(startAngle, endAngle);
+		if (gl_OcclusionBuffer.IsActive()) AddOccluder(seg);
 	}
 	else if (!ispoly)	// Two-sided polyobjects never obstruct the view
 	{
@@ -419,6 +422,100 @@ void GLSceneDrawer::RenderThings(subsector_t * sub, sector_t * sector)
 }
 
 
+//==========================================================================
+//
+// Solid walls are rasterized into the occlusion buffer so that
+// subsectors and sprites behind them can be skipped.
+//
+//==========================================================================
+
+void GLSceneDrawer::AddOccluder(seg_t *seg)
+{
+	line_t *line = seg->linedef;
+	if (line->isVisualPortal() || line->special == Line_Mirror || line->special == Line_Horizon) return;
+
+	DVector2 v1 = seg->v1->fPos();
+	DVector2 v2 = seg->v2->fPos();
+	gl_OcclusionBuffer.AddWall(v1, v2,
+		currentsector->floorplane.ZatPoint(v1), currentsector->floorplane.ZatPoint(v2),
+		currentsector->ceilingplane.ZatPoint(v1), currentsector->ceilingplane.ZatPoint(v2));
+}
+
+//==========================================================================
+//
+// Checks if a subsector is completely hidden behind walls that were
+// already added to the occlusion buffer. Anything that may draw outside
+// the planes of the adjoining sectors is never considered occluded.
+//
+//==========================================================================
+
+bool GLSceneDrawer::IsSubsectorOccluded(subsector_t *sub, sector_t *sector)
+{
+	if (!gl_OcclusionBuffer.IsActive()) return false;
+	if (sub->polys != nullptr || (sub->hacked & 1) || sector->GetHeightSec() || sector->e->XFloor.ffloors.Size() > 0) return false;
+
+	double minx = FLT_MAX, miny = FLT_MAX, maxx = -FLT_MAX, maxy = -FLT_MAX;
+	double minz = FLT_MAX, maxz = -FLT_MAX;
+
+	auto addplanes = [&](sector_t *sec, const DVector2 &pos)
+	{
+		if (sec->GetTexture(sector_t::floor) == skyflatnum || sec->Portals[sector_t::floor] != 0 || sec->GetGLPortal(sector_t::floor) != nullptr) minz = -FLT_MAX;
+		else minz = MIN(minz, sec->floorplane.ZatPoint(pos));
+		if (sec->GetTexture(sector_t::ceiling) == skyflatnum || sec->Portals[sector_t::ceiling] != 0 || sec->GetGLPortal(sector_t::ceiling) != nullptr) maxz = FLT_MAX;
+		else maxz = MAX(maxz, sec->ceilingplane.ZatPoint(pos));
+	};
+
+	seg_t *seg = sub->firstline;
+	for (uint32_t i = 0; i < sub->numlines; i++, seg++)
+	{
+		if (seg->linedef != nullptr)
+		{
+			line_t *line = seg->linedef;
+			if (line->isVisualPortal() || line->special == Line_Mirror || line->special == Line_Horizon) return false;
+		}
+		DVector2 v1 = seg->v1->fPos();
+		DVector2 v2 = seg->v2->fPos();
+		minx = MIN(minx, v1.X);
+		maxx = MAX(maxx, v1.X);
+		miny = MIN(miny, v1.Y);
+		maxy = MAX(maxy, v1.Y);
+		addplanes(sector, v1);
+		if (seg->backsector != nullptr)
+		{
+			// upper and lower parts of this seg extend to the back sector's planes.
+			addplanes(seg->backsector, v1);
+			addplanes(seg->backsector, v2);
+		}
+	}
+	return gl_OcclusionBuffer.IsBoxOccluded(minx, miny, maxx, maxy, minz, maxz);
+}
+
+//==========================================================================
+//
+// An occluded subsector still blocks the view through its solid walls.
+//
+//==========================================================================
+
+void GLSceneDrawer::ClipOccludedSubsector(subsector_t *sub)
+{
+	int count = sub->numlines;
+	seg_t * seg = sub->firstline;
+
+	while (count--)
+	{
+		if (seg->sidedef != nullptr && seg->backsector == nullptr)
+		{
+			angle_t startAngle = clipper.GetClipAngle(seg->v2);
+			angle_t endAngle = clipper.GetClipAngle(seg->v1);
+			if (startAngle-endAngle >= ANGLE_180)
+			{
+				clipper.SafeAddClipRange(startAngle, endAngle);
+			}
+		}
+		seg++;
+	}
+}
+
 //==========================================================================
 //
 // R_Subsector
@@ -476,21 +573,30 @@ void GLSceneDrawer::DoSubsector(subsector_t * sub)
 		GLRenderer->mVBO->CheckUpdate(sector);
 	}
 
-	// [RH] Add particles
-	//int shade = LIGHT2SHADE((floorlightlevel + ceilinglightlevel)/2 + r_actualextralight);
-	if (gl_render_things)
+	bool occluded = IsSubsectorOccluded(sub, fakesector);
+	if (occluded)
 	{
-		SetupSprite.Clock();
-
-		for (i = ParticlesInSubsec[sub->Index()]; i != NO_PARTICLE; i = Particles[i].snext)
+		culled_subsectors++;
+		ClipOccludedSubsector(sub);
+	}
+	else
+	{
+		// [RH] Add particles
+		//int shade = LIGHT2SHADE((floorlightlevel + ceilinglightlevel)/2 + r_actualextralight);
+		if (gl_render_things)
 		{
-			GLSprite sprite(this);
-			sprite.ProcessParticle(&Particles[i], fakesector);
+			SetupSprite.Clock();
+
+			for (i = ParticlesInSubsec[sub->Index()]; i != NO_PARTICLE; i = Particles[i].snext)
+			{
+				GLSprite sprite(this);
+				sprite.ProcessParticle(&Particles[i], fakesector);
+			}
+			SetupSprite.Unclock();
 		}
-		SetupSprite.Unclock();
-	}
 
-	AddLines(sub, fakesector);
+		AddLines(sub, fakesector);
+	}
 
 	// BSP is traversed by subsector.
 	// A sector might have been split into several
@@ -508,7 +614,7 @@ void GLSceneDrawer::DoSubsector(subsector_t * sub)
 		sector->MoreFlags |= SECMF_DRAWN;
 	}
 
-	if (gl_render_flats)
+	if (gl_render_flats && !occluded)
 	{
 		// Subsectors with only 2 lines cannot have any area
 		if (sub->numlines>2 || (sub->hacked&1)) 
@@ -49,6 +49,7 @@
 #include "gl/shaders/gl_shader.h"
 #include "gl/stereo3d/scoped_color_mask.h"
 #include "gl/renderer/gl_quaddrawer.h"
+#include "gl/models/gl_models.h"
 
 FDrawInfo * gl_drawinfo;
 
@@ -884,6 +885,45 @@ void GLDrawList::DrawFlats(int pass)
 	RenderFlat.Unclock();
 }
 
+//==========================================================================
+//
+// Draws the model list, combining runs of identical models into
+// instanced draw calls where possible.
+//
+//==========================================================================
+void GLDrawList::DrawModels(int pass)
+{
+	if (pass == GLPASS_LIGHTSONLY || !gl_ModelInstancingActive())
+	{
+		Draw(pass);
+		return;
+	}
+
+	static TArray<GLSprite *> batch;
+
+	RenderSprite.Clock();
+	for (unsigned i = 0; i < drawitems.Size(); )
+	{
+		GLSprite *s = &sprites[drawitems[i].index];
+		unsigned count = 1;
+
+		if (s->CanBatchModel())
+		{
+			batch.Clear();
+			batch.Push(s);
+			while (i + count < drawitems.Size() && s->CanBatchModelWith(sprites[drawitems[i + count].index]))
+			{
+				batch.Push(&sprites[drawitems[i + count].index]);
+				count++;
+			}
+		}
+		if (count > 1) s->DrawModelBatch(pass, &batch[0], count);
+		else s->Draw(pass);
+		i += count;
+	}
+	RenderSprite.Unclock();
+}
+
 //==========================================================================
 //
 //
@@ -932,6 +972,27 @@ void GLDrawList::SortFlats()
 	}
 }
 
+//==========================================================================
+//
+// Sorting the models so that the ones DrawModels can batch are adjacent.
+//
+//==========================================================================
+
+void GLDrawList::SortModels()
+{
+	if (drawitems.Size() > 1)
+	{
+		std::sort(drawitems.begin(), drawitems.end(), [=](const GLDrawItem &a, const GLDrawItem &b)
+		{
+			GLSprite * s1 = &sprites[a.index];
+			GLSprite * s2 = &sprites[b.index];
+
+			if (s1->modelframe != s2->modelframe) return s1->modelframe < s2->modelframe;
+			return s1->lightlevel < s2->lightlevel;
+		});
+	}
+}
+
 //==========================================================================
 //
 //
@@ -137,6 +137,7 @@ public:
 	void Reset();
 	void SortWalls();
 	void SortFlats();
+	void SortModels();
 
 
 	void MakeSortList();
@@ -157,6 +158,7 @@ public:
 	void Draw(int pass, bool trans = false);
 	void DrawWalls(int pass);
 	void DrawFlats(int pass);
+	void DrawModels(int pass);
 	void DrawDecals();
 	
 	GLDrawList * next;
@@ -0,0 +1,277 @@
+//
+//---------------------------------------------------------------------------
+//
+// Copyright(C) 2018 Christoph Oelckers
+// All rights reserved.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+//--------------------------------------------------------------------------
+//
+/*
+** gl_occlusion.cpp
+** Software occlusion buffer for culling subsectors and sprites
+** that are hidden behind solid walls
+**
+*/
+
+#include <float.h>
+#include <math.h>
+#include "templates.h"
+#include "gl/scene/gl_occlusion.h"
+
+static const double COLUMNWIDTH = 2 * M_PI / FOcclusionBuffer::COLUMNS;
+static const double ROWHEIGHT = M_PI / FOcclusionBuffer::ROWS;
+
+// Walls closer than this are not used as occluders and boxes closer than this are never culled.
+static const double MIN_DISTANCE = 1.;
+
+FOcclusionBuffer gl_OcclusionBuffer;
+
+//==========================================================================
+//
+// Resets the buffer for a new scene. Inactive buffers never cull anything.
+//
+//==========================================================================
+
+FOcclusionBuffer::FOcclusionBuffer()
+{
+	mEmpty = false;
+	Clear(DVector3(0, 0, 0), false);
+}
+
+void FOcclusionBuffer::Clear(const DVector3 &viewpos, bool active)
+{
+	mViewPos = viewpos;
+	mActive = active;
+	if (!mEmpty)
+	{
+		for (auto &d : mDepth) d = FLT_MAX;
+		for (auto &d : mTileMax) d = FLT_MAX;
+		for (auto &d : mTileDirty) d = false;
+		mEmpty = true;
+	}
+}
+
+//==========================================================================
+//
+// Rasterizes a solid wall into all cells it completely covers.
+// v1/v2 are the wall's end points, floor/ceil the heights at these points.
+//
+//==========================================================================
+
+void FOcclusionBuffer::AddWall(const DVector2 &v1, const DVector2 &v2, double floor1, double floor2, double ceil1, double ceil2)
+{
+	if (!mActive) return;
+
+	DVector2 w(v1.X - mViewPos.X, v1.Y - mViewPos.Y);
+	DVector2 u = v2 - v1;
+	double len = u.Length();
+	if (len < MIN_DISTANCE) return;
+
+	// perpendicular distance from the viewer to the wall's line.
+	double cross = w.X * u.Y - w.Y * u.X;
+	double perp = fabs(cross) / len;
+	if (perp < MIN_DISTANCE) return;
+
+	double a1 = atan2(w.Y, w.X);
+	double a2 = atan2(w.Y + u.Y, w.X + u.X);
+	double span = a2 - a1;
+	if (span > M_PI) span -= 2 * M_PI;
+	else if (span < -M_PI) span += 2 * M_PI;
+	double start = span > 0 ? a1 : a2;
+	span = fabs(span);
+	if (start < 0) start += 2 * M_PI;
+
+	// only columns that lie entirely within the wall's angular span are affected.
+	int col1 = (int)ceil(start / COLUMNWIDTH);
+	int col2 = (int)floor((start + span) / COLUMNWIDTH) - 1;
+	if (col2 < col1) return;
+
+	// parameter of the foot point of the perpendicular, needed for the nearest distance.
+	double tfoot = -(w.X * u.X + w.Y * u.Y) / (len * len);
+	DVector2 foot(w.X + u.X * tfoot, w.Y + u.Y * tfoot);
+	double footangle = atan2(foot.Y, foot.X);
+	if (footangle < 0) footangle += 2 * M_PI;
+	bool footonwall = tfoot >= 0 && tfoot <= 1;
+
+	double vz = mViewPos.Z;
+	double tl = 0, dl = 0;
+
+	for (int col = col1; col <= col2 + 1; col++)
+	{
+		// intersect the ray at the column's edge with the wall
+		double angle = col * COLUMNWIDTH;
+		double ex = cos(angle), ey = sin(angle);
+		double denom = ex * u.Y - ey * u.X;
+		if (fabs(denom) < 1e-9) return;
+		double tr = clamp((w.X * ey - w.Y * ex) / denom, 0., 1.);
+		double dr = (w.X * u.Y - w.Y * u.X) / denom;
+
+		if (col > col1)
+		{
+			double dmax = MAX(dl, dr);
+			double dmin = MIN(dl, dr);
+			double fa = footangle;
+			double la = (col - 1) * COLUMNWIDTH;
+			while (fa < la) fa += 2 * M_PI;
+			if (footonwall && fa < angle) dmin = perp;
+
+			double ztop = MIN(ceil1 + (ceil2 - ceil1) * tl, ceil1 + (ceil2 - ceil1) * tr) - vz;
+			double zbot = MAX(floor1 + (floor2 - floor1) * tl, floor1 + (floor2 - floor1) * tr) - vz;
+			if (ztop > zbot && dmin >= MIN_DISTANCE)
+			{
+				double top = atan(ztop >= 0 ? ztop / dmax : ztop / dmin);
+				double bottom = atan(zbot >= 0 ? zbot / dmin : zbot / dmax);
+				int row1 = MAX(0, (int)ceil((bottom + M_PI / 2) / ROWHEIGHT));
+				int row2 = MIN(ROWS - 1, (int)floor((top + M_PI / 2) / ROWHEIGHT) - 1);
+				if (row1 <= row2)
+				{
+					int column = (col - 1) & (COLUMNS - 1);
+					float depth = (float)dmax;
+					for (int row = row1; row <= row2; row++)
+					{
+						float &cell = Cell(column, row);
+						if (depth < cell)
+						{
+							cell = depth;
+							mTileDirty[(row / TILE) * TILECOLUMNS + column / TILE] = true;
+							mEmpty = false;
+						}
+					}
+				}
+			}
+		}
+		tl = tr;
+		dl = dr;
+	}
+}
+
+//==========================================================================
+//
+// Returns the largest depth within a tile. Since depths only ever get
+// smaller the cached value is always conservative, even if stale.
+//
+//==========================================================================
+
+float FOcclusionBuffer::TileMax(int tcolumn, int trow)
+{
+	int index = trow * TILECOLUMNS + tcolumn;
+	if (mTileDirty[index])
+	{
+		float m = 0;
+		for (int row = trow * TILE; row < (trow + 1) * TILE; row++)
+		{
+			for (int col = tcolumn * TILE; col < (tcolumn + 1) * TILE; col++)
+			{
+				m = MAX(m, Cell(col, row));
+			}
+		}
+		mTileMax[index] = m;
+		mTileDirty[index] = false;
+	}
+	return mTileMax[index];
+}
+
+//==========================================================================
+//
+// Checks if all cells in the given range are closer than dist.
+// col2 may be larger than COLUMNS if the range wraps around.
+//
+//==========================================================================
+
+bool FOcclusionBuffer::IsRangeOccluded(int col1, int col2, int row1, int row2, float dist)
+{
+	for (int trow = row1 / TILE; trow <= row2 / TILE; trow++)
+	{
+		int r1 = MAX(row1, trow * TILE);
+		int r2 = MIN(row2, trow * TILE + TILE - 1);
+		for (int tcol = col1 / TILE; tcol <= col2 / TILE; tcol++)
+		{
+			int tcolumn = tcol & (TILECOLUMNS - 1);
+			if (TileMax(tcolumn, trow) < dist) continue;
+
+			int c1 = MAX(col1, tcol * TILE);
+			int c2 = MIN(col2, tcol * TILE + TILE - 1);
+			for (int col = c1; col <= c2; col++)
+			{
+				int column = col & (COLUMNS - 1);
+				for (int row = r1; row <= r2; row++)
+				{
+					if (Cell(column, row) >= dist) return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+//==========================================================================
+//
+// Checks if an axis aligned box is completely hidden.
+// The z values may be infinite for boxes without an upper or lower bound.
+//
+//==========================================================================
+
+bool FOcclusionBuffer::IsBoxOccluded(double minx, double miny, double maxx, double maxy, double minz, double maxz)
+{
+	if (!mActive || mEmpty) return false;
+
+	double vx = mViewPos.X, vy = mViewPos.Y, vz = mViewPos.Z;
+	if (vx >= minx - MIN_DISTANCE && vx <= maxx + MIN_DISTANCE && vy >= miny - MIN_DISTANCE && vy <= maxy + MIN_DISTANCE) return false;
+
+	double nx = clamp(vx, minx, maxx) - vx;
+	double ny = clamp(vy, miny, maxy) - vy;
+	double dmin = sqrt(nx * nx + ny * ny);
+	if (dmin < MIN_DISTANCE) return false;
+
+	double cx = (minx + maxx) * 0.5 - vx;
+	double cy = (miny + maxy) * 0.5 - vy;
+	double center = atan2(cy, cx);
+	double lo = 0, hi = 0, dmax = 0;
+	const double xs[] = { minx - vx, maxx - vx };
+	const double ys[] = { miny - vy, maxy - vy };
+	for (double x : xs)
+	{
+		for (double y : ys)
+		{
+			double rel = atan2(y, x) - center;
+			if (rel > M_PI) rel -= 2 * M_PI;
+			else if (rel < -M_PI) rel += 2 * M_PI;
+			lo = MIN(lo, rel);
+			hi = MAX(hi, rel);
+			dmax = MAX(dmax, x * x + y * y);
+		}
+	}
+	if (hi - lo >= M_PI) return false;
+	dmax = sqrt(dmax);
+
+	if (center < 0) center += 2 * M_PI;
+	int col1 = (int)floor((center + lo) / COLUMNWIDTH);
+	int col2 = (int)floor((center + hi) / COLUMNWIDTH);
+	if (col1 < 0)
+	{
+		col1 += COLUMNS;
+		col2 += COLUMNS;
+	}
+
+	double ztop = maxz - vz;
+	double zbot = minz - vz;
+	double top = maxz >= FLT_MAX ? M_PI / 2 : atan(ztop >= 0 ? ztop / dmin : ztop / dmax);
+	double bottom = minz <= -FLT_MAX ? -M_PI / 2 : atan(zbot >= 0 ? zbot / dmax : zbot / dmin);
+	int row1 = clamp((int)floor((bottom + M_PI / 2) / ROWHEIGHT), 0, ROWS - 1);
+	int row2 = clamp((int)floor((top + M_PI / 2) / ROWHEIGHT), 0, ROWS - 1);
+
+	return IsRangeOccluded(col1, col2, row1, row2, (float)dmin);
+}
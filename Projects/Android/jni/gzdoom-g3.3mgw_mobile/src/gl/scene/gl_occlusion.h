@@ -0,0 +1,58 @@
+#ifndef __GL_OCCLUSION
+#define __GL_OCCLUSION
+
+#include "doomtype.h"
+#include "vectors.h"
+
+//==========================================================================
+//
+// Low resolution software depth buffer for the BSP walk.
+//
+// The buffer is laid out around the viewer in world space: columns cover
+// the full circle of yaw angles and rows cover the elevation from straight
+// down to straight up, so it does not depend on pitch, FOV or aspect.
+// Each cell stores the horizontal distance to the farthest point of the
+// closest solid wall that covers the entire cell. A box whose nearest point
+// is farther away than all cells it touches cannot be visible.
+//
+// Coarse tiles keep the maximum of their cells so that the common case of
+// a box behind a large wall can be decided without looking at every cell.
+//
+//==========================================================================
+
+class FOcclusionBuffer
+{
+public:
+	enum
+	{
+		COLUMNS = 256,
+		ROWS = 64,
+		TILE = 8,
+		TILECOLUMNS = COLUMNS / TILE,
+		TILEROWS = ROWS / TILE,
+	};
+
+	FOcclusionBuffer();
+	void Clear(const DVector3 &viewpos, bool active);
+	void Deactivate() { mActive = false; }
+	bool IsActive() const { return mActive; }
+
+	void AddWall(const DVector2 &v1, const DVector2 &v2, double floor1, double floor2, double ceil1, double ceil2);
+	bool IsBoxOccluded(double minx, double miny, double maxx, double maxy, double minz, double maxz);
+
+private:
+	float &Cell(int column, int row) { return mDepth[row * COLUMNS + column]; }
+	float TileMax(int tcolumn, int trow);
+	bool IsRangeOccluded(int col1, int col2, int row1, int row2, float dist);
+
+	float mDepth[COLUMNS * ROWS];
+	float mTileMax[TILECOLUMNS * TILEROWS];
+	bool mTileDirty[TILECOLUMNS * TILEROWS];
+	DVector3 mViewPos;
+	bool mActive = false;
+	bool mEmpty = true;
+};
+
+extern FOcclusionBuffer gl_OcclusionBuffer;
+
+#endif
@@ -72,6 +72,10 @@ EXTERN_CVAR(Bool, gl_portals)
 EXTERN_CVAR(Bool, gl_noquery)
 EXTERN_CVAR(Int, r_mirror_recursions)
 
+// Culls portals based on an occlusion query from an earlier frame instead of waiting for the GPU.
+// A portal that just became visible will be missing for one frame.
+CVAR(Bool, gl_portalocclusion, false, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+
 GLSceneDrawer *GLPortal::drawer;
 TArray<GLPortal *> GLPortal::portals;
 TArray<float> GLPortal::planestack;
@@ -81,6 +85,8 @@ int GLPortal::PlaneMirrorFlag;
 int GLPortal::renderdepth;
 int GLPortal::PlaneMirrorMode;
 GLuint GLPortal::QueryObject;
+TArray<FPortalQuery> GLPortal::PortalQueries;
+int GLPortal::QueryFrame;
 
 int		 GLPortal::instack[2];
 bool	 GLPortal::inskybox;
@@ -203,19 +209,57 @@ bool GLPortal::Start(bool usestencil, bool doquery)
 			if (NeedDepthBuffer())
 			{
 				glDepthMask(false);							// don't write to Z-buffer!
-				if (!NeedDepthBuffer()) doquery = false;		// too much overhead and nothing to gain.
-				else if (gl_noquery) doquery = false;
+				if (gl_noquery) doquery = false;
 
+				int queryslot = gl_portalocclusion ? FindPortalQuery() : -1;
+				if (queryslot >= 0)
+				{
+					// Decide with the last available result so that the GPU does not need to be waited for.
+					// A new query is only started once the previous one has delivered its result.
+					FPortalQuery &q = PortalQueries[queryslot];
+					bool startquery = !q.pending;
+					doquery = false;
+
+					if (startquery) glBeginQuery(GL_ANY_SAMPLES_PASSED, q.query);
+					if (q.occluded)
+					{
+						// Only draw the shape for the query, nothing gets written.
+						glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+						DrawPortalStencil(STP_Stencil);
+						if (startquery)
+						{
+							glEndQuery(GL_ANY_SAMPLES_PASSED);
+							q.pending = true;
+						}
+						glStencilFunc(GL_EQUAL, recursion, ~0);
+						glDepthMask(true);
+						gl_RenderState.EnableTexture(true);
+						gl_RenderState.SetEffect(EFF_NONE);
+						culled_portals++;
+						portal_saved_draws += q.lastcost;
+						return false;
+					}
+					DrawPortalStencil(STP_Stencil);
+					if (startquery)
+					{
+						glEndQuery(GL_ANY_SAMPLES_PASSED);
+						q.pending = true;
+					}
+					mQuerySlot = queryslot;
+					mDrawCost = DrawCount();
+				}
 				// If occlusion query is supported let's use it to avoid rendering portals that aren't visible
-				if (QueryObject)
+				else if (doquery && QueryObject)
 				{
 					glBeginQuery(GL_SAMPLES_PASSED, QueryObject);
+					DrawPortalStencil(STP_Stencil);
+					glEndQuery(GL_SAMPLES_PASSED);
+				}
+				else
+				{
+					doquery = false;
+					DrawPortalStencil(STP_Stencil);
 				}
-				else doquery = false;	// some kind of error happened
-
-				DrawPortalStencil(STP_Stencil);
-
-				glEndQuery(GL_SAMPLES_PASSED);
 
 				// Clear Z-buffer
 				glStencilFunc(GL_EQUAL, recursion + 1, ~0);		// draw sky into stencil
@@ -234,7 +278,7 @@ bool GLPortal::Start(bool usestencil, bool doquery)
 
 				GLuint sampleCount;
 
-				if (QueryObject)
+				if (doquery)
 				{
 					glGetQueryObjectuiv(QueryObject, GL_QUERY_RESULT, &sampleCount);
 
@@ -343,6 +387,12 @@ void GLPortal::End(bool usestencil)
 {
 	bool needdepth = NeedDepthBuffer();
 
+	if (mQuerySlot >= 0)
+	{
+		PortalQueries[mQuerySlot].lastcost = DrawCount() - mDrawCost;
+		mQuerySlot = -1;
+	}
+
 	PortalAll.Clock();
 	if (PrevPortal != NULL) PrevPortal->PopState();
 	GLRenderer->mCurrentPortal = PrevPortal;
@@ -459,10 +509,68 @@ void GLPortal::StartFrame()
 	{
 		inskybox=false;
 		instack[sector_t::floor]=instack[sector_t::ceiling]=0;
+
+		// Forget about portals that have not been seen for a while.
+		QueryFrame++;
+		for (int i = PortalQueries.Size() - 1; i >= 0; i--)
+		{
+			if (!PortalQueries[i].pending && QueryFrame - PortalQueries[i].lastused > 100)
+			{
+				glDeleteQueries(1, &PortalQueries[i].query);
+				PortalQueries.Delete(i);
+			}
+		}
 	}
 	renderdepth++;
 }
 
+//-----------------------------------------------------------------------------
+//
+// Finds the query for this portal and picks up its last result
+// if the GPU is done with it.
+//
+//-----------------------------------------------------------------------------
+
+int GLPortal::FindPortalQuery()
+{
+	if (gl.legacyMode || !HasStableSource()) return -1;
+
+	void *source = GetSource();
+	unsigned i;
+	for (i = 0; i < PortalQueries.Size(); i++)
+	{
+		if (PortalQueries[i].source == source && PortalQueries[i].depth == recursion) break;
+	}
+	if (i == PortalQueries.Size())
+	{
+		FPortalQuery q = { source, recursion, 0, QueryFrame, 0, false, false };
+		glGenQueries(1, &q.query);
+		if (q.query == 0) return -1;
+		PortalQueries.Push(q);
+	}
+
+	FPortalQuery &q = PortalQueries[i];
+	q.lastused = QueryFrame;
+	if (q.pending)
+	{
+		GLuint available = 0;
+		glGetQueryObjectuiv(q.query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available)
+		{
+			GLuint anysamples = 0;
+			glGetQueryObjectuiv(q.query, GL_QUERY_RESULT, &anysamples);
+			q.occluded = anysamples == 0;
+			q.pending = false;
+		}
+	}
+	return i;
+}
+
+int GLPortal::DrawCount()
+{
+	return rendered_lines + rendered_flats + rendered_sprites + rendered_decals;
+}
+
 
 //-----------------------------------------------------------------------------
 //
@@ -1280,6 +1388,12 @@ void GLPortal::Initialize()
 
 void GLPortal::Shutdown()
 {
+	for (auto &q : PortalQueries)
+	{
+		glDeleteQueries(1, &q.query);
+	}
+	PortalQueries.Clear();
+
 	if (0 != QueryObject)
 	{
 		glDeleteQueries(1, &QueryObject);
@@ -80,11 +80,25 @@ extern UniqueList<FGLLinePortal> UniqueLineToLines;
 struct GLEEHorizonPortal;
 class GLSceneDrawer;
 
+// Occlusion query of one portal whose result gets used in a later frame.
+struct FPortalQuery
+{
+	void *source;
+	int depth;
+	unsigned int query;
+	int lastused;
+	int lastcost;		// what got drawn inside the portal the last time it was visible
+	bool pending;
+	bool occluded;
+};
+
 class GLPortal
 {
 	static TArray<GLPortal *> portals;
 	static int recursion;
 	static unsigned int QueryObject;
+	static TArray<FPortalQuery> PortalQueries;
+	static int QueryFrame;
 protected:
 	static TArray<float> planestack;
 	static int MirrorFlag;
@@ -121,6 +135,11 @@ private:
 	GLPortal *PrevClipPortal;
 	TArray<uint8_t> savedmapsection;
 	TArray<unsigned int> mPrimIndices;
+	int mQuerySlot = -1;
+	int mDrawCost;
+
+	int FindPortalQuery();
+	static int DrawCount();
 
 protected:
 	TArray<GLWall> lines;
@@ -137,6 +156,7 @@ protected:
 	virtual bool IsSky() { return false; }
 	virtual bool NeedCap() { return true; }
 	virtual bool NeedDepthBuffer() { return true; }
+	virtual bool HasStableSource() { return false; }	// the source can identify this portal across frames
 	void ClearScreen();
 	virtual const char *GetName() = 0;
 	void SaveMapSection();
@@ -254,6 +274,7 @@ struct GLMirrorPortal : public GLLinePortal
 protected:
 	virtual void DrawContents();
 	virtual void * GetSource() const { return linedef; }
+	virtual bool HasStableSource() { return true; }
 	virtual const char *GetName();
 
 public:
@@ -272,6 +293,7 @@ struct GLLineToLinePortal : public GLLinePortal
 protected:
 	virtual void DrawContents();
 	virtual void * GetSource() const { return glport; }
+	virtual bool HasStableSource() { return true; }
 	virtual const char *GetName();
 	virtual line_t *ClipLine() { return line(); }
 	virtual void RenderAttached();
@@ -294,6 +316,7 @@ protected:
 	virtual void DrawContents();
 	virtual void * GetSource() const { return portal; }
 	virtual bool IsSky() { return true; }
+	virtual bool HasStableSource() { return true; }
 	virtual const char *GetName();
 
 public:
@@ -340,6 +363,7 @@ protected:
 	virtual void DrawContents();
 	virtual void * GetSource() const { return origin; }
 	virtual bool IsSky() { return true; }	// although this isn't a real sky it can be handled as one.
+	virtual bool HasStableSource() { return true; }
 	virtual const char *GetName();
 	FPortal *origin;
 
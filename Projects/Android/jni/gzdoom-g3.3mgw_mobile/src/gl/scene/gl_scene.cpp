@@ -60,6 +60,7 @@
 #include "gl/models/gl_models.h"
 #include "gl/scene/gl_clipper.h"
 #include "gl/scene/gl_drawinfo.h"
+#include "gl/scene/gl_occlusion.h"
 #include "gl/scene/gl_portal.h"
 #include "gl/scene/gl_scenedrawer.h"
 #include "gl/renderer/gl_renderer.h"
@@ -91,6 +92,7 @@ EXTERN_CVAR (Float, r_visibility)
 EXTERN_CVAR (Bool, gl_legacy_mode)
 EXTERN_CVAR (Bool, r_drawvoxels)
 EXTERN_CVAR(Bool, gl_sync)
+EXTERN_CVAR(Bool, gl_occlusionbuffer)
 
 extern bool NoInterpolateView;
 
@@ -278,7 +280,9 @@ void GLSceneDrawer::CreateScene()
 	GLRenderer->mVBO->Map();
 	SetView();
 	validcount++;	// used for processing sidedefs only once by the renderer.
+	gl_OcclusionBuffer.Clear(r_viewpoint.Pos, gl_occlusionbuffer && GLRenderer->mCurrentPortal == nullptr);
 	RenderBSPNode (level.HeadNode());
+	gl_OcclusionBuffer.Deactivate();
 	if (GLRenderer->mCurrentPortal != NULL) GLRenderer->mCurrentPortal->RenderAttached();
 	Bsp.Unclock();
 
@@ -320,11 +324,16 @@ void GLSceneDrawer::RenderScene(int recursion)
 		gl_drawinfo->drawlists[GLDL_MASKEDWALLS].SortWalls();
 		gl_drawinfo->drawlists[GLDL_MASKEDFLATS].SortFlats();
 		gl_drawinfo->drawlists[GLDL_MASKEDWALLSOFS].SortWalls();
+		gl_drawinfo->drawlists[GLDL_MODELS].SortModels();
 	}
 
 	// if we don't have a persistently mapped buffer, we have to process all the dynamic lights up front,
 	// so that we don't have to do repeated map/unmap calls on the buffer.
 	bool haslights = GLRenderer->mLightCount > 0 && FixedColormap == CM_DEFAULT && vr_dynlights;
+	if (haslights)
+	{
+		GLRenderer->mShadowMap.PrepareSpriteShadows(gl_drawinfo);
+	}
 	if (gl.lightmethod == LM_DEFERRED && haslights)
 	{
 		GLRenderer->mLights->Begin();
@@ -390,7 +399,7 @@ void GLSceneDrawer::RenderScene(int recursion)
 		glPolygonOffset(0, 0);
 	}
 
-	gl_drawinfo->drawlists[GLDL_MODELS].Draw(pass);
+	gl_drawinfo->drawlists[GLDL_MODELS].DrawModels(pass);
 
 	gl_RenderState.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
@@ -22,6 +22,9 @@ class GLSceneDrawer
 	
 	void UnclipSubsector(subsector_t *sub);
 	void AddLine (seg_t *seg, bool portalclip);
+	void AddOccluder(seg_t *seg);
+	bool IsSubsectorOccluded(subsector_t *sub, sector_t *sector);
+	void ClipOccludedSubsector(subsector_t *sub);
 	void PolySubsector(subsector_t * sub);
 	void RenderPolyBSPNode (void *node);
 	void AddPolyobjs(subsector_t *sub);
@@ -51,6 +51,7 @@
 #include "gl/data/gl_data.h"
 #include "gl/dynlights/gl_glow.h"
 #include "gl/scene/gl_drawinfo.h"
+#include "gl/scene/gl_occlusion.h"
 #include "gl/scene/gl_scenedrawer.h"
 #include "gl/scene/gl_portal.h"
 #include "gl/models/gl_models.h"
@@ -362,7 +363,7 @@ void GLSprite::Draw(int pass)
 			if (modelframe && !particle)
 				dynlightindex = gl_SetDynModelLight(gl_light_sprites ? actor : NULL, dynlightindex);
 			else
-				gl_SetDynSpriteLight(gl_light_sprites ? actor : NULL, gl_light_particles ? particle : NULL);
+				gl_SetDynSpriteLight(gl_light_sprites ? actor : NULL, gl_light_particles ? particle : NULL, shadowrays);
 		}
 		sector_t *cursec = actor ? actor->Sector : particle ? particle->subsector->sector : nullptr;
 		if (cursec != nullptr)
@@ -516,6 +517,86 @@ void GLSprite::Draw(int pass)
 	gl_RenderState.SetDynLight(0,0,0);
 }
 
+//==========================================================================
+//
+// Opaque models that need none of the per-sprite special cases in Draw
+// can be drawn together with others of the same kind.
+//
+//==========================================================================
+
+bool GLSprite::CanBatchModel()
+{
+	return modelframe != nullptr && actor != nullptr && particle == nullptr && lightlist == nullptr &&
+		topclip == LARGE_VALUE && bottomclip == -LARGE_VALUE &&
+		RenderStyle == LegacyRenderStyles[STYLE_Normal] && actor->RenderStyle == LegacyRenderStyles[STYLE_Normal];
+}
+
+//==========================================================================
+//
+// Checks that the other sprite shows the same model frame with the same
+// state setup, so that only position, orientation, animation progress
+// and dynamic lights differ.
+//
+//==========================================================================
+
+bool GLSprite::CanBatchModelWith(GLSprite &other)
+{
+	if (other.modelframe != modelframe || !other.CanBatchModel()) return false;
+	if (!(modelframe->flags & MDL_IGNORETRANSLATION) && other.actor->Translation != actor->Translation) return false;
+	if (other.lightlevel != lightlevel || other.foglevel != foglevel || other.fullbright != fullbright || other.trans != trans) return false;
+	if (other.ThingColor != ThingColor || other.Colormap != Colormap || other.gltexture != gltexture || other.OverrideShader != OverrideShader) return false;
+
+	sector_t *sec = actor->Sector;
+	sector_t *othersec = other.actor->Sector;
+	return sec == othersec || (sec->SpecialColors[sector_t::sprites] == othersec->SpecialColors[sector_t::sprites] &&
+		sec->AdditiveColors[sector_t::sprites] == othersec->AdditiveColors[sector_t::sprites]);
+}
+
+//==========================================================================
+//
+// Draws a run of sprites accepted by CanBatchModelWith. This is the part
+// of Draw that applies to opaque models, with the light setup done for
+// each of them.
+//
+//==========================================================================
+
+void GLSprite::DrawModelBatch(int pass, GLSprite **batch, int count)
+{
+	static TArray<int> lightindices;
+
+	int rel = fullbright ? 0 : getExtraLight();
+	bool lights = vr_dynlights && GLRenderer->mLightCount && mDrawer->FixedColormap == CM_DEFAULT && !fullbright;
+
+	lightindices.Resize(count);
+	for (int i = 0; i < count; i++)
+	{
+		GLSprite *spr = batch[i];
+		if (lights) spr->dynlightindex = gl_SetDynModelLight(gl_light_sprites ? spr->actor : nullptr, spr->dynlightindex);
+		lightindices[i] = lights ? spr->dynlightindex : -1;
+	}
+
+	sector_t *cursec = actor->Sector;
+	const PalEntry finalcol = fullbright
+		? ThingColor
+		: ThingColor.Modulate(cursec->SpecialColors[sector_t::sprites]);
+
+	gl_RenderState.SetObjectColor(finalcol);
+	gl_RenderState.SetAddColor(cursec->AdditiveColors[sector_t::sprites] | 0xff000000);
+	mDrawer->SetColor(lightlevel, rel, Colormap, trans);
+
+	if (gl_isBlack(Colormap.FadeColor)) foglevel = lightlevel;
+	mDrawer->SetFog(foglevel, rel, &Colormap, false);
+
+	if (gltexture) gl_RenderState.SetMaterial(gltexture, CLAMP_XY, translation, OverrideShader, false);
+
+	gl_RenderModelBatch(batch, &lightindices[0], count);
+
+	gl_RenderState.SetObjectColor(0xffffffff);
+	gl_RenderState.SetAddColor(0);
+	gl_RenderState.EnableTexture(true);
+	gl_RenderState.SetDynLight(0,0,0);
+}
+
 
 //==========================================================================
 //
@@ -535,6 +616,7 @@ inline void GLSprite::PutSprite(bool translucent)
 		list = GLDL_MODELS;
 	}
 	dynlightindex = -1;
+	shadowrays = -1;
 	gl_drawinfo->drawlists[list].AddSprite(this);
 }
 
@@ -979,6 +1061,19 @@ void GLSprite::Process(AActor* thing, sector_t * sector, int thruportal)
 		gltexture = NULL;
 	}
 
+	if (gltexture != nullptr && gl_OcclusionBuffer.IsActive())
+	{
+		// The sprite may still get rotated around its center by billboarding,
+		// so test a cube that encloses it in any orientation.
+		float cx = (x1 + x2) * 0.5f, cy = (y1 + y2) * 0.5f, cz = (z1 + z2) * 0.5f;
+		float radius = FVector3(x2 - x1, y2 - y1, z1 - z2).Length();
+		if (gl_OcclusionBuffer.IsBoxOccluded(cx - radius, cy - radius, cx + radius, cy + radius, cz - radius, cz + radius))
+		{
+			culled_sprites++;
+			return;
+		}
+	}
+
 	depth = (float)((x - r_viewpoint.CenterEyePos.X) * r_viewpoint.TanCos + (y - r_viewpoint.CenterEyePos.Y) * r_viewpoint.TanSin);
 
 	// light calculation
@@ -63,7 +63,7 @@ T smoothstep(const T edge0, const T edge1, const T x)
 //
 //==========================================================================
 
-void gl_SetDynSpriteLight(AActor *self, float x, float y, float z, subsector_t * subsec)
+void gl_SetDynSpriteLight(AActor *self, float x, float y, float z, subsector_t * subsec, int shadowrays)
 {
 	FDynamicLight *light;
 	float frac, lr, lg, lb;
@@ -119,7 +119,15 @@ void gl_SetDynSpriteLight(AActor *self, float x, float y, float z, subsector_t *
 					frac *= (float)smoothstep(light->pSpotOuterAngle->Cos(), light->pSpotInnerAngle->Cos(), cosDir);
 				}
 
-				if (frac > 0 && GLRenderer->mShadowMap.ShadowTest(light, { x, y, z }))
+				bool visible;
+				if (frac <= 0)
+					visible = false;
+				else if (shadowrays >= 0)
+					visible = GLRenderer->mShadowMap.SpriteShadowTest(shadowrays, light, { x, y, z });
+				else
+					visible = GLRenderer->mShadowMap.ShadowTest(light, { x, y, z });
+
+				if (visible)
 				{
 					lr = light->GetRed() / 255.0f;
 					lg = light->GetGreen() / 255.0f;
@@ -145,15 +153,15 @@ void gl_SetDynSpriteLight(AActor *self, float x, float y, float z, subsector_t *
 	modellightindex = -1;
 }
 
-void gl_SetDynSpriteLight(AActor *thing, particle_t *particle)
+void gl_SetDynSpriteLight(AActor *thing, particle_t *particle, int shadowrays)
 {
 	if (thing != NULL)
 	{
-		gl_SetDynSpriteLight(thing, (float)thing->X(), (float)thing->Y(), (float)thing->Center(), thing->subsector);
+		gl_SetDynSpriteLight(thing, (float)thing->X(), (float)thing->Y(), (float)thing->Center(), thing->subsector, shadowrays);
 	}
 	else if (particle != NULL)
 	{
-		gl_SetDynSpriteLight(NULL, (float)particle->Pos.X, (float)particle->Pos.Y, (float)particle->Pos.Z, particle->subsector);
+		gl_SetDynSpriteLight(NULL, (float)particle->Pos.X, (float)particle->Pos.Y, (float)particle->Pos.Z, particle->subsector, shadowrays);
 	}
 }
 
@@ -204,6 +204,8 @@ private:
 
 	void Put3DWall(lightlist_t * lightlist, bool translucent);
 	bool SplitWallComplex(sector_t * frontsector, bool translucent, float& maplightbottomleft, float& maplightbottomright);
+	void PutSplitPiece(TArray<lightlist_t> &lightlist, int light, bool translucent);
+	void DoSplitWall(sector_t * frontsector, bool translucent);
 	void SplitWall(sector_t * frontsector, bool translucent);
 
 	void SetupLights();
@@ -389,6 +391,7 @@ public:
 	float x2,y2,z2;
 	float trans;
 	int dynlightindex;
+	int shadowrays;	// first light of this sprite in FShadowMap's sprite ray results
 
 	FMaterial *gltexture;
 	AActor * actor;
@@ -409,6 +412,9 @@ public:
 		mDrawer = drawer;
 	}
 	void Draw(int pass);
+	bool CanBatchModel();
+	bool CanBatchModelWith(GLSprite &other);
+	void DrawModelBatch(int pass, GLSprite **batch, int count);
 	void PutSprite(bool translucent);
 	void Process(AActor* thing,sector_t * sector, int thruportal = false);
 	void ProcessParticle (particle_t *particle, sector_t *sector);//, int shade, int fakeside)
@@ -425,8 +431,8 @@ inline float Dist2(float x1,float y1,float x2,float y2)
 
 // Light + color
 
-void gl_SetDynSpriteLight(AActor *self, float x, float y, float z, subsector_t *subsec);
-void gl_SetDynSpriteLight(AActor *actor, particle_t *particle);
+void gl_SetDynSpriteLight(AActor *self, float x, float y, float z, subsector_t *subsec, int shadowrays = -1);
+void gl_SetDynSpriteLight(AActor *actor, particle_t *particle, int shadowrays = -1);
 int gl_SetDynModelLight(AActor *self, int dynlightindex);
 
 #endif
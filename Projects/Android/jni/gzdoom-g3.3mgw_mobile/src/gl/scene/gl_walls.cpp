@@ -257,8 +257,8 @@ bool GLWall::SplitWallComplex(sector_t * frontsector, bool translucent, float& m
 			copyWall1.tcs[LORGT].u = copyWall2.tcs[LOLFT].u = tcs[LOLFT].u + coeff * (tcs[LORGT].u - tcs[LOLFT].u);
 			copyWall1.tcs[LORGT].v = copyWall2.tcs[LOLFT].v = tcs[LOLFT].v + coeff * (tcs[LORGT].v - tcs[LOLFT].v);
 
-			copyWall1.SplitWall(frontsector, translucent);
-			copyWall2.SplitWall(frontsector, translucent);
+			copyWall1.DoSplitWall(frontsector, translucent);
+			copyWall2.DoSplitWall(frontsector, translucent);
 			return true;
 		}
 	}
@@ -298,8 +298,8 @@ bool GLWall::SplitWallComplex(sector_t * frontsector, bool translucent, float& m
 			copyWall1.tcs[LORGT].u = copyWall2.tcs[LOLFT].u = tcs[LOLFT].u + coeff * (tcs[LORGT].u - tcs[LOLFT].u);
 			copyWall1.tcs[LORGT].v = copyWall2.tcs[LOLFT].v = tcs[LOLFT].v + coeff * (tcs[LORGT].v - tcs[LOLFT].v);
 
-			copyWall1.SplitWall(frontsector, translucent);
-			copyWall2.SplitWall(frontsector, translucent);
+			copyWall1.DoSplitWall(frontsector, translucent);
+			copyWall2.DoSplitWall(frontsector, translucent);
 			return true;
 		}
 	}
@@ -307,7 +307,201 @@ bool GLWall::SplitWallComplex(sector_t * frontsector, bool translucent, float& m
 	return false;
 }
 
+//==========================================================================
+//
+// Per-sidedef cache of the pieces a wall gets split into by a 3D floor
+// light list. An entry is valid as long as the wall's geometry is the same
+// and the sector's light list has not been rebuilt since it was recorded.
+// Only the geometry is cached, the light levels and colormaps are always
+// taken from the current light list.
+//
+//==========================================================================
+
+struct FWallSplitKey
+{
+	GLSeg glseg;
+	float ztop[2], zbottom[2];
+	texcoord tcs[4];
+	uint16_t flags;
+};
+
+struct FWallSplitPiece
+{
+	FWallSplitKey geo;
+	int light;			// index into the light list or -1 for clip plane splitting
+};
+
+struct FWallSplitCacheEntry
+{
+	seg_t *seg;
+	extsector_t *ext;
+	FMaterial *gltexture;
+	uint8_t type;
+	int lightliststamp;
+	FWallSplitKey key;
+	FWallSplitKey result;	// what SplitWall leaves in the wall it was called for
+	bool resultput;
+	GLWall *owner;			// only valid while recording
+	TArray<FWallSplitPiece> pieces;
+};
+
+enum
+{
+	SPLITCACHE_ENTRIES_PER_SIDE = 8,
+	SPLITCACHE_FLAGS = GLWall::GLWF_NOSPLITUPPER | GLWall::GLWF_NOSPLITLOWER,
+};
+
+static TArray<TArray<FWallSplitCacheEntry>> WallSplitCache;
+static FWallSplitCacheEntry *SplitRecording;
+
+static void GetSplitKey(FWallSplitKey &key, const GLSeg &glseg, const float *ztop, const float *zbottom, const texcoord *tcs, int flags)
+{
+	memset(&key, 0, sizeof(key));
+	key.glseg = glseg;
+	memcpy(key.ztop, ztop, sizeof(key.ztop));
+	memcpy(key.zbottom, zbottom, sizeof(key.zbottom));
+	memcpy(key.tcs, tcs, sizeof(key.tcs));
+	key.flags = flags & SPLITCACHE_FLAGS;
+}
+
+void gl_ClearWallCaches()
+{
+	WallSplitCache.Clear();
+	SplitRecording = nullptr;
+	gl_ClearGlowCache();
+}
+
+//==========================================================================
+//
+// Puts one piece of a split wall, either lit by a single entry of
+// the light list or clipped against it in the shader.
+//
+//==========================================================================
+
+void GLWall::PutSplitPiece(TArray<lightlist_t> &lightlist, int light, bool translucent)
+{
+	if (SplitRecording != nullptr)
+	{
+		FWallSplitPiece &piece = SplitRecording->pieces[SplitRecording->pieces.Reserve(1)];
+		GetSplitKey(piece.geo, glseg, ztop, zbottom, tcs, flags);
+		piece.light = light;
+		if (this == SplitRecording->owner) SplitRecording->resultput = true;
+	}
+
+	if (light < 0)
+	{
+		this->lightlist = &lightlist;
+		PutWall(translucent);
+	}
+	else
+	{
+		Put3DWall(&lightlist[light], translucent);
+	}
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
 void GLWall::SplitWall(sector_t * frontsector, bool translucent)
+{
+	if (!gl_wallcache || seg->sidedef == nullptr || (glseg.x1 == glseg.x2 && glseg.y1 == glseg.y2))
+	{
+		DoSplitWall(frontsector, translucent);
+		return;
+	}
+
+	unsigned sidenum = seg->sidedef->Index();
+	if (WallSplitCache.Size() != level.sides.Size())
+	{
+		WallSplitCache.Clear();
+		WallSplitCache.Resize(level.sides.Size());
+	}
+
+	extsector_t *ext = frontsector->e;
+	FWallSplitKey key;
+	GetSplitKey(key, glseg, ztop, zbottom, tcs, flags);
+
+	TArray<FWallSplitCacheEntry> &entries = WallSplitCache[sidenum];
+	FWallSplitCacheEntry *entry = nullptr;
+	for (auto &e : entries)
+	{
+		if (e.seg == seg && e.ext == ext && e.type == type && e.gltexture == gltexture)
+		{
+			entry = &e;
+			break;
+		}
+	}
+
+	if (entry != nullptr && entry->lightliststamp == ext->XFloor.lightliststamp && !memcmp(&entry->key, &key, sizeof(key)))
+	{
+		wallcache_hits++;
+
+		TArray<lightlist_t> &lightlist = ext->XFloor.lightlist;
+		int origlight = lightlevel;
+		FColormap origcm = Colormap;
+		for (auto &piece : entry->pieces)
+		{
+			GLWall copyWall = *this;
+			copyWall.glseg = piece.geo.glseg;
+			memcpy(copyWall.ztop, piece.geo.ztop, sizeof(ztop));
+			memcpy(copyWall.zbottom, piece.geo.zbottom, sizeof(zbottom));
+			memcpy(copyWall.tcs, piece.geo.tcs, sizeof(tcs));
+			copyWall.flags = (flags & ~SPLITCACHE_FLAGS) | piece.geo.flags;
+			if (piece.light < 0)
+			{
+				copyWall.lightlist = &lightlist;
+				copyWall.PutWall(translucent);
+			}
+			else
+			{
+				copyWall.Put3DWall(&lightlist[piece.light], translucent);
+			}
+		}
+		memcpy(ztop, entry->result.ztop, sizeof(ztop));
+		memcpy(zbottom, entry->result.zbottom, sizeof(zbottom));
+		memcpy(tcs, entry->result.tcs, sizeof(tcs));
+		if (entry->resultput) vertcount = 0;
+		lightlevel = origlight;
+		Colormap = origcm;
+		flags &= ~GLWF_NOSPLITUPPER;
+		this->lightlist = nullptr;
+		return;
+	}
+
+	wallcache_misses++;
+	if (entry == nullptr)
+	{
+		if (entries.Size() >= SPLITCACHE_ENTRIES_PER_SIDE) entries.Delete(0);
+		entry = &entries[entries.Reserve(1)];
+		entry->seg = seg;
+		entry->ext = ext;
+		entry->type = type;
+		entry->gltexture = gltexture;
+	}
+	entry->lightliststamp = ext->XFloor.lightliststamp;
+	entry->key = key;
+	entry->resultput = false;
+	entry->pieces.Clear();
+	entry->owner = this;
+
+	SplitRecording = entry;
+	DoSplitWall(frontsector, translucent);
+	SplitRecording = nullptr;
+
+	entry->owner = nullptr;
+	GetSplitKey(entry->result, glseg, ztop, zbottom, tcs, flags);
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void GLWall::DoSplitWall(sector_t * frontsector, bool translucent)
 {
 	float maplightbottomleft;
 	float maplightbottomright;
@@ -360,8 +554,7 @@ void GLWall::SplitWall(sector_t * frontsector, bool translucent)
 				if (!(gl.flags & RFL_NO_CLIP_PLANES))
 				{
 					// Use hardware clipping if this cannot be done cleanly.
-					this->lightlist = &lightlist;
-					PutWall(translucent);
+					PutSplitPiece(lightlist, -1, translucent);
 
 					goto out;
 				}
@@ -375,7 +568,7 @@ void GLWall::SplitWall(sector_t * frontsector, bool translucent)
 			// 3D floor is completely within this light
 			if (maplightbottomleft<=zbottom[0] && maplightbottomright<=zbottom[1])
 			{
-				Put3DWall(&lightlist[i], translucent);
+				PutSplitPiece(lightlist, i, translucent);
 				goto out;
 			}
 
@@ -392,7 +585,7 @@ void GLWall::SplitWall(sector_t * frontsector, bool translucent)
 					(maplightbottomleft-copyWall1.ztop[0])*(copyWall1.tcs[LOLFT].v-copyWall1.tcs[UPLFT].v)/(zbottom[0]-copyWall1.ztop[0]);
 				tcs[UPRGT].v=copyWall1.tcs[LORGT].v=copyWall1.tcs[UPRGT].v+ 
 					(maplightbottomright-copyWall1.ztop[1])*(copyWall1.tcs[LORGT].v-copyWall1.tcs[UPRGT].v)/(zbottom[1]-copyWall1.ztop[1]);
-				copyWall1.Put3DWall(&lightlist[i], translucent);
+				copyWall1.PutSplitPiece(lightlist, i, translucent);
 			}
 			if (ztop[0]==zbottom[0] && ztop[1]==zbottom[1]) 
 			{
@@ -402,7 +595,7 @@ void GLWall::SplitWall(sector_t * frontsector, bool translucent)
 		}
 	}
 
-	Put3DWall(&lightlist[lightlist.Size()-1], translucent);
+	PutSplitPiece(lightlist, lightlist.Size()-1, translucent);
 
 out:
 	lightlevel=origlight;
@@ -163,12 +163,48 @@ void GLWall::SetupLights()
 //
 //==========================================================================
 
+static int StaticWallPart(int type)
+{
+	switch (type)
+	{
+	case RENDERWALL_TOP:
+		return 0;
+
+	case RENDERWALL_M1S:
+	case RENDERWALL_M2S:
+	case RENDERWALL_M2SNF:
+		return 1;
+
+	case RENDERWALL_BOTTOM:
+		return 2;
+
+	default:
+		return -1;
+	}
+}
+
 void GLWall::MakeVertices(bool nosplit)
 {
 	if (vertcount == 0)
 	{
 		bool split = (gl_seamless && !nosplit && seg->sidedef != NULL && !(seg->sidedef->Flags & WALLF_POLYOBJ) && !(flags & GLWF_NOSPLIT));
 
+		// Unsplit walls can use the sidedef's static vertex range.
+		int part = StaticWallPart(type);
+		if (!split && part >= 0 && seg->sidedef != NULL)
+		{
+			FFlatVertex verts[4];
+			verts[0].Set(glseg.x1, zbottom[0], glseg.y1, tcs[LOLFT].u, tcs[LOLFT].v);
+			verts[1].Set(glseg.x1, ztop[0], glseg.y1, tcs[UPLFT].u, tcs[UPLFT].v);
+			verts[2].Set(glseg.x2, ztop[1], glseg.y2, tcs[UPRGT].u, tcs[UPRGT].v);
+			verts[3].Set(glseg.x2, zbottom[1], glseg.y2, tcs[LORGT].u, tcs[LORGT].v);
+			if (GLRenderer->mVBO->GetStaticWall(seg->sidedef->Index() * FFlatVertexBuffer::WALLSLOTS_PER_SIDE + part, verts, &vertindex))
+			{
+				vertcount = 4;
+				return;
+			}
+		}
+
 		FFlatVertex *ptr = GLRenderer->mVBO->GetBuffer();
 
 		if (ptr != nullptr) {
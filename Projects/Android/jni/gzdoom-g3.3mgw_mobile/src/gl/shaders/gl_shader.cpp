@@ -361,6 +361,9 @@ bool FShader::Load(const char * name, const char * vert_prog_lump, const char *
 	// dynamic lights
 	i_data += "uniform int uLightIndex;\n";
 
+	// instanced model rendering: matrices, interpolation and light index come from vertex attributes
+	i_data += "uniform int uInstanced;\n";
+
 	// Software fuzz scaling
 	i_data += "uniform int uViewHeight;\n";
 
@@ -602,6 +605,9 @@ bool FShader::Load(const char * name, const char * vert_prog_lump, const char *
 		glBindAttribLocation(hShader, VATTR_COLOR, "aColor");
 		glBindAttribLocation(hShader, VATTR_VERTEX2, "aVertex2");
 		glBindAttribLocation(hShader, VATTR_NORMAL, "aNormal");
+		glBindAttribLocation(hShader, VATTR_INSTANCEMATRIX, "aInstanceMatrix");
+		glBindAttribLocation(hShader, VATTR_INSTANCENORMAL, "aInstanceNormalMatrix");
+		glBindAttribLocation(hShader, VATTR_INSTANCEPARAMS, "aInstanceParams");
 #ifndef __MOBILE__
 		glBindFragDataLocation(hShader, 0, "FragColor");
 		glBindFragDataLocation(hShader, 1, "FragFog");
@@ -660,6 +666,7 @@ bool FShader::Load(const char * name, const char * vert_prog_lump, const char *
 	muColormapStart.Init(hShader, "uFixedColormapStart");
 	muColormapRange.Init(hShader, "uFixedColormapRange");
 	muLightIndex.Init(hShader, "uLightIndex");
+	muInstanced.Init(hShader, "uInstanced");
 	muFogColor.Init(hShader, "uFogColor");
 	muDynLightColor.Init(hShader, "uDynLightColor");
 	muObjectColor.Init(hShader, "uObjectColor");
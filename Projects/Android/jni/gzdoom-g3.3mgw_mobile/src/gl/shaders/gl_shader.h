@@ -34,7 +34,10 @@ enum
 	VATTR_TEXCOORD = 1,
 	VATTR_COLOR = 2,
 	VATTR_VERTEX2 = 3,
-	VATTR_NORMAL = 4
+	VATTR_NORMAL = 4,
+	VATTR_INSTANCEMATRIX = 5,	// 4 slots, per-instance model matrix
+	VATTR_INSTANCENORMAL = 9,	// 3 slots, per-instance normal matrix
+	VATTR_INSTANCEPARAMS = 12	// interpolation factor and light index
 };
 
 class FShaderCollection;
@@ -269,6 +272,7 @@ class FShader
 	FUniform4f muColormapStart;
 	FUniform4f muColormapRange;
 	FBufferedUniform1i muLightIndex;
+	FBufferedUniform1i muInstanced;
 	FBufferedUniformPE muFogColor;
 	FBufferedUniform4f muDynLightColor;
 	FBufferedUniformPE muObjectColor;
@@ -427,12 +427,23 @@ namespace s3d
         return false;
     }
 
+    /* virtual */
+    void OculusQuestMode::BeginFrame() const
+    {
+        if (!frameStarted)
+        {
+            QzDoom_FrameSetup();
+            frameStarted = true;
+        }
+    }
+
     /* virtual */
     void OculusQuestMode::SetUp() const
     {
         super::SetUp();
 
-        QzDoom_FrameSetup();
+        BeginFrame();
+        frameStarted = false;
 
         if (shutdown)
         {
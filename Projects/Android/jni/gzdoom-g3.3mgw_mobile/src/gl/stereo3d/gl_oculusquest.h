@@ -70,6 +70,7 @@ public:
 	static const Stereo3DMode& getInstance(); // Might return Mono mode, if no HMD available
 
 	virtual ~OculusQuestMode() override;
+	virtual void BeginFrame() const override; // waits for the runtime to release the next frame
 	virtual void SetUp() const override; // called immediately before rendering a scene frame
 	virtual void TearDown() const override; // called immediately after rendering a scene frame
 	virtual void Present() const override;
@@ -93,6 +94,7 @@ protected:
 
 	mutable int cachedScreenBlocks;
 	mutable ovrTracking2 tracking;
+	mutable bool frameStarted = false;
 
 private:
 	typedef Stereo3DMode super;
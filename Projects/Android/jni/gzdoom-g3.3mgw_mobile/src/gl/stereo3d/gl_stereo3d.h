@@ -81,6 +81,7 @@ public:
 	virtual const EyePose * getEyePose(int ix) const { return eye_ptrs(ix); }
 
 	/* hooks for setup and cleanup operations for each stereo mode */
+	virtual void BeginFrame() const {}; // called by the main loop while the playsim is running
 	virtual void SetUp() const {};
 	virtual void TearDown() const {};
 
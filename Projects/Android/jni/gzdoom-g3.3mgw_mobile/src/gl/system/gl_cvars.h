@@ -28,6 +28,7 @@ EXTERN_CVAR (Bool, gl_lights_checkside);
 EXTERN_CVAR (Bool, gl_light_sprites);
 EXTERN_CVAR (Bool, gl_light_particles);
 EXTERN_CVAR (Bool, gl_light_shadowmap);
+EXTERN_CVAR (Bool, gl_light_spriteshadows);
 EXTERN_CVAR (Int, gl_shadowmap_quality);
 
 EXTERN_CVAR(Int, gl_fogmode)
@@ -37,6 +38,7 @@ EXTERN_CVAR(Bool,gl_mirror_envmap)
 EXTERN_CVAR(Bool,gl_mirrors)
 EXTERN_CVAR(Bool,gl_mirror_envmap)
 EXTERN_CVAR(Bool, gl_seamless)
+EXTERN_CVAR(Bool, gl_wallcache)
 
 EXTERN_CVAR(Float, gl_mask_threshold)
 EXTERN_CVAR(Float, gl_mask_sprite_threshold)
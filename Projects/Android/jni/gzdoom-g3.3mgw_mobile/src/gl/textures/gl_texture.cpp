@@ -752,6 +752,20 @@ void gl_PrecacheTexture(uint8_t *texhitlist, TMap<PClassActor*, bool> &actorhitl
 		precache.Reset();
 		precache.Clock();
 
+		// Decompressing the source lumps doesn't need the GL context so this can be done on all cores up front.
+		TArray<int> lumps;
+		for (int i = cnt - 1; i >= 0; i--)
+		{
+			FTexture *tex = TexMan.ByIndex(i);
+			if (tex == nullptr || tex->GetSourceLump() < 0) continue;
+			if ((texhitlist[i] & (FTextureManager::HIT_Wall | FTextureManager::HIT_Flat | FTextureManager::HIT_Sky)) ||
+				(spritehitlist[i] != nullptr && (*spritehitlist[i]).CountUsed() > 0))
+			{
+				lumps.Push(tex->GetSourceLump());
+			}
+		}
+		Wads.PrefetchLumps(lumps);
+
 		// cache all used textures
 		for (int i = cnt - 1; i >= 0; i--)
 		{
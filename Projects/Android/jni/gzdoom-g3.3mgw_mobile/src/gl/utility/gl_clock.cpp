@@ -68,9 +68,16 @@ glcycle_t ProcessAll, PostProcess;
 glcycle_t RenderAll;
 glcycle_t Dirty;
 glcycle_t drawcalls;
+glcycle_t RenderModels;
 int vertexcount, flatvertices, flatprimitives;
 
 int rendered_lines,rendered_flats,rendered_sprites,render_vertexsplit,render_texsplit,rendered_decals, rendered_portals;
+int rendered_models, rendered_models_lod, model_framecache_hits, model_framecache_misses;
+int model_drawcalls, model_instanced_draws;
+int wallcache_hits, wallcache_misses, glowcache_hits, glowcache_misses;
+int staticwall_draws, staticwall_updates;
+int culled_portals, portal_saved_draws;
+int culled_subsectors, culled_sprites;
 int iter_dlightf, iter_dlight, draw_dlight, draw_dlightf;
 
 double		gl_SecondsPerCycle = 1e-8;
@@ -151,7 +158,14 @@ void ResetProfilingData()
 	RenderSprite.Reset();
 	SetupSprite.Reset();
 	drawcalls.Reset();
-
+	RenderModels.Reset();
+
+	rendered_models = rendered_models_lod = model_framecache_hits = model_framecache_misses = 0;
+	model_drawcalls = model_instanced_draws = 0;
+	wallcache_hits = wallcache_misses = glowcache_hits = glowcache_misses = 0;
+	staticwall_draws = staticwall_updates = 0;
+	culled_portals = portal_saved_draws = 0;
+	culled_subsectors = culled_sprites = 0;
 	flatvertices=flatprimitives=vertexcount=0;
 	render_texsplit=render_vertexsplit=rendered_lines=rendered_flats=rendered_sprites=rendered_decals=rendered_portals = 0;
 }
@@ -171,18 +185,25 @@ static void AppendRenderTimes(FString &str)
 	str.AppendFormat("W: Render=%2.3f, Setup=%2.3f, Clip=%2.3f\n"
 		"F: Render=%2.3f, Setup=%2.3f\n"
 		"S: Render=%2.3f, Setup=%2.3f\n"
+		"M: Render=%2.3f\n"
 		"All=%2.3f, Render=%2.3f, Setup=%2.3f, BSP = %2.3f, Portal=%2.3f, Drawcalls=%2.3f, Postprocess=%2.3f, Finish=%2.3f\n",
 	RenderWall.TimeMS(), setupwall, clipwall, RenderFlat.TimeMS(), SetupFlat.TimeMS(),
-	RenderSprite.TimeMS(), SetupSprite.TimeMS(), All.TimeMS() + Finish.TimeMS(), RenderAll.TimeMS(),
+	RenderSprite.TimeMS(), SetupSprite.TimeMS(), RenderModels.TimeMS(), All.TimeMS() + Finish.TimeMS(), RenderAll.TimeMS(),
 	ProcessAll.TimeMS(), bsp, PortalAll.TimeMS(), drawcalls.TimeMS(), PostProcess.TimeMS(), Finish.TimeMS());
 }
 
 static void AppendRenderStats(FString &out)
 {
 	out.AppendFormat("Walls: %d (%d splits, %d t-splits, %d vertices)\n"
+		"Wall cache: %d light splits reused, %d rebuilt, glow: %d reused, %d rebuilt, %d static vertex ranges (%d updated)\n"
 		"Flats: %d (%d primitives, %d vertices)\n"
-		"Sprites: %d, Decals=%d, Portals: %d\n",
-		rendered_lines, render_vertexsplit, render_texsplit, vertexcount, rendered_flats, flatprimitives, flatvertices, rendered_sprites,rendered_decals, rendered_portals );
+		"Sprites: %d, Decals=%d, Portals: %d (%d culled by occlusion, %d draws saved)\n"
+		"Occlusion buffer: %d subsectors, %d sprites culled\n"
+		"Models: %d (%d at lower LOD), %d draw calls (%d instanced), interpolated frames: %d reused, %d computed\n",
+		rendered_lines, render_vertexsplit, render_texsplit, vertexcount,
+		wallcache_hits, wallcache_misses, glowcache_hits, glowcache_misses, staticwall_draws, staticwall_updates, rendered_flats, flatprimitives, flatvertices, rendered_sprites,rendered_decals, rendered_portals, culled_portals, portal_saved_draws,
+		culled_subsectors, culled_sprites,
+		rendered_models, rendered_models_lod, model_drawcalls, model_instanced_draws, model_framecache_hits, model_framecache_misses);
 }
 
 static void AppendLightStats(FString &out)
@@ -99,10 +99,17 @@ extern glcycle_t ProcessAll, PostProcess;
 extern glcycle_t RenderAll;
 extern glcycle_t Dirty;
 extern glcycle_t drawcalls;
+extern glcycle_t RenderModels;
 
 extern int iter_dlightf, iter_dlight, draw_dlight, draw_dlightf;
 extern int rendered_lines,rendered_flats,rendered_sprites,rendered_decals,render_vertexsplit,render_texsplit;
 extern int rendered_portals;
+extern int rendered_models, rendered_models_lod, model_framecache_hits, model_framecache_misses;
+extern int model_drawcalls, model_instanced_draws;
+extern int wallcache_hits, wallcache_misses, glowcache_hits, glowcache_misses;
+extern int staticwall_draws, staticwall_updates;
+extern int culled_portals, portal_saved_draws;
+extern int culled_subsectors, culled_sprites;
 
 extern int vertexcount, flatvertices, flatprimitives;
 
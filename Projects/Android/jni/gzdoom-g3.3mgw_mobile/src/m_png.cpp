@@ -50,6 +50,14 @@
 #include "templates.h"
 #include "files.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PNG_SSE2
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define PNG_NEON
+#endif
+
 // MACROS ------------------------------------------------------------------
 
 // The maximum size of an IDAT chunk ZDoom will write. This is also the
@@ -98,6 +106,7 @@ static inline void MakeChunk (void *where, uint32_t type, size_t len);
 static inline void StuffPalette (const PalEntry *from, uint8_t *to);
 static bool WriteIDAT (FileWriter *file, const uint8_t *data, int len);
 static void UnfilterRow (int width, uint8_t *dest, uint8_t *stream, uint8_t *prev, int bpp);
+static void CopyRowToBGRA (int width, uint8_t *dest, const uint8_t *row, uint8_t colortype);
 static void UnpackPixels (int width, int bytesPerRow, int bitdepth, const uint8_t *rowin, uint8_t *rowout, bool grayscale);
 
 // EXTERNAL DATA DECLARATIONS ----------------------------------------------
@@ -112,6 +121,7 @@ CUSTOM_CVAR(Int, png_level, 5, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 		self = 9;
 }
 CVAR(Float, png_gamma, 0.f, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
+CVAR(Bool, png_simd, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 
 // PRIVATE DATA DEFINITIONS ------------------------------------------------
 
@@ -689,6 +699,105 @@ bool M_ReadIDAT (FileReader &file, uint8_t *buffer, int width, int height, int p
 	return true;
 }
 
+//==========================================================================
+//
+// ReadIDATToBGRA
+//
+// A faster version of ReadIDAT for the most common kind of PNGs. Since
+// there is no interlacing to take care of, each row is converted to BGRA
+// right after it has been unfiltered, which only needs two rows of
+// temporary storage instead of a copy of the whole image. If the file
+// is in memory, zlib reads the IDAT chunks straight from there.
+//
+//==========================================================================
+
+bool M_ReadIDATToBGRA (FileReader &file, uint8_t *buffer, int width, int height, int pitch,
+					   uint8_t colortype, unsigned int chunklen)
+{
+	assert(colortype == 2 || colortype == 6);
+
+	Byte chunkbuffer[4096];
+	int bytesPerPixel = colortype == 6 ? 4 : 3;
+	int bytesPerRow = width * bytesPerPixel;
+	TArray<Byte> rows(bytesPerRow * 3 + 1, true);
+	Byte *inputLine = &rows[0];
+	Byte *curr = inputLine + bytesPerRow + 1;
+	Byte *prev = curr + bytesPerRow;
+	memset (prev, 0, bytesPerRow);
+
+	z_stream stream = {};
+	if (inflateInit (&stream) != Z_OK)
+	{
+		return false;
+	}
+	stream.next_out = inputLine;
+	stream.avail_out = bytesPerRow + 1;
+
+	bool lastIDAT = false;
+	for (int y = 0; y < height; )
+	{
+		if (stream.avail_in == 0)
+		{
+			while (chunklen == 0 && !lastIDAT)
+			{
+				uint32_t x[3];
+				if (file.Read (x, 12) != 12 || x[2] != MAKE_ID('I','D','A','T'))
+				{
+					lastIDAT = true;
+				}
+				else
+				{
+					chunklen = BigLong((unsigned int)x[1]);
+				}
+			}
+
+			const char *data = file.GetBuffer();
+			if (data != nullptr)
+			{
+				auto pos = file.Tell();
+				stream.next_in = (Bytef *)data + pos;
+				stream.avail_in = (uInt)MIN<long>(chunklen, file.GetLength() - pos);
+				file.Seek (stream.avail_in, FileReader::SeekCur);
+			}
+			else if (chunklen > 0)
+			{
+				stream.next_in = chunkbuffer;
+				stream.avail_in = (uInt)file.Read (chunkbuffer, MIN<uint32_t>(chunklen,sizeof(chunkbuffer)));
+			}
+			if (stream.avail_in == 0)
+			{ // nothing left to read
+				lastIDAT = true;
+				chunklen = 0;
+			}
+			chunklen -= stream.avail_in;
+		}
+
+		int err = inflate (&stream, Z_SYNC_FLUSH);
+		if (err != Z_OK && err != Z_STREAM_END && (err != Z_BUF_ERROR || stream.avail_in != 0))
+		{ // something unexpected happened
+			inflateEnd (&stream);
+			return false;
+		}
+
+		if (stream.avail_out == 0)
+		{
+			UnfilterRow (bytesPerRow, curr, inputLine, prev, bytesPerPixel);
+			CopyRowToBGRA (width, buffer + y * pitch, curr, colortype);
+			std::swap (curr, prev);
+			stream.next_out = inputLine;
+			stream.avail_out = bytesPerRow + 1;
+			y++;
+		}
+		else if (err != Z_OK && (err == Z_STREAM_END || lastIDAT))
+		{ // the image is incomplete
+			break;
+		}
+	}
+
+	inflateEnd (&stream);
+	return true;
+}
+
 // PRIVATE CODE ------------------------------------------------------------
 
 
@@ -1068,6 +1177,220 @@ static bool WriteIDAT (FileWriter *file, const uint8_t *data, int len)
 	return true;
 }
 
+//==========================================================================
+//
+// Vectorized unfiltering
+//
+// Up can be done 16 bytes at a time. Sub is a running sum over the
+// pixels that gets computed for 16 bytes with a few shifted additions.
+// Average and Paeth depend on the previous pixel's final value so they
+// still go pixel by pixel, but work on all channels of a pixel at once
+// instead of one byte after the other. Only 3 and 4 byte pixels are
+// handled here, which covers 8 bit RGB and RGBA images.
+//
+//==========================================================================
+
+#if defined(PNG_SSE2) || defined(PNG_NEON)
+
+template<int BPP> static inline uint32_t LoadPixel(const uint8_t *p)
+{
+	uint32_t v = 0;
+	memcpy(&v, p, BPP);
+	return v;
+}
+
+template<int BPP> static inline void StorePixel(uint8_t *p, uint32_t v)
+{
+	memcpy(p, &v, BPP);
+}
+
+static void UnfilterUp(int width, uint8_t *dest, const uint8_t *row, const uint8_t *prev)
+{
+	int x = 0;
+	for (; x + 16 <= width; x += 16)
+	{
+#ifdef PNG_SSE2
+		__m128i d = _mm_add_epi8(_mm_loadu_si128((const __m128i *)(row + x)), _mm_loadu_si128((const __m128i *)(prev + x)));
+		_mm_storeu_si128((__m128i *)(dest + x), d);
+#else
+		vst1q_u8(dest + x, vaddq_u8(vld1q_u8(row + x), vld1q_u8(prev + x)));
+#endif
+	}
+	for (; x < width; x++)
+	{
+		dest[x] = row[x] + prev[x];
+	}
+}
+
+template<int BPP> static void UnfilterSub(int width, uint8_t *dest, const uint8_t *row)
+{
+	int x = 0;
+#ifdef PNG_SSE2
+	__m128i carry = _mm_setzero_si128();
+	if (BPP == 4)
+	{
+		for (; x + 16 <= width; x += 16)
+		{
+			__m128i d = _mm_loadu_si128((const __m128i *)(row + x));
+			d = _mm_add_epi8(d, _mm_slli_si128(d, 4));
+			d = _mm_add_epi8(d, _mm_slli_si128(d, 8));
+			d = _mm_add_epi8(d, carry);
+			_mm_storeu_si128((__m128i *)(dest + x), d);
+			carry = _mm_shuffle_epi32(d, _MM_SHUFFLE(3, 3, 3, 3));
+		}
+	}
+	else
+	{
+		// 4 pixels per iteration. The last 4 bytes get overwritten by the next one.
+		const __m128i mask = _mm_cvtsi32_si128(0xffffff);
+		for (; x + 16 <= width; x += 12)
+		{
+			__m128i d = _mm_loadu_si128((const __m128i *)(row + x));
+			d = _mm_add_epi8(d, _mm_slli_si128(d, 3));
+			d = _mm_add_epi8(d, _mm_slli_si128(d, 6));
+			carry = _mm_or_si128(carry, _mm_slli_si128(carry, 3));
+			carry = _mm_or_si128(carry, _mm_slli_si128(carry, 6));
+			d = _mm_add_epi8(d, carry);
+			_mm_storeu_si128((__m128i *)(dest + x), d);
+			carry = _mm_and_si128(_mm_srli_si128(d, 9), mask);
+		}
+	}
+#else
+	const uint8x16_t zero = vdupq_n_u8(0);
+	uint8x16_t carry = zero;
+	if (BPP == 4)
+	{
+		for (; x + 16 <= width; x += 16)
+		{
+			uint8x16_t d = vld1q_u8(row + x);
+			d = vaddq_u8(d, vextq_u8(zero, d, 12));
+			d = vaddq_u8(d, vextq_u8(zero, d, 8));
+			d = vaddq_u8(d, carry);
+			vst1q_u8(dest + x, d);
+			carry = vreinterpretq_u8_u32(vdupq_laneq_u32(vreinterpretq_u32_u8(d), 3));
+		}
+	}
+	else
+	{
+		// 4 pixels per iteration. The last 4 bytes get overwritten by the next one.
+		const uint8x16_t mask = vreinterpretq_u8_u32(vsetq_lane_u32(0xffffff, vdupq_n_u32(0), 0));
+		for (; x + 16 <= width; x += 12)
+		{
+			uint8x16_t d = vld1q_u8(row + x);
+			d = vaddq_u8(d, vextq_u8(zero, d, 13));
+			d = vaddq_u8(d, vextq_u8(zero, d, 10));
+			carry = vorrq_u8(carry, vextq_u8(zero, carry, 13));
+			carry = vorrq_u8(carry, vextq_u8(zero, carry, 10));
+			d = vaddq_u8(d, carry);
+			vst1q_u8(dest + x, d);
+			carry = vandq_u8(vextq_u8(d, zero, 9), mask);
+		}
+	}
+#endif
+	for (; x < BPP && x < width; x++)
+	{
+		dest[x] = row[x];
+	}
+	for (; x < width; x++)
+	{
+		dest[x] = row[x] + dest[x - BPP];
+	}
+}
+
+template<int BPP> static void UnfilterAverage(int width, uint8_t *dest, const uint8_t *row, const uint8_t *prev)
+{
+#ifdef PNG_SSE2
+	const __m128i one = _mm_set1_epi8(1);
+	__m128i a = _mm_setzero_si128();
+	for (int x = 0; x < width; x += BPP)
+	{
+		__m128i b = _mm_cvtsi32_si128(LoadPixel<BPP>(prev + x));
+		// _mm_avg_epu8 rounds up, PNG wants the average rounded down.
+		__m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+		a = _mm_add_epi8(_mm_cvtsi32_si128(LoadPixel<BPP>(row + x)), avg);
+		StorePixel<BPP>(dest + x, _mm_cvtsi128_si32(a));
+	}
+#else
+	uint8x8_t a = vdup_n_u8(0);
+	for (int x = 0; x < width; x += BPP)
+	{
+		uint8x8_t b = vcreate_u8(LoadPixel<BPP>(prev + x));
+		a = vadd_u8(vcreate_u8(LoadPixel<BPP>(row + x)), vhadd_u8(a, b));
+		StorePixel<BPP>(dest + x, vget_lane_u32(vreinterpret_u32_u8(a), 0));
+	}
+#endif
+}
+
+template<int BPP> static void UnfilterPaeth(int width, uint8_t *dest, const uint8_t *row, const uint8_t *prev)
+{
+#ifdef PNG_SSE2
+	// Done with 16 bit values because the predictor's distances don't fit into a byte.
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i bytemask = _mm_set1_epi16(0xff);
+	auto abs16 = [=](__m128i v) { return _mm_max_epi16(v, _mm_sub_epi16(zero, v)); };
+	auto select = [](__m128i mask, __m128i a, __m128i b) { return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b)); };
+
+	__m128i a = zero, c = zero;
+	for (int x = 0; x < width; x += BPP)
+	{
+		__m128i b = _mm_unpacklo_epi8(_mm_cvtsi32_si128(LoadPixel<BPP>(prev + x)), zero);
+		__m128i pa = _mm_sub_epi16(b, c);
+		__m128i pb = _mm_sub_epi16(a, c);
+		__m128i pc = abs16(_mm_add_epi16(pa, pb));
+		pa = abs16(pa);
+		pb = abs16(pb);
+		__m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+		__m128i nearest = select(_mm_cmpeq_epi16(smallest, pa), a, select(_mm_cmpeq_epi16(smallest, pb), b, c));
+		__m128i r = _mm_unpacklo_epi8(_mm_cvtsi32_si128(LoadPixel<BPP>(row + x)), zero);
+		a = _mm_and_si128(_mm_add_epi16(r, nearest), bytemask);
+		StorePixel<BPP>(dest + x, _mm_cvtsi128_si32(_mm_packus_epi16(a, a)));
+		c = b;
+	}
+#else
+	uint8x8_t a = vdup_n_u8(0), c = a;
+	for (int x = 0; x < width; x += BPP)
+	{
+		uint8x8_t b = vcreate_u8(LoadPixel<BPP>(prev + x));
+		uint16x8_t pa = vabdl_u8(b, c);
+		uint16x8_t pb = vabdl_u8(a, c);
+		uint16x8_t pc = vabdq_u16(vaddl_u8(a, b), vaddl_u8(c, c));
+		uint8x8_t usea = vmovn_u16(vandq_u16(vcleq_u16(pa, pb), vcleq_u16(pa, pc)));
+		uint8x8_t useb = vmovn_u16(vcleq_u16(pb, pc));
+		uint8x8_t nearest = vbsl_u8(usea, a, vbsl_u8(useb, b, c));
+		a = vadd_u8(vcreate_u8(LoadPixel<BPP>(row + x)), nearest);
+		StorePixel<BPP>(dest + x, vget_lane_u32(vreinterpret_u32_u8(a), 0));
+		c = b;
+	}
+#endif
+}
+
+template<int BPP> static bool UnfilterRowBPP(int width, uint8_t *dest, const uint8_t *row, const uint8_t *prev)
+{
+	switch (*row++)
+	{
+	case 1:		UnfilterSub<BPP>(width, dest, row);				return true;
+	case 2:		UnfilterUp(width, dest, row, prev);				return true;
+	case 3:		UnfilterAverage<BPP>(width, dest, row, prev);	return true;
+	case 4:		UnfilterPaeth<BPP>(width, dest, row, prev);		return true;
+	default:	return false;
+	}
+}
+
+static bool UnfilterRowSIMD(int width, uint8_t *dest, const uint8_t *row, const uint8_t *prev, int bpp)
+{
+	if (width % bpp != 0) return false;
+	if (bpp == 4) return UnfilterRowBPP<4>(width, dest, row, prev);
+	if (bpp == 3) return UnfilterRowBPP<3>(width, dest, row, prev);
+	if (*row == 2)
+	{
+		UnfilterUp(width, dest, row + 1, prev);
+		return true;
+	}
+	return false;
+}
+
+#endif
+
 //==========================================================================
 //
 // UnfilterRow
@@ -1082,6 +1405,13 @@ void UnfilterRow (int width, uint8_t *dest, uint8_t *row, uint8_t *prev, int bpp
 {
 	int x;
 
+#if defined(PNG_SSE2) || defined(PNG_NEON)
+	if (png_simd && UnfilterRowSIMD(width, dest, row, prev, bpp))
+	{
+		return;
+	}
+#endif
+
 	switch (*row++)
 	{
 	case 1:		// Sub
@@ -1293,3 +1623,85 @@ static void UnpackPixels (int width, int bytesPerRow, int bitdepth, const uint8_
 		}
 	}
 }
+
+//==========================================================================
+//
+// CopyRowToBGRA
+//
+// Converts a row of 8 bit RGB or RGBA pixels to BGRA. This must give the
+// same result as FBitmap::CopyPixelDataRGB with OP_COPY, so pixels with
+// an alpha of 0 leave the destination alone.
+//
+//==========================================================================
+
+static void CopyRowToBGRA (int width, uint8_t *dest, const uint8_t *row, uint8_t colortype)
+{
+	int x = 0;
+
+	if (colortype == 6)
+	{
+#if defined(PNG_SSE2)
+		if (png_simd)
+		{
+			const __m128i agmask = _mm_set1_epi32(0xff00ff00);
+			const __m128i rbmask = _mm_set1_epi32(0x00ff00ff);
+			const __m128i amask = _mm_set1_epi32(0xff000000);
+			for (; x + 4 <= width; x += 4)
+			{
+				__m128i px = _mm_loadu_si128((const __m128i *)(row + x * 4));
+				__m128i rb = _mm_and_si128(px, rbmask);
+				__m128i bgra = _mm_or_si128(_mm_and_si128(px, agmask), _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16)));
+				__m128i keep = _mm_cmpeq_epi32(_mm_and_si128(px, amask), _mm_setzero_si128());
+				__m128i old = _mm_loadu_si128((const __m128i *)(dest + x * 4));
+				_mm_storeu_si128((__m128i *)(dest + x * 4), _mm_or_si128(_mm_and_si128(keep, old), _mm_andnot_si128(keep, bgra)));
+			}
+		}
+#elif defined(PNG_NEON)
+		if (png_simd)
+		{
+			for (; x + 16 <= width; x += 16)
+			{
+				uint8x16x4_t px = vld4q_u8(row + x * 4);
+				uint8x16x4_t out = vld4q_u8(dest + x * 4);
+				uint8x16_t keep = vceqq_u8(px.val[3], vdupq_n_u8(0));
+				out.val[0] = vbslq_u8(keep, out.val[0], px.val[2]);
+				out.val[1] = vbslq_u8(keep, out.val[1], px.val[1]);
+				out.val[2] = vbslq_u8(keep, out.val[2], px.val[0]);
+				out.val[3] = vbslq_u8(keep, out.val[3], px.val[3]);
+				vst4q_u8(dest + x * 4, out);
+			}
+		}
+#endif
+		for (row += x * 4, dest += x * 4; x < width; x++, row += 4, dest += 4)
+		{
+			if (row[3] != 0)
+			{
+				dest[0] = row[2];
+				dest[1] = row[1];
+				dest[2] = row[0];
+				dest[3] = row[3];
+			}
+		}
+	}
+	else
+	{
+#if defined(PNG_NEON)
+		if (png_simd)
+		{
+			for (; x + 16 <= width; x += 16)
+			{
+				uint8x16x3_t px = vld3q_u8(row + x * 3);
+				uint8x16x4_t out = { { px.val[2], px.val[1], px.val[0], vdupq_n_u8(255) } };
+				vst4q_u8(dest + x * 4, out);
+			}
+		}
+#endif
+		for (row += x * 3, dest += x * 4; x < width; x++, row += 3, dest += 4)
+		{
+			dest[0] = row[2];
+			dest[1] = row[1];
+			dest[2] = row[0];
+			dest[3] = 255;
+		}
+	}
+}
@@ -109,6 +109,13 @@ bool M_GetPNGText (PNGHandle *png, const char *keyword, char *buffer, size_t buf
 bool M_ReadIDAT (FileReader &file, uint8_t *buffer, int width, int height, int pitch,
 				 uint8_t bitdepth, uint8_t colortype, uint8_t interlace, unsigned int idatlen);
 
+// Same as M_ReadIDAT but only for non-interlaced 8 bit RGB (colortype 2) and RGBA
+// (colortype 6) images. The pixels are written to the buffer as BGRA without
+// going through a temporary copy of the image. Fully transparent pixels are
+// skipped, like FBitmap's OP_COPY does.
+bool M_ReadIDATToBGRA (FileReader &file, uint8_t *buffer, int width, int height, int pitch,
+					   uint8_t colortype, unsigned int idatlen);
+
 
 class FTexture;
 
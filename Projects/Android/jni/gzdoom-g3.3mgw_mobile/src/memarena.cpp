@@ -291,7 +291,7 @@ void *FMemArena::Block::Alloc(size_t size)
 
 FSharedStringArena::FSharedStringArena()
 {
-	memset(Buckets, 0, sizeof(Buckets));
+	for (auto &bucket : Buckets) bucket.store(nullptr, std::memory_order_relaxed);
 }
 
 //==========================================================================
@@ -318,20 +318,7 @@ FSharedStringArena::~FSharedStringArena()
 
 FString *FSharedStringArena::Alloc(const FString &source)
 {
-	unsigned int hash;
-	Node *strnode;
-
-	strnode = FindString(source, source.Len(), hash);
-	if (strnode == NULL)
-	{
-		strnode = (Node *)iAlloc(sizeof(Node));
-		::new(&strnode->String) FString(source);
-		strnode->Hash = hash;
-		hash %= countof(Buckets);
-		strnode->Next = Buckets[hash];
-		Buckets[hash] = strnode;
-	}
-	return &strnode->String;
+	return AddString(source.GetChars(), source.Len(), &source);
 }
 
 //==========================================================================
@@ -342,7 +329,7 @@ FString *FSharedStringArena::Alloc(const FString &source)
 
 FString *FSharedStringArena::Alloc(const char *source)
 {
-	return Alloc(source, strlen(source));
+	return AddString(source, strlen(source), nullptr);
 }
 
 //==========================================================================
@@ -353,18 +340,39 @@ FString *FSharedStringArena::Alloc(const char *source)
 
 FString *FSharedStringArena::Alloc(const char *source, size_t strlen)
 {
-	unsigned int hash;
-	Node *strnode;
+	return AddString(source, strlen, nullptr);
+}
 
-	strnode = FindString(source, strlen, hash);
+//==========================================================================
+//
+// FSharedStringArena :: AddString
+//
+// Returns the existing copy of the string or adds a new one. Only adding
+// needs the lock. The node is fully set up before it gets linked into its
+// bucket so that lookups on other threads never see a partial node.
+//
+//==========================================================================
+
+FString *FSharedStringArena::AddString(const char *str, size_t strlen, const FString *source)
+{
+	unsigned int hash = SuperFastHash(str, strlen);
+	Node *strnode = FindString(str, strlen, hash);
 	if (strnode == NULL)
 	{
-		strnode = (Node *)iAlloc(sizeof(Node));
-		::new(&strnode->String) FString(source, strlen);
-		strnode->Hash = hash;
-		hash %= countof(Buckets);
-		strnode->Next = Buckets[hash];
-		Buckets[hash] = strnode;
+		std::lock_guard<std::mutex> lock(Lock);
+
+		// Another thread may have added the same string in the meantime.
+		strnode = FindString(str, strlen, hash);
+		if (strnode == NULL)
+		{
+			strnode = (Node *)iAlloc(sizeof(Node));
+			if (source != nullptr) ::new(&strnode->String) FString(*source);
+			else ::new(&strnode->String) FString(str, strlen);
+			strnode->Hash = hash;
+			auto &bucket = Buckets[hash % countof(Buckets)];
+			strnode->Next = bucket.load(std::memory_order_relaxed);
+			bucket.store(strnode, std::memory_order_release);
+		}
 	}
 	return &strnode->String;
 }
@@ -377,13 +385,11 @@ FString *FSharedStringArena::Alloc(const char *source, size_t strlen)
 //
 //==========================================================================
 
-FSharedStringArena::Node *FSharedStringArena::FindString(const char *str, size_t strlen, unsigned int &hash)
+FSharedStringArena::Node *FSharedStringArena::FindString(const char *str, size_t strlen, unsigned int hash)
 {
-	hash = SuperFastHash(str, strlen);
-
-	for (Node *node = Buckets[hash % countof(Buckets)]; node != NULL; node = node->Next)
+	for (Node *node = Buckets[hash % countof(Buckets)].load(std::memory_order_acquire); node != NULL; node = node->Next)
 	{
-		if (node->Hash == hash && node->String.Len() == strlen && memcmp(&node->String[0], str, strlen) == 0)
+		if (node->Hash == hash && node->String.Len() == strlen && memcmp(node->String.GetChars(), str, strlen) == 0)
 		{
 			return node;
 		}
@@ -414,6 +420,6 @@ void FSharedStringArena::FreeAll()
 		block->NextBlock = FreeBlocks;
 		FreeBlocks = block;
 	}
-	memset(Buckets, 0, sizeof(Buckets));
+	for (auto &bucket : Buckets) bucket.store(nullptr, std::memory_order_relaxed);
 	TopBlock = NULL;
 }
@@ -34,6 +34,8 @@
 #ifndef __MEMARENA_H
 #define __MEMARENA_H
 
+#include <atomic>
+#include <mutex>
 #include "zstring.h"
 
 // A general purpose arena.
@@ -64,6 +66,9 @@ protected:
 // An arena specializing in storage of FStrings. It knows how to free them,
 // but this means it also should never be used for allocating anything else.
 // Identical strings all return the same pointer.
+// Alloc may be called from multiple threads at once. Looking up a string
+// that is already in the arena does not need a lock. FreeAll must not be
+// called while other threads are using the arena.
 class FSharedStringArena : public FMemArena
 {
 public:
@@ -82,9 +87,11 @@ protected:
 		FString String;
 		unsigned int Hash;
 	};
-	Node *Buckets[256];
+	std::atomic<Node *> Buckets[256];
+	std::mutex Lock;
 
-	Node *FindString(const char *str, size_t strlen, unsigned int &hash);
+	Node *FindString(const char *str, size_t strlen, unsigned int hash);
+	FString *AddString(const char *str, size_t strlen, const FString *source);
 private:
 	void *Alloc(size_t size) { return NULL; }	// No access to FMemArena::Alloc for outsiders.
 };
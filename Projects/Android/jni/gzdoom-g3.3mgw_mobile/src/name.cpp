@@ -33,9 +33,16 @@
 */
 
 #include <string.h>
+#include <mutex>
 #include "name.h"
 #include "c_dispatch.h"
 #include "c_console.h"
+#include "doomerrors.h"
+#include "memarena.h"
+#include "threadpool.h"
+#include "templates.h"
+#include "stats.h"
+#include "v_text.h"
 
 // MACROS ------------------------------------------------------------------
 
@@ -44,9 +51,6 @@
 // that is just large enough to hold it.
 #define BLOCK_SIZE			4096
 
-// How many entries to grow the NameArray by when it needs to grow.
-#define NAME_GROW_AMOUNT	256
-
 // TYPES -------------------------------------------------------------------
 
 // Name text is stored in a linked list of NameBlock structures. This
@@ -67,6 +71,7 @@ struct FName::NameManager::NameBlock
 
 FName::NameManager FName::NameData;
 bool FName::NameManager::Inited;
+static std::mutex NameLock;	// only needed for adding names.
 
 // Define the predefined names.
 static const char *PredefinedNames[] =
@@ -89,6 +94,18 @@ static const char *PredefinedNames[] =
 //==========================================================================
 
 int FName::NameManager::FindName (const char *text, bool noCreate)
+{
+	return FindName (text, text == NULL ? 0 : strlen (text), noCreate);
+}
+
+//==========================================================================
+//
+// The same as above, but the text length is also passed, for creating
+// a name from a substring or for speed if the length is already known.
+//
+//==========================================================================
+
+int FName::NameManager::FindName (const char *text, size_t textLen, bool noCreate)
 {
 	if (!Inited)
 	{
@@ -100,18 +117,14 @@ int FName::NameManager::FindName (const char *text, bool noCreate)
 		return 0;
 	}
 
-	unsigned int hash = MakeKey (text);
+	unsigned int hash = MakeKey (text, textLen);
 	unsigned int bucket = hash % HASH_SIZE;
-	int scanner = Buckets[bucket];
 
 	// See if the name already exists.
-	while (scanner >= 0)
+	int scanner = FindEntry (text, textLen, hash, bucket);
+	if (scanner >= 0)
 	{
-		if (NameArray[scanner].Hash == hash && stricmp (NameArray[scanner].Text, text) == 0)
-		{
-			return scanner;
-		}
-		scanner = NameArray[scanner].NextHash;
+		return scanner;
 	}
 
 	// If we get here, then the name does not exist.
@@ -120,51 +133,34 @@ int FName::NameManager::FindName (const char *text, bool noCreate)
 		return 0;
 	}
 
-	return AddName (text, hash, bucket);
+	return AddName (text, textLen, hash, bucket);
 }
 
 //==========================================================================
 //
-// The same as above, but the text length is also passed, for creating
-// a name from a substring or for speed if the length is already known.
+// FName :: NameManager :: FindEntry
+//
+// Searches a hash chain. This does not need a lock, since entries are
+// fully set up before they get linked into their chain.
 //
 //==========================================================================
 
-int FName::NameManager::FindName (const char *text, size_t textLen, bool noCreate)
+int FName::NameManager::FindEntry (const char *text, size_t textLen, unsigned int hash, unsigned int bucket)
 {
-	if (!Inited)
-	{
-		InitBuckets ();
-	}
-
-	if (text == NULL)
-	{
-		return 0;
-	}
-
-	unsigned int hash = MakeKey (text, textLen);
-	unsigned int bucket = hash % HASH_SIZE;
-	int scanner = Buckets[bucket];
+	int scanner = Buckets[bucket].load (std::memory_order_acquire);
 
-	// See if the name already exists.
 	while (scanner >= 0)
 	{
-		if (NameArray[scanner].Hash == hash &&
-			strnicmp (NameArray[scanner].Text, text, textLen) == 0 &&
-			NameArray[scanner].Text[textLen] == '\0')
+		const NameEntry &entry = GetEntry (scanner);
+		if (entry.Hash == hash &&
+			strnicmp (entry.Text, text, textLen) == 0 &&
+			entry.Text[textLen] == '\0')
 		{
 			return scanner;
 		}
-		scanner = NameArray[scanner].NextHash;
+		scanner = entry.NextHash;
 	}
-
-	// If we get here, then the name does not exist.
-	if (noCreate)
-	{
-		return 0;
-	}
-
-	return AddName (text, hash, bucket);
+	return -1;
 }
 
 //==========================================================================
@@ -178,7 +174,10 @@ int FName::NameManager::FindName (const char *text, size_t textLen, bool noCreat
 void FName::NameManager::InitBuckets ()
 {
 	Inited = true;
-	memset (Buckets, -1, sizeof(Buckets));
+	for (auto &bucket : Buckets)
+	{
+		bucket.store (-1, std::memory_order_relaxed);
+	}
 
 	// Register built-in names. 'None' must be name 0.
 	for (size_t i = 0; i < countof(PredefinedNames); ++i)
@@ -196,11 +195,20 @@ void FName::NameManager::InitBuckets ()
 //
 //==========================================================================
 
-int FName::NameManager::AddName (const char *text, unsigned int hash, unsigned int bucket)
+int FName::NameManager::AddName (const char *text, size_t textLen, unsigned int hash, unsigned int bucket)
 {
+	std::lock_guard<std::mutex> lock(NameLock);
+
+	// Another thread may have added the same name in the meantime.
+	int scanner = FindEntry (text, textLen, hash, bucket);
+	if (scanner >= 0)
+	{
+		return scanner;
+	}
+
 	char *textstore;
 	NameBlock *block = Blocks;
-	size_t len = strlen (text) + 1;
+	size_t len = textLen + 1;
 
 	// Get a block large enough for the name. Only the first block in the
 	// list is ever considered for name storage.
@@ -211,25 +219,32 @@ int FName::NameManager::AddName (const char *text, unsigned int hash, unsigned i
 
 	// Copy the string into the block.
 	textstore = (char *)block + block->NextAlloc;
-	strcpy (textstore, text);
+	memcpy (textstore, text, textLen);
+	textstore[textLen] = '\0';
 	block->NextAlloc += len;
 
-	// Add an entry for the name to the NameArray
-	if (NumNames >= MaxNames)
+	// Add an entry for the name. The entries are allocated in chunks that
+	// never move, so readers don't need to be stopped while this grows.
+	int index = NumNames.load (std::memory_order_relaxed);
+	if ((index & (CHUNK_SIZE - 1)) == 0)
 	{
-		// If no names have been defined yet, make the first allocation
-		// large enough to hold all the predefined names.
-		MaxNames += MaxNames == 0 ? countof(PredefinedNames) + NAME_GROW_AMOUNT : NAME_GROW_AMOUNT;
-
-		NameArray = (NameEntry *)M_Realloc (NameArray, MaxNames * sizeof(NameEntry));
+		if ((index >> CHUNK_SHIFT) >= MAX_CHUNKS)
+		{
+			I_FatalError ("Too many names");
+		}
+		NameChunks[index >> CHUNK_SHIFT] = (NameEntry *)M_Malloc (CHUNK_SIZE * sizeof(NameEntry));
 	}
 
-	NameArray[NumNames].Text = textstore;
-	NameArray[NumNames].Hash = hash;
-	NameArray[NumNames].NextHash = Buckets[bucket];
-	Buckets[bucket] = NumNames;
+	NameEntry &entry = NameChunks[index >> CHUNK_SHIFT][index & (CHUNK_SIZE - 1)];
+	entry.Text = textstore;
+	entry.Hash = hash;
+	entry.NextHash = Buckets[bucket].load (std::memory_order_relaxed);
+
+	// Publish the entry only after it has been completely set up.
+	NumNames.store (index + 1, std::memory_order_release);
+	Buckets[bucket].store (index, std::memory_order_release);
 
-	return NumNames++;
+	return index;
 }
 
 //==========================================================================
@@ -278,11 +293,116 @@ FName::NameManager::~NameManager()
 	}
 	Blocks = NULL;
 
-	if (NameArray != NULL)
+	for (auto &chunk : NameChunks)
+	{
+		if (chunk != NULL)
+		{
+			M_Free (chunk);
+			chunk = NULL;
+		}
+	}
+	NumNames = 0;
+	for (auto &bucket : Buckets)
+	{
+		bucket = -1;
+	}
+}
+
+//==========================================================================
+//
+// CCMD namebench
+//
+// Looks up and adds names and shared strings on all worker threads at
+// once and compares the throughput with a single thread.
+//
+//==========================================================================
+
+CCMD(namebench)
+{
+	int passes = argv.argc() > 1 ? MAX(1, atoi(argv[1])) : 10;
+	int threads = FThreadPool::Get().NumThreads();
+	TArray<FString> names, newnames;
+
+	for (int i = 0; FName((ENamedName)i).IsValidName(); i++)
+	{
+		names.Push(FName((ENamedName)i).GetChars());
+	}
+	for (int i = 0; i < 4096; i++)
+	{
+		FString name;
+		name.Format("NameBench%d", i);
+		newnames.Push(name);
+	}
+
+	std::atomic<int> found(0);
+	auto lookup = [&](int)
+	{
+		int count = 0;
+		for (int pass = 0; pass < passes; pass++)
+		{
+			for (auto &name : names) count += FName(name, true) != NAME_None;
+		}
+		found += count;
+	};
+
+	// All threads add the same names at the same time, so every one of them must get the same indices.
+	TArray<TArray<int>> indices(threads, true);
+	auto add = [&](int item)
+	{
+		for (auto &name : newnames) indices[item].Push(FName(name).GetIndex());
+	};
+
+	FSharedStringArena arena;
+	TArray<TArray<FString *>> strings(threads, true);
+	auto intern = [&](int item)
 	{
-		M_Free (NameArray);
-		NameArray = NULL;
+		for (int pass = 0; pass < passes; pass++)
+		{
+			for (auto &name : names) strings[item].Push(arena.Alloc(name.GetChars(), name.Len()));
+		}
+	};
+
+	cycle_t serial, parallel, addtime, interntime;
+	serial.Reset();
+	parallel.Reset();
+	addtime.Reset();
+	interntime.Reset();
+
+	serial.Clock();
+	lookup(0);
+	serial.Unclock();
+
+	parallel.Clock();
+	FThreadPool::Get().ParallelFor(threads, lookup);
+	parallel.Unclock();
+
+	addtime.Clock();
+	FThreadPool::Get().ParallelFor(threads, add);
+	addtime.Unclock();
+
+	interntime.Clock();
+	FThreadPool::Get().ParallelFor(threads, intern);
+	interntime.Unclock();
+
+	int mismatches = 0;
+	for (int i = 1; i < threads; i++)
+	{
+		for (unsigned j = 0; j < newnames.Size(); j++)
+		{
+			mismatches += indices[i][j] != indices[0][j];
+		}
+		for (unsigned j = 0; j < strings[i].Size(); j++)
+		{
+			mismatches += strings[i][j] != strings[0][j];
+		}
 	}
-	NumNames = MaxNames = 0;
-	memset (Buckets, -1, sizeof(Buckets));
+
+	auto nsPerOp = [](cycle_t &timer, double count) { return count == 0 ? 0. : timer.TimeMS() * 1e6 / count; };
+	double lookups = double(names.Size()) * passes;
+	Printf("%u names, %d passes, %d threads, %d found\n", names.Size(), passes, threads, found.load());
+	Printf("Lookups, 1 thread: %.1f ns per lookup\n", nsPerOp(serial, lookups));
+	Printf("Lookups, %d threads: %.1f ns per lookup\n", threads, nsPerOp(parallel, lookups * threads));
+	Printf("Adding the same names, %d threads: %.1f ns per name\n", threads, nsPerOp(addtime, double(newnames.Size()) * threads));
+	Printf("Shared strings, %d threads: %.1f ns per string\n", threads, nsPerOp(interntime, lookups * threads));
+	if (mismatches > 0) Printf(TEXTCOLOR_RED "%d mismatches between threads\n", mismatches);
 }
@@ -34,6 +34,8 @@
 #ifndef NAME_H
 #define NAME_H
 
+#include <atomic>
+
 enum ENamedName
 {
 #define xx(n) NAME_##n,
@@ -58,8 +60,8 @@ public:
 
 	int GetIndex() const { return Index; }
 	operator int() const { return Index; }
-	const char *GetChars() const { return NameData.NameArray[Index].Text; }
-	operator const char *() const { return NameData.NameArray[Index].Text; }
+	const char *GetChars() const { return NameData.GetEntry(Index).Text; }
+	operator const char *() const { return NameData.GetEntry(Index).Text; }
 
 	FName &operator = (const char *text) { Index = NameData.FindName (text, false); return *this; }
 	FName &operator = (const FString &text);
@@ -96,6 +98,10 @@ protected:
 		int NextHash;
 	};
 
+	// Names can be looked up from any thread without locking. Adding a
+	// name takes a lock, and entries are never moved once they have been
+	// added, so readers always see either the old or the new state of a
+	// hash chain.
 	struct NameManager
 	{
 		// No constructor because we can't ensure that it actually gets
@@ -103,17 +109,26 @@ protected:
 		// means this struct must only exist in the program's BSS section.
 		~NameManager();
 
-		enum { HASH_SIZE = 1024 };
+		enum
+		{
+			HASH_SIZE = 16384,
+			CHUNK_SHIFT = 12,
+			CHUNK_SIZE = 1 << CHUNK_SHIFT,
+			MAX_CHUNKS = 1024,
+		};
 		struct NameBlock;
 
 		NameBlock *Blocks;
-		NameEntry *NameArray;
-		int NumNames, MaxNames;
-		int Buckets[HASH_SIZE];
+		NameEntry *NameChunks[MAX_CHUNKS];
+		std::atomic<int> NumNames;
+		std::atomic<int> Buckets[HASH_SIZE];
+
+		const NameEntry &GetEntry(int index) const { return NameChunks[index >> CHUNK_SHIFT][index & (CHUNK_SIZE - 1)]; }
 
 		int FindName (const char *text, bool noCreate);
 		int FindName (const char *text, size_t textlen, bool noCreate);
-		int AddName (const char *text, unsigned int hash, unsigned int bucket);
+		int FindEntry (const char *text, size_t textlen, unsigned int hash, unsigned int bucket);
+		int AddName (const char *text, size_t textlen, unsigned int hash, unsigned int bucket);
 		NameBlock *AddBlock (size_t len);
 		void InitBuckets ();
 		static bool Inited;
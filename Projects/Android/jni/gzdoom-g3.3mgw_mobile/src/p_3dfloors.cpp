@@ -427,6 +427,10 @@ void P_Recalculate3DFloors(sector_t * sector)
 
 	TArray<F3DFloor*> & ffloors=sector->e->XFloor.ffloors;
 	TArray<lightlist_t> & lightlist = sector->e->XFloor.lightlist;
+	static int lightliststamp;
+
+	// Let the renderer know that anything it derived from the light list is outdated.
+	sector->e->XFloor.lightliststamp = ++lightliststamp;
 
 	// Sort the floors top to bottom for quicker access here and later
 	// Translucent and swimmable floors are split if they overlap with solid ones.
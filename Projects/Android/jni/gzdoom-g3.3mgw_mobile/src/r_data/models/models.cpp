@@ -42,7 +42,8 @@
 #include "r_data/models/models.h"
 #include "r_data/models/models_ue1.h"
 #include "r_data/models/models_obj.h"
-#include "i_time.h"
+#include "c_dispatch.h"
+#include "v_text.h"
 #include "gl/stereo3d/gl_stereo3d.h"
 
 #ifdef _MSC_VER
@@ -50,6 +51,10 @@
 #endif
 
 CVAR(Bool, gl_interpolate_model_frames, true, CVAR_ARCHIVE)
+CUSTOM_CVAR(Float, gl_model_lod_distance, 0.f, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)	// distance between model LODs, 0 disables LOD selection
+{
+	if (self < 0.f) self = 0.f;
+}
 EXTERN_CVAR(Bool, r_drawvoxels)
 EXTERN_CVAR(Int, vr_control_scheme)
 EXTERN_CVAR(Float, vr_weaponScale)
@@ -61,12 +66,23 @@ TDeletingArray<FModel*> Models;
 
 void FModelRenderer::RenderModel(float x, float y, float z, FSpriteModelFrame *smf, AActor *actor)
 {
-	// Setup transformation.
-
 	int translation = 0;
 	if (!(smf->flags & MDL_IGNORETRANSLATION))
 		translation = actor->Translation;
 
+	FModelInstance instance;
+	GetModelInstance(x, y, z, smf, actor, instance);
+
+	mLOD = instance.lod;
+	BeginDrawModel(actor, smf, instance.objectToWorldMatrix, instance.mirrored);
+	RenderFrameModels(smf, instance.smfNext, instance.inter, translation);
+	EndDrawModel(actor, smf);
+}
+
+void FModelRenderer::GetModelInstance(float x, float y, float z, FSpriteModelFrame *smf, AActor *actor, FModelInstance &instance)
+{
+	// Setup transformation.
+
 	// y scale for a sprite means height, i.e. z in the world!
 	float scaleFactorX = actor->Scale.X * smf->xscale;
 	float scaleFactorY = actor->Scale.X * smf->yscale;
@@ -121,7 +137,7 @@ void FModelRenderer::RenderModel(float x, float y, float z, FSpriteModelFrame *s
 	}
 	if (smf->flags & MDL_USEACTORROLL) roll += actor->Angles.Roll.Degrees;
 
-	VSMatrix objectToWorldMatrix;
+	VSMatrix &objectToWorldMatrix = instance.objectToWorldMatrix;
 	objectToWorldMatrix.loadIdentity();
 
 	// Model space => World space
@@ -178,9 +194,18 @@ void FModelRenderer::RenderModel(float x, float y, float z, FSpriteModelFrame *s
 
 	float orientation = scaleFactorX * scaleFactorY * scaleFactorZ;
 
-	BeginDrawModel(actor, smf, objectToWorldMatrix, orientation < 0);
-	RenderFrameModels(smf, actor->state, actor->tics, actor->GetClass(), translation);
-	EndDrawModel(actor, smf);
+	// Pick the LOD by distance to the view. Formats with LODs of their own (DMD) use the matching one,
+	// and from the third LOD on frame interpolation is skipped for all models.
+	mLOD = 0;
+	if (gl_model_lod_distance > 0.f)
+	{
+		double dist = (DVector3(x, y, z) - r_viewpoint.Pos).Length();
+		mLOD = clamp(int(dist / gl_model_lod_distance), 0, MAX_LODS - 1);
+	}
+
+	instance.lod = mLOD;
+	instance.mirrored = orientation < 0;
+	instance.smfNext = FindNextFrame(smf, actor->state, actor->tics, actor->GetClass(), instance.inter);
 }
 
 void FModelRenderer::RenderHUDModel(DPSprite *psp, float ofsX, float ofsY)
@@ -233,18 +258,22 @@ void FModelRenderer::RenderHUDModel(DPSprite *psp, float ofsX, float ofsY)
 
 	float orientation = smf->xscale * smf->yscale * smf->zscale;
 
+	mLOD = 0;
+	double inter;
+	FSpriteModelFrame *smfNext = FindNextFrame(smf, psp->GetState(), psp->GetTics(), playermo->player->ReadyWeapon->GetClass(), inter);
+
 	BeginDrawHUDModel(playermo, objectToWorldMatrix, orientation < 0);
-	RenderFrameModels(smf, psp->GetState(), psp->GetTics(), playermo->player->ReadyWeapon->GetClass(), psp->Flags & PSPF_PLAYERTRANSLATED ? psp->Owner->mo->Translation : 0);
+	RenderFrameModels(smf, smfNext, inter, psp->Flags & PSPF_PLAYERTRANSLATED ? psp->Owner->mo->Translation : 0);
 	EndDrawHUDModel(playermo);
 }
 
-void FModelRenderer::RenderFrameModels(const FSpriteModelFrame *smf, const FState *curState, const int curTics, const PClass *ti, int translation)
+FSpriteModelFrame *FModelRenderer::FindNextFrame(const FSpriteModelFrame *smf, const FState *curState, const int curTics, const PClass *ti, double &inter) const
 {
 	// [BB] Frame interpolation: Find the FSpriteModelFrame smfNext which follows after smf in the animation
 	// and the scalar value inter ( element of [0,1) ), both necessary to determine the interpolated frame.
 	FSpriteModelFrame * smfNext = nullptr;
-	double inter = 0.;
-	if (gl_interpolate_model_frames && !(smf->flags & MDL_NOINTERPOLATION))
+	inter = 0.;
+	if (gl_interpolate_model_frames && !(smf->flags & MDL_NOINTERPOLATION) && mLOD < 2)
 	{
 		FState *nextState = curState->GetNextState();
 		if (curState != nextState && nextState)
@@ -285,7 +314,11 @@ void FModelRenderer::RenderFrameModels(const FSpriteModelFrame *smf, const FStat
 			}
 		}
 	}
+	return smfNext;
+}
 
+void FModelRenderer::RenderFrameModels(const FSpriteModelFrame *smf, const FSpriteModelFrame *smfNext, double inter, int translation)
+{
 	for (int i = 0; i<MAX_MODELS_PER_FRAME; i++)
 	{
 		if (smf->modelIDs[i] != -1)
@@ -955,3 +988,72 @@ bool IsHUDModelForPlayerAvailable (player_t * player)
 	return ( smf != nullptr );
 }
 
+
+//===========================================================================
+//
+// CCMD modelbench
+//
+// Spawns a grid of model actors in front of the player to measure model
+// rendering with 'stat renderstats', 'stat rendertimes' or 'bench'.
+//
+//===========================================================================
+
+static TArray<AActor *> BenchModels;
+
+CCMD(modelbench)
+{
+	if (argv.argc() < 2)
+	{
+		Printf("Usage: modelbench <actor class> [count] | clear\n");
+		return;
+	}
+
+	if (!stricmp(argv[1], "clear"))
+	{
+		// Only compare against live actors so that nothing that has already been destroyed gets touched.
+		TThinkerIterator<AActor> it;
+		AActor *mo;
+		while ((mo = it.Next()) != nullptr)
+		{
+			if (BenchModels.Find(mo) < BenchModels.Size()) mo->Destroy();
+		}
+		BenchModels.Clear();
+		return;
+	}
+
+	if (netgame || CheckCheatmode() || players[consoleplayer].mo == nullptr)
+		return;
+
+	PClassActor *cls = PClass::FindActor(argv[1]);
+	if (cls == nullptr)
+	{
+		Printf(TEXTCOLOR_RED "Unknown actor class '%s'\n", argv[1]);
+		return;
+	}
+	AActor *def = GetDefaultByType(cls);
+	if (def->SpawnState == nullptr || FindModelFrame(cls, def->SpawnState->sprite, def->SpawnState->Frame, false) == nullptr)
+	{
+		Printf(TEXTCOLOR_RED "'%s' does not have a model\n", argv[1]);
+		return;
+	}
+
+	int count = argv.argc() > 2 ? clamp((int)strtol(argv[2], nullptr, 10), 1, 4096) : 200;
+	int side = (int)ceil(sqrt((double)count));
+	double spacing = MAX(def->radius * 3, 64.);
+
+	AActor *player = players[consoleplayer].mo;
+	DVector2 forward = player->Angles.Yaw.ToVector();
+	DVector2 right(forward.Y, -forward.X);
+	for (int i = 0; i < count; i++)
+	{
+		int row = i / side, col = i % side;
+		DVector2 pos = player->Pos().XY() + forward * (128 + row * spacing) + right * ((col - side / 2) * spacing);
+		AActor *mo = Spawn(cls, DVector3(pos, player->Z()), ALLOW_REPLACE);
+		if (mo != nullptr)
+		{
+			mo->SetZ(mo->floorz);
+			BenchModels.Push(mo);
+		}
+	}
+	Printf("Spawned %d %s. Use 'modelbench clear' to remove them.\n", count, cls->TypeName.GetChars());
+}
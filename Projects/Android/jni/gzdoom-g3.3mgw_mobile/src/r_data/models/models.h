@@ -47,6 +47,17 @@ FTextureID LoadSkin(const char * path, const char * fn);
 struct FSpriteModelFrame;
 class IModelVertexBuffer;
 
+// Everything needed to place one actor's model in the world, so that renderers
+// which draw several actors with one call can collect them first.
+struct FModelInstance
+{
+	VSMatrix objectToWorldMatrix;
+	FSpriteModelFrame *smfNext;	// frame to interpolate to, or nullptr
+	double inter;
+	int lod;
+	bool mirrored;
+};
+
 enum ModelRendererType
 {
 	GLModelRendererType,
@@ -61,6 +72,7 @@ public:
 	virtual ~FModelRenderer() { }
 
 	void RenderModel(float x, float y, float z, FSpriteModelFrame *modelframe, AActor *actor);
+	void GetModelInstance(float x, float y, float z, FSpriteModelFrame *smf, AActor *actor, FModelInstance &instance);
 	void RenderHUDModel(DPSprite *psp, float ofsx, float ofsy);
 
 	virtual ModelRendererType GetType() const = 0;
@@ -83,8 +95,14 @@ public:
 	virtual void DrawArrays(int start, int count) = 0;
 	virtual void DrawElements(int numIndices, size_t offset) = 0;
 
-private:
-	void RenderFrameModels(const FSpriteModelFrame *smf, const FState *curState, const int curTics, const PClass *ti, int translation);
+	// Level of detail for the model being rendered, 0 being the most detailed. Models that have no LODs of their own ignore it.
+	int GetLOD() const { return mLOD; }
+
+protected:
+	FSpriteModelFrame *FindNextFrame(const FSpriteModelFrame *smf, const FState *curState, const int curTics, const PClass *ti, double &inter) const;
+	void RenderFrameModels(const FSpriteModelFrame *smf, const FSpriteModelFrame *smfNext, double inter, int translation);
+
+	int mLOD = 0;
 };
 
 struct FModelVertex
@@ -231,6 +249,8 @@ protected:
 	struct DMDLoD
 	{
 		FTriangle		* triangles;
+		unsigned int	vindex;			// offset of this LOD's vertices within a frame in the vertex buffer
+		unsigned int	numVertices;
 	};
 
 
@@ -256,6 +276,8 @@ public:
 		for (int i = 0; i < MAX_LODS; i++)
 		{
 			lods[i].triangles = NULL;
+			lods[i].vindex = 0;
+			lods[i].numVertices = 0;
 		}
 		info.numLODs = 0;
 		texCoords = NULL;
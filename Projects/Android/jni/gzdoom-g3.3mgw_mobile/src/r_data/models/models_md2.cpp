@@ -124,6 +124,7 @@ bool FDMDModel::Load(const char * path, int lumpnum, const char * buffer, int le
 			info.numTexCoords = LittleLong(info.numTexCoords);
 			info.numFrames = LittleLong(info.numFrames);
 			info.numLODs = LittleLong(info.numLODs);
+			if (info.numLODs > MAX_LODS) info.numLODs = MAX_LODS;
 			info.offsetSkins = LittleLong(info.offsetSkins);
 			info.offsetTexCoords = LittleLong(info.offsetTexCoords);
 			info.offsetFrames = LittleLong(info.offsetFrames);
@@ -286,7 +287,16 @@ void FDMDModel::BuildVertexBuffer(FModelRenderer *renderer)
 	{
 		LoadGeometry();
 
-		int VertexBufferSize = info.numFrames * lodInfo[0].numTriangles * 3;
+		// All LODs of a frame are stored next to each other so that they share the frame's vindex
+		unsigned int FrameSize = 0;
+		for (int l = 0; l < MAX_LODS; l++)
+		{
+			lods[l].vindex = FrameSize;
+			lods[l].numVertices = (l < info.numLODs && lods[l].triangles != nullptr) ? lodInfo[l].numTriangles * 3 : 0;
+			FrameSize += lods[l].numVertices;
+		}
+
+		int VertexBufferSize = info.numFrames * FrameSize;
 		unsigned int vindex = 0;
 
 		auto vbuf = renderer->CreateVertexBuffer(false, info.numFrames == 1);
@@ -301,21 +311,24 @@ void FDMDModel::BuildVertexBuffer(FModelRenderer *renderer)
 
 			frames[i].vindex = vindex;
 
-			FTriangle *tri = lods[0].triangles;
-
-			for (int i = 0; i < lodInfo[0].numTriangles; i++)
+			for (int l = 0; l < MAX_LODS; l++)
 			{
-				for (int j = 0; j < 3; j++)
+				FTriangle *tri = lods[l].triangles;
+
+				for (unsigned int t = 0; t < lods[l].numVertices / 3; t++)
 				{
+					for (int j = 0; j < 3; j++)
+					{
 
-					int ti = tri->textureIndices[j];
-					int vi = tri->vertexIndices[j];
+						int ti = tri->textureIndices[j];
+						int vi = tri->vertexIndices[j];
 
-					FModelVertex *bvert = &vertptr[vindex++];
-					bvert->Set(vert[vi].xyz[0], vert[vi].xyz[1], vert[vi].xyz[2], (float)texCoords[ti].s / info.skinWidth, (float)texCoords[ti].t / info.skinHeight);
-					bvert->SetNormal(norm[vi].xyz[0], norm[vi].xyz[1], norm[vi].xyz[2]);
+						FModelVertex *bvert = &vertptr[vindex++];
+						bvert->Set(vert[vi].xyz[0], vert[vi].xyz[1], vert[vi].xyz[2], (float)texCoords[ti].s / info.skinWidth, (float)texCoords[ti].t / info.skinHeight);
+						bvert->SetNormal(norm[vi].xyz[0], norm[vi].xyz[1], norm[vi].xyz[2]);
+					}
+					tri++;
 				}
-				tri++;
 			}
 		}
 		vbuf->UnlockVertexBuffer();
@@ -371,10 +384,14 @@ void FDMDModel::RenderFrame(FModelRenderer *renderer, FTexture * skin, int frame
 		if (!skin) return;
 	}
 
+	// Use the requested LOD or the closest more detailed one the model has
+	int lod = MIN(renderer->GetLOD(), MAX_LODS - 1);
+	while (lod > 0 && lods[lod].numVertices == 0) lod--;
+
 	renderer->SetInterpolation(inter);
 	renderer->SetMaterial(skin, false, translation);
-	GetVertexBuffer(renderer)->SetupFrame(renderer, frames[frameno].vindex, frames[frameno2].vindex, lodInfo[0].numTriangles * 3);
-	renderer->DrawArrays(0, lodInfo[0].numTriangles * 3);
+	GetVertexBuffer(renderer)->SetupFrame(renderer, frames[frameno].vindex + lods[lod].vindex, frames[frameno2].vindex + lods[lod].vindex, lods[lod].numVertices);
+	renderer->DrawArrays(0, lods[lod].numVertices);
 	renderer->SetInterpolation(0.f);
 }
 
@@ -51,10 +51,6 @@ class DSectorPlaneInterpolation : public DInterpolation
 {
 	DECLARE_CLASS(DSectorPlaneInterpolation, DInterpolation)
 
-	sector_t *sector;
-	double oldheight, oldtexz;
-	double bakheight, baktexz;
-	bool ceiling;
 	TArray<DInterpolation *> attached;
 
 
@@ -63,9 +59,6 @@ public:
 	DSectorPlaneInterpolation() {}
 	DSectorPlaneInterpolation(sector_t *sector, bool plane, bool attach);
 	void OnDestroy() override;
-	void UpdateInterpolation();
-	void Restore();
-	void Interpolate(double smoothratio);
 	
 	virtual void Serialize(FSerializer &arc);
 	size_t PropagateMark();
@@ -81,19 +74,11 @@ class DSectorScrollInterpolation : public DInterpolation
 {
 	DECLARE_CLASS(DSectorScrollInterpolation, DInterpolation)
 
-	sector_t *sector;
-	double oldx, oldy;
-	double bakx, baky;
-	bool ceiling;
-
 public:
 
 	DSectorScrollInterpolation() {}
 	DSectorScrollInterpolation(sector_t *sector, bool plane);
 	void OnDestroy() override;
-	void UpdateInterpolation();
-	void Restore();
-	void Interpolate(double smoothratio);
 	
 	virtual void Serialize(FSerializer &arc);
 };
@@ -109,19 +94,11 @@ class DWallScrollInterpolation : public DInterpolation
 {
 	DECLARE_CLASS(DWallScrollInterpolation, DInterpolation)
 
-	side_t *side;
-	int part;
-	double oldx, oldy;
-	double bakx, baky;
-
 public:
 
 	DWallScrollInterpolation() {}
 	DWallScrollInterpolation(side_t *side, int part);
 	void OnDestroy() override;
-	void UpdateInterpolation();
-	void Restore();
-	void Interpolate(double smoothratio);
 	
 	virtual void Serialize(FSerializer &arc);
 };
@@ -136,19 +113,11 @@ class DPolyobjInterpolation : public DInterpolation
 {
 	DECLARE_CLASS(DPolyobjInterpolation, DInterpolation)
 
-	FPolyObj *poly;
-	TArray<double> oldverts, bakverts;
-	double oldcx, oldcy;
-	double bakcx, bakcy;
-
 public:
 
 	DPolyobjInterpolation() {}
 	DPolyobjInterpolation(FPolyObj *poly);
 	void OnDestroy() override;
-	void UpdateInterpolation();
-	void Restore();
-	void Interpolate(double smoothratio);
 	
 	virtual void Serialize(FSerializer &arc);
 };
@@ -187,6 +156,7 @@ IMPLEMENT_CLASS(DPolyobjInterpolation, false, false)
 //==========================================================================
 
 FInterpolator interpolator;
+static cycle_t InterpolationTime;
 
 //==========================================================================
 //
@@ -205,12 +175,49 @@ int FInterpolator::CountInterpolations ()
 //
 //==========================================================================
 
-void FInterpolator::UpdateInterpolations()
+static void UpdatePlane(FPlaneInterpolation &p)
+{
+	if (!p.ceiling)
+	{
+		p.oldheight = p.sector->floorplane.fD();
+		p.oldtexz = p.sector->GetPlaneTexZ(sector_t::floor);
+	}
+	else
+	{
+		p.oldheight = p.sector->ceilingplane.fD();
+		p.oldtexz = p.sector->GetPlaneTexZ(sector_t::ceiling);
+	}
+}
+
+static void UpdateSectorScroll(FSectorScrollInterpolation &s)
+{
+	s.oldx = s.sector->GetXOffset(s.ceiling);
+	s.oldy = s.sector->GetYOffset(s.ceiling, false);
+}
+
+static void UpdateWallScroll(FWallScrollInterpolation &w)
+{
+	w.oldx = w.side->GetTextureXOffset(w.part);
+	w.oldy = w.side->GetTextureYOffset(w.part);
+}
+
+static void UpdatePolyobj(FPolyobjInterpolation &p, double *verts)
 {
-	for (DInterpolation *probe = Head; probe != NULL; probe = probe->Next)
+	for (unsigned int i = 0; i < p.numverts; i++, verts += 4)
 	{
-		probe->UpdateInterpolation ();
+		verts[0] = p.poly->Vertices[i]->fX();
+		verts[1] = p.poly->Vertices[i]->fY();
 	}
+	p.oldcx = p.poly->CenterSpot.pos.X;
+	p.oldcy = p.poly->CenterSpot.pos.Y;
+}
+
+void FInterpolator::UpdateInterpolations()
+{
+	for (auto &p : Planes) UpdatePlane(p);
+	for (auto &s : SectorScrolls) UpdateSectorScroll(s);
+	for (auto &w : WallScrolls) UpdateWallScroll(w);
+	for (auto &p : Polyobjs) UpdatePolyobj(p, &PolyVertices[p.firstvert * 4]);
 }
 
 //==========================================================================
@@ -253,7 +260,41 @@ void FInterpolator::RemoveInterpolation(DInterpolation *interp)
 
 //==========================================================================
 //
+// Polyobject vertices are stored in one shared array.
 //
+//==========================================================================
+
+int FInterpolator::AllocPolyobjSlot(DInterpolation *owner, FPolyObj *poly, unsigned int numverts)
+{
+	int slot = AllocSlot(Polyobjs, owner);
+	Polyobjs[slot].poly = poly;
+	Polyobjs[slot].firstvert = PolyVertices.Size() / 4;
+	Polyobjs[slot].numverts = numverts;
+	PolyVertices.Reserve(numverts * 4);
+	return slot;
+}
+
+void FInterpolator::FreePolyobjSlot(int slot)
+{
+	unsigned int first = Polyobjs[slot].firstvert;
+	unsigned int num = Polyobjs[slot].numverts;
+
+	if (num > 0)
+	{
+		PolyVertices.Delete(first * 4, num * 4);
+		for (auto &p : Polyobjs)
+		{
+			if (p.firstvert > first) p.firstvert -= num;
+		}
+	}
+	FreeSlot(Polyobjs, slot);
+}
+
+//==========================================================================
+//
+// Interpolations which are no longer referenced and did not move since
+// the last tic are collected and destroyed after the pass, so that the
+// arrays are not modified while they are being iterated.
 //
 //==========================================================================
 
@@ -266,14 +307,113 @@ void FInterpolator::DoInterpolations(double smoothratio)
 	}
 
 	didInterp = true;
+	InterpolationTime.Reset();
+	InterpolationTime.Clock();
 
-	DInterpolation *probe = Head;
-	while (probe != NULL)
+	for (auto &p : Planes)
 	{
-		DInterpolation *next = probe->Next;
-		probe->Interpolate(smoothratio);
-		probe = next;
+		sector_t *sector = p.sector;
+		secplane_t *pplane;
+		int pos;
+
+		if (!p.ceiling)
+		{
+			pplane = &sector->floorplane;
+			pos = sector_t::floor;
+		}
+		else
+		{
+			pplane = &sector->ceilingplane;
+			pos = sector_t::ceiling;
+		}
+
+		p.bakheight = pplane->fD();
+		p.baktexz = sector->GetPlaneTexZ(pos);
+
+		if (p.owner->refcount == 0 && p.oldheight == p.bakheight)
+		{
+			Expired.Push(p.owner);
+		}
+		else
+		{
+			pplane->setD(p.oldheight + (p.bakheight - p.oldheight) * smoothratio);
+			sector->SetPlaneTexZ(pos, p.oldtexz + (p.baktexz - p.oldtexz) * smoothratio, true);
+			P_RecalculateAttached3DFloors(sector);
+			sector->CheckPortalPlane(pos);
+		}
+	}
+
+	for (auto &s : SectorScrolls)
+	{
+		s.bakx = s.sector->GetXOffset(s.ceiling);
+		s.baky = s.sector->GetYOffset(s.ceiling, false);
+
+		if (s.oldx == s.bakx && s.oldy == s.baky)
+		{
+			if (s.owner->refcount == 0) Expired.Push(s.owner);
+		}
+		else
+		{
+			s.sector->SetXOffset(s.ceiling, s.oldx + (s.bakx - s.oldx) * smoothratio);
+			s.sector->SetYOffset(s.ceiling, s.oldy + (s.baky - s.oldy) * smoothratio);
+		}
+	}
+
+	for (auto &w : WallScrolls)
+	{
+		w.bakx = w.side->GetTextureXOffset(w.part);
+		w.baky = w.side->GetTextureYOffset(w.part);
+
+		if (w.oldx == w.bakx && w.oldy == w.baky)
+		{
+			if (w.owner->refcount == 0) Expired.Push(w.owner);
+		}
+		else
+		{
+			w.side->SetTextureXOffset(w.part, w.oldx + (w.bakx - w.oldx) * smoothratio);
+			w.side->SetTextureYOffset(w.part, w.oldy + (w.baky - w.oldy) * smoothratio);
+		}
 	}
+
+	for (auto &p : Polyobjs)
+	{
+		FPolyObj *poly = p.poly;
+		double *verts = &PolyVertices[p.firstvert * 4];
+		bool changed = false;
+
+		for (unsigned int i = 0; i < p.numverts; i++, verts += 4)
+		{
+			vertex_t *v = poly->Vertices[i];
+			verts[2] = v->fX();
+			verts[3] = v->fY();
+
+			if (verts[2] != verts[0] || verts[3] != verts[1])
+			{
+				changed = true;
+				v->set(verts[0] + (verts[2] - verts[0]) * smoothratio, verts[1] + (verts[3] - verts[1]) * smoothratio);
+			}
+		}
+		if (p.owner->refcount == 0 && !changed)
+		{
+			Expired.Push(p.owner);
+		}
+		else
+		{
+			p.bakcx = poly->CenterSpot.pos.X;
+			p.bakcy = poly->CenterSpot.pos.Y;
+			poly->CenterSpot.pos.X = p.bakcx + (p.bakcx - p.oldcx) * smoothratio;
+			poly->CenterSpot.pos.Y = p.bakcy + (p.bakcy - p.oldcy) * smoothratio;
+
+			poly->ClearSubsectorLinks();
+		}
+	}
+
+	for (auto interp : Expired)
+	{
+		interp->Destroy();
+	}
+	Expired.Clear();
+	InterpolationTime.Unclock();
 }
 
 //==========================================================================
@@ -287,10 +427,50 @@ void FInterpolator::RestoreInterpolations()
 	if (didInterp)
 	{
 		didInterp = false;
-		for (DInterpolation *probe = Head; probe != NULL; probe = probe->Next)
+		InterpolationTime.Clock();
+
+		for (auto &p : Planes)
+		{
+			sector_t *sector = p.sector;
+			if (!p.ceiling)
+			{
+				sector->floorplane.setD(p.bakheight);
+				sector->SetPlaneTexZ(sector_t::floor, p.baktexz, true);
+			}
+			else
+			{
+				sector->ceilingplane.setD(p.bakheight);
+				sector->SetPlaneTexZ(sector_t::ceiling, p.baktexz, true);
+			}
+			P_RecalculateAttached3DFloors(sector);
+			sector->CheckPortalPlane(p.ceiling? sector_t::ceiling : sector_t::floor);
+		}
+
+		for (auto &s : SectorScrolls)
 		{
-			probe->Restore();
+			s.sector->SetXOffset(s.ceiling, s.bakx);
+			s.sector->SetYOffset(s.ceiling, s.baky);
 		}
+
+		for (auto &w : WallScrolls)
+		{
+			w.side->SetTextureXOffset(w.part, w.bakx);
+			w.side->SetTextureYOffset(w.part, w.baky);
+		}
+
+		for (auto &p : Polyobjs)
+		{
+			FPolyObj *poly = p.poly;
+			const double *verts = &PolyVertices[p.firstvert * 4];
+			for (unsigned int i = 0; i < p.numverts; i++, verts += 4)
+			{
+				poly->Vertices[i]->set(verts[2], verts[3]);
+			}
+			poly->CenterSpot.pos.X = p.bakcx;
+			poly->CenterSpot.pos.Y = p.bakcy;
+			poly->ClearSubsectorLinks();
+		}
+		InterpolationTime.Unclock();
 	}
 }
 
@@ -313,6 +493,20 @@ void FInterpolator::ClearInterpolations()
 	}
 }
 
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+FString FInterpolator::GetStats()
+{
+	FString out;
+	out.Format("%d interpolations (%u planes, %u sector scrolls, %u wall scrolls, %u polyobjects), %2.3f ms",
+		count, Planes.Size(), SectorScrolls.Size(), WallScrolls.Size(), Polyobjs.Size(), InterpolationTime.TimeMS());
+	return out;
+}
+
 
 //==========================================================================
 //
@@ -331,6 +525,7 @@ DInterpolation::DInterpolation()
 	Next = nullptr;
 	Prev = nullptr;
 	refcount = 0;
+	slot = -1;
 }
 
 //==========================================================================
@@ -400,14 +595,16 @@ void DInterpolation::Serialize(FSerializer &arc)
 
 DSectorPlaneInterpolation::DSectorPlaneInterpolation(sector_t *_sector, bool _plane, bool attach)
 {
-	sector = _sector;
-	ceiling = _plane;
-	UpdateInterpolation ();
+	slot = interpolator.AllocSlot(interpolator.Planes, this);
+	FPlaneInterpolation &p = interpolator.Planes[slot];
+	p.sector = _sector;
+	p.ceiling = _plane;
+	UpdatePlane(p);
 
 	if (attach)
 	{
-		P_Start3dMidtexInterpolations(attached, sector, ceiling);
-		P_StartLinkedSectorInterpolations(attached, sector, ceiling);
+		P_Start3dMidtexInterpolations(attached, _sector, _plane);
+		P_StartLinkedSectorInterpolations(attached, _sector, _plane);
 	}
 	interpolator.AddInterpolation(this);
 }
@@ -420,17 +617,22 @@ DSectorPlaneInterpolation::DSectorPlaneInterpolation(sector_t *_sector, bool _pl
 
 void DSectorPlaneInterpolation::OnDestroy()
 {
-	if (sector != nullptr)
+	if (slot >= 0)
 	{
-		if (ceiling)
+		FPlaneInterpolation &p = interpolator.Planes[slot];
+		if (p.sector != nullptr)
 		{
-			sector->interpolations[sector_t::CeilingMove] = nullptr;
+			if (p.ceiling)
+			{
+				p.sector->interpolations[sector_t::CeilingMove] = nullptr;
+			}
+			else
+			{
+				p.sector->interpolations[sector_t::FloorMove] = nullptr;
+			}
 		}
-		else
-		{
-			sector->interpolations[sector_t::FloorMove] = nullptr;
-		}
-		sector = nullptr;
+		interpolator.FreeSlot(interpolator.Planes, slot);
+		slot = -1;
 	}
 	for(unsigned i=0; i<attached.Size(); i++)
 	{
@@ -445,93 +647,15 @@ void DSectorPlaneInterpolation::OnDestroy()
 //
 //==========================================================================
 
-void DSectorPlaneInterpolation::UpdateInterpolation()
-{
-	if (!ceiling)
-	{
-		oldheight = sector->floorplane.fD();
-		oldtexz = sector->GetPlaneTexZ(sector_t::floor);
-	}
-	else
-	{
-		oldheight = sector->ceilingplane.fD();
-		oldtexz = sector->GetPlaneTexZ(sector_t::ceiling);
-	}
-}
-
-//==========================================================================
-//
-//
-//
-//==========================================================================
-
-void DSectorPlaneInterpolation::Restore()
-{
-	if (!ceiling)
-	{
-		sector->floorplane.setD(bakheight);
-		sector->SetPlaneTexZ(sector_t::floor, baktexz, true);
-	}
-	else
-	{
-		sector->ceilingplane.setD(bakheight);
-		sector->SetPlaneTexZ(sector_t::ceiling, baktexz, true);
-	}
-	P_RecalculateAttached3DFloors(sector);
-	sector->CheckPortalPlane(ceiling? sector_t::ceiling : sector_t::floor);
-}
-
-//==========================================================================
-//
-//
-//
-//==========================================================================
-
-void DSectorPlaneInterpolation::Interpolate(double smoothratio)
-{
-	secplane_t *pplane;
-	int pos;
-
-	if (!ceiling)
-	{
-		pplane = &sector->floorplane;
-		pos = sector_t::floor;
-	}
-	else
-	{
-		pplane = &sector->ceilingplane;
-		pos = sector_t::ceiling;
-	}
-
-	bakheight = pplane->fD();
-	baktexz = sector->GetPlaneTexZ(pos);
-
-	if (refcount == 0 && oldheight == bakheight)
-	{
-		Destroy();
-	}
-	else
-	{
-		pplane->setD(oldheight + (bakheight - oldheight) * smoothratio);
-		sector->SetPlaneTexZ(pos, oldtexz + (baktexz - oldtexz) * smoothratio, true);
-	P_RecalculateAttached3DFloors(sector);
-		sector->CheckPortalPlane(pos);
-	}
-}
-
-//==========================================================================
-//
-//
-//
-//==========================================================================
-
 void DSectorPlaneInterpolation::Serialize(FSerializer &arc)
 {
 	Super::Serialize(arc);
-	arc("sector", sector)
-		("ceiling", ceiling)
-		("oldheight", oldheight)
-		("oldtexz", oldtexz)
+	if (arc.isReading() && slot < 0) slot = interpolator.AllocSlot(interpolator.Planes, this);
+	FPlaneInterpolation &p = interpolator.Planes[slot];
+	arc("sector", p.sector)
+		("ceiling", p.ceiling)
+		("oldheight", p.oldheight)
+		("oldtexz", p.oldtexz)
 		("attached", attached);
 }
 
@@ -565,9 +689,11 @@ size_t DSectorPlaneInterpolation::PropagateMark()
 
 DSectorScrollInterpolation::DSectorScrollInterpolation(sector_t *_sector, bool _plane)
 {
-	sector = _sector;
-	ceiling = _plane;
-	UpdateInterpolation ();
+	slot = interpolator.AllocSlot(interpolator.SectorScrolls, this);
+	FSectorScrollInterpolation &s = interpolator.SectorScrolls[slot];
+	s.sector = _sector;
+	s.ceiling = _plane;
+	UpdateSectorScroll(s);
 	interpolator.AddInterpolation(this);
 }
 
@@ -579,17 +705,22 @@ DSectorScrollInterpolation::DSectorScrollInterpolation(sector_t *_sector, bool _
 
 void DSectorScrollInterpolation::OnDestroy()
 {
-	if (sector != nullptr)
+	if (slot >= 0)
 	{
-		if (ceiling)
+		FSectorScrollInterpolation &s = interpolator.SectorScrolls[slot];
+		if (s.sector != nullptr)
 		{
-			sector->interpolations[sector_t::CeilingScroll] = nullptr;
+			if (s.ceiling)
+			{
+				s.sector->interpolations[sector_t::CeilingScroll] = nullptr;
+			}
+			else
+			{
+				s.sector->interpolations[sector_t::FloorScroll] = nullptr;
+			}
 		}
-		else
-		{
-			sector->interpolations[sector_t::FloorScroll] = nullptr;
-		}
-		sector = nullptr;
+		interpolator.FreeSlot(interpolator.SectorScrolls, slot);
+		slot = -1;
 	}
 	Super::OnDestroy();
 }
@@ -600,59 +731,15 @@ void DSectorScrollInterpolation::OnDestroy()
 //
 //==========================================================================
 
-void DSectorScrollInterpolation::UpdateInterpolation()
-{
-	oldx = sector->GetXOffset(ceiling);
-	oldy = sector->GetYOffset(ceiling, false);
-}
-
-//==========================================================================
-//
-//
-//
-//==========================================================================
-
-void DSectorScrollInterpolation::Restore()
-{
-	sector->SetXOffset(ceiling, bakx);
-	sector->SetYOffset(ceiling, baky);
-}
-
-//==========================================================================
-//
-//
-//
-//==========================================================================
-
-void DSectorScrollInterpolation::Interpolate(double smoothratio)
-{
-	bakx = sector->GetXOffset(ceiling);
-	baky = sector->GetYOffset(ceiling, false);
-
-	if (refcount == 0 && oldx == bakx && oldy == baky)
-	{
-		Destroy();
-	}
-	else
-	{
-		sector->SetXOffset(ceiling, oldx + (bakx - oldx) * smoothratio);
-		sector->SetYOffset(ceiling, oldy + (baky - oldy) * smoothratio);
-	}
-}
-
-//==========================================================================
-//
-//
-//
-//==========================================================================
-
 void DSectorScrollInterpolation::Serialize(FSerializer &arc)
 {
 	Super::Serialize(arc);
-	arc("sector", sector)
-		("ceiling", ceiling)
-		("oldx", oldx)
-		("oldy", oldy);
+	if (arc.isReading() && slot < 0) slot = interpolator.AllocSlot(interpolator.SectorScrolls, this);
+	FSectorScrollInterpolation &s = interpolator.SectorScrolls[slot];
+	arc("sector", s.sector)
+		("ceiling", s.ceiling)
+		("oldx", s.oldx)
+		("oldy", s.oldy);
 }
 
 
@@ -670,9 +757,11 @@ void DSectorScrollInterpolation::Serialize(FSerializer &arc)
 
 DWallScrollInterpolation::DWallScrollInterpolation(side_t *_side, int _part)
 {
-	side = _side;
-	part = _part;
-	UpdateInterpolation ();
+	slot = interpolator.AllocSlot(interpolator.WallScrolls, this);
+	FWallScrollInterpolation &w = interpolator.WallScrolls[slot];
+	w.side = _side;
+	w.part = _part;
+	UpdateWallScroll(w);
 	interpolator.AddInterpolation(this);
 }
 
@@ -684,10 +773,15 @@ DWallScrollInterpolation::DWallScrollInterpolation(side_t *_side, int _part)
 
 void DWallScrollInterpolation::OnDestroy()
 {
-	if (side != nullptr)
+	if (slot >= 0)
 	{
-		side->textures[part].interpolation = nullptr;
-		side = nullptr;
+		FWallScrollInterpolation &w = interpolator.WallScrolls[slot];
+		if (w.side != nullptr)
+		{
+			w.side->textures[w.part].interpolation = nullptr;
+		}
+		interpolator.FreeSlot(interpolator.WallScrolls, slot);
+		slot = -1;
 	}
 	Super::OnDestroy();
 }
@@ -698,59 +792,15 @@ void DWallScrollInterpolation::OnDestroy()
 //
 //==========================================================================
 
-void DWallScrollInterpolation::UpdateInterpolation()
-{
-	oldx = side->GetTextureXOffset(part);
-	oldy = side->GetTextureYOffset(part);
-}
-
-//==========================================================================
-//
-//
-//
-//==========================================================================
-
-void DWallScrollInterpolation::Restore()
-{
-	side->SetTextureXOffset(part, bakx);
-	side->SetTextureYOffset(part, baky);
-}
-
-//==========================================================================
-//
-//
-//
-//==========================================================================
-
-void DWallScrollInterpolation::Interpolate(double smoothratio)
-{
-	bakx = side->GetTextureXOffset(part);
-	baky = side->GetTextureYOffset(part);
-
-	if (refcount == 0 && oldx == bakx && oldy == baky)
-	{
-		Destroy();
-	}
-	else
-	{
-		side->SetTextureXOffset(part, oldx + (bakx - oldx) * smoothratio);
-		side->SetTextureYOffset(part, oldy + (baky - oldy) * smoothratio);
-	}
-}
-
-//==========================================================================
-//
-//
-//
-//==========================================================================
-
 void DWallScrollInterpolation::Serialize(FSerializer &arc)
 {
 	Super::Serialize(arc);
-	arc("side", side)
-		("part", part)
-		("oldx", oldx)
-		("oldy", oldy);
+	if (arc.isReading() && slot < 0) slot = interpolator.AllocSlot(interpolator.WallScrolls, this);
+	FWallScrollInterpolation &w = interpolator.WallScrolls[slot];
+	arc("side", w.side)
+		("part", w.part)
+		("oldx", w.oldx)
+		("oldy", w.oldy);
 }
 
 //==========================================================================
@@ -767,10 +817,9 @@ void DWallScrollInterpolation::Serialize(FSerializer &arc)
 
 DPolyobjInterpolation::DPolyobjInterpolation(FPolyObj *po)
 {
-	poly = po;
-	oldverts.Resize(po->Vertices.Size() << 1);
-	bakverts.Resize(po->Vertices.Size() << 1);
-	UpdateInterpolation ();
+	slot = interpolator.AllocPolyobjSlot(this, po, po->Vertices.Size());
+	FPolyobjInterpolation &p = interpolator.Polyobjs[slot];
+	UpdatePolyobj(p, &interpolator.PolyVertices[p.firstvert * 4]);
 	interpolator.AddInterpolation(this);
 }
 
@@ -782,98 +831,67 @@ DPolyobjInterpolation::DPolyobjInterpolation(FPolyObj *po)
 
 void DPolyobjInterpolation::OnDestroy()
 {
-	if (poly != nullptr)
+	if (slot >= 0)
 	{
-		poly->interpolation = nullptr;
+		FPolyobjInterpolation &p = interpolator.Polyobjs[slot];
+		if (p.poly != nullptr)
+		{
+			p.poly->interpolation = nullptr;
+		}
+		interpolator.FreePolyobjSlot(slot);
+		slot = -1;
 	}
 	Super::OnDestroy();
 }
 
 //==========================================================================
 //
-//
+// The old vertex positions are stored in the same format as before
+// they were moved into the interpolator.
 //
 //==========================================================================
 
-void DPolyobjInterpolation::UpdateInterpolation()
-{
-	for(unsigned int i = 0; i < poly->Vertices.Size(); i++)
-	{
-		oldverts[i*2  ] = poly->Vertices[i]->fX();
-		oldverts[i*2+1] = poly->Vertices[i]->fY();
-	}
-	oldcx = poly->CenterSpot.pos.X;
-	oldcy = poly->CenterSpot.pos.Y;
-}
-
-//==========================================================================
-//
-//
-//
-//==========================================================================
-
-void DPolyobjInterpolation::Restore()
+void DPolyobjInterpolation::Serialize(FSerializer &arc)
 {
-	for(unsigned int i = 0; i < poly->Vertices.Size(); i++)
-	{
-		poly->Vertices[i]->set(bakverts[i*2  ], bakverts[i*2+1]);
-	}
-	poly->CenterSpot.pos.X = bakcx;
-	poly->CenterSpot.pos.Y = bakcy;
-	poly->ClearSubsectorLinks();
-}
+	Super::Serialize(arc);
 
-//==========================================================================
-//
-//
-//
-//==========================================================================
+	FPolyObj *poly = slot >= 0 ? interpolator.Polyobjs[slot].poly : nullptr;
+	TArray<double> oldverts;
+	double oldcx = 0, oldcy = 0;
 
-void DPolyobjInterpolation::Interpolate(double smoothratio)
-{
-	bool changed = false;
-	for(unsigned int i = 0; i < poly->Vertices.Size(); i++)
+	if (!arc.isReading())
 	{
-		bakverts[i*2  ] = poly->Vertices[i]->fX();
-		bakverts[i*2+1] = poly->Vertices[i]->fY();
-
-		if (bakverts[i * 2] != oldverts[i * 2] || bakverts[i * 2 + 1] != oldverts[i * 2 + 1])
+		const FPolyobjInterpolation &p = interpolator.Polyobjs[slot];
+		const double *verts = &interpolator.PolyVertices[p.firstvert * 4];
+		oldverts.Resize(p.numverts * 2);
+		for (unsigned int i = 0; i < p.numverts; i++, verts += 4)
 		{
-			changed = true;
-			poly->Vertices[i]->set(
-				oldverts[i * 2] + (bakverts[i * 2] - oldverts[i * 2]) * smoothratio,
-				oldverts[i * 2 + 1] + (bakverts[i * 2 + 1] - oldverts[i * 2 + 1]) * smoothratio);
+			oldverts[i * 2] = verts[0];
+			oldverts[i * 2 + 1] = verts[1];
 		}
+		oldcx = p.oldcx;
+		oldcy = p.oldcy;
 	}
-	if (refcount == 0 && !changed)
-	{
-		Destroy();
-	}
-	else
-	{
-		bakcx = poly->CenterSpot.pos.X;
-		bakcy = poly->CenterSpot.pos.Y;
-		poly->CenterSpot.pos.X = bakcx + (bakcx - oldcx) * smoothratio;
-		poly->CenterSpot.pos.Y = bakcy + (bakcy - oldcy) * smoothratio;
 
-		poly->ClearSubsectorLinks();
-	}
-}
-
-//==========================================================================
-//
-//
-//
-//==========================================================================
-
-void DPolyobjInterpolation::Serialize(FSerializer &arc)
-{
-	Super::Serialize(arc);
 	arc("poly", poly)
 		("oldverts", oldverts)
 		("oldcx", oldcx)
 		("oldcy", oldcy);
-	if (arc.isReading()) bakverts.Resize(oldverts.Size());
+
+	if (arc.isReading())
+	{
+		if (slot >= 0) interpolator.FreePolyobjSlot(slot);
+		slot = interpolator.AllocPolyobjSlot(this, poly, oldverts.Size() / 2);
+		FPolyobjInterpolation &p = interpolator.Polyobjs[slot];
+		double *verts = &interpolator.PolyVertices[p.firstvert * 4];
+		for (unsigned int i = 0; i < p.numverts; i++, verts += 4)
+		{
+			verts[0] = verts[2] = oldverts[i * 2];
+			verts[1] = verts[3] = oldverts[i * 2 + 1];
+		}
+		p.oldcx = p.bakcx = oldcx;
+		p.oldcy = p.bakcy = oldcy;
+	}
 }
 
 
@@ -985,9 +1003,5 @@ void FPolyObj::StopInterpolation()
 
 ADD_STAT (interpolations)
 {
-	FString out;
-	out.Format ("%d interpolations", interpolator.CountInterpolations ());
-	return out;
+	return interpolator.GetStats();
 }
-
-
@@ -2,6 +2,11 @@
 #define R_INTERPOLATE_H
 
 #include "dobject.h"
+
+struct sector_t;
+struct side_t;
+struct FPolyObj;
+
 //==========================================================================
 //
 //
@@ -20,6 +25,7 @@ class DInterpolation : public DObject
 
 protected:
 	int refcount;
+	int slot;	// index of this interpolation's state in the interpolator's array for its kind
 
 	DInterpolation();
 
@@ -28,13 +34,56 @@ public:
 	int DelRef(bool force = false);
 
 	void OnDestroy() override;
-	virtual void UpdateInterpolation() = 0;
-	virtual void Restore() = 0;
-	virtual void Interpolate(double smoothratio) = 0;
 	
 	virtual void Serialize(FSerializer &arc);
 };
 
+//==========================================================================
+//
+// The state of all interpolations is kept in one array per kind so that
+// the per-frame passes are plain loops over contiguous memory. The
+// DInterpolation objects are only handles that own a slot in these arrays
+// and keep the reference count and the garbage collector's view of them.
+//
+//==========================================================================
+
+struct FPlaneInterpolation
+{
+	DInterpolation *owner;
+	sector_t *sector;
+	double oldheight, oldtexz;
+	double bakheight, baktexz;
+	bool ceiling;
+};
+
+struct FSectorScrollInterpolation
+{
+	DInterpolation *owner;
+	sector_t *sector;
+	double oldx, oldy;
+	double bakx, baky;
+	bool ceiling;
+};
+
+struct FWallScrollInterpolation
+{
+	DInterpolation *owner;
+	side_t *side;
+	double oldx, oldy;
+	double bakx, baky;
+	int part;
+};
+
+struct FPolyobjInterpolation
+{
+	DInterpolation *owner;
+	FPolyObj *poly;
+	unsigned int firstvert;	// into FInterpolator::PolyVertices, 4 values per vertex: old x/y, backup x/y
+	unsigned int numverts;
+	double oldcx, oldcy;
+	double bakcx, bakcy;
+};
+
 //==========================================================================
 //
 //
@@ -47,8 +96,34 @@ struct FInterpolator
 	bool didInterp;
 	int count;
 
+	TArray<FPlaneInterpolation> Planes;
+	TArray<FSectorScrollInterpolation> SectorScrolls;
+	TArray<FWallScrollInterpolation> WallScrolls;
+	TArray<FPolyobjInterpolation> Polyobjs;
+	TArray<double> PolyVertices;
+	TArray<DInterpolation *> Expired;
+
 	int CountInterpolations ();
 
+	template<class T> int AllocSlot(TArray<T> &array, DInterpolation *owner)
+	{
+		int slot = array.Reserve(1);
+		memset(&array[slot], 0, sizeof(T));
+		array[slot].owner = owner;
+		return slot;
+	}
+
+	template<class T> void FreeSlot(TArray<T> &array, int slot)
+	{
+		unsigned int last = array.Size() - 1;
+		if ((unsigned)slot != last)
+		{
+			array[slot] = array[last];
+			array[slot].owner->slot = slot;
+		}
+		array.Pop();
+	}
+
 public:
 	FInterpolator()
 	{
@@ -62,6 +137,10 @@ public:
 	void DoInterpolations(double smoothratio);
 	void RestoreInterpolations();
 	void ClearInterpolations();
+
+	int AllocPolyobjSlot(DInterpolation *owner, FPolyObj *poly, unsigned int numverts);
+	void FreePolyobjSlot(int slot);
+	FString GetStats();
 };
 
 extern FInterpolator interpolator;
@@ -69,4 +148,3 @@ extern FInterpolator interpolator;
 
 
 #endif
-
@@ -37,6 +37,7 @@
 #include "r_data/voxels.h"
 #include "textures/textures.h"
 #include "vm.h"
+#include "d_startupprofile.h"
 
 void InitModels();
 
@@ -1043,6 +1044,7 @@ void R_InitSprites ()
 	// [RH] Sort the skins, but leave base as skin 0
 	//qsort (&skins[PlayerClasses.Size ()], numskins-PlayerClasses.Size (), sizeof(FPlayerSkin), skinsorter);
 
+	FStartupScope scope("Models");
 	InitModels();
 }
 
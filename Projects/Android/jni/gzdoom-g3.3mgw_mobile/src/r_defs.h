@@ -560,6 +560,7 @@ struct extsector_t
 		TDeletingArray<F3DFloor *>		ffloors;		// 3D floors in this sector
 		TArray<lightlist_t>				lightlist;		// 3D light list
 		TArray<sector_t*>				attached;		// 3D floors attached to this sector
+		int								lightliststamp = 0;	// changes each time the light list gets rebuilt
 	} XFloor;
 
 	TArray<vertex_t *> vertices;
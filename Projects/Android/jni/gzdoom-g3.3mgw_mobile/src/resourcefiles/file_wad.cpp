@@ -34,6 +34,7 @@
 */
 
 #include <ctype.h>
+#include <atomic>
 #include "resourcefile.h"
 #include "cmdlib.h"
 #include "templates.h"
@@ -393,7 +394,8 @@ void FWadFile::SetNamespace(const char *startmarker, const char *endmarker, name
 
 void FWadFile::SkinHack ()
 {
-	static int namespc = ns_firstskin;
+	// Archives may be opened concurrently.
+	static std::atomic<int> nextnamespc(ns_firstskin);
 	bool skinned = false;
 	bool hasmap = false;
 	uint32_t i;
@@ -413,13 +415,13 @@ void FWadFile::SkinHack ()
 			if (!skinned)
 			{
 				skinned = true;
+				int namespc = nextnamespc++;
 				uint32_t j;
 
 				for (j = 0; j < NumLumps; j++)
 				{
 					Lumps[j].Namespace = namespc;
 				}
-				namespc++;
 			}
 		}
 		if ((lump->Name[0] == 'M' &&
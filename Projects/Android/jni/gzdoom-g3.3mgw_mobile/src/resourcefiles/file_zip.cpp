@@ -34,6 +34,7 @@
 */
 
 #include <time.h>
+#include <zlib.h>
 #include "file_zip.h"
 #include "cmdlib.h"
 #include "templates.h"
@@ -42,6 +43,9 @@
 #include "w_zip.h"
 #include "i_system.h"
 #include "ancientzip.h"
+#include "m_misc.h"
+#include "c_dispatch.h"
+#include "stats.h"
 
 #define BUFREADCOMMENT (0x400)
 
@@ -67,6 +71,14 @@ static bool UncompressZipLump(char *Cache, FileReader &Reader, int Method, int L
 		case METHOD_BZIP2:
 		case METHOD_LZMA:
 		{
+			// In-memory data doesn't need to go through a stream.
+			const char *buffer = Reader.GetBuffer();
+			if (buffer != nullptr)
+			{
+				long pos = Reader.Tell();
+				long avail = MIN<long>(CompressedSize, Reader.GetLength() - pos);
+				if (DecompressBuffer(Cache, LumpSize, buffer + pos, avail, Method)) break;
+			}
 			FileReader frz;
 			if (frz.OpenDecompressor(Reader, LumpSize, Method, false))
 			{
@@ -214,12 +226,13 @@ bool FZipFile::Open(bool quiet)
 
 	// Check if all files have the same prefix so that this can be stripped out.
 	// This will only be done if there is either a MAPINFO, ZMAPINFO or GAMEINFO lump in the subdirectory, denoting a ZDoom mod.
+	// The names are checked in place because creating a string for every entry is far too slow for large archives.
 	if (NumLumps > 1) for (uint32_t i = 0; i < NumLumps; i++)
 	{
 		FZipCentralDirectoryInfo *zip_fh = (FZipCentralDirectoryInfo *)dirptr;
 
 		int len = LittleShort(zip_fh->NameLength);
-		FString name(dirptr + sizeof(FZipCentralDirectoryInfo), len);
+		const char *name = dirptr + sizeof(FZipCentralDirectoryInfo);
 
 		dirptr += sizeof(FZipCentralDirectoryInfo) +
 			LittleShort(zip_fh->NameLength) +
@@ -233,30 +246,32 @@ bool FZipFile::Open(bool quiet)
 			return false;
 		}
 
-		name.ToLower();
 		if (i == 0)
 		{
+			FString first(name, len);
+			first.ToLower();
 			// check for special names, if one of these gets found this must be treated as a normal zip.
-			bool isspecial = !name.Compare("flats/") ||
-				name.IndexOf("/") < 0 ||
-				!name.Compare("textures/") ||
-				!name.Compare("hires/") ||
-				!name.Compare("sprites/") ||
-				!name.Compare("voxels/") ||
-				!name.Compare("colormaps/") ||
-				!name.Compare("acs/") ||
-				!name.Compare("maps/") ||
-				!name.Compare("voices/") ||
-				!name.Compare("patches/") ||
-				!name.Compare("graphics/") ||
-				!name.Compare("sounds/") ||
-				!name.Compare("music/");
+			bool isspecial = !first.Compare("flats/") ||
+				first.IndexOf("/") < 0 ||
+				!first.Compare("textures/") ||
+				!first.Compare("hires/") ||
+				!first.Compare("sprites/") ||
+				!first.Compare("voxels/") ||
+				!first.Compare("colormaps/") ||
+				!first.Compare("acs/") ||
+				!first.Compare("maps/") ||
+				!first.Compare("voices/") ||
+				!first.Compare("patches/") ||
+				!first.Compare("graphics/") ||
+				!first.Compare("sounds/") ||
+				!first.Compare("music/");
 			if (isspecial) break;
-			name0 = name;
+			name0 = first;
 		}
 		else
 		{
-			if (name.IndexOf(name0) != 0)
+			int prefixlen = (int)name0.Len();
+			if (len < prefixlen || strnicmp(name, name0, prefixlen) != 0)
 			{
 				name0 = "";
 				break;
@@ -264,19 +279,24 @@ bool FZipFile::Open(bool quiet)
 			else if (!foundspeciallump)
 			{
 				// at least one of the more common definition lumps must be present.
-				if (name.IndexOf(name0 + "mapinfo") == 0) foundspeciallump = true;
-				else if (name.IndexOf(name0 + "zmapinfo") == 0) foundspeciallump = true;
-				else if (name.IndexOf(name0 + "gameinfo") == 0) foundspeciallump = true;
-				else if (name.IndexOf(name0 + "sndinfo") == 0) foundspeciallump = true;
-				else if (name.IndexOf(name0 + "sbarinfo") == 0) foundspeciallump = true;
-				else if (name.IndexOf(name0 + "menudef") == 0) foundspeciallump = true;
-				else if (name.IndexOf(name0 + "gldefs") == 0) foundspeciallump = true;
-				else if (name.IndexOf(name0 + "animdefs") == 0) foundspeciallump = true;
-				else if (name.IndexOf(name0 + "decorate.") == 0) foundspeciallump = true;	// DECORATE is a common subdirectory name, so the check needs to be a bit different.
-				else if (name.Compare(name0 + "decorate") == 0) foundspeciallump = true;
-				else if (name.IndexOf(name0 + "zscript.") == 0) foundspeciallump = true;	// same here.
-				else if (name.Compare(name0 + "zscript") == 0) foundspeciallump = true;
-				else if (name.Compare(name0 + "maps/") == 0) foundspeciallump = true;
+				const char *rest = name + prefixlen;
+				size_t restlen = len - prefixlen;
+				auto startswith = [=](const char *str) { size_t l = strlen(str); return restlen >= l && !strnicmp(rest, str, l); };
+				auto equals = [=](const char *str) { return restlen == strlen(str) && !strnicmp(rest, str, restlen); };
+
+				if (startswith("mapinfo")) foundspeciallump = true;
+				else if (startswith("zmapinfo")) foundspeciallump = true;
+				else if (startswith("gameinfo")) foundspeciallump = true;
+				else if (startswith("sndinfo")) foundspeciallump = true;
+				else if (startswith("sbarinfo")) foundspeciallump = true;
+				else if (startswith("menudef")) foundspeciallump = true;
+				else if (startswith("gldefs")) foundspeciallump = true;
+				else if (startswith("animdefs")) foundspeciallump = true;
+				else if (startswith("decorate.")) foundspeciallump = true;	// DECORATE is a common subdirectory name, so the check needs to be a bit different.
+				else if (equals("decorate")) foundspeciallump = true;
+				else if (startswith("zscript.")) foundspeciallump = true;	// same here.
+				else if (equals("zscript")) foundspeciallump = true;
+				else if (equals("maps/")) foundspeciallump = true;
 			}
 		}
 	}
@@ -669,3 +689,86 @@ bool WriteZip(const char *filename, TArray<FString> &filenames, TArray<FCompress
 	}
 	return false;
 }
+
+//==========================================================================
+//
+// CCMD zipbench
+//
+// Writes an archive with many small compressed lumps, then measures how
+// long it takes to open it and to read all lumps twice. The second read
+// is served from the lump cache as far as lump_cachesize allows.
+//
+//==========================================================================
+
+static FCompressedBuffer DeflateBenchLump(const FString &text)
+{
+	FCompressedBuffer buff = { (unsigned)text.Len(), 0, METHOD_DEFLATE, 0, 0, nullptr };
+	buff.mCRC32 = crc32(0, (const Bytef*)text.GetChars(), buff.mSize);
+	buff.mBuffer = new char[compressBound(buff.mSize)];
+
+	z_stream stream = {};
+	stream.next_in = (Bytef *)text.GetChars();
+	stream.avail_in = buff.mSize;
+	stream.next_out = (Bytef *)buff.mBuffer;
+	stream.avail_out = (uInt)compressBound(buff.mSize);
+	deflateInit2(&stream, 6, Z_DEFLATED, -15, 9, Z_DEFAULT_STRATEGY);
+	deflate(&stream, Z_FINISH);
+	buff.mCompressedSize = stream.total_out;
+	deflateEnd(&stream);
+	return buff;
+}
+
+CCMD(zipbench)
+{
+	int numlumps = argv.argc() > 1 ? clamp(atoi(argv[1]), 1, 65535) : 50000;
+	FString path = M_GetCachePath(true);
+	CreatePath(path);
+	path << "/zipbench.pk3";
+
+	TArray<FString> names;
+	TArray<FCompressedBuffer> contents;
+	for (int i = 0; i < numlumps; i++)
+	{
+		FString text;
+		for (int j = 0; j < 64; j++) text.AppendFormat("Lump %d, line %d\n", i, j);
+		names.Push(FStringf("textures/bench%d/t%05d.txt", i % 64, i));
+		contents.Push(DeflateBenchLump(text));
+	}
+	bool written = WriteZip(path, names, contents);
+	for (auto &c : contents) c.Clean();
+	if (!written)
+	{
+		Printf("Unable to write %s\n", path.GetChars());
+		return;
+	}
+
+	cycle_t opentime, firstread, secondread;
+	opentime.Reset();
+	firstread.Reset();
+	secondread.Reset();
+
+	opentime.Clock();
+	FResourceFile *resfile = FResourceFile::OpenResourceFile(path, true);
+	opentime.Unclock();
+
+	if (resfile != nullptr)
+	{
+		unsigned hits = LumpCache.Hits;
+		cycle_t *timers[] = { &firstread, &secondread };
+		for (auto timer : timers)
+		{
+			timer->Clock();
+			for (uint32_t i = 0; i < resfile->LumpCount(); i++)
+			{
+				auto lump = resfile->GetLump(i);
+				lump->CacheLump();
+				lump->ReleaseCache();
+			}
+			timer->Unclock();
+		}
+		Printf("%u lumps: open %.2f ms, first read %.2f ms, second read %.2f ms, %u cache hits\n", resfile->LumpCount(),
+			opentime.TimeMS(), firstread.TimeMS(), secondread.TimeMS(), LumpCache.Hits - hits);
+		delete resfile;
+	}
+	remove(path);
+}
@@ -35,6 +35,7 @@
 */
 
 #include <zlib.h>
+#include <algorithm>
 #include "resourcefile.h"
 #include "cmdlib.h"
 #include "w_wad.h"
@@ -43,6 +44,12 @@
 #include "doomstat.h"
 #include "w_zip.h"
 #include "md5.h"
+#include "c_cvars.h"
+#include "c_dispatch.h"
+#include "stats.h"
+#include "c_console.h"
+#include "threadpool.h"
+#include "templates.h"
 
 
 //==========================================================================
@@ -70,6 +77,332 @@ public:
 };
 
 
+//==========================================================================
+//
+// Cache for the data of compressed lumps that are no longer in use.
+//
+// Decompressing a lump can be a lot more expensive than reading it, and
+// many lumps get read more than once, e.g. textures whose size is checked
+// long before their pixels are needed. So instead of deleting it, the
+// data of a compressed lump is kept until the cache exceeds its size
+// limit, at which point the least recently used lumps get discarded.
+// Cached lumps have a valid Cache pointer and a RefCount of 0.
+//
+//==========================================================================
+
+CUSTOM_CVAR(Int, lump_cachesize, 128, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)	// in MB
+{
+	if (self < 0) self = 0;
+	else LumpCache.Trim();
+}
+
+FLumpCache LumpCache;
+
+//==========================================================================
+//
+// Adds a lump that's no longer in use. Returns false if it was not
+// added, in which case the caller has to free the data.
+//
+//==========================================================================
+
+bool FLumpCache::Add(FResourceLump *lump)
+{
+	size_t limit = size_t(*lump_cachesize) << 20;
+	if ((size_t)lump->LumpSize > limit / 4)
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(Lock);
+	lump->CachePrev = NULL;
+	lump->CacheNext = Head;
+	if (Head != NULL) Head->CachePrev = lump;
+	else Tail = lump;
+	Head = lump;
+	Size += lump->LumpSize;
+	Count++;
+	Evict(limit);
+	return true;
+}
+
+//==========================================================================
+//
+// Takes a lump out of the cache because it's going to be used again.
+//
+//==========================================================================
+
+bool FLumpCache::Remove(FResourceLump *lump)
+{
+	std::lock_guard<std::mutex> lock(Lock);
+	if (lump->CachePrev == NULL && Head != lump)
+	{
+		return false;
+	}
+	Unlink(lump);
+	return true;
+}
+
+void FLumpCache::Unlink(FResourceLump *lump)
+{
+	if (lump->CachePrev != NULL) lump->CachePrev->CacheNext = lump->CacheNext;
+	else Head = lump->CacheNext;
+	if (lump->CacheNext != NULL) lump->CacheNext->CachePrev = lump->CachePrev;
+	else Tail = lump->CachePrev;
+	lump->CachePrev = lump->CacheNext = NULL;
+	Size -= lump->LumpSize;
+	Count--;
+}
+
+//==========================================================================
+//
+// Frees the least recently used lumps until the cache fits the limit.
+//
+//==========================================================================
+
+void FLumpCache::Evict(size_t limit)
+{
+	while (Size > limit && Tail != NULL)
+	{
+		FResourceLump *lump = Tail;
+		Unlink(lump);
+		delete[] lump->Cache;
+		lump->Cache = NULL;
+		Evictions++;
+	}
+}
+
+void FLumpCache::Trim()
+{
+	std::lock_guard<std::mutex> lock(Lock);
+	Evict(size_t(*lump_cachesize) << 20);
+}
+
+void FLumpCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(Lock);
+	Evict(0);
+}
+
+FString FLumpCache::GetStats()
+{
+	FString out;
+	out.Format("Lump cache: %u lumps, %.2f MB, %u hits, %u misses, %u evicted, %u prefetched", Count, Size / 1048576., Hits, Misses, Evictions, Prefetched);
+	return out;
+}
+
+ADD_STAT(lumpcache)
+{
+	return LumpCache.GetStats();
+}
+
+CCMD(flushlumpcache)
+{
+	LumpCache.Clear();
+}
+
+//==========================================================================
+//
+// Decompresses a list of lumps on all cores and puts them into the lump
+// cache so that the next CacheLump call can use them right away.
+//
+// The compressed data has to be read serially because all lumps of a file
+// share its reader. Decompression is done in batches so that not all of
+// the compressed data needs to be in memory at once.
+//
+//==========================================================================
+
+CVAR(Bool, lump_parallelprecache, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
+
+struct FDecompressJob
+{
+	FResourceLump *Lump;
+	FCompressedBuffer Raw;
+	char *Data;
+	bool Ok;
+	FString Output;
+};
+
+static void DecompressJob(FDecompressJob &job)
+{
+	job.Data = new char[job.Lump->LumpSize];
+	C_CaptureOutput(&job.Output);
+	try
+	{
+		job.Ok = job.Raw.Decompress(job.Data);
+	}
+	catch (...)
+	{
+		C_CaptureOutput(nullptr);
+		throw;
+	}
+	C_CaptureOutput(nullptr);
+}
+
+void DecompressLumps(const TArray<FResourceLump *> &lumps)
+{
+	if (!lump_parallelprecache) return;
+
+	// Lumps may be in the list more than once.
+	TArray<FResourceLump *> sorted = lumps;
+	std::sort(sorted.Data(), sorted.Data() + sorted.Size());
+	auto last = std::unique(sorted.Data(), sorted.Data() + sorted.Size());
+
+	// Only lumps the cache can keep are worth it and everything past its size would push out the first ones again.
+	size_t limit = size_t(*lump_cachesize) << 20;
+	size_t total = 0;
+	TArray<FResourceLump *> todo;
+	for (auto p = sorted.Data(); p < last; p++)
+	{
+		FResourceLump *lump = *p;
+		if (lump->Cache != NULL || lump->LumpSize <= 0 || !lump->HasCompressedRawData()) continue;
+		if ((size_t)lump->LumpSize > limit / 4 || total + lump->LumpSize > limit) continue;
+		total += lump->LumpSize;
+		todo.Push(lump);
+	}
+
+	const size_t BATCH_SIZE = 32 << 20;
+	TArray<FDecompressJob> jobs;
+	for (unsigned start = 0; start < todo.Size(); )
+	{
+		size_t batchsize = 0;
+		jobs.Clear();
+		while (start < todo.Size() && (jobs.Size() == 0 || batchsize + todo[start]->LumpSize <= BATCH_SIZE))
+		{
+			FResourceLump *lump = todo[start++];
+			auto &job = jobs[jobs.Reserve(1)];
+			job.Lump = lump;
+			job.Raw = lump->GetRawData();
+			job.Data = NULL;
+			job.Ok = false;
+			batchsize += lump->LumpSize;
+		}
+
+		try
+		{
+			FThreadPool::Get().ParallelFor(jobs.Size(), [&](int i) { DecompressJob(jobs[i]); });
+		}
+		catch (...)
+		{
+			for (auto &job : jobs)
+			{
+				job.Raw.Clean();
+				delete[] job.Data;
+			}
+			throw;
+		}
+
+		for (auto &job : jobs)
+		{
+			job.Raw.Clean();
+			if (job.Output.IsNotEmpty()) PrintString(PRINT_HIGH, job.Output);
+			if (job.Ok && job.Lump->Cache == NULL)
+			{
+				job.Lump->Cache = job.Data;
+				job.Lump->RefCount = 0;
+				if (LumpCache.Add(job.Lump))
+				{
+					LumpCache.Prefetched++;
+					continue;
+				}
+				job.Lump->Cache = NULL;
+			}
+			delete[] job.Data;
+		}
+	}
+}
+
+//==========================================================================
+//
+// CCMD decompressbench
+//
+// Decompresses the compressed lumps of all loaded files, up to the given
+// number of MB per compression method, and prints the throughput of the
+// stream decompressors, of decompressing in one go and of DecompressLumps'
+// parallel decompression.
+//
+//==========================================================================
+
+CCMD(decompressbench)
+{
+	static const struct { int Method; const char *Name; } methods[] =
+	{
+		{ METHOD_DEFLATE, "Deflate" }, { METHOD_BZIP2, "BZip2" }, { METHOD_LZMA, "LZMA" },
+		{ METHOD_IMPLODE, "Implode" }, { METHOD_SHRINK, "Shrink" },
+	};
+	size_t maxsize = size_t(argv.argc() > 1 ? MAX(1, atoi(argv[1])) : 64) << 20;
+	int numlumps = Wads.GetNumLumps();
+
+	for (auto &method : methods)
+	{
+		TArray<FDecompressJob> jobs;
+		size_t size = 0, compressedsize = 0, maxlumpsize = 0;
+		for (int i = 0; i < numlumps; i++)
+		{
+			FResourceLump *lump = Wads.GetLumpRecord(i);
+			if (lump == nullptr || lump->LumpSize <= 0 || !lump->HasCompressedRawData()) continue;
+			if (size + lump->LumpSize > maxsize) continue;
+			FCompressedBuffer raw = lump->GetRawData();
+			if (raw.mMethod != method.Method)
+			{
+				raw.Clean();
+				continue;
+			}
+			auto &job = jobs[jobs.Reserve(1)];
+			job.Lump = lump;
+			job.Raw = raw;
+			job.Data = NULL;
+			size += raw.mSize;
+			compressedsize += raw.mCompressedSize;
+			maxlumpsize = MAX<size_t>(maxlumpsize, raw.mSize);
+		}
+		if (jobs.Size() == 0) continue;
+
+		TArray<char> buffer(maxlumpsize, true);
+		cycle_t streamtime, oneshottime, paralleltime;
+		streamtime.Reset();
+		oneshottime.Reset();
+		paralleltime.Reset();
+
+		bool hasstream = method.Method == METHOD_DEFLATE || method.Method == METHOD_BZIP2 || method.Method == METHOD_LZMA;
+		if (hasstream)
+		{
+			streamtime.Clock();
+			for (auto &job : jobs)
+			{
+				FileReader mr, frz;
+				mr.OpenMemory(job.Raw.mBuffer, job.Raw.mCompressedSize);
+				if (frz.OpenDecompressor(mr, job.Raw.mSize, job.Raw.mMethod, false))
+				{
+					frz.Read(buffer.Data(), job.Raw.mSize);
+				}
+			}
+			streamtime.Unclock();
+		}
+
+		oneshottime.Clock();
+		for (auto &job : jobs)
+		{
+			job.Raw.Decompress(buffer.Data());
+		}
+		oneshottime.Unclock();
+
+		paralleltime.Clock();
+		FThreadPool::Get().ParallelFor(jobs.Size(), [&](int i) { DecompressJob(jobs[i]); });
+		paralleltime.Unclock();
+
+		for (auto &job : jobs)
+		{
+			job.Raw.Clean();
+			delete[] job.Data;
+		}
+
+		auto mbps = [=](cycle_t &timer) { return size / 1048576. / MAX(timer.TimeMS() / 1000., 1e-6); };
+		FString stream = hasstream ? FStringf("%.1f MB/s", mbps(streamtime)) : FString("n/a");
+		Printf("%s: %u lumps, %.2f MB -> %.2f MB, stream %s, one go %.1f MB/s, parallel %.1f MB/s (%d threads)\n",
+			method.Name, jobs.Size(), compressedsize / 1048576., size / 1048576., stream.GetChars(), mbps(oneshottime), mbps(paralleltime), FThreadPool::Get().NumThreads());
+	}
+}
+
 //==========================================================================
 //
 // Base class for resource lumps
@@ -80,6 +413,7 @@ FResourceLump::~FResourceLump()
 {
 	if (Cache != NULL && RefCount >= 0)
 	{
+		if (RefCount == 0) LumpCache.Remove(this);
 		delete [] Cache;
 		Cache = NULL;
 	}
@@ -245,9 +579,15 @@ void *FResourceLump::CacheLump()
 	if (Cache != NULL)
 	{
 		if (RefCount > 0) RefCount++;
+		else if (RefCount == 0 && LumpCache.Remove(this))
+		{
+			LumpCache.Hits++;
+			RefCount = 1;
+		}
 	}
 	else if (LumpSize > 0)
 	{
+		if (Flags & (LUMPF_COMPRESSED | LUMPF_BLOODCRYPT)) LumpCache.Misses++;
 		FillCache();
 	}
 	return Cache;
@@ -265,8 +605,12 @@ int FResourceLump::ReleaseCache()
 	{
 		if (--RefCount == 0)
 		{
-			delete [] Cache;
-			Cache = NULL;
+			// Keep the data of lumps that are expensive to load in case they are needed again.
+			if (!(Flags & (LUMPF_COMPRESSED | LUMPF_BLOODCRYPT)) || !LumpCache.Add(this))
+			{
+				delete [] Cache;
+				Cache = NULL;
+			}
 		}
 	}
 	return RefCount;
@@ -340,12 +684,33 @@ FResourceFile::~FResourceFile()
 {
 }
 
-int lumpcmp(const void * a, const void * b)
+//==========================================================================
+//
+// Sorts the lumps by name. Lumps are too large to be swapped around
+// efficiently, so this sorts their indices and moves each lump only once.
+// Like the qsort this replaces, the lumps are moved as raw memory.
+//
+//==========================================================================
+
+static void SortLumps(void *lumps, uint32_t numlumps, size_t lumpsize)
 {
-	FResourceLump * rec1 = (FResourceLump *)a;
-	FResourceLump * rec2 = (FResourceLump *)b;
+	if (numlumps < 2) return;
+	auto lump = [=](uint32_t i) { return (FResourceLump *)((char *)lumps + i * lumpsize); };
 
-	return rec1->FullName.CompareNoCase(rec2->FullName);
+	TArray<uint32_t> order(numlumps, true);
+	for (uint32_t i = 0; i < numlumps; i++) order[i] = i;
+	std::stable_sort(order.Data(), order.Data() + numlumps, [=](uint32_t a, uint32_t b)
+	{
+		return stricmp(lump(a)->FullName, lump(b)->FullName) < 0;
+	});
+
+	char *sorted = new char[numlumps * lumpsize];
+	for (uint32_t i = 0; i < numlumps; i++)
+	{
+		memcpy(sorted + i * lumpsize, lump(order[i]), lumpsize);
+	}
+	memcpy(lumps, sorted, numlumps * lumpsize);
+	delete[] sorted;
 }
 
 //==========================================================================
@@ -395,7 +760,7 @@ void FResourceFile::GenerateHash()
 void FResourceFile::PostProcessArchive(void *lumps, size_t lumpsize)
 {
 	// Entries in archives are sorted alphabetically
-	qsort(lumps, NumLumps, lumpsize, lumpcmp);
+	SortLumps(lumps, NumLumps, lumpsize);
 	
 
 	// Filter out lumps using the same names as the Autoload.* sections
@@ -3,6 +3,7 @@
 #ifndef __RESFILE_H
 #define __RESFILE_H
 
+#include <mutex>
 #include "files.h"
 
 class FResourceFile;
@@ -50,6 +51,10 @@ struct FResourceLump
 	FTexture *		LinkedTexture;
 	int				Namespace;
 
+	// Links for the cache of unused decompressed lumps.
+	FResourceLump *	CachePrev;
+	FResourceLump *	CacheNext;
+
 	FResourceLump()
 	{
 		Cache = NULL;
@@ -59,6 +64,7 @@ struct FResourceLump
 		Namespace = 0;	// ns_global
 		*Name = 0;
 		LinkedTexture = NULL;
+		CachePrev = CacheNext = NULL;
 	}
 
 	virtual ~FResourceLump();
@@ -69,6 +75,7 @@ struct FResourceLump
 	void LumpNameSetup(FString iname);
 	void CheckEmbedded();
 	virtual FCompressedBuffer GetRawData();
+	virtual bool HasCompressedRawData() { return false; }	// GetRawData returns data that can be decompressed without the owner.
 
 	void *CacheLump();
 	int ReleaseCache();
@@ -122,6 +129,38 @@ public:
 	FResourceLump *FindLump(const char *name);
 };
 
+//==========================================================================
+//
+// Keeps the data of compressed lumps after their last user released them,
+// up to the size set by lump_cachesize.
+//
+//==========================================================================
+
+class FLumpCache
+{
+	std::mutex Lock;
+	FResourceLump *Head = nullptr;	// most recently used.
+	FResourceLump *Tail = nullptr;
+	size_t Size = 0;
+	unsigned Count = 0;
+
+	void Unlink(FResourceLump *lump);
+	void Evict(size_t limit);
+
+public:
+	unsigned Hits = 0, Misses = 0, Evictions = 0, Prefetched = 0;
+
+	bool Add(FResourceLump *lump);
+	bool Remove(FResourceLump *lump);
+	void Trim();
+	void Clear();
+	FString GetStats();
+};
+
+extern FLumpCache LumpCache;
+
+void DecompressLumps(const TArray<FResourceLump *> &lumps);
+
 struct FUncompressedLump : public FResourceLump
 {
 	int				Position;
@@ -37,6 +37,7 @@
 
 #include <string.h>
 #include <stdlib.h>
+#include <mutex>
 #include "doomtype.h"
 #include "i_system.h"
 #include "sc_man.h"
@@ -46,6 +47,11 @@
 #include "templates.h"
 #include "doomstat.h"
 #include "v_text.h"
+#include "c_cvars.h"
+#include "c_dispatch.h"
+#include "doomerrors.h"
+#include "superfasthash.h"
+#include "stats.h"
 
 // MACROS ------------------------------------------------------------------
 
@@ -476,6 +482,219 @@ void FScanner::SetStateMode(bool stately)
 	StateOptions = stately;
 }
 
+//==========================================================================
+//
+// Vectorized helpers for skipping the parts of a script that the
+// generated scanner would otherwise have to walk through one character
+// at a time: whitespace, line breaks and comments.
+//
+// All of them look at 16 characters at a time with SSE2 or NEON and
+// count the line breaks they pass over.
+//
+//==========================================================================
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SC_SSE2
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define SC_NEON
+#endif
+
+CVAR(Bool, sc_simdscan, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
+
+static inline bool IsBlank(char c)
+{
+	return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+#ifdef SC_SSE2
+static inline int CountBits(unsigned v)
+{
+	v = v - ((v >> 1) & 0x55555555);
+	v = (v & 0x33333333) + ((v >> 2) & 0x33333333);
+	return (((v + (v >> 4)) & 0x0f0f0f0f) * 0x01010101) >> 24;
+}
+
+static inline int FirstBit(unsigned v)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, v);
+	return (int)index;
+#else
+	return __builtin_ctz(v);
+#endif
+}
+#endif
+
+#ifdef SC_NEON
+// Number of set bytes in a comparison result.
+static inline int CountMatches(uint8x16_t cmp)
+{
+	return vaddvq_u8(vshrq_n_u8(cmp, 7));
+}
+
+// Index of the first set byte in a comparison result, 16 if there is none.
+static inline int FirstMatch(uint8x16_t cmp)
+{
+	uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(cmp), 4)), 0);
+	return mask == 0 ? 16 : __builtin_ctzll(mask) >> 2;
+}
+#endif
+
+//==========================================================================
+//
+// Returns the first character in [p, end) that is not a blank.
+//
+//==========================================================================
+
+static const char *SkipBlanks(const char *p, const char *end, int &lines)
+{
+#if defined(SC_SSE2)
+	const __m128i nine = _mm_set1_epi8(9), four = _mm_set1_epi8(4), space = _mm_set1_epi8(' '), newline = _mm_set1_epi8('\n');
+	while (end - p >= 16)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i *)p);
+		__m128i blank = _mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(_mm_subs_epu8(_mm_sub_epi8(v, nine), four), _mm_setzero_si128()));
+		unsigned nonblank = ~_mm_movemask_epi8(blank) & 0xffff;
+		unsigned newlines = _mm_movemask_epi8(_mm_cmpeq_epi8(v, newline));
+		if (nonblank != 0)
+		{
+			int index = FirstBit(nonblank);
+			lines += CountBits(newlines & ((1u << index) - 1));
+			return p + index;
+		}
+		lines += CountBits(newlines);
+		p += 16;
+	}
+#elif defined(SC_NEON)
+	const uint8x16_t nine = vdupq_n_u8(9), four = vdupq_n_u8(4), space = vdupq_n_u8(' '), newline = vdupq_n_u8('\n');
+	while (end - p >= 16)
+	{
+		uint8x16_t v = vld1q_u8((const uint8_t *)p);
+		uint8x16_t blank = vorrq_u8(vceqq_u8(v, space), vcleq_u8(vsubq_u8(v, nine), four));
+		int index = FirstMatch(vmvnq_u8(blank));
+		if (index < 16)
+		{
+			for (int i = 0; i < index; i++) lines += p[i] == '\n';
+			return p + index;
+		}
+		lines += CountMatches(vceqq_u8(v, newline));
+		p += 16;
+	}
+#endif
+	for (; p < end && IsBlank(*p); p++)
+	{
+		lines += *p == '\n';
+	}
+	return p;
+}
+
+//==========================================================================
+//
+// Returns the first occurence of c in [p, end), or end if there is none.
+//
+//==========================================================================
+
+static const char *FindChar(const char *p, const char *end, char c, int &lines)
+{
+#if defined(SC_SSE2)
+	const __m128i match = _mm_set1_epi8(c), newline = _mm_set1_epi8('\n');
+	while (end - p >= 16)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i *)p);
+		unsigned found = _mm_movemask_epi8(_mm_cmpeq_epi8(v, match));
+		unsigned newlines = _mm_movemask_epi8(_mm_cmpeq_epi8(v, newline));
+		if (found != 0)
+		{
+			int index = FirstBit(found);
+			lines += CountBits(newlines & ((1u << index) - 1));
+			return p + index;
+		}
+		lines += CountBits(newlines);
+		p += 16;
+	}
+#elif defined(SC_NEON)
+	const uint8x16_t match = vdupq_n_u8((uint8_t)c), newline = vdupq_n_u8('\n');
+	while (end - p >= 16)
+	{
+		uint8x16_t v = vld1q_u8((const uint8_t *)p);
+		int index = FirstMatch(vceqq_u8(v, match));
+		if (index < 16)
+		{
+			for (int i = 0; i < index; i++) lines += p[i] == '\n';
+			return p + index;
+		}
+		lines += CountMatches(vceqq_u8(v, newline));
+		p += 16;
+	}
+#endif
+	for (; p < end && *p != c; p++)
+	{
+		lines += *p == '\n';
+	}
+	return p;
+}
+
+//==========================================================================
+//
+// FScanner :: SkipBlanksAndComments
+//
+// Moves ScriptPtr past any whitespace and comments in front of the next
+// token. This is purely an optimization, whatever is left over is handled
+// by the generated scanner, which knows the same rules. To keep the end of
+// script handling in one place, the last character is never consumed here.
+//
+//==========================================================================
+
+void FScanner::SkipBlanksAndComments()
+{
+	const char *p = ScriptPtr;
+	const char *end = ScriptEndPtr - 1;
+	int lines = 0;
+
+	while (p < end)
+	{
+		p = SkipBlanks(p, end, lines);
+		if (p + 1 >= end || p[0] != '/')
+		{
+			break;
+		}
+		int commentlines = 0;
+		if (p[1] == '/')
+		{
+			const char *q = FindChar(p + 2, end, '\n', commentlines);
+			if (q >= end) break;
+			p = q + 1;
+			lines += commentlines + 1;
+		}
+		else if (p[1] == '*')
+		{
+			const char *q = p + 2;
+			for (;;)
+			{
+				q = FindChar(q, end, '*', commentlines);
+				if (q + 1 >= end || q[1] == '/') break;
+				q++;
+			}
+			if (q + 2 > end) break;
+			p = q + 2;
+			lines += commentlines;
+		}
+		else
+		{
+			break;
+		}
+	}
+	if (lines > 0)
+	{
+		Line += lines;
+		Crossed = true;
+	}
+	ScriptPtr = p;
+}
+
 //==========================================================================
 //
 // FScanner::ScanString
@@ -511,6 +730,11 @@ bool FScanner::ScanString (bool tokens)
 	LastGotPtr = ScriptPtr;
 	LastGotLine = Line;
 
+	if (sc_simdscan)
+	{
+		SkipBlanksAndComments();
+	}
+
 	// In case the generated scanner does not use marker, avoid compiler warnings.
 	marker;
 #include "sc_man_scanner.h"
@@ -1133,7 +1357,8 @@ void FScanner::CheckOpen()
 //==========================================================================
 int FScriptPosition::ErrorCounter;
 int FScriptPosition::WarnCounter;
-bool FScriptPosition::StrictErrors;	// makes all OPTERROR messages real errors.
+static std::mutex CounterLock;	// messages may come from the code generator's worker threads.
+thread_local bool FScriptPosition::StrictErrors;	// makes all OPTERROR messages real errors.
 bool FScriptPosition::errorout;		// call I_Error instead of printing the error itself.
 
 
@@ -1202,13 +1427,19 @@ void FScriptPosition::Message (int severity, const char *message, ...) const
 	case MSG_WARNING:
 	case MSG_DEBUGWARN:
 	case MSG_DEBUGERROR:	// This is intentionally not being printed as an 'error', the difference to MSG_DEBUGWARN is only the severity level at which it gets triggered.
-		WarnCounter++;
+		{
+			std::lock_guard<std::mutex> lock(CounterLock);
+			WarnCounter++;
+		}
 		type = "warning";
 		color = TEXTCOLOR_ORANGE;
 		break;
 
 	case MSG_ERROR:
-		ErrorCounter++;
+		{
+			std::lock_guard<std::mutex> lock(CounterLock);
+			ErrorCounter++;
+		}
 		type = "error";
 		color = TEXTCOLOR_RED;
 		break;
@@ -1236,3 +1467,111 @@ void FScriptPosition::Message (int severity, const char *message, ...) const
 }
 
 
+
+//==========================================================================
+//
+// CCMD scanbench
+//
+// Tokenizes all loaded text lumps in both scanner modes, once with and
+// once without the vectorized whitespace and comment skipping, and checks
+// that both produce the same tokens.
+//
+//==========================================================================
+
+static const char *const BenchLumps[] =
+{
+	"DECORATE", "ZSCRIPT", "MAPINFO", "ZMAPINFO", "GLDEFS", "TEXTURES", "SNDINFO", "LANGUAGE", "ANIMDEFS",
+	"MENUDEF", "SBARINFO", "KEYCONF", "TERRAIN", "LOCKDEFS", "DECALDEF", "FONTDEFS", "MODELDEF", "GAMEINFO", nullptr
+};
+
+static uint32_t ScanLump(const char *name, const FString &text, bool tokens, int &count)
+{
+	FScanner sc;
+	uint32_t hash = 0;
+	sc.OpenMem(name, text.GetChars(), (int)text.Len());
+	sc.SetCMode(tokens);
+	try
+	{
+		while (tokens ? sc.GetToken() : sc.GetString())
+		{
+			hash = hash * 31 + sc.TokenType * 17 + sc.Line + MakeKey(sc.String, sc.StringLen);
+			count++;
+		}
+	}
+	catch (CRecoverableError &)
+	{
+		// Not every text lump follows the rules of the token based scanner.
+		hash = hash * 31 + sc.Line;
+	}
+	return hash;
+}
+
+CCMD(scanbench)
+{
+	int passes = argv.argc() > 1 ? MAX(1, atoi(argv[1])) : 3;
+	TArray<FString> texts, names;
+	size_t bytes = 0;
+
+	for (int i = 0; i < Wads.GetNumLumps(); i++)
+	{
+		FString name;
+		Wads.GetLumpName(name, i);
+		const char *fullname = Wads.GetLumpFullName(i);
+		const char *ext = strrchr(fullname, '.');
+		bool match = ext != nullptr && (!stricmp(ext, ".zs") || !stricmp(ext, ".txt"));
+		for (int j = 0; !match && BenchLumps[j] != nullptr; j++)
+		{
+			match = !name.CompareNoCase(BenchLumps[j]);
+		}
+		if (match && Wads.LumpLength(i) > 0)
+		{
+			texts.Push(Wads.ReadLump(i).GetString());
+			names.Push(fullname);
+			bytes += texts.Last().Len();
+		}
+	}
+
+	bool simd = sc_simdscan;
+	cycle_t times[2][2];
+	int counts[2][2] = {};
+	int mismatches = 0;
+	for (int mode = 0; mode < 2; mode++)
+	{
+		for (int fast = 0; fast < 2; fast++)
+		{
+			times[mode][fast].Reset();
+		}
+	}
+
+	for (int pass = 0; pass < passes; pass++)
+	{
+		for (int mode = 0; mode < 2; mode++)
+		{
+			TArray<uint32_t> hashes;
+			for (int fast = 0; fast < 2; fast++)
+			{
+				sc_simdscan = !!fast;
+				int count = 0;
+				times[mode][fast].Clock();
+				for (unsigned i = 0; i < texts.Size(); i++)
+				{
+					uint32_t hash = ScanLump(names[i], texts[i], !!mode, count);
+					if (fast == 0) hashes.Push(hash);
+					else mismatches += hash != hashes[i];
+				}
+				times[mode][fast].Unclock();
+				counts[mode][fast] = count;
+			}
+		}
+	}
+	sc_simdscan = simd;
+
+	auto mbps = [=](cycle_t &timer) { return timer.TimeMS() == 0 ? 0. : bytes * passes / (timer.TimeMS() * 1000.); };
+	Printf("%u text lumps, %.2f MB, %d passes\n", texts.Size(), bytes / 1048576., passes);
+	Printf("Strings: %d, %.1f MB/s scalar, %.1f MB/s vectorized\n", counts[0][1], mbps(times[0][0]), mbps(times[0][1]));
+	Printf("Tokens: %d, %.1f MB/s scalar, %.1f MB/s vectorized\n", counts[1][1], mbps(times[1][0]), mbps(times[1][1]));
+	if (mismatches > 0 || counts[0][0] != counts[0][1] || counts[1][0] != counts[1][1])
+	{
+		Printf(TEXTCOLOR_RED "%d lumps scanned differently\n", mismatches);
+	}
+}
@@ -97,6 +97,7 @@ protected:
 	void PrepareScript();
 	void CheckOpen();
 	bool ScanString(bool tokens);
+	void SkipBlanksAndComments();
 
 	// Strings longer than this minus one will be dynamically allocated.
 	static const int MAX_STRING_SIZE = 128;
@@ -161,7 +162,7 @@ struct FScriptPosition
 {
 	static int WarnCounter;
 	static int ErrorCounter;
-	static bool StrictErrors;
+	static thread_local bool StrictErrors;
 	static bool errorout;
 	FName FileName;
 	int ScriptLine;
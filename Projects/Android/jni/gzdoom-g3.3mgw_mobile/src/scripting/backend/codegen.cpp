@@ -7270,6 +7270,7 @@ FxArrayElement::FxArrayElement(FxExpression *base, FxExpression *_index)
 	AddressRequested = false;
 	AddressWritable = false;
 	SizeAddr = ~0u;
+	SizeField = nullptr;
 }
 
 //==========================================================================
@@ -7375,6 +7376,9 @@ FxExpression *FxArrayElement::Resolve(FCompileContext &ctx)
 		{
 			auto parentfield = static_cast<FxMemberBase *>(Array)->membervar;
 			SizeAddr = parentfield->Offset + sizeof(void*);
+			// The field for reading the size must be created here because Emit may run on a worker thread.
+			bool ismeta = Array->ExprType == EFX_ClassMember && (parentfield->Flags & VARF_Meta);
+			SizeField = Create<PField>(NAME_None, TypeUInt32, ismeta? VARF_Meta : 0, SizeAddr);
 		}
 		else if (Array->ExprType == EFX_ArrayElement || Array->ExprType == EFX_OutVarDereference)
 		{
@@ -7456,12 +7460,10 @@ ExpEmit FxArrayElement::Emit(VMFunctionBuilder *build)
 	
 	if (SizeAddr != ~0u)
 	{
-		bool ismeta = Array->ExprType == EFX_ClassMember && static_cast<FxClassMember*>(Array)->membervar->Flags & VARF_Meta;
-
 		start = ExpEmit(build, REGT_POINTER);
 		build->Emit(OP_LP, start.RegNum, arrayvar.RegNum, build->GetConstantInt(0));
 
-		auto f = Create<PField>(NAME_None, TypeUInt32, ismeta? VARF_Meta : 0, SizeAddr);
+		auto f = SizeField;
 		auto arraymemberbase = static_cast<FxMemberBase *>(Array);
 
 		auto origmembervar = arraymemberbase->membervar;
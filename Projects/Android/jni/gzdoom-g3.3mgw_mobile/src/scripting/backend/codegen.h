@@ -1518,6 +1518,7 @@ public:
 	FxExpression *Array;
 	FxExpression *index;
 	size_t SizeAddr;
+	PField *SizeField;
 	bool AddressRequested;
 	bool AddressWritable;
 	bool arrayispointer = false;
@@ -37,6 +37,9 @@
 #include "info.h"
 #include "m_argv.h"
 #include "c_cvars.h"
+#include "c_console.h"
+#include "threadpool.h"
+#include "templates.h"
 #include "scripting/vm/jit.h"
 #include "doomerrors.h"
 #include "vmintern.h"
@@ -810,107 +813,213 @@ VMFunction *FFunctionBuildList::AddFunction(PNamespace *gnspc, const VersionInfo
 }
 
 
-void FFunctionBuildList::Build()
+//==========================================================================
+//
+// Resolving needs the type and symbol tables, which may get extended
+// along the way, so this is always done on the main thread.
+//
+//==========================================================================
+
+void FFunctionBuildList::ResolveItem(Item &item)
 {
-	VMDisassemblyDumper disasmdump(VMDisassemblyDumper::Overwrite);
+	assert(item.Code != NULL);
 
-	for (auto &item : mItems)
+	// We don't know the return type in advance for anonymous functions.
+	auto ctx = new FCompileContext(item.CurGlobals, item.Func, item.Func->SymbolName == NAME_None ? nullptr : item.Func->Variants[0].Proto, item.FromDecorate, item.StateIndex, item.StateCount, item.Lump, item.Version);
+	item.Context = ctx;
+
+	// Allocate registers for the function's arguments and create local variable nodes before starting to resolve it.
+	auto buildit = new VMFunctionBuilder(item.Func->GetImplicitArgs());
+	item.Builder = buildit;
+	for (unsigned i = 0; i < item.Func->Variants[0].Proto->ArgumentTypes.Size(); i++)
 	{
-		assert(item.Code != NULL);
+		auto type = item.Func->Variants[0].Proto->ArgumentTypes[i];
+		auto name = item.Func->Variants[0].ArgNames[i];
+		auto flags = item.Func->Variants[0].ArgFlags[i];
+		// this won't get resolved and won't get emitted. It is only needed so that the code generator can retrieve the necessary info about this argument to do its work.
+		auto local = new FxLocalVariableDeclaration(type, name, nullptr, flags, FScriptPosition());
+		if (!(flags & VARF_Out)) local->RegNum = buildit->Registers[type->GetRegType()].Get(type->GetRegCount());
+		else local->RegNum = buildit->Registers[REGT_POINTER].Get(1);
+		ctx->FunctionArgs.Push(local);
+	}
 
-		// We don't know the return type in advance for anonymous functions.
-		FCompileContext ctx(item.CurGlobals, item.Func, item.Func->SymbolName == NAME_None ? nullptr : item.Func->Variants[0].Proto, item.FromDecorate, item.StateIndex, item.StateCount, item.Lump, item.Version);
+	FScriptPosition::StrictErrors = !item.FromDecorate;
+	item.Code = item.Code->Resolve(*ctx);
 
-		// Allocate registers for the function's arguments and create local variable nodes before starting to resolve it.
-		VMFunctionBuilder buildit(item.Func->GetImplicitArgs());
-		for (unsigned i = 0; i < item.Func->Variants[0].Proto->ArgumentTypes.Size(); i++)
+	// Make sure resolving it didn't obliterate it.
+	if (item.Code != nullptr)
+	{
+		if (!item.Code->CheckReturn())
 		{
-			auto type = item.Func->Variants[0].Proto->ArgumentTypes[i];
-			auto name = item.Func->Variants[0].ArgNames[i];
-			auto flags = item.Func->Variants[0].ArgFlags[i];
-			// this won't get resolved and won't get emitted. It is only needed so that the code generator can retrieve the necessary info about this argument to do its work.
-			auto local = new FxLocalVariableDeclaration(type, name, nullptr, flags, FScriptPosition());
-			if (!(flags & VARF_Out)) local->RegNum = buildit.Registers[type->GetRegType()].Get(type->GetRegCount());
-			else local->RegNum = buildit.Registers[REGT_POINTER].Get(1);
-			ctx.FunctionArgs.Push(local);
+			auto newcmpd = new FxCompoundStatement(item.Code->ScriptPosition);
+			newcmpd->Add(item.Code);
+			newcmpd->Add(new FxReturnStatement(nullptr, item.Code->ScriptPosition));
+			item.Code = newcmpd->Resolve(*ctx);
+		}
+	}
+	if (item.Code != nullptr)
+	{
+		item.Proto = ctx->ReturnProto;
+		if (item.Proto == nullptr)
+		{
+			item.Code->ScriptPosition.Message(MSG_ERROR, "Function %s without prototype", item.PrintableName.GetChars());
+			return;
 		}
 
-		FScriptPosition::StrictErrors = !item.FromDecorate;
-		item.Code = item.Code->Resolve(ctx);
-		// If we need extra space, load the frame pointer into a register so that we do not have to call the wasteful LFP instruction more than once.
-		if (item.Function->ExtraSpace > 0)
+		// Generate prototype for anonymous functions.
+		VMScriptFunction *sfunc = item.Function;
+		// create a new prototype from the now known return type and the argument list of the function's template prototype.
+		if (sfunc->Proto == nullptr)
 		{
-			buildit.FramePointer = ExpEmit(&buildit, REGT_POINTER);
-			buildit.FramePointer.Fixed = true;
-			buildit.Emit(OP_LFP, buildit.FramePointer.RegNum);
+			sfunc->Proto = NewPrototype(item.Proto->ReturnTypes, item.Func->Variants[0].Proto->ArgumentTypes);
+			sfunc->ArgFlags = item.Func->Variants[0].ArgFlags;
 		}
+		item.Resolved = true;
+	}
+}
+
+//==========================================================================
+//
+// Emitting only works on the function's own builder and expression
+// tree, so this may run on a worker thread. Messages are collected
+// and printed by FinishItem.
+//
+//==========================================================================
+
+void FFunctionBuildList::EmitItem(Item &item)
+{
+	if (!item.Resolved) return;
+
+	auto buildit = item.Builder;
+	C_CaptureOutput(&item.Output);
+	FScriptPosition::StrictErrors = !item.FromDecorate;
+
+	// If we need extra space, load the frame pointer into a register so that we do not have to call the wasteful LFP instruction more than once.
+	if (item.Function->ExtraSpace > 0)
+	{
+		buildit->FramePointer = ExpEmit(buildit, REGT_POINTER);
+		buildit->FramePointer.Fixed = true;
+		buildit->Emit(OP_LFP, buildit->FramePointer.RegNum);
+	}
+
+	// Emit code
+	try
+	{
+		buildit->BeginStatement(item.Code);
+		item.Code->Emit(buildit);
+		buildit->EndStatement();
+	}
+	catch (CRecoverableError &err)
+	{
+		// catch errors from the code generator and pring something meaningful.
+		item.Code->ScriptPosition.Message(MSG_ERROR, "%s in %s", err.GetMessage(), item.PrintableName.GetChars());
+		item.Resolved = false;
+	}
+	catch (...)
+	{
+		C_CaptureOutput(nullptr);
+		throw;
+	}
+	FScriptPosition::StrictErrors = false;
+	C_CaptureOutput(nullptr);
+}
+
+//==========================================================================
+//
+// Creates the VM function. This is done in the order the functions
+// were added so that the output is the same as for a serial build.
+//
+//==========================================================================
+
+void FFunctionBuildList::FinishItem(Item &item, VMDisassemblyDumper &disasmdump)
+{
+	if (item.Output.IsNotEmpty())
+	{
+		PrintString(PRINT_HIGH, item.Output);
+	}
 
-		// Make sure resolving it didn't obliterate it.
-		if (item.Code != nullptr)
+	if (item.Resolved)
+	{
+		VMScriptFunction *sfunc = item.Function;
+		sfunc->SourceFileName = item.Code->ScriptPosition.FileName;	// remember the file name for printing error messages if something goes wrong in the VM.
+		item.Builder->MakeFunction(sfunc);
+		sfunc->NumArgs = 0;
+		// NumArgs for the VMFunction must be the amount of stack elements, which can differ from the amount of logical function arguments if vectors are in the list.
+		// For the VM a vector is 2 or 3 args, depending on size.
+		auto funcVariant = item.Func->Variants[0];
+		for (unsigned int i = 0; i < funcVariant.Proto->ArgumentTypes.Size(); i++)
 		{
-			if (!item.Code->CheckReturn())
+			auto argType = funcVariant.Proto->ArgumentTypes[i];
+			auto argFlags = funcVariant.ArgFlags[i];
+			if (argFlags & VARF_Out)
 			{
-				auto newcmpd = new FxCompoundStatement(item.Code->ScriptPosition);
-				newcmpd->Add(item.Code);
-				newcmpd->Add(new FxReturnStatement(nullptr, item.Code->ScriptPosition));
-				item.Code = newcmpd->Resolve(ctx);
+				auto argPointer = NewPointer(argType);
+				sfunc->NumArgs += argPointer->GetRegCount();
 			}
-
-			item.Proto = ctx.ReturnProto;
-			if (item.Proto == nullptr)
+			else
 			{
-				item.Code->ScriptPosition.Message(MSG_ERROR, "Function %s without prototype", item.PrintableName.GetChars());
-				continue;
+				sfunc->NumArgs += argType->GetRegCount();
 			}
+		}
 
-			// Generate prototype for anonymous functions.
-			VMScriptFunction *sfunc = item.Function;
-			// create a new prototype from the now known return type and the argument list of the function's template prototype.
-			if (sfunc->Proto == nullptr)
-			{
-				sfunc->Proto = NewPrototype(item.Proto->ReturnTypes, item.Func->Variants[0].Proto->ArgumentTypes);
-				sfunc->ArgFlags = item.Func->Variants[0].ArgFlags;
-			}
+		disasmdump.Write(sfunc, item.PrintableName);
 
-			// Emit code
-			try
-			{
-				sfunc->SourceFileName = item.Code->ScriptPosition.FileName;	// remember the file name for printing error messages if something goes wrong in the VM.
-				buildit.BeginStatement(item.Code);
-				item.Code->Emit(&buildit);
-				buildit.EndStatement();
-				buildit.MakeFunction(sfunc);
-				sfunc->NumArgs = 0;
-				// NumArgs for the VMFunction must be the amount of stack elements, which can differ from the amount of logical function arguments if vectors are in the list.
-				// For the VM a vector is 2 or 3 args, depending on size.
-				auto funcVariant = item.Func->Variants[0];
-				for (unsigned int i = 0; i < funcVariant.Proto->ArgumentTypes.Size(); i++)
-				{
-					auto argType = funcVariant.Proto->ArgumentTypes[i];
-					auto argFlags = funcVariant.ArgFlags[i];
-					if (argFlags & VARF_Out)
-					{
-						auto argPointer = NewPointer(argType);
-						sfunc->NumArgs += argPointer->GetRegCount();
-					}
-					else
-					{
-						sfunc->NumArgs += argType->GetRegCount();
-					}
-				}
+		sfunc->Unsafe = item.Context->Unsafe;
+	}
+	delete item.Code;
+	delete item.Builder;
+	delete item.Context;
+	item.Code = nullptr;
+	item.Builder = nullptr;
+	item.Context = nullptr;
+	item.Output = "";
+	disasmdump.Flush();
+}
 
-				disasmdump.Write(sfunc, item.PrintableName);
+//==========================================================================
+//
+// The functions are processed in batches: all functions of a batch
+// are resolved first, then their code gets emitted in parallel.
+// Batches keep the memory for the expression trees and builders that
+// are alive at the same time within reasonable limits.
+//
+//==========================================================================
 
-				sfunc->Unsafe = ctx.Unsafe;
-			}
-			catch (CRecoverableError &err)
+static const unsigned BUILD_BATCH_SIZE = 256;
+
+void FFunctionBuildList::Build()
+{
+	VMDisassemblyDumper disasmdump(VMDisassemblyDumper::Overwrite);
+
+	for (unsigned start = 0; start < mItems.Size(); start += BUILD_BATCH_SIZE)
+	{
+		unsigned count = MIN(BUILD_BATCH_SIZE, mItems.Size() - start);
+		Item *batch = &mItems[start];
+
+		for (unsigned i = 0; i < count; i++)
+		{
+			ResolveItem(batch[i]);
+		}
+		FScriptPosition::StrictErrors = false;
+
+		try
+		{
+			FThreadPool::Get().ParallelFor(count, [this, batch](int i) { EmitItem(batch[i]); });
+		}
+		catch (...)
+		{
+			// Errors that are not caught by EmitItem abort the compilation. Print what was collected so far before passing it on.
+			for (unsigned i = 0; i < count; i++)
 			{
-				// catch errors from the code generator and pring something meaningful.
-				item.Code->ScriptPosition.Message(MSG_ERROR, "%s in %s", err.GetMessage(), item.PrintableName.GetChars());
+				if (batch[i].Output.IsNotEmpty()) PrintString(PRINT_HIGH, batch[i].Output);
 			}
+			throw;
+		}
+
+		for (unsigned i = 0; i < count; i++)
+		{
+			FinishItem(batch[i], disasmdump);
 		}
-		delete item.Code;
-		disasmdump.Flush();
 	}
 	VMFunction::CreateRegUseInfo();
 	FScriptPosition::StrictErrors = false;
@@ -9,6 +9,8 @@
 class VMFunctionBuilder;
 class FxExpression;
 class FxLocalVariableDeclaration;
+struct FCompileContext;
+class VMDisassemblyDumper;
 
 struct ExpEmit
 {
@@ -151,10 +153,19 @@ class FFunctionBuildList
 		int Lump;
 		VersionInfo Version;
 		bool FromDecorate;
+
+		// State that is passed from resolving to emitting the code.
+		FCompileContext *Context = nullptr;
+		VMFunctionBuilder *Builder = nullptr;
+		FString Output;
+		bool Resolved = false;
 	};
 
 	TArray<Item> mItems;
 
+	void ResolveItem(Item &item);
+	void EmitItem(Item &item);
+	void FinishItem(Item &item, VMDisassemblyDumper &disasmdump);
 	void DumpJit();
 
 public:
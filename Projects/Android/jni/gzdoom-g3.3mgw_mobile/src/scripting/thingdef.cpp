@@ -60,6 +60,7 @@
 #include "p_conversation.h"
 #include "v_text.h"
 //#include "thingdef.h"
+#include "d_startupprofile.h"
 #include "backend/codegen.h"
 #include "a_sharedglobal.h"
 #include "backend/vmbuilder.h"
@@ -473,13 +474,19 @@ void LoadActors()
 
 	InitThingdef();
 	FScriptPosition::StrictErrors = true;
+	int node = StartupProfiler.Begin("ZScript");
 	ParseScripts();
+	StartupProfiler.End(node);
 
 	FScriptPosition::StrictErrors = false;
+	node = StartupProfiler.Begin("DECORATE");
 	ParseAllDecorate();
 	SynthesizeFlagFields();
+	StartupProfiler.End(node);
 
+	node = StartupProfiler.Begin("Function building");
 	FunctionBuildList.Build();
+	StartupProfiler.End(node);
 
 	if (FScriptPosition::ErrorCounter > 0)
 	{
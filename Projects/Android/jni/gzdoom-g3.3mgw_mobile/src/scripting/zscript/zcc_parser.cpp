@@ -44,6 +44,8 @@
 #include "version.h"
 #include "zcc_parser.h"
 #include "zcc_compile.h"
+#include "d_startupprofile.h"
+#include "zcc_tokencache.h"
 
 TArray<FString> Includes;
 TArray<FScriptPosition> IncludeLocs;
@@ -236,6 +238,102 @@ static void InitTokenMap()
 #undef TOKENDEF
 #undef TOKENDEF2
 
+static FZCCTokenCache TokenCache;
+
+//**--------------------------------------------------------------------------
+//
+// Feeds a cached token stream to the parser. The scanner is only needed
+// for the script's name and the line numbers the parser asks for.
+//
+//**--------------------------------------------------------------------------
+
+static void ReplayTokens(FScanner &sc, const FZCCTokenStream &stream, void *parser, ZCCParseState &state)
+{
+	ZCCToken value;
+	TArray<int> names(stream.Strings.Size(), true);
+	for (auto &name : names) name = -1;
+
+	state.sc = &sc;
+	value.Largest = 0;
+	for (auto &token : stream.Tokens)
+	{
+		value.Largest = 0;
+		value.SourceLoc = token.SourceLoc;
+		switch (token.Kind)
+		{
+		case FZCCCachedToken::Int:
+			value.Int = token.IntValue;
+			break;
+
+		case FZCCCachedToken::Float:
+			value.Float = token.FloatValue;
+			break;
+
+		case FZCCCachedToken::String:
+		{
+			const FString &str = stream.Strings[token.StringIndex];
+			value.String = state.Strings.Alloc(str.GetChars(), str.Len());
+			break;
+		}
+
+		case FZCCCachedToken::Name:
+			if (names[token.StringIndex] < 0) names[token.StringIndex] = FName(stream.Strings[token.StringIndex]).GetIndex();
+			value.Int = names[token.StringIndex];
+			break;
+		}
+		sc.Line = token.MessageLine;
+		ZCCParse(parser, token.TokenType, value, &state);
+	}
+	sc.Line = stream.EndLine;
+	value.Int = -1;
+	ZCCParse(parser, ZCC_EOF, value, &state);
+	state.sc = nullptr;
+}
+
+//**--------------------------------------------------------------------------
+
+static void RecordToken(FZCCTokenStream &stream, TMap<int, unsigned> &names, int tokentype, const ZCCToken &value, FScanner &sc)
+{
+	FZCCCachedToken &token = stream.Tokens[stream.Tokens.Reserve(1)];
+	token.TokenType = tokentype;
+	token.SourceLoc = value.SourceLoc;
+	token.MessageLine = sc.GetMessageLine();
+	switch (tokentype)
+	{
+	case ZCC_INTCONST:
+	case ZCC_UINTCONST:
+		token.Kind = FZCCCachedToken::Int;
+		token.FloatValue = 0;
+		token.IntValue = value.Int;
+		break;
+
+	case ZCC_FLOATCONST:
+		token.Kind = FZCCCachedToken::Float;
+		token.FloatValue = value.Float;
+		break;
+
+	case ZCC_STRCONST:
+		token.Kind = FZCCCachedToken::String;
+		token.FloatValue = 0;
+		token.StringIndex = stream.Strings.Push(*value.String);
+		break;
+
+	default:
+	{
+		// Everything else carries a name.
+		token.Kind = FZCCCachedToken::Name;
+		token.FloatValue = 0;
+		unsigned *index = names.CheckKey(value.Int);
+		if (index == nullptr)
+		{
+			index = &names.Insert(value.Int, stream.Strings.Push(FName(ENamedName(value.Int)).GetChars()));
+		}
+		token.StringIndex = *index;
+		break;
+	}
+	}
+}
+
 //**--------------------------------------------------------------------------
 
 static void ParseSingleFile(FScanner *pSC, const char *filename, int lump, void *parser, ZCCParseState &state)
@@ -244,25 +342,44 @@ static void ParseSingleFile(FScanner *pSC, const char *filename, int lump, void
 	//bool failed;
 	ZCCToken value;
 	FScanner lsc;
+	FString cachekey;
+	std::unique_ptr<FZCCTokenStream> recording;
+	TMap<int, unsigned> recordednames;
+	int errors = FScriptPosition::ErrorCounter + FScriptPosition::WarnCounter;
 
 	if (pSC == nullptr)
 	{
 		if (filename != nullptr)
 		{
 			lump = Wads.CheckNumForFullName(filename, true);
-			if (lump >= 0)
-			{
-				lsc.OpenLumpNum(lump);
-			}
-			else
+			if (lump < 0)
 			{
 				Printf("Could not find script lump '%s'\n", filename);
 				return;
 			}
 		}
-		else lsc.OpenLumpNum(lump);
 
+		// Same as OpenLumpNum, but the text is also needed for the cache.
+		FString text;
+		{
+			FMemLump mem = Wads.ReadLump(lump);
+			text = mem.GetString();
+		}
+		lsc.OpenString(Wads.GetLumpFullPath(lump), text);
+		lsc.LumpNum = lump;
 		pSC = &lsc;
+
+		if (TokenCache.IsEnabled())
+		{
+			cachekey = FZCCTokenCache::MakeKey(text, state.ParseVersion);
+			FZCCTokenStream *cached = TokenCache.Find(cachekey);
+			if (cached != nullptr)
+			{
+				ReplayTokens(lsc, *cached, parser, state);
+				return;
+			}
+			recording.reset(new FZCCTokenStream);
+		}
 	}
 	FScanner &sc = *pSC;
 	sc.SetParseVersion(state.ParseVersion);
@@ -339,16 +456,26 @@ static void ParseSingleFile(FScanner *pSC, const char *filename, int lump, void
 			else
 			{
 				sc.ScriptMessage("Unexpected token %s.\n", sc.TokenName(sc.TokenType).GetChars());
+				recording.reset();
 				goto parse_end;
 			}
 			break;
 		}
+		if (recording != nullptr) RecordToken(*recording, recordednames, tokentype, value, sc);
 		ZCCParse(parser, tokentype, value, &state);
 	}
 parse_end:
+	if (recording != nullptr) recording->EndLine = sc.GetMessageLine();
 	value.Int = -1;
 	ZCCParse(parser, ZCC_EOF, value, &state);
 	state.sc = nullptr;
+
+	// Only cache files that went through without any message so that
+	// everything that gets printed comes from the parser itself.
+	if (recording != nullptr && errors == FScriptPosition::ErrorCounter + FScriptPosition::WarnCounter)
+	{
+		TokenCache.Add(cachekey, std::move(recording));
+	}
 }
 
 //**--------------------------------------------------------------------------
@@ -360,6 +487,7 @@ static void DoParse(int lumpnum)
 	ZCCToken value;
 	auto baselump = lumpnum;
 	auto fileno = Wads.GetLumpFile(lumpnum);
+	FStartupScope scope(Wads.GetLumpFullPath(lumpnum));
 
 	parser = ZCCParseAlloc(malloc);
 	ZCCParseState state;
@@ -502,10 +630,13 @@ void ParseScripts()
 	int lump, lastlump = 0;
 	FScriptPosition::ResetErrorCounter();
 
+	TokenCache.Load();
 	while ((lump = Wads.FindLump("ZSCRIPT", &lastlump)) != -1)
 	{
 		DoParse(lump);
 	}
+	TokenCache.Save();
+	TokenCache.Clear();
 }
 
 static FString ZCCTokenName(int terminal)
@@ -0,0 +1,266 @@
+/*
+** zcc_tokencache.cpp
+** Persistent cache of lexed ZScript lumps
+**
+**---------------------------------------------------------------------------
+** Copyright 2018 Christoph Oelckers
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+*/
+
+#include <stdexcept>
+#include "zcc_tokencache.h"
+#include "m_misc.h"
+#include "m_argv.h"
+#include "cmdlib.h"
+#include "files.h"
+#include "md5.h"
+#include "version.h"
+
+static const char *TokenCacheMagic = "ZSTC";
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+static FString CreateTokenCacheName(bool create)
+{
+	FString path = M_GetCachePath(create);
+	if (create) CreatePath(path);
+	path << "/zscriptcache.zstc";
+	return path;
+}
+
+//==========================================================================
+//
+// Anything that may change the tokens goes into the key: the script
+// itself, the parse version it is lexed with and the lexer's build.
+//
+//==========================================================================
+
+FString FZCCTokenCache::MakeKey(const FString &text, VersionInfo version)
+{
+	const char *build = GetGitHash();
+	const char *engineversion = GetVersionString();
+
+	uint8_t digest[16];
+	MD5Context md5;
+	md5.Update((const uint8_t *)build, (unsigned)strlen(build));
+	md5.Update((const uint8_t *)engineversion, (unsigned)strlen(engineversion));
+	md5.Update((const uint8_t *)&version, (unsigned)sizeof(version));
+	md5.Update((const uint8_t *)text.GetChars(), (unsigned)text.Len());
+	md5.Final(digest);
+
+	char hexdigest[33];
+	for (int i = 0; i < 16; i++)
+	{
+		mysnprintf(hexdigest + i * 2, 3, "%02x", digest[i]);
+	}
+	return hexdigest;
+}
+
+//==========================================================================
+//
+// Reads the whole cache file. A broken file is simply ignored.
+//
+//==========================================================================
+
+void FZCCTokenCache::Load()
+{
+	Clear();
+	Enabled = !Args->CheckParm("-nozscriptcache");
+	if (!Enabled) return;
+
+	try
+	{
+		FileReader fr;
+		if (!fr.OpenFile(CreateTokenCacheName(false)))
+			return;
+
+		TArray<uint8_t> data(fr.GetLength(), true);
+		if (fr.Read(data.Data(), data.Size()) != (long)data.Size())
+			throw std::runtime_error("Read error");
+
+		unsigned pos = 0;
+		auto read = [&](void *dest, unsigned size)
+		{
+			if (size > data.Size() - pos)
+				throw std::runtime_error("Truncated token cache file");
+			memcpy(dest, &data[pos], size);
+			pos += size;
+		};
+
+		char magic[4];
+		read(magic, 4);
+		if (memcmp(magic, TokenCacheMagic, 4) != 0)
+			throw std::runtime_error("Not a token cache file");
+
+		uint32_t count;
+		read(&count, sizeof(count));
+		for (uint32_t i = 0; i < count; i++)
+		{
+			char key[33];
+			read(key, 32);
+			key[32] = 0;
+
+			std::unique_ptr<FZCCTokenStream> stream(new FZCCTokenStream);
+			uint32_t numtokens, numstrings;
+			read(&numtokens, sizeof(numtokens));
+			read(&numstrings, sizeof(numstrings));
+			read(&stream->EndLine, sizeof(stream->EndLine));
+			if (numtokens > data.Size() / sizeof(FZCCCachedToken) || numstrings > data.Size())
+				throw std::runtime_error("Token cache file corrupt");
+
+			stream->Tokens.Resize(numtokens);
+			read(stream->Tokens.Data(), numtokens * sizeof(FZCCCachedToken));
+			stream->Strings.Resize(numstrings);
+			for (auto &str : stream->Strings)
+			{
+				uint32_t len;
+				read(&len, sizeof(len));
+				if (len > data.Size() - pos)
+					throw std::runtime_error("Token cache file corrupt");
+				str = FString((const char *)&data[pos], len);
+				pos += len;
+			}
+			for (auto &token : stream->Tokens)
+			{
+				if ((token.Kind == FZCCCachedToken::String || token.Kind == FZCCCachedToken::Name) && token.StringIndex >= numstrings)
+					throw std::runtime_error("Token cache file corrupt");
+			}
+			Streams[key] = std::move(stream);
+		}
+	}
+	catch (...)
+	{
+		Streams.clear();
+	}
+}
+
+//==========================================================================
+//
+// Writes all streams that have been used by this run, so that the cache
+// does not keep growing with every version of a mod that gets loaded.
+//
+//==========================================================================
+
+void FZCCTokenCache::Save()
+{
+	if (!Enabled) return;
+
+	bool unused = false;
+	for (const auto &it : Streams)
+	{
+		if (!it.second->Used) unused = true;
+	}
+	if (!Changed && !unused) return;
+
+	TArray<uint8_t> data;
+	auto write = [&](const void *src, unsigned size)
+	{
+		unsigned pos = data.Reserve(size);
+		memcpy(&data[pos], src, size);
+	};
+
+	uint32_t count = 0;
+	for (const auto &it : Streams)
+	{
+		if (it.second->Used) count++;
+	}
+	write(TokenCacheMagic, 4);
+	write(&count, sizeof(count));
+	for (const auto &it : Streams)
+	{
+		const FZCCTokenStream *stream = it.second.get();
+		if (!stream->Used) continue;
+
+		uint32_t numtokens = stream->Tokens.Size();
+		uint32_t numstrings = stream->Strings.Size();
+		write(it.first.GetChars(), 32);
+		write(&numtokens, sizeof(numtokens));
+		write(&numstrings, sizeof(numstrings));
+		write(&stream->EndLine, sizeof(stream->EndLine));
+		write(stream->Tokens.Data(), numtokens * sizeof(FZCCCachedToken));
+		for (const auto &str : stream->Strings)
+		{
+			uint32_t len = (uint32_t)str.Len();
+			write(&len, sizeof(len));
+			write(str.GetChars(), len);
+		}
+	}
+
+	std::unique_ptr<FileWriter> fw(FileWriter::Open(CreateTokenCacheName(true)));
+	if (fw)
+	{
+		fw->Write(data.Data(), data.Size());
+	}
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void FZCCTokenCache::Clear()
+{
+	Streams.clear();
+	Changed = false;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+FZCCTokenStream *FZCCTokenCache::Find(const FString &key)
+{
+	if (!Enabled) return nullptr;
+
+	auto it = Streams.find(key);
+	if (it == Streams.end()) return nullptr;
+	it->second->Used = true;
+	return it->second.get();
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void FZCCTokenCache::Add(const FString &key, std::unique_ptr<FZCCTokenStream> stream)
+{
+	if (!Enabled) return;
+
+	stream->Used = true;
+	Streams[key] = std::move(stream);
+	Changed = true;
+}
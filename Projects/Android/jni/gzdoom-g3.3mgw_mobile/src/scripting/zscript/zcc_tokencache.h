@@ -0,0 +1,72 @@
+#ifndef ZCC_TOKENCACHE_H
+#define ZCC_TOKENCACHE_H
+
+#include <map>
+#include <memory>
+#include "tarray.h"
+#include "zstring.h"
+#include "doomtype.h"
+
+//==========================================================================
+//
+// The token stream the ZScript lexer produced for a script lump.
+// Names are stored as strings because name indices differ between runs.
+//
+//==========================================================================
+
+struct FZCCCachedToken
+{
+	enum
+	{
+		Int,
+		Float,
+		String,
+		Name,
+	};
+
+	int TokenType;
+	int Kind;
+	int SourceLoc;
+	int MessageLine;	// what the scanner reported as the current line when the token was parsed.
+	union
+	{
+		int IntValue;
+		double FloatValue;
+		unsigned StringIndex;	// into FZCCTokenStream::Strings, for names and string constants.
+	};
+};
+
+struct FZCCTokenStream
+{
+	TArray<FZCCCachedToken> Tokens;
+	TArray<FString> Strings;
+	int EndLine = 0;
+	bool Used = false;
+};
+
+//==========================================================================
+//
+// Persistent cache of lexed ZScript lumps, keyed by the lump's contents,
+// the parse version and the engine build. Replaying the tokens into the
+// parser gives exactly the same AST as lexing the lump again.
+//
+//==========================================================================
+
+class FZCCTokenCache
+{
+	std::map<FString, std::unique_ptr<FZCCTokenStream>> Streams;	// Not a TMap because it doesn't support unique_ptr move semantics
+	bool Enabled = false;
+	bool Changed = false;
+
+public:
+	void Load();
+	void Save();
+	void Clear();
+
+	bool IsEnabled() const { return Enabled; }
+	static FString MakeKey(const FString &text, VersionInfo version);
+	FZCCTokenStream *Find(const FString &key);
+	void Add(const FString &key, std::unique_ptr<FZCCTokenStream> stream);
+};
+
+#endif
@@ -28,6 +28,7 @@ enum EChanFlag
 	CHANF_NOSTOP = 4096,	// only for A_PlaySound. Does not start if channel is playing something.
 	CHANF_OVERLAP = 8192, // [MK] Does not stop any sounds in the channel and instead plays over them.
 	CHANF_LOCAL = 16384,	// only plays locally for the calling actor
+	CHANF_INAUDIBLE = 32768,	// internal: Looping sound was evicted because it is out of hearing range.
 };
 
 typedef TFlags<EChanFlag> EChanFlags;
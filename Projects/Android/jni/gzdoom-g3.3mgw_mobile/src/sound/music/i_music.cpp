@@ -54,6 +54,9 @@
 #include "s_music.h"
 #include "doomstat.h"
 #include "filereadermusicinterface.h"
+#include "m_misc.h"
+#include "cmdlib.h"
+#include "i_time.h"
 
 
 
@@ -299,6 +302,12 @@ void I_InitMusic (void)
 	callbacks.SF_Close = mus_sfclose;
 
 	ZMusic_SetCallbacks(&callbacks);
+
+	FString cachepath = M_GetCachePath(true);
+	cachepath << "/midicache";
+	CreatePath(cachepath);
+	ChangeMusicSetting(zmusic_snd_midirendercache_path, nullptr, cachepath);
+
 	SetupGenMidi();
 	SetupDMXGUS();
 	SetupWgOpn();
@@ -459,6 +468,172 @@ UNSAFE_CCMD (writewave)
 	}
 }
 
+//==========================================================================
+//
+// Synth benchmarks
+//
+// Both render a song twice with different settings, print how long each
+// run took and how far apart the outputs are.
+//
+//==========================================================================
+
+static bool ReadWaveSamples(const char *filename, TArray<float> &samples)
+{
+	FileReader fr;
+	if (!fr.OpenFile(filename)) return false;
+	auto data = fr.Read();
+	fr.Close();
+
+	// Skip to the data chunk. The wave writer always outputs float stereo.
+	unsigned pos = 12;
+	while (pos + 8 <= data.Size())
+	{
+		uint32_t len = data[pos + 4] | (data[pos + 5] << 8) | (data[pos + 6] << 16) | (data[pos + 7] << 24);
+		if (!memcmp(&data[pos], "data", 4))
+		{
+			len = MIN<uint32_t>(len, data.Size() - pos - 8);
+			samples.Resize(len / sizeof(float));
+			memcpy(samples.Data(), &data[pos + 8], samples.Size() * sizeof(float));
+			return true;
+		}
+		pos += 8 + len;
+	}
+	return false;
+}
+
+static bool BenchmarkRender(const char *song, EMidiDevice device, const char *synthname, int samplerate, TArray<float> &output, uint64_t &time)
+{
+	auto source = GetMIDISource(song);
+	if (source == nullptr) return false;
+
+	FString filename = M_GetCachePath(true);
+	CreatePath(filename);
+	filename += "/synthbench.wav";
+
+	uint64_t start = I_nsTime();
+	if (!ZMusic_MIDIDumpWave(source, device, nullptr, filename, 0, samplerate))
+	{
+		Printf("%s: MIDI dump of %s failed: %s\n", synthname, song, ZMusic_GetLastError());
+		return false;
+	}
+	time = I_nsTime() - start;
+	bool ok = ReadWaveSamples(filename, output);
+	if (!ok) Printf("%s: Unable to read back %s\n", synthname, filename.GetChars());
+	remove(filename);
+	return ok;
+}
+
+static void PrintBenchmark(const char *synthname, const char *names[2], TArray<float> output[2], uint64_t time[2], int samplerate, double tolerance)
+{
+	double maxdiff = 0;
+	unsigned count = MIN(output[0].Size(), output[1].Size());
+	for (unsigned i = 0; i < count; i++)
+	{
+		maxdiff = MAX(maxdiff, fabs(double(output[0][i]) - output[1][i]));
+	}
+	bool match = output[0].Size() == output[1].Size() && maxdiff <= tolerance;
+	double seconds = output[0].Size() / 2. / samplerate;
+	Printf("%s: %.1fs of audio, %s %.1f ms (%.1fx realtime), %s %.1f ms (%.1fx realtime), speedup %.2f, max difference %g: %s\n",
+		synthname, seconds,
+		names[0], time[0] / 1e6, seconds * 1e9 / MAX<uint64_t>(time[0], 1),
+		names[1], time[1] / 1e6, seconds * 1e9 / MAX<uint64_t>(time[1], 1),
+		double(time[0]) / MAX<uint64_t>(time[1], 1), maxdiff,
+		match ? "ok" : TEXTCOLOR_RED "MISMATCH" TEXTCOLOR_NORMAL);
+}
+
+//==========================================================================
+//
+// CCMD snd_synthbench
+//
+// Compares the scalar and SSE2/NEON mixing loops of the GUS and OPL synths.
+//
+//==========================================================================
+
+EXTERN_CVAR(Bool, snd_synthsimd)
+
+UNSAFE_CCMD(snd_synthbench)
+{
+	if (argv.argc() < 2)
+	{
+		Printf("Usage: snd_synthbench <midi> [sample rate]\n"
+		" - use '*' as song name to benchmark the currently playing song\n");
+		return;
+	}
+	static const struct { EMidiDevice device; const char *name; } synths[] =
+	{
+		{ MDEV_GUS, "GUS" },
+		{ MDEV_OPL, "OPL" },
+	};
+	static const char *names[2] = { "scalar", "SIMD" };
+	int samplerate = argv.argc() < 3 ? 44100 : (int)strtol(argv[2], nullptr, 10);
+
+	// We must stop the currently playing music to avoid interference between two synths.
+	auto savedsong = mus_playing;
+	S_StopMusic(true);
+
+	for (auto &synth : synths)
+	{
+		TArray<float> output[2];
+		uint64_t time[2];
+		int simd;
+
+		for (simd = 0; simd < 2; simd++)
+		{
+			ChangeMusicSetting(zmusic_snd_synthsimd, nullptr, simd);
+			if (!BenchmarkRender(argv[1], synth.device, synth.name, samplerate, output[simd], time[simd])) break;
+		}
+		if (simd == 2) PrintBenchmark(synth.name, names, output, time, samplerate, 1e-4);
+	}
+
+	ChangeMusicSetting(zmusic_snd_synthsimd, nullptr, *snd_synthsimd);
+	S_ChangeMusic(savedsong.name, savedsong.baseorder, savedsong.loop, true);
+}
+
+//==========================================================================
+//
+// CCMD timidity_threadbench
+//
+// Compares single and multithreaded voice mixing in Timidity++. Dense
+// songs benefit the most, so it accepts several of them in one go.
+// Since the mixer works with integers, the outputs must be identical.
+//
+//==========================================================================
+
+EXTERN_CVAR(Int, timidity_render_threads)
+
+UNSAFE_CCMD(timidity_threadbench)
+{
+	if (argv.argc() < 2)
+	{
+		Printf("Usage: timidity_threadbench <midi> [<midi> ...]\n"
+		" - use '*' as song name to benchmark the currently playing song\n"
+		" - uses timidity_render_threads for the multithreaded run\n");
+		return;
+	}
+	static const char *names[2] = { "1 thread", "threaded" };
+	int samplerate = 44100;
+
+	auto savedsong = mus_playing;
+	S_StopMusic(true);
+
+	for (int i = 1; i < argv.argc(); i++)
+	{
+		TArray<float> output[2];
+		uint64_t time[2];
+		int pass;
+
+		for (pass = 0; pass < 2; pass++)
+		{
+			ChangeMusicSetting(zmusic_timidity_render_threads, nullptr, pass == 0 ? 1 : *timidity_render_threads);
+			if (!BenchmarkRender(argv[i], MDEV_TIMIDITY, "Timidity++", samplerate, output[pass], time[pass])) break;
+		}
+		if (pass == 2) PrintBenchmark(argv[i], names, output, time, samplerate, 0);
+	}
+
+	ChangeMusicSetting(zmusic_timidity_render_threads, nullptr, *timidity_render_threads);
+	S_ChangeMusic(savedsong.name, savedsong.baseorder, savedsong.loop, true);
+}
+
 //==========================================================================
 //
 // CCMD writemidi
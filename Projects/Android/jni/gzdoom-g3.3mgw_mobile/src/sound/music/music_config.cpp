@@ -380,6 +380,12 @@ CUSTOM_CVAR(Int, timidity_key_adjust, 0, CVAR_ARCHIVE | CVAR_GLOBALCONFIG | CVAR
 	FORWARD_CVAR(timidity_key_adjust);
 }
 
+// 0 picks the number of threads based on the CPU count, 1 disables multithreaded mixing.
+CUSTOM_CVAR(Int, timidity_render_threads, 0, CVAR_ARCHIVE | CVAR_GLOBALCONFIG | CVAR_VIRTUAL)
+{
+	FORWARD_CVAR(timidity_render_threads);
+}
+
 CUSTOM_CVAR(Float, timidity_tempo_adjust, 1, CVAR_ARCHIVE | CVAR_GLOBALCONFIG | CVAR_VIRTUAL)
 {
 	FORWARD_CVAR(timidity_tempo_adjust);
@@ -432,6 +438,32 @@ CUSTOM_CVAR(Bool, snd_midiprecache, false, CVAR_ARCHIVE | CVAR_GLOBALCONFIG | CV
 	FORWARD_BOOL_CVAR(snd_midiprecache);
 }
 
+//==========================================================================
+//
+// Render cache for the software synths
+//
+//==========================================================================
+
+#ifdef __ANDROID__
+CUSTOM_CVAR(Bool, snd_midirendercache, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG | CVAR_VIRTUAL)
+#else
+CUSTOM_CVAR(Bool, snd_midirendercache, false, CVAR_ARCHIVE | CVAR_GLOBALCONFIG | CVAR_VIRTUAL)
+#endif
+{
+	FORWARD_BOOL_CVAR(snd_midirendercache);
+}
+
+//==========================================================================
+//
+// Vectorized mixing in the GUS and OPL synths
+//
+//==========================================================================
+
+CUSTOM_CVAR(Bool, snd_synthsimd, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG | CVAR_VIRTUAL)
+{
+	FORWARD_BOOL_CVAR(snd_synthsimd);
+}
+
 //==========================================================================
 //
 // GME
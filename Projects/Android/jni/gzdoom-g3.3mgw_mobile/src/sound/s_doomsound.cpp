@@ -65,6 +65,7 @@
 #include "vm.h"
 #include "g_game.h"
 #include "s_music.h"
+#include "i_time.h"
 
 // PUBLIC DATA DEFINITIONS -------------------------------------------------
 
@@ -75,6 +76,15 @@ CUSTOM_CVAR(Int, snd_channels, 128, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)	// number
 	if (self < 64) self = 64;
 }
 CVAR(Bool, snd_waterreverb, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+CUSTOM_CVAR(Int, snd_decodecache, 32, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)	// memory budget for decoded sounds in MB, 0 disables the cache
+{
+	if (self < 0) self = 0;
+	else if (soundEngine) soundEngine->SetDecodeCacheSize(size_t(self) << 20);
+}
+CUSTOM_CVAR(Bool, snd_virtualize, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)	// free the voices of looping sounds that are out of hearing range
+{
+	if (soundEngine) soundEngine->SetVirtualization(self);
+}
 
 
 static FString LastLocalSndInfo;
@@ -88,6 +98,7 @@ class DoomSoundEngine : public SoundEngine
 	void CalcPosVel(int type, const void* source, const float pt[3], int channum, int chanflags, FSoundID soundid, FVector3* pos, FVector3* vel, FSoundChan *) override;
 	bool ValidatePosVel(int sourcetype, const void* source, const FVector3& pos, const FVector3& vel);
 	TArray<uint8_t> ReadSound(int lumpnum);
+	void PrefetchSounds(const TArray<int> &lumps) override;
 	int PickReplacement(int refid);
 	FSoundID ResolveSound(const void *ent, int type, FSoundID soundid, float &attenuation) override;
 
@@ -111,6 +122,8 @@ void S_Init()
 	if (!soundEngine)
 	{
 		soundEngine = new DoomSoundEngine;
+		soundEngine->SetDecodeCacheSize(size_t(*snd_decodecache) << 20);
+		soundEngine->SetVirtualization(snd_virtualize);
 	}
 
 	I_InitSound();
@@ -1060,6 +1073,17 @@ TArray<uint8_t> DoomSoundEngine::ReadSound(int lumpnum)
 	return wlump.Read();
 }
 
+//==========================================================================
+//
+// Sounds in PK3s are often compressed, which can be done in parallel.
+//
+//==========================================================================
+
+void DoomSoundEngine::PrefetchSounds(const TArray<int> &lumps)
+{
+	Wads.PrefetchLumps(lumps);
+}
+
 //==========================================================================
 //
 // S_PickReplacement
@@ -1431,3 +1455,60 @@ ADD_STAT (sound)
 {
 	return GSnd->GatherStats ();
 }
+
+ADD_STAT (sounddecode)
+{
+	return soundEngine->GetDecodeCacheStats();
+}
+
+ADD_STAT (soundchannels)
+{
+	return soundEngine->GetChannelStats();
+}
+
+//==========================================================================
+//
+// CCMD snd_stresstest
+//
+// Starts a large number of looping sounds scattered around the listener
+// and measures how long it takes to start and update them.
+//
+//==========================================================================
+
+CCMD (snd_stresstest)
+{
+	if (argv.argc() < 2)
+	{
+		Printf("Usage: snd_stresstest <sound> [count] [updates]\n");
+		return;
+	}
+	AActor *listener = players[consoleplayer].camera;
+	FSoundID id = argv[1];
+	if (id == 0 || listener == nullptr || gamestate != GS_LEVEL)
+	{
+		Printf("Sound %s cannot be played now\n", argv[1]);
+		return;
+	}
+	int count = argv.argc() > 2 ? atoi(argv[2]) : 2000;
+	int updates = argv.argc() > 3 ? atoi(argv[3]) : 100;
+	static FRandom pr_stresstest("SoundStressTest");
+
+	uint64_t start = I_nsTime();
+	for (int i = 0; i < count; i++)
+	{
+		// Scatter the sounds so that some are in range and most are not.
+		FVector3 pt((float)listener->X() + pr_stresstest.Random2() * 32.f, (float)listener->Z(), (float)listener->Y() + pr_stresstest.Random2() * 32.f);
+		soundEngine->StartSound(SOURCE_Unattached, nullptr, &pt, CHAN_AUTO, CHANF_LOOP, id, 1.f, ATTN_NORM);
+	}
+	uint64_t started = I_nsTime();
+	for (int i = 0; i < updates; i++)
+	{
+		S_UpdateSounds(listener);
+	}
+	uint64_t updated = I_nsTime();
+
+	Printf("%d sounds started in %.3f ms (%.2f us per sound)\n", count, (started - start) / 1e6, count > 0 ? (started - start) / 1e3 / count : 0.);
+	Printf("%d updates in %.3f ms (%.3f ms per update)\n", updates, (updated - started) / 1e6, updates > 0 ? (updated - started) / 1e6 / updates : 0.);
+	Printf("%s\n", soundEngine->GetChannelStats().GetChars());
+	soundEngine->StopSoundID(id);
+}
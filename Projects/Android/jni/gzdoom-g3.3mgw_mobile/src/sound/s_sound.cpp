@@ -82,6 +82,7 @@ void SoundEngine::Clear()
 	UnloadAllSounds();
 	GetSounds().Clear();
 	ClearRandoms();
+	DecodeCache.Clear();
 }
 
 //==========================================================================
@@ -132,6 +133,19 @@ void SoundEngine::CacheMarkedSounds()
 		MarkUsed(chan->SoundID);
 	}
 
+	// Sounds from compressed archives can be read ahead of time in one batch.
+	TArray<int> lumps;
+	for (unsigned i = 1; i < S_sfx.Size(); ++i)
+	{
+		sfxinfo_t *sfx = &S_sfx[i];
+		if (!sfx->bUsed || sfx->bPlayerReserve || sfx->bRandomHeader) continue;
+		while (sfx->link != sfxinfo_t::NO_LINK && !sfx->bRandomHeader) sfx = &S_sfx[sfx->link];
+		if (!sfx->data.isValid() && sfx->lumpnum >= 0) lumps.Push(sfx->lumpnum);
+	}
+	PrefetchSounds(lumps);
+
+	// Compressed sounds only get queued for decoding here. They will be uploaded on first use.
+	DeferDecoding = true;
 	for (unsigned i = 1; i < S_sfx.Size(); ++i)
 	{
 		if (S_sfx[i].bUsed)
@@ -139,6 +153,7 @@ void SoundEngine::CacheMarkedSounds()
 			CacheSound(&S_sfx[i]);
 		}
 	}
+	DeferDecoding = false;
 	for (unsigned i = 1; i < S_sfx.Size(); ++i)
 	{
 		if (!S_sfx[i].bUsed && S_sfx[i].link == sfxinfo_t::NO_LINK)
@@ -229,6 +244,7 @@ FSoundChan *SoundEngine::GetChannel(void *syschan)
 
 void SoundEngine::ReturnChannel(FSoundChan *chan)
 {
+	UnlinkSoundChannel(chan);
 	UnlinkChannel(chan);
 	memset(chan, 0, sizeof(*chan));
 	LinkChannel(chan, &FreeChannels);
@@ -266,6 +282,65 @@ void SoundEngine::LinkChannel(FSoundChan *chan, FSoundChan **head)
 	chan->PrevChan = head;
 }
 
+//==========================================================================
+//
+// LinkSoundChannel
+//
+// Adds a channel to the list of channels playing its sound.
+//
+//==========================================================================
+
+void SoundEngine::LinkSoundChannel(FSoundChan *chan)
+{
+	unsigned id = chan->SoundID;
+	if (id >= SoundChannels.Size())
+	{
+		unsigned oldsize = SoundChannels.Size();
+		SoundChannels.Resize(id + 1);
+		for (unsigned i = oldsize; i <= id; i++)
+		{
+			SoundChannels[i] = nullptr;
+		}
+	}
+	chan->PrevSame = nullptr;
+	chan->NextSame = SoundChannels[id];
+	if (chan->NextSame != nullptr)
+	{
+		chan->NextSame->PrevSame = chan;
+	}
+	SoundChannels[id] = chan;
+}
+
+//==========================================================================
+//
+// UnlinkSoundChannel
+//
+// Does nothing if the channel isn't linked.
+//
+//==========================================================================
+
+void SoundEngine::UnlinkSoundChannel(FSoundChan *chan)
+{
+	unsigned id = chan->SoundID;
+	if (chan->PrevSame != nullptr)
+	{
+		chan->PrevSame->NextSame = chan->NextSame;
+	}
+	else if (id < SoundChannels.Size() && SoundChannels[id] == chan)
+	{
+		SoundChannels[id] = chan->NextSame;
+	}
+	else
+	{
+		return;
+	}
+	if (chan->NextSame != nullptr)
+	{
+		chan->NextSame->PrevSame = chan->PrevSame;
+	}
+	chan->NextSame = chan->PrevSame = nullptr;
+}
+
 //==========================================================================
 //
 //
@@ -316,6 +391,27 @@ FString SoundEngine::ListSoundChannels()
 	return output;
 }
 
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+FString SoundEngine::GetChannelStats()
+{
+	int total = 0, playing = 0, evicted = 0, inaudible = 0;
+	for (FSoundChan *chan = Channels; chan != nullptr; chan = chan->NextChan)
+	{
+		total++;
+		if (chan->ChanFlags & CHANF_INAUDIBLE) inaudible++;
+		else if (chan->ChanFlags & CHANF_EVICTED) evicted++;
+		else if (chan->SysChannel != nullptr) playing++;
+	}
+	FString out;
+	out.Format("%d channels: %d playing, %d evicted, %d out of range", total, playing, evicted, inaudible);
+	return out;
+}
+
 // [RH] Split S_StartSoundAtVolume into multiple parts so that sounds can
 //		be specified both by id and by name. Also borrowed some stuff from
 //		Hexen and parameters from Quake.
@@ -542,6 +638,12 @@ FSoundChan *SoundEngine::StartSound(int type, const void *source,
 		pitch = DEFAULT_PITCH;
 	}
 
+	// A looping sound that cannot be heard from here does not need a voice until the listener gets close enough.
+	if (VirtualizeInaudible && (chanflags & CHANF_LOOP) && attenuation > 0 && type != SOURCE_None && !IsAudible(rolloff, attenuation, pos))
+	{
+		chanflags |= CHANF_EVICTED | CHANF_INAUDIBLE;
+	}
+
 	if (chanflags & CHANF_EVICTED)
 	{
 		chan = NULL;
@@ -572,6 +674,7 @@ FSoundChan *SoundEngine::StartSound(int type, const void *source,
 	{
 		chan = (FSoundChan*)GetChannel(NULL);
 		GSnd->MarkStartTime(chan);
+		chan->Rolloff = *rolloff;
 		chanflags |= CHANF_EVICTED;
 	}
 	if (attenuation > 0)
@@ -586,6 +689,7 @@ FSoundChan *SoundEngine::StartSound(int type, const void *source,
 	{
 		chan->SoundID = sound_id;
 		chan->OrgID = FSoundID(org_id);
+		LinkSoundChannel(chan);
 		chan->EntChannel = channel;
 		chan->Volume = float(volume);
 		chan->ChanFlags |= chanflags;
@@ -630,6 +734,10 @@ void SoundEngine::RestartChannel(FSoundChan *chan)
 	if (sfx->bSingular && CheckSingular(chan->SoundID))
 		return;
 
+	// Out of range sounds only get checked every few updates.
+	if ((chan->ChanFlags & CHANF_INAUDIBLE) && ((UpdateCount + (size_t(chan) >> 4)) & 3) != 0)
+		return;
+
 	sfx = LoadSound(sfx);
 
 	// The empty sound never plays.
@@ -638,6 +746,10 @@ void SoundEngine::RestartChannel(FSoundChan *chan)
 		return;
 	}
 
+	// Channels restored from a savegame have not been indexed yet.
+	UnlinkSoundChannel(chan);
+	LinkSoundChannel(chan);
+
 	EChanFlags oldflags = chan->ChanFlags;
 
 	int startflags = 0;
@@ -657,6 +769,13 @@ void SoundEngine::RestartChannel(FSoundChan *chan)
 			return;
 		}
 
+		if (VirtualizeInaudible && (chan->ChanFlags & CHANF_LOOP) && !IsAudible(&chan->Rolloff, chan->DistanceScale, pos))
+		{
+			chan->ChanFlags |= CHANF_INAUDIBLE;
+			return;
+		}
+		chan->ChanFlags &= ~CHANF_INAUDIBLE;
+
 		// If this sound doesn't like playing near itself, don't play it if
 		// that's what would happen.
 		if (chan->NearLimit > 0 && CheckSoundLimit(&S_sfx[chan->SoundID], pos, chan->NearLimit, chan->LimitRange, 0, NULL, 0))
@@ -718,6 +837,17 @@ sfxinfo_t *SoundEngine::LoadSound(sfxinfo_t *sfx)
 			}
 		}
 
+		// Compressed sounds which have been decoded before can be uploaded straight from the cache.
+		if (!sfx->bLoadRAW)
+		{
+			auto decoded = DecodeCache.Find(sfx->lumpnum);
+			if (decoded != nullptr)
+			{
+				sfx->data = GSnd->LoadSoundRaw(decoded->Data.Data(), decoded->Data.Size(), decoded->SampleRate, decoded->Channels, decoded->Bits, decoded->LoopStart, decoded->LoopEnd);
+				if (sfx->data.isValid()) break;
+			}
+		}
+
 		//DPrintf(DMSG_NOTIFY, "Loading sound \"%s\" (%td)\n", sfx->name.GetChars(), sfx - &S_sfx[0]);
 
 		auto sfxdata = ReadSound(sfx->lumpnum);
@@ -743,10 +873,20 @@ sfxinfo_t *SoundEngine::LoadSound(sfxinfo_t *sfx)
 				if (frequency == 0) frequency = 11025;
 				sfx->data = GSnd->LoadSoundRaw(sfxdata.Data()+8, dmxlen, frequency, 1, 8, sfx->LoopStart);
 			}
+			// When precaching, leave the decoding to the cache's background thread.
+			else if (DeferDecoding && DecodeCache.IsEnabled())
+			{
+				DecodeCache.Precache(sfx->lumpnum, sfxdata);
+				return sfx;
+			}
 			// If that fails, let the sound system try and figure it out.
 			else
 			{
-				sfx->data = GSnd->LoadSound(sfxdata.Data(), size);
+				auto decoded = DecodeCache.Decode(sfx->lumpnum, sfxdata);
+				if (decoded != nullptr)
+				{
+					sfx->data = GSnd->LoadSoundRaw(decoded->Data.Data(), decoded->Data.Size(), decoded->SampleRate, decoded->Channels, decoded->Bits, decoded->LoopStart, decoded->LoopEnd);
+				}
 			}
 		}
 
@@ -805,10 +945,15 @@ bool SoundEngine::CheckSoundLimit(sfxinfo_t *sfx, const FVector3 &pos, int near_
 {
 	FSoundChan *chan;
 	int count;
-	
-	for (chan = Channels, count = 0; chan != NULL && count < near_limit; chan = chan->NextChan)
+	unsigned id = unsigned(sfx - &S_sfx[0]);
+
+	if (id >= SoundChannels.Size())
+	{
+		return false;
+	}
+	for (chan = SoundChannels[id], count = 0; chan != NULL && count < near_limit; chan = chan->NextSame)
 	{
-		if (!(chan->ChanFlags & CHANF_EVICTED) && &S_sfx[chan->SoundID] == sfx)
+		if (!(chan->ChanFlags & CHANF_EVICTED))
 		{
 			FVector3 chanorigin;
 
@@ -1226,6 +1371,7 @@ void SoundEngine::UpdateSounds(int time)
 {
 	FVector3 pos, vel;
 
+	UpdateCount++;
 	for (FSoundChan* chan = Channels; chan != NULL; chan = chan->NextChan)
 	{
 		if ((chan->ChanFlags & (CHANF_EVICTED | CHANF_IS3D)) == CHANF_IS3D)
@@ -1234,7 +1380,22 @@ void SoundEngine::UpdateSounds(int time)
 
 			if (ValidatePosVel(chan, pos, vel))
 			{
-				GSnd->UpdateSoundParams3D(&listener, chan, !!(chan->ChanFlags & CHANF_AREA), pos, vel);
+				if (VirtualizeInaudible && (chan->ChanFlags & CHANF_LOOP) && !IsAudible(&chan->Rolloff, chan->DistanceScale, pos))
+				{
+					// Give the voice to something that can be heard. RestoreEvictedChannels
+					// restarts the sound where it left off once it gets back in range.
+					chan->ChanFlags |= CHANF_EVICTED | CHANF_INAUDIBLE;
+					if (!(chan->ChanFlags & CHANF_ABSTIME))
+					{
+						chan->StartTime = GSnd->GetPosition(chan);
+						chan->ChanFlags |= CHANF_ABSTIME;
+					}
+					StopChannel(chan);
+				}
+				else
+				{
+					GSnd->UpdateSoundParams3D(&listener, chan, !!(chan->ChanFlags & CHANF_AREA), pos, vel);
+				}
 			}
 		}
 		chan->ChanFlags &= ~CHANF_JUSTSTARTED;
@@ -1251,6 +1412,24 @@ void SoundEngine::UpdateSounds(int time)
 	}
 }
 
+//==========================================================================
+//
+// IsAudible
+//
+// Checks if a sound with the given rolloff can be heard at this position.
+// Logarithmic rolloff never goes completely silent.
+//
+//==========================================================================
+
+bool SoundEngine::IsAudible(const FRolloffInfo *rolloff, float distscale, const FVector3 &pos)
+{
+	if (!listener.valid || rolloff->MinDistance == 0 || rolloff->RolloffType == ROLLOFF_Log)
+	{
+		return true;
+	}
+	return GetRolloff(rolloff, (pos - listener.position).Length() * distscale) > 0.f;
+}
+
 //==========================================================================
 //
 // S_GetRolloff
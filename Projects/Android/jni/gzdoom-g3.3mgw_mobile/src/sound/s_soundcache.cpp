@@ -0,0 +1,446 @@
+/*
+** s_soundcache.cpp
+** Cache for decoded sound data
+**
+**---------------------------------------------------------------------------
+** Copyright 2020 QuestZDoom contributors
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+*/
+
+#include "s_soundcache.h"
+#include "doomtype.h"
+#include "m_fixed.h"
+#include "zmusic/zmusic.h"
+
+const char *GetSampleTypeName(SampleType type);
+const char *GetChannelConfigName(ChannelConfig chan);
+
+static size_t GetChannelCount(ChannelConfig chans)
+{
+	switch(chans)
+	{
+		case ChannelConfig_Mono: return 1;
+		case ChannelConfig_Stereo: return 2;
+	}
+	return 0;
+}
+
+//==========================================================================
+//
+// S_DecodeSound
+//
+// Decodes a compressed sound into raw PCM data. This may be called from
+// the background decoding thread.
+//
+//==========================================================================
+
+bool S_DecodeSound(const uint8_t *sfxdata, int length, FDecodedSound &out)
+{
+#ifdef __MOBILE__ // 3D sounds are very loud without making the sound mono. This needs to be fixed because it is making all sounds mono for now..
+	bool monoize = true;
+#endif
+	// The decoder libraries perform some global initialization on first use which is not thread safe.
+	static std::mutex DecoderLock;
+
+	ChannelConfig chans;
+	SampleType type;
+	int srate;
+	uint32_t loop_start = 0, loop_end = ~0u;
+	bool startass = false, endass = false;
+
+	FindLoopTags(sfxdata, length, &loop_start, &startass, &loop_end, &endass);
+	SoundDecoder *decoder;
+	{
+		std::lock_guard<std::mutex> lock(DecoderLock);
+		decoder = CreateDecoder(sfxdata, length, true);
+	}
+	if (!decoder)
+		return false;
+
+	SoundDecoder_GetInfo(decoder, &srate, &chans, &type);
+	int bits = type == SampleType_UInt8 ? 8 : type == SampleType_Int16 ? 16 : 0;
+	int channels = (int)GetChannelCount(chans);
+#ifdef __MOBILE__
+	if (monoize && channels > 0) channels = 1;
+#endif
+
+	if (bits == 0 || channels == 0)
+	{
+		SoundDecoder_Close(decoder);
+		Printf("Unsupported audio format: %s, %s\n", GetChannelConfigName(chans),
+			GetSampleTypeName(type));
+		return false;
+	}
+
+	auto &data = out.Data;
+	unsigned total = 0;
+	unsigned got;
+
+	data.Resize(total + 32768);
+	while ((got = (unsigned)SoundDecoder_Read(decoder, (char*)&data[total], data.Size() - total)) > 0)
+	{
+		total += got;
+		data.Resize(total * 2);
+	}
+	data.Resize(total);
+	SoundDecoder_Close(decoder);
+
+#ifdef __MOBILE__
+	if(chans != ChannelConfig_Mono && monoize)
+	{
+		size_t chancount = GetChannelCount(chans);
+		size_t frames = data.Size() / chancount / (bits / 8);
+		if(type == SampleType_Int16)
+		{
+			short *sfxdata = (short*)data.Data();
+			for(size_t i = 0;i < frames;i++)
+			{
+				int sum = 0;
+				for(size_t c = 0;c < chancount;c++)
+					sum += sfxdata[i*chancount + c];
+				sfxdata[i] = short(sum / chancount);
+			}
+		}
+		else if(type == SampleType_UInt8)
+		{
+			uint8_t *sfxdata = data.Data();
+			for(size_t i = 0;i < frames;i++)
+			{
+				int sum = 0;
+				for(size_t c = 0;c < chancount;c++)
+					sum += sfxdata[i*chancount + c] - 128;
+				sfxdata[i] = uint8_t((sum / chancount) + 128);
+			}
+		}
+		data.Resize(unsigned(data.Size()/chancount));
+	}
+#endif
+	data.ShrinkToFit();
+
+	if (!startass) loop_start = Scale(loop_start, srate, 1000);
+	if (!endass && loop_end != ~0u) loop_end = Scale(loop_end, srate, 1000);
+	const uint32_t samples = data.Size() / (channels * bits / 8);
+	if (loop_start > samples) loop_start = 0;
+	if (loop_end > samples) loop_end = samples;
+
+	// A loop covering the entire sound is the same as having no loop points at all.
+	if (loop_end <= loop_start || (loop_start == 0 && loop_end == samples))
+		loop_start = loop_end = 0;
+
+	out.SampleRate = srate;
+	out.Channels = channels;
+	out.Bits = bits;
+	out.LoopStart = loop_start;
+	out.LoopEnd = loop_end;
+	return true;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+FSoundDecodeCache::~FSoundDecodeCache()
+{
+	if (Worker.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(Lock);
+			QuitWorker = true;
+		}
+		WorkAvailable.notify_all();
+		Worker.join();
+	}
+	Clear();
+}
+
+//==========================================================================
+//
+// LRU list maintenance. Must be called with the lock held.
+//
+//==========================================================================
+
+void FSoundDecodeCache::LinkFront(Entry *entry)
+{
+	entry->Prev = nullptr;
+	entry->Next = Head;
+	if (Head) Head->Prev = entry;
+	else Tail = entry;
+	Head = entry;
+}
+
+void FSoundDecodeCache::Unlink(Entry *entry)
+{
+	if (entry->Prev) entry->Prev->Next = entry->Next;
+	else Head = entry->Next;
+	if (entry->Next) entry->Next->Prev = entry->Prev;
+	else Tail = entry->Prev;
+	entry->Prev = entry->Next = nullptr;
+}
+
+void FSoundDecodeCache::Remove(Entry *entry)
+{
+	Unlink(entry);
+	Entries.Remove(entry->LumpNum);
+	if (entry->Sound != nullptr) MemoryUsed -= entry->Sound->MemorySize();
+	delete entry;
+}
+
+//==========================================================================
+//
+// Evicts the least recently used sounds until the cache fits its budget.
+// Sounds that are still waiting to be decoded are never evicted.
+//
+//==========================================================================
+
+void FSoundDecodeCache::Trim()
+{
+	Entry *entry = Tail;
+	while (MemoryUsed > Budget && entry != nullptr)
+	{
+		Entry *prev = entry->Prev;
+		if (!entry->Pending)
+		{
+			Remove(entry);
+			Evictions++;
+		}
+		entry = prev;
+	}
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void FSoundDecodeCache::SetBudget(size_t bytes)
+{
+	std::lock_guard<std::mutex> lock(Lock);
+	Budget = bytes;
+	Trim();
+}
+
+//==========================================================================
+//
+// Returns the decoded data for a lump if it is in the cache. If it is still
+// waiting for the background thread, it either gets decoded right here or,
+// if the worker is already busy with it, this waits for the result.
+//
+//==========================================================================
+
+std::shared_ptr<FDecodedSound> FSoundDecodeCache::Find(int lumpnum)
+{
+	std::unique_lock<std::mutex> lock(Lock);
+	Entry **pentry = Entries.CheckKey(lumpnum);
+	if (pentry == nullptr) return nullptr;
+
+	Entry *entry = *pentry;
+	if (entry->Pending)
+	{
+		Waits++;
+		unsigned index = Queue.Find(entry);
+		if (index < Queue.Size())
+		{
+			// Not started yet so don't wait for everything queued before it.
+			Queue.Delete(index);
+			TArray<uint8_t> source = std::move(entry->Source);
+			lock.unlock();
+			auto sound = std::make_shared<FDecodedSound>();
+			bool ok = S_DecodeSound(source.Data(), source.Size(), *sound);
+			lock.lock();
+			entry->Pending = false;
+			if (!ok)
+			{
+				Remove(entry);
+				return nullptr;
+			}
+			entry->Sound = sound;
+			MemoryUsed += sound->MemorySize();
+		}
+		else
+		{
+			while ((pentry = Entries.CheckKey(lumpnum)) != nullptr && (*pentry)->Pending)
+			{
+				Decoded.wait(lock);
+			}
+			if (pentry == nullptr) return nullptr;
+			entry = *pentry;
+		}
+	}
+	Hits++;
+	Unlink(entry);
+	LinkFront(entry);
+	auto sound = entry->Sound;
+	Trim();
+	return sound;
+}
+
+//==========================================================================
+//
+// Synchronously decodes a sound and adds it to the cache.
+//
+//==========================================================================
+
+std::shared_ptr<FDecodedSound> FSoundDecodeCache::Decode(int lumpnum, TArray<uint8_t> &sfxdata)
+{
+	auto sound = std::make_shared<FDecodedSound>();
+	if (!S_DecodeSound(sfxdata.Data(), sfxdata.Size(), *sound))
+	{
+		return nullptr;
+	}
+
+	std::lock_guard<std::mutex> lock(Lock);
+	Misses++;
+	if (Budget > 0 && Entries.CheckKey(lumpnum) == nullptr)
+	{
+		Entry *entry = new Entry{ lumpnum, false, {}, sound, nullptr, nullptr };
+		Entries.Insert(lumpnum, entry);
+		LinkFront(entry);
+		MemoryUsed += sound->MemorySize();
+		Trim();
+	}
+	return sound;
+}
+
+//==========================================================================
+//
+// Queues a sound for decoding on the background thread.
+//
+//==========================================================================
+
+void FSoundDecodeCache::Precache(int lumpnum, TArray<uint8_t> &sfxdata)
+{
+	std::unique_lock<std::mutex> lock(Lock);
+	if (Budget == 0 || Entries.CheckKey(lumpnum) != nullptr) return;
+
+	Entry *entry = new Entry{ lumpnum, true, std::move(sfxdata), nullptr, nullptr, nullptr };
+	Entries.Insert(lumpnum, entry);
+	LinkFront(entry);
+	Queue.Push(entry);
+
+	if (!Worker.joinable())
+	{
+		QuitWorker = false;
+		Worker = std::thread([=]() { WorkerProc(); });
+	}
+	lock.unlock();
+	WorkAvailable.notify_one();
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void FSoundDecodeCache::WorkerProc()
+{
+	std::unique_lock<std::mutex> lock(Lock);
+	while (!QuitWorker)
+	{
+		if (Queue.Size() == 0)
+		{
+			WorkAvailable.wait(lock);
+			continue;
+		}
+		Entry *entry = Queue[0];
+		Queue.Delete(0);
+		TArray<uint8_t> source = std::move(entry->Source);
+
+		lock.unlock();
+		auto sound = std::make_shared<FDecodedSound>();
+		bool ok = S_DecodeSound(source.Data(), source.Size(), *sound);
+		lock.lock();
+
+		// Clear() waits for the entry being worked on, so it cannot have been deleted in the meantime.
+		entry->Pending = false;
+		if (ok)
+		{
+			entry->Sound = sound;
+			MemoryUsed += sound->MemorySize();
+			BackgroundDecodes++;
+			Trim();
+		}
+		else
+		{
+			Remove(entry);
+		}
+		Decoded.notify_all();
+	}
+}
+
+//==========================================================================
+//
+// Flushes the entire cache. Lump numbers are only valid for the current
+// set of resource files so this must be called when they change.
+//
+//==========================================================================
+
+void FSoundDecodeCache::Clear()
+{
+	std::unique_lock<std::mutex> lock(Lock);
+	for (auto entry : Queue)
+	{
+		entry->Pending = false;
+	}
+	Queue.Clear();
+	// Wait for the worker to finish whatever it is decoding right now.
+	while (Head != nullptr)
+	{
+		Entry *entry = Head;
+		while (entry != nullptr && entry->Pending) entry = entry->Next;
+		if (entry == nullptr)
+		{
+			Decoded.wait(lock);
+			continue;
+		}
+		Remove(entry);
+	}
+	MemoryUsed = 0;
+	Hits = Misses = Waits = BackgroundDecodes = Evictions = 0;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+FString FSoundDecodeCache::GetStats()
+{
+	std::lock_guard<std::mutex> lock(Lock);
+	FString out;
+	unsigned lookups = Hits + Misses;
+	out.Format("Decode cache: %u sounds, %.2f/%.2f MB, %u hits, %u misses (%.1f%% hit rate)\n"
+		"%u waited, %u decoded in background, %u evicted, %u queued",
+		Entries.CountUsed(), MemoryUsed / 1048576., Budget / 1048576., Hits, Misses,
+		lookups == 0 ? 0. : Hits * 100. / lookups, Waits, BackgroundDecodes, Evictions, Queue.Size());
+	return out;
+}
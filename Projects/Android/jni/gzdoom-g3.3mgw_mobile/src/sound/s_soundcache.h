@@ -0,0 +1,86 @@
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include "tarray.h"
+#include "zstring.h"
+
+//==========================================================================
+//
+// Decoded PCM data of a compressed sound lump, in a format that can be
+// handed directly to SoundRenderer::LoadSoundRaw.
+//
+//==========================================================================
+
+struct FDecodedSound
+{
+	TArray<uint8_t> Data;
+	int SampleRate = 0;
+	int Channels = 0;
+	int Bits = 0;
+	int LoopStart = 0;	// in samples, 0/0 means no loop points
+	int LoopEnd = 0;
+
+	size_t MemorySize() const { return Data.Size() + sizeof(*this); }
+};
+
+bool S_DecodeSound(const uint8_t *sfxdata, int length, FDecodedSound &out);
+
+//==========================================================================
+//
+// LRU cache of decoded sound lumps with a memory budget.
+//
+// Compressed sounds (Ogg, FLAC, MP3, etc.) are expensive to decode, so
+// the decoded data is kept around after the sound has been uploaded to
+// the backend. This makes reloading after level changes and sound resets
+// cheap, and precaching can push the decoding to a background thread so
+// that the first play of a sound doesn't need to decode anything.
+//
+//==========================================================================
+
+class FSoundDecodeCache
+{
+	struct Entry
+	{
+		int LumpNum;
+		bool Pending;		// queued for background decoding.
+		TArray<uint8_t> Source;	// compressed data, only while pending.
+		std::shared_ptr<FDecodedSound> Sound;
+		Entry *Prev, *Next;	// LRU list, most recently used first.
+	};
+
+	std::mutex Lock;
+	std::condition_variable Decoded;
+	std::condition_variable WorkAvailable;
+	std::thread Worker;
+	bool QuitWorker = false;
+
+	TMap<int, Entry*> Entries;
+	TArray<Entry*> Queue;
+	Entry *Head = nullptr, *Tail = nullptr;
+
+	size_t Budget = 0;
+	size_t MemoryUsed = 0;
+	unsigned Hits = 0, Misses = 0, Waits = 0, BackgroundDecodes = 0, Evictions = 0;
+
+	void LinkFront(Entry *entry);
+	void Unlink(Entry *entry);
+	void Remove(Entry *entry);
+	void Trim();
+	void WorkerProc();
+
+public:
+	~FSoundDecodeCache();
+
+	void SetBudget(size_t bytes);
+	bool IsEnabled() const { return Budget > 0; }
+
+	std::shared_ptr<FDecodedSound> Find(int lumpnum);
+	std::shared_ptr<FDecodedSound> Decode(int lumpnum, TArray<uint8_t> &sfxdata);
+	void Precache(int lumpnum, TArray<uint8_t> &sfxdata);
+	void Clear();
+	FString GetStats();
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "i_sound.h"
+#include "s_soundcache.h"
 
 struct FRandomSoundList
 {
@@ -162,6 +163,8 @@ struct FSoundChan : public FISoundChannel
 {
 	FSoundChan	*NextChan;	// Next channel in this list.
 	FSoundChan **PrevChan;	// Previous channel in this list.
+	FSoundChan	*NextSame;	// Next channel playing the same sound.
+	FSoundChan	*PrevSame;	// Previous channel playing the same sound.
 	FSoundID	SoundID;	// Sound ID of playing sound.
 	FSoundID	OrgID;		// Sound ID of sound used to start this channel.
 	float		Volume;
@@ -248,9 +251,20 @@ protected:
 	TArray<FRandomSoundList> S_rnd;
 	bool blockNewSounds = false;
 
+	FSoundDecodeCache DecodeCache;
+	bool DeferDecoding = false;	// set while precaching so that compressed sounds get decoded in the background.
+
+	// Heads of the per-sound channel lists, indexed by SoundID, so that limit checks only need to look at copies of the same sound.
+	TArray<FSoundChan*> SoundChannels;
+	bool VirtualizeInaudible = false;	// evict looping sounds that are out of hearing range instead of keeping them on a voice.
+	unsigned UpdateCount = 0;
+
 private:
 	void LinkChannel(FSoundChan* chan, FSoundChan** head);
 	void UnlinkChannel(FSoundChan* chan);
+	void LinkSoundChannel(FSoundChan* chan);
+	void UnlinkSoundChannel(FSoundChan* chan);
+	bool IsAudible(const FRolloffInfo* rolloff, float distscale, const FVector3& pos);
 	void ReturnChannel(FSoundChan* chan);
 	void RestartChannel(FSoundChan* chan);
 	void RestoreEvictedChannel(FSoundChan* chan);
@@ -267,6 +281,8 @@ private:
 	bool CheckSingular(int sound_id);
 	bool CheckSoundLimit(sfxinfo_t* sfx, const FVector3& pos, int near_limit, float limit_range, int sourcetype, const void* actor, int channel);
 	virtual TArray<uint8_t> ReadSound(int lumpnum) = 0;
+	// Called before a batch of sounds gets loaded so that the client can prepare their data. The default does nothing.
+	virtual void PrefetchSounds(const TArray<int> &lumps) {}
 protected:
 	virtual FSoundID ResolveSound(const void *ent, int srctype, FSoundID soundid, float &attenuation);
 
@@ -326,6 +342,19 @@ public:
 	void Reset();
 	void MarkUsed(int num);
 	void CacheMarkedSounds();
+	void SetDecodeCacheSize(size_t bytes)
+	{
+		DecodeCache.SetBudget(bytes);
+	}
+	FString GetDecodeCacheStats()
+	{
+		return DecodeCache.GetStats();
+	}
+	void SetVirtualization(bool on)
+	{
+		VirtualizeInaudible = on;
+	}
+	FString GetChannelStats();
 	TArray<FSoundChan*> AllActiveChannels();
 
 	void MarkAllUnused()
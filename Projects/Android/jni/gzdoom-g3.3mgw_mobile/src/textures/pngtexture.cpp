@@ -41,6 +41,12 @@
 #include "bitmap.h"
 #include "v_palette.h"
 #include "textures/textures.h"
+#include "c_cvars.h"
+#include "c_dispatch.h"
+#include "stats.h"
+#include "v_text.h"
+
+CVAR(Bool, png_directdecode, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 
 //==========================================================================
 //
@@ -563,6 +569,20 @@ int FPNGTexture::CopyTrueColorPixels(FBitmap *bmp, int x, int y, int rotate, FCo
 		lump = &fr;
 	}
 
+	// Plain 8 bit RGB and RGBA images, which is what most hires textures are,
+	// can be decoded straight into the bitmap if it doesn't need to be clipped.
+	const FClipRect &clip = bmp->GetClipRect();
+	if (png_directdecode && BitDepth == 8 && !Interlace && (ColorType == 6 || (ColorType == 2 && !HaveTrans)) &&
+		rotate == 0 && (inf == NULL || (inf->op == OP_COPY && inf->blend == BLEND_NONE)) &&
+		x >= clip.x && y >= clip.y && x + Width <= clip.x + clip.width && y + Height <= clip.y + clip.height)
+	{
+		lump->Seek (StartOfIDAT, FileReader::SeekSet);
+		lump->Read(&len, 4);
+		lump->Read(&id, 4);
+		M_ReadIDATToBGRA (*lump, bmp->GetPixels() + 4 * x + bmp->GetPitch() * y, Width, Height, bmp->GetPitch(), ColorType, BigLong((unsigned int)len));
+		return ColorType == 6 ? -1 : false;
+	}
+
 	lump->Seek(33, FileReader::SeekSet);
 	for(int i = 0; i < 256; i++)	// default to a gray map
 		pe[i] = PalEntry(255,i,i,i);
@@ -673,3 +693,72 @@ bool FPNGTexture::UseBasePalette()
 { 
 	return false; 
 }
+
+
+//===========================================================================
+//
+// CCMD pngbench
+//
+// Decodes all PNGs in the loaded files into bitmaps, once with the old
+// scalar code, once with the vectorized unfiltering and once more with
+// direct decoding, and checks that all of them give the same result.
+//
+//===========================================================================
+
+EXTERN_CVAR(Bool, png_simd)
+
+CCMD(pngbench)
+{
+	int passes = argv.argc() > 1 ? MAX(1, atoi(argv[1])) : 1;
+	int numlumps = Wads.GetNumLumps();
+	bool simd = png_simd, direct = png_directdecode;
+	cycle_t times[3];
+	for (auto &t : times) t.Reset();
+	int count = 0, mismatches = 0;
+	double pixels = 0;
+
+	for (int i = 0; i < numlumps; i++)
+	{
+		// Don't decompress every lump of a PK3 just to find out that it's not a PNG.
+		const char *ext = strrchr(Wads.GetLumpFullName(i), '.');
+		if ((Wads.GetLumpFlags(i) & LUMPF_COMPRESSED) && (ext == nullptr || stricmp(ext, ".png"))) continue;
+		if (Wads.LumpLength(i) < 8) continue;
+
+		auto reader = Wads.OpenLumpReader(i);
+		FTexture *tex = PNGTexture_TryCreate(reader, i);
+		reader.Close();
+		if (tex == nullptr) continue;
+
+		int width = tex->GetWidth(), height = tex->GetHeight();
+		FBitmap bmps[3];
+		for (int mode = 0; mode < 3; mode++)
+		{
+			png_simd = mode > 0;
+			png_directdecode = mode > 1;
+			for (int pass = 0; pass < passes; pass++)
+			{
+				bmps[mode].Destroy();
+				bmps[mode].Create(width, height);
+				times[mode].Clock();
+				tex->CopyTrueColorPixels(&bmps[mode], 0, 0);
+				times[mode].Unclock();
+			}
+			if (mode > 0 && memcmp(bmps[0].GetPixels(), bmps[mode].GetPixels(), width * height * 4))
+			{
+				if (mismatches++ < 10) Printf(TEXTCOLOR_RED "%s decoded differently in mode %d\n", Wads.GetLumpFullName(i), mode);
+			}
+		}
+		delete tex;
+		count++;
+		pixels += double(width) * height * passes;
+	}
+	png_simd = simd;
+	png_directdecode = direct;
+
+	auto mpps = [=](cycle_t &timer) { return timer.TimeMS() == 0 ? 0. : pixels / (timer.TimeMS() * 1000.); };
+	Printf("%d PNGs, %.1f megapixels, %d passes\n", count, pixels / passes / 1e6, passes);
+	Printf("Scalar: %.1f ms, %.1f MPixels/s\n", times[0].TimeMS(), mpps(times[0]));
+	Printf("Vectorized: %.1f ms, %.1f MPixels/s\n", times[1].TimeMS(), mpps(times[1]));
+	Printf("Vectorized and direct: %.1f ms, %.1f MPixels/s\n", times[2].TimeMS(), mpps(times[2]));
+	if (mismatches > 0) Printf(TEXTCOLOR_RED "%d PNGs decoded differently\n", mismatches);
+}
@@ -0,0 +1,177 @@
+/*
+** threadpool.cpp
+** Worker threads for independent work items
+**
+**---------------------------------------------------------------------------
+** Copyright 2018 Christoph Oelckers
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+*/
+
+#include "threadpool.h"
+#include "templates.h"
+#include "c_cvars.h"
+
+// Only read when the pool is first used, so changing it requires a restart.
+CVAR(Int, sys_workerthreads, -1, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+
+static thread_local bool InWorkItem;
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+FThreadPool::FThreadPool()
+{
+	int count = sys_workerthreads;
+	if (count < 0) count = (int)std::thread::hardware_concurrency() - 1;
+	count = clamp(count, 0, 15);
+
+	NextItem = 0;
+	for (int i = 0; i < count; i++)
+	{
+		Workers.push_back(std::thread([this]() { WorkerProc(); }));
+	}
+}
+
+FThreadPool::~FThreadPool()
+{
+	{
+		std::unique_lock<std::mutex> lock(Lock);
+		QuitWorkers = true;
+	}
+	WorkAvailable.notify_all();
+	for (auto &worker : Workers)
+	{
+		worker.join();
+	}
+}
+
+FThreadPool &FThreadPool::Get()
+{
+	static FThreadPool pool;
+	return pool;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void FThreadPool::RunItems(const std::function<void(int)> &func, int count)
+{
+	InWorkItem = true;
+	for (;;)
+	{
+		int item = NextItem++;
+		if (item >= count) break;
+		try
+		{
+			func(item);
+		}
+		catch (...)
+		{
+			std::unique_lock<std::mutex> lock(Lock);
+			if (!Error) Error = std::current_exception();
+		}
+	}
+	InWorkItem = false;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void FThreadPool::WorkerProc()
+{
+	unsigned lastbatch = 0;
+	for (;;)
+	{
+		const std::function<void(int)> *batch;
+		int count;
+		{
+			std::unique_lock<std::mutex> lock(Lock);
+			WorkAvailable.wait(lock, [&]() { return QuitWorkers || (Batch != nullptr && BatchId != lastbatch); });
+			if (QuitWorkers) return;
+			lastbatch = BatchId;
+			batch = Batch;
+			count = BatchSize;
+			ActiveWorkers++;
+		}
+
+		RunItems(*batch, count);
+
+		{
+			std::unique_lock<std::mutex> lock(Lock);
+			if (--ActiveWorkers == 0) WorkDone.notify_all();
+		}
+	}
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void FThreadPool::ParallelFor(int count, const std::function<void(int)> &func)
+{
+	if (count <= 0) return;
+	if (count == 1 || Workers.size() == 0 || InWorkItem)
+	{
+		for (int i = 0; i < count; i++) func(i);
+		return;
+	}
+
+	std::unique_lock<std::mutex> batchlock(BatchLock);
+	{
+		std::unique_lock<std::mutex> lock(Lock);
+		Batch = &func;
+		BatchSize = count;
+		BatchId++;
+		NextItem = 0;
+		Error = nullptr;
+	}
+	WorkAvailable.notify_all();
+
+	RunItems(func, count);
+
+	std::exception_ptr error;
+	{
+		std::unique_lock<std::mutex> lock(Lock);
+		WorkDone.wait(lock, [this]() { return ActiveWorkers == 0; });
+		Batch = nullptr;
+		error = Error;
+		Error = nullptr;
+	}
+	if (error) std::rethrow_exception(error);
+}
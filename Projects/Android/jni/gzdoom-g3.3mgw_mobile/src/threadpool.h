@@ -0,0 +1,53 @@
+#pragma once
+
+#include <functional>
+#include <exception>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <vector>
+
+//==========================================================================
+//
+// A small pool of worker threads for splitting independent work items
+// across all cores. The calling thread works along and ParallelFor only
+// returns once all items are done. The first exception thrown by an item
+// is passed on to the caller; the remaining items are still run.
+// Calls from inside a work item are run serially on the calling thread.
+//
+// Work items must not call Printf (see C_CaptureOutput) or touch the GL
+// context unless the code they call is known to be thread safe. FNames
+// and FSharedStringArenas can be used freely.
+//
+//==========================================================================
+
+class FThreadPool
+{
+	std::mutex Lock;
+	std::mutex BatchLock;	// only one thread at a time can hand out work.
+	std::condition_variable WorkAvailable;
+	std::condition_variable WorkDone;
+	std::vector<std::thread> Workers;
+	bool QuitWorkers = false;
+
+	// The batch currently being worked on.
+	const std::function<void(int)> *Batch = nullptr;
+	int BatchSize = 0;
+	unsigned BatchId = 0;
+	std::atomic<int> NextItem;
+	int ActiveWorkers = 0;
+	std::exception_ptr Error;
+
+	void WorkerProc();
+	void RunItems(const std::function<void(int)> &func, int count);
+
+public:
+	FThreadPool();
+	~FThreadPool();
+
+	static FThreadPool &Get();
+
+	int NumThreads() const { return (int)Workers.size() + 1; }
+	void ParallelFor(int count, const std::function<void(int)> &func);
+};
@@ -58,6 +58,9 @@
 #include "md5.h"
 #include "doomstat.h"
 #include "vm.h"
+#include "threadpool.h"
+#include "c_console.h"
+#include "stats.h"
 
 // MACROS ------------------------------------------------------------------
 
@@ -129,6 +132,50 @@ void FWadCollection::DeleteAll ()
 	Files.Clear();
 }
 
+//==========================================================================
+//
+// An archive that has been opened on a worker thread but not been added
+// to the lump list yet. Anything that goes wrong is left to AddFile to
+// report so that the output is the same as if it was opened there.
+//
+//==========================================================================
+
+struct FPreopenedFile
+{
+	bool Opened = false;
+	FResourceFile *File = nullptr;
+	FString Output;
+	std::exception_ptr Error;
+
+	~FPreopenedFile()
+	{
+		delete File;
+	}
+};
+
+static void PreopenFile(const char *filename, FPreopenedFile &pre)
+{
+	bool isdir;
+	FileReader wadreader;
+
+	if (!DirEntryExists(filename, &isdir) || isdir || !wadreader.OpenFile(filename))
+	{
+		return;
+	}
+
+	pre.Opened = true;
+	C_CaptureOutput(&pre.Output);
+	try
+	{
+		pre.File = FResourceFile::OpenResourceFile(filename, wadreader);
+	}
+	catch (...)
+	{
+		pre.Error = std::current_exception();
+	}
+	C_CaptureOutput(nullptr);
+}
+
 //==========================================================================
 //
 // W_InitMultipleFiles
@@ -148,10 +195,23 @@ void FWadCollection::InitMultipleFiles (TArray<FString> &filenames)
 	DeleteAll();
 	numfiles = 0;
 
+	// Reading the archive directories is independent for each file so this
+	// can be done in parallel. Adding them to the lump list must still be
+	// done in order. Hashing reads the files serially anyway.
+	TArray<FPreopenedFile> preopened;
+	if (hashfile == nullptr && filenames.Size() > 1)
+	{
+		preopened.Resize(filenames.Size());
+		FThreadPool::Get().ParallelFor(filenames.Size(), [&](int i)
+		{
+			PreopenFile(filenames[i], preopened[i]);
+		});
+	}
+
 	for(unsigned i=0;i<filenames.Size(); i++)
 	{
 		int baselump = NumLumps;
-		AddFile (filenames[i]);
+		AddFile (filenames[i], nullptr, preopened.Size() > 0 ? &preopened[i] : nullptr);
 
 		if (i == (unsigned)IwadIndex) MoveLumpsInFolder("after_iwad/");
 		FStringf path("filter/%s", Files.Last()->GetHash().GetChars());
@@ -168,11 +228,6 @@ void FWadCollection::InitMultipleFiles (TArray<FString> &filenames)
 	FixMacHexen();
 
 	// [RH] Set up hash table
-	Hashes.Resize(6 * NumLumps);
-	FirstLumpIndex = &Hashes[0];
-	NextLumpIndex = &Hashes[NumLumps];
-	FirstLumpIndex_FullName = &Hashes[NumLumps*2];
-	NextLumpIndex_FullName = &Hashes[NumLumps*3];
 	InitHashChains ();
 	LumpInfo.ShrinkToFit();
 	Files.ShrinkToFit();
@@ -206,13 +261,17 @@ int FWadCollection::AddExternalFile(const char *filename)
 // [RH] Removed reload hack
 //==========================================================================
 
-void FWadCollection::AddFile (const char *filename, FileReader *wadr)
+void FWadCollection::AddFile (const char *filename, FileReader *wadr, FPreopenedFile *preopened)
 {
 	int startlump;
 	bool isdir = false;
 	FileReader wadreader;
 
-	if (wadr == nullptr)
+	if (preopened != nullptr && preopened->Opened)
+	{
+		// The checks below have already been done.
+	}
+	else if (wadr == nullptr)
 	{
 		// Does this exist? If so, is it a directory?
 		if (!DirEntryExists(filename, &isdir))
@@ -239,7 +298,14 @@ void FWadCollection::AddFile (const char *filename, FileReader *wadr)
 
 	FResourceFile *resfile;
 	
-	if (!isdir)
+	if (preopened != nullptr && preopened->Opened)
+	{
+		Printf("%s", preopened->Output.GetChars());
+		if (preopened->Error) std::rethrow_exception(preopened->Error);
+		resfile = preopened->File;
+		preopened->File = nullptr;
+	}
+	else if (!isdir)
 		resfile = FResourceFile::OpenResourceFile(filename, wadreader);
 	else
 		resfile = FResourceFile::OpenDirectory(filename);
@@ -425,24 +491,23 @@ int FWadCollection::CheckNumForName (const char *name, int space)
 	}
 
 	uppercopy (uname, name);
-	i = FirstLumpIndex[LumpNameHash (uname) % NumLumps];
-
-	while (i != NULL_INDEX)
+	for (uint32_t slot = HashShortName(qname) & HashMask; ; slot = (slot + 1) & HashMask)
 	{
-		FResourceLump *lump = LumpInfo[i].lump;
+		const FShortNameSlot &entry = ShortNameHash[slot];
+		i = entry.Lump;
+		if (i == NULL_INDEX) break;
 
-		if (lump->qwName == qname)
+		if (entry.QName == qname)
 		{
-			if (lump->Namespace == space) break;
+			if (entry.Namespace == space) break;
 			// If the lump is from one of the special namespaces exclusive to Zips
 			// the check has to be done differently:
 			// If we find a lump with this name in the global namespace that does not come
 			// from a Zip return that. WADs don't know these namespaces and single lumps must
 			// work as well.
-			if (space > ns_specialzipdirectory && lump->Namespace == ns_global && 
-				!(lump->Flags & LUMPF_ZIPFILE)) break;
+			if (space > ns_specialzipdirectory && entry.Namespace == ns_global && 
+				!(LumpInfo[i].lump->Flags & LUMPF_ZIPFILE)) break;
 		}
-		i = NextLumpIndex[i];
 	}
 
 	return i != NULL_INDEX ? i : -1;
@@ -450,7 +515,6 @@ int FWadCollection::CheckNumForName (const char *name, int space)
 
 int FWadCollection::CheckNumForName (const char *name, int space, int wadnum, bool exact)
 {
-	FResourceLump *lump;
 	union
 	{
 		char uname[8];
@@ -464,17 +528,21 @@ int FWadCollection::CheckNumForName (const char *name, int space, int wadnum, bo
 	}
 
 	uppercopy (uname, name);
-	i = FirstLumpIndex[LumpNameHash (uname) % NumLumps];
 
 	// If exact is true if will only find lumps in the same WAD, otherwise
 	// also those in earlier WADs.
 
-	while (i != NULL_INDEX &&
-		(lump = LumpInfo[i].lump, lump->qwName != qname ||
-		lump->Namespace != space ||
-		 (exact? (LumpInfo[i].wadnum != wadnum) : (LumpInfo[i].wadnum > wadnum)) ))
+	for (uint32_t slot = HashShortName(qname) & HashMask; ; slot = (slot + 1) & HashMask)
 	{
-		i = NextLumpIndex[i];
+		const FShortNameSlot &entry = ShortNameHash[slot];
+		i = entry.Lump;
+		if (i == NULL_INDEX) break;
+
+		if (entry.QName == qname && entry.Namespace == space &&
+			(exact? (LumpInfo[i].wadnum == wadnum) : (LumpInfo[i].wadnum <= wadnum)))
+		{
+			break;
+		}
 	}
 
 	return i != NULL_INDEX ? i : -1;
@@ -529,15 +597,15 @@ int FWadCollection::CheckNumForFullName (const char *name, bool trynormal, int n
 		return -1;
 	}
 
-	i = FirstLumpIndex_FullName[MakeKey(name) % NumLumps];
-
-	while (i != NULL_INDEX && stricmp(name, LumpInfo[i].lump->FullName))
+	uint32_t hash = MakeKey(name);
+	for (uint32_t slot = hash & HashMask; ; slot = (slot + 1) & HashMask)
 	{
-		i = NextLumpIndex_FullName[i];
+		const FFullNameSlot &entry = FullNameHash[slot];
+		i = entry.Lump;
+		if (i == NULL_INDEX) break;
+		if (entry.Hash == hash && !stricmp(name, LumpInfo[i].lump->FullName)) return i;
 	}
 
-	if (i != NULL_INDEX) return i;
-
 	if (trynormal && strlen(name) <= 8 && !strpbrk(name, "./"))
 	{
 		return CheckNumForName(name, namespc);
@@ -561,12 +629,13 @@ int FWadCollection::CheckNumForFullName (const char *name, int wadnum)
 		return CheckNumForFullName (name);
 	}
 
-	i = FirstLumpIndex_FullName[MakeKey (name) % NumLumps];
-
-	while (i != NULL_INDEX && 
-		(stricmp(name, LumpInfo[i].lump->FullName) || LumpInfo[i].wadnum != wadnum))
+	uint32_t hash = MakeKey (name);
+	for (uint32_t slot = hash & HashMask; ; slot = (slot + 1) & HashMask)
 	{
-		i = NextLumpIndex_FullName[i];
+		const FFullNameSlot &entry = FullNameHash[slot];
+		i = entry.Lump;
+		if (i == NULL_INDEX) break;
+		if (entry.Hash == hash && LumpInfo[i].wadnum == wadnum && !stricmp(name, LumpInfo[i].lump->FullName)) break;
 	}
 
 	return i != NULL_INDEX ? i : -1;
@@ -701,6 +770,18 @@ uint32_t FWadCollection::LumpNameHash (const char *s)
 	return hash ^ 0xffffffff;
 }
 
+//==========================================================================
+//
+// Hash for an upper cased 8 character name.
+//
+//==========================================================================
+
+uint32_t FWadCollection::HashShortName (uint64_t qname)
+{
+	// Fibonacci hashing: the upper bits of the product depend on all bytes of the name.
+	return uint32_t((qname * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
 //==========================================================================
 //
 // W_InitHashChains
@@ -712,29 +793,51 @@ uint32_t FWadCollection::LumpNameHash (const char *s)
 
 void FWadCollection::InitHashChains (void)
 {
-	char name[8];
-	unsigned int i, j;
+	// At most half of the slots are used so that probe sequences stay short.
+	uint32_t size = 16;
+	while (size < NumLumps * 2) size <<= 1;
+	HashMask = size - 1;
+
+	// Hashing the names is independent for each lump. Large mods have
+	// 100000s of lumps with long paths so this is done on all cores.
+	TArray<uint32_t> shorthashes(NumLumps, true);
+	TArray<uint32_t> fullhashes(NumLumps, true);
+	const int BATCH = 4096;
+	FThreadPool::Get().ParallelFor((NumLumps + BATCH - 1) / BATCH, [&](int batch)
+	{
+		uint32_t end = MIN<uint32_t>(NumLumps, (batch + 1) * BATCH);
+		for (uint32_t i = batch * BATCH; i < end; i++)
+		{
+			union
+			{
+				char name[8];
+				uint64_t qname;
+			};
+			uppercopy (name, LumpInfo[i].lump->Name);
+			shorthashes[i] = HashShortName(qname);
+			fullhashes[i] = LumpInfo[i].lump->FullName.IsNotEmpty() ? MakeKey(LumpInfo[i].lump->FullName) : 0;
+		}
+	});
 
-	// Mark all buckets as empty
-	memset (FirstLumpIndex, 255, NumLumps*sizeof(FirstLumpIndex[0]));
-	memset (NextLumpIndex, 255, NumLumps*sizeof(NextLumpIndex[0]));
-	memset (FirstLumpIndex_FullName, 255, NumLumps*sizeof(FirstLumpIndex_FullName[0]));
-	memset (NextLumpIndex_FullName, 255, NumLumps*sizeof(NextLumpIndex_FullName[0]));
+	ShortNameHash.Resize(size);
+	FullNameHash.Resize(size);
+	for (auto &entry : ShortNameHash) entry.Lump = NULL_INDEX;
+	for (auto &entry : FullNameHash) entry.Lump = NULL_INDEX;
 
-	// Now set up the chains
-	for (i = 0; i < (unsigned)NumLumps; i++)
+	// Inserting the newest lumps first puts them in front of older lumps with the same name.
+	for (uint32_t i = NumLumps; i-- > 0; )
 	{
-		uppercopy (name, LumpInfo[i].lump->Name);
-		j = LumpNameHash (name) % NumLumps;
-		NextLumpIndex[i] = FirstLumpIndex[j];
-		FirstLumpIndex[j] = i;
+		FResourceLump *lump = LumpInfo[i].lump;
+		uint32_t slot = shorthashes[i] & HashMask;
+		while (ShortNameHash[slot].Lump != NULL_INDEX) slot = (slot + 1) & HashMask;
+		ShortNameHash[slot] = { lump->qwName, i, lump->Namespace };
 
 		// Do the same for the full paths
-		if (LumpInfo[i].lump->FullName.IsNotEmpty())
+		if (lump->FullName.IsNotEmpty())
 		{
-			j = MakeKey(LumpInfo[i].lump->FullName) % NumLumps;
-			NextLumpIndex_FullName[i] = FirstLumpIndex_FullName[j];
-			FirstLumpIndex_FullName[j] = i;
+			slot = fullhashes[i] & HashMask;
+			while (FullNameHash[slot].Lump != NULL_INDEX) slot = (slot + 1) & HashMask;
+			FullNameHash[slot] = { fullhashes[i], i };
 		}
 	}
 }
@@ -1108,23 +1211,29 @@ int FWadCollection::FindLump (const char *name, int *lastlump, bool anyns)
 		char name8[8];
 		uint64_t qname;
 	};
-	LumpRecord *lump_p;
+	uint32_t found = NULL_INDEX;
 
 	uppercopy (name8, name);
 
 	assert(lastlump != NULL && *lastlump >= 0);
-	lump_p = &LumpInfo[*lastlump];
-	while (lump_p < &LumpInfo[NumLumps])
+
+	// All lumps with this name are in the same probe sequence in descending
+	// order, so the last match is the first one after lastlump.
+	for (uint32_t slot = HashShortName(qname) & HashMask; ; slot = (slot + 1) & HashMask)
 	{
-		FResourceLump *lump = lump_p->lump;
+		const FShortNameSlot &entry = ShortNameHash[slot];
+		if (entry.Lump == NULL_INDEX) break;
 
-		if ((anyns || lump->Namespace == ns_global) && lump->qwName == qname)
+		if (entry.QName == qname && entry.Lump >= (uint32_t)*lastlump && (anyns || entry.Namespace == ns_global))
 		{
-			int lump = int(lump_p - &LumpInfo[0]);
-			*lastlump = lump + 1;
-			return lump;
+			found = entry.Lump;
 		}
-		lump_p++;
+	}
+
+	if (found != NULL_INDEX)
+	{
+		*lastlump = found + 1;
+		return found;
 	}
 
 	*lastlump = NumLumps;
@@ -1511,6 +1620,28 @@ FileReader FWadCollection::ReopenLumpReader(int lump, bool alwayscache)
 	return rl->NewReader();	// This always gets a reader to the cache
 }
 
+//==========================================================================
+//
+// PrefetchLumps
+//
+// Decompresses the given lumps in parallel and keeps them in the lump
+// cache. Lumps that aren't compressed are ignored.
+//
+//==========================================================================
+
+void FWadCollection::PrefetchLumps(const TArray<int> &lumps)
+{
+	TArray<FResourceLump *> records;
+	for (int lump : lumps)
+	{
+		if ((unsigned)lump < (unsigned)LumpInfo.Size() && (LumpInfo[lump].lump->Flags & LUMPF_COMPRESSED))
+		{
+			records.Push(LumpInfo[lump].lump);
+		}
+	}
+	if (records.Size() > 0) DecompressLumps(records);
+}
+
 //==========================================================================
 //
 // GetFileReader
@@ -1753,3 +1884,67 @@ CCMD(lumpnumfull)
 	}
 }
 #endif
+
+//==========================================================================
+//
+// CCMD lumphashbench
+//
+// Times lookups of every loaded lump by its 8 character name and its full
+// name, as well as the same number of lookups for names that don't exist.
+//
+//==========================================================================
+
+CCMD(lumphashbench)
+{
+	int passes = argv.argc() > 1 ? MAX(1, atoi(argv[1])) : 10;
+	int numlumps = Wads.GetNumLumps();
+	TArray<FString> shortnames, fullnames;
+	TArray<int> namespaces;
+
+	for (int i = 0; i < numlumps; i++)
+	{
+		FString name;
+		Wads.GetLumpName(name, i);
+		shortnames.Push(name);
+		namespaces.Push(Wads.GetLumpNamespace(i));
+		const char *fullname = Wads.GetLumpFullName(i);
+		if (fullname != nullptr && *fullname != 0) fullnames.Push(fullname);
+	}
+
+	int found = 0;
+	cycle_t shorttime, fulltime, misstime;
+	shorttime.Reset();
+	fulltime.Reset();
+	misstime.Reset();
+	for (int pass = 0; pass < passes; pass++)
+	{
+		shorttime.Clock();
+		for (int i = 0; i < numlumps; i++)
+		{
+			found += Wads.CheckNumForName(shortnames[i], namespaces[i]) >= 0;
+		}
+		shorttime.Unclock();
+
+		fulltime.Clock();
+		for (auto &name : fullnames)
+		{
+			found += Wads.CheckNumForFullName(name) >= 0;
+		}
+		fulltime.Unclock();
+
+		misstime.Clock();
+		for (int i = 0; i < numlumps; i++)
+		{
+			char name[9];
+			mysnprintf(name, countof(name), "~%07X", i);
+			found += Wads.CheckNumForName(name, ns_global) >= 0;
+		}
+		misstime.Unclock();
+	}
+
+	auto nsPerLookup = [=](cycle_t &timer, unsigned count) { return count == 0 ? 0. : timer.TimeMS() * 1e6 / (double(count) * passes); };
+	Printf("%d lumps, %d passes, %d found\n", numlumps, passes, found);
+	Printf("8 character names: %.1f ns per lookup\n", nsPerLookup(shorttime, numlumps));
+	Printf("Full names: %.1f ns per lookup\n", nsPerLookup(fulltime, fullnames.Size()));
+	Printf("Missing names: %.1f ns per lookup\n", nsPerLookup(misstime, numlumps));
+}
@@ -16,6 +16,7 @@
 class FResourceFile;
 struct FResourceLump;
 class FTexture;
+struct FPreopenedFile;
 
 struct wadinfo_t
 {
@@ -118,7 +119,7 @@ public:
 	void SetIwadNum(int x) { IwadIndex = x; }
 
 	void InitMultipleFiles (TArray<FString> &filenames);
-	void AddFile (const char *filename, FileReader *wadinfo = NULL);
+	void AddFile (const char *filename, FileReader *wadinfo = NULL, FPreopenedFile *preopened = NULL);
 	int CheckIfWadLoaded (const char *name);
 
 	const char *GetWadName (int wadnum) const;
@@ -160,6 +161,7 @@ public:
 
 	FileReader OpenLumpReader(int lump);		// opens a reader that redirects to the containing file's one.
 	FileReader ReopenLumpReader(int lump, bool alwayscache = false);		// opens an independent reader.
+	void PrefetchLumps(const TArray<int> &lumps);	// decompresses the given lumps on all cores ahead of their use.
 
 	int FindLump (const char *name, int *lastlump, bool anyns=false);		// [RH] Find lumps with duplication
 	int FindLumpMulti (const char **names, int *lastlump, bool anyns = false, int *nameindex = NULL); // same with multiple possible names
@@ -196,12 +198,24 @@ protected:
 	TArray<FResourceFile *> Files;
 	TArray<LumpRecord> LumpInfo;
 
-	TArray<uint32_t> Hashes;	// one allocation for all hash lists.
-	uint32_t *FirstLumpIndex;	// [RH] Hashing stuff moved out of lumpinfo structure
-	uint32_t *NextLumpIndex;
-
-	uint32_t *FirstLumpIndex_FullName;	// The same information for fully qualified paths from .zips
-	uint32_t *NextLumpIndex_FullName;
+	// Open addressed lump name hash tables with linear probing. Lumps with
+	// the same name are stored in descending order so that later files
+	// override earlier ones. The keys are kept in the table so that a miss
+	// never needs to look at the lump itself.
+	struct FShortNameSlot
+	{
+		uint64_t QName;
+		uint32_t Lump;
+		int Namespace;
+	};
+	struct FFullNameSlot
+	{
+		uint32_t Hash;	// MakeKey of the full name
+		uint32_t Lump;
+	};
+	TArray<FShortNameSlot> ShortNameHash;
+	TArray<FFullNameSlot> FullNameHash;
+	uint32_t HashMask = 0;
 
 	uint32_t NumLumps = 0;					// Not necessarily the same as LumpInfo.Size()
 	uint32_t NumWads;
@@ -209,6 +223,7 @@ protected:
 	int IwadIndex;
 
 	void InitHashChains ();								// [RH] Set up the lumpinfo hashing
+	static uint32_t HashShortName (uint64_t qname);
 
 private:
 	void RenameSprites();
@@ -61,6 +61,14 @@
 std::wstring WideString(const char *);
 #endif
 
+// Strings may be shared between threads, so the reference counts must be updated atomically.
+#ifdef _MSC_VER
+#include <intrin.h>
+inline int FString_AtomicAdd(int &value, int add) { return _InterlockedExchangeAdd((long *)&value, add) + add; }
+#else
+inline int FString_AtomicAdd(int &value, int add) { return __atomic_add_fetch(&value, add, __ATOMIC_ACQ_REL); }
+#endif
+
 struct FStringData
 {
 	unsigned int Len;		// Length of string, excluding terminating null
@@ -86,7 +94,7 @@ struct FStringData
 		}
 		else
 		{
-			RefCount++;
+			FString_AtomicAdd(RefCount, 1);
 			return (char *)(this + 1);
 		}
 	}
@@ -95,7 +103,7 @@ struct FStringData
 	{
 		assert (RefCount != 0);
 
-		if (--RefCount <= 0)
+		if (FString_AtomicAdd(RefCount, -1) <= 0)
 		{
 			Dealloc();
 		}
@@ -349,7 +357,7 @@ protected:
 
 	void ResetToNull()
 	{
-		NullString.RefCount++;
+		FString_AtomicAdd(NullString.RefCount, 1);
 		Chars = &NullString.Nothing[0];
 	}
 
@@ -7,6 +7,10 @@ in vec4 vEyeNormal;
 in vec4 vTexCoord;
 in vec4 vColor;
 
+// instanced models pass their light index through the vertex shader
+flat in int vLightIndex;
+#define uLightIndex vLightIndex
+
 out vec4 FragColor;
 #ifdef GBUFFER_PASS
 out vec4 FragFog;